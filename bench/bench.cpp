@@ -0,0 +1,87 @@
+#include "bench.h"
+#include "core/file_utils.h"
+#include "core/utils.h"
+#include <algorithm>
+#include <fstream>
+
+namespace teditor {
+namespace bench {
+
+State::State(const std::string& n, int s, double minTimeSec):
+  sz(s), minTime(minTimeSec), items(0), gen(42), res() {
+  res.name = n;
+  res.iters = 0;
+  res.minNs = res.medianNs = res.meanNs = res.itemsPerSec = 0.0;
+}
+
+void State::measure(std::function<void()> func, std::function<void()> setup) {
+  typedef std::chrono::steady_clock Clock;
+  const int MinIters = 5;
+  std::vector<double> times;
+  double total = 0.0;
+  if(setup) setup();
+  func();  // warmup
+  while(total < minTime || (int)times.size() < MinIters) {
+    if(setup) setup();
+    auto start = Clock::now();
+    func();
+    auto ns = std::chrono::duration<double, std::nano>(Clock::now() - start);
+    times.push_back(ns.count());
+    total += ns.count() / 1e9;
+  }
+  std::sort(times.begin(), times.end());
+  res.iters = (int)times.size();
+  res.minNs = times.front();
+  res.medianNs = times[times.size() / 2];
+  res.meanNs = total * 1e9 / times.size();
+  res.itemsPerSec = items > 0 ? items / (res.medianNs / 1e9) : 0.0;
+}
+
+
+std::vector<std::pair<std::string, BenchFunc>>& Registry::all() {
+  static std::vector<std::pair<std::string, BenchFunc>> benches;
+  return benches;
+}
+
+Registry::Registrar::Registrar(const std::string& name, BenchFunc f) {
+  auto& b = all();
+  for(const auto& itr : b)
+    ASSERT(itr.first != name, "Benchmark '%s' already registered!",
+           name.c_str());
+  b.push_back({name, f});
+  std::sort(b.begin(), b.end());
+}
+
+
+std::string randomWord(std::mt19937& rng, int minLen, int maxLen) {
+  int len = minLen + int(rng() % (maxLen - minLen + 1));
+  std::string ret(len, 'a');
+  for(auto& c : ret) c = char('a' + rng() % 26);
+  return ret;
+}
+
+std::string randomText(std::mt19937& rng, int n, int maxWords) {
+  static const char* Puncts[] = {" ", " ", " ", ", ", " = ", "(", ") ", "; "};
+  std::string ret;
+  for(int i = 0; i < n; ++i) {
+    ret.append(rng() % 4, ' ');
+    int nWords = 1 + int(rng() % maxWords);
+    for(int j = 0; j < nWords; ++j) {
+      ret += randomWord(rng, 1, 10);
+      ret += Puncts[rng() % 8];
+    }
+    ret += '\n';
+  }
+  return ret;
+}
+
+std::string writeTempFile(const std::string& contents) {
+  auto file = tempFileName();
+  std::ofstream fp(file.c_str());
+  ASSERT(fp.is_open(), "writeTempFile: failed to open '%s'!", file.c_str());
+  fp << contents;
+  return file;
+}
+
+}  // namespace bench
+}  // namespace teditor
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace teditor {
+namespace bench {
+
+/** results of a benchmark */
+struct Result {
+  std::string name;
+  /** number of timed iterations */
+  int iters;
+  /** per-iteration times */
+  double minNs, medianNs, meanNs;
+  /** items processed per second, 0 if the benchmark didn't say */
+  double itemsPerSec;
+  /** any other metrics reported by the benchmark */
+  std::vector<std::pair<std::string, double>> counters;
+};
+
+/**
+ * @brief Handle passed to every benchmark. A benchmark first builds its
+ * workload (the generated inputs are scaled by `size()`) and then calls
+ * `measure` with the operation to be timed.
+ */
+class State {
+public:
+  State(const std::string& n, int sz, double minTimeSec);
+
+  /** scale factor of the generated inputs */
+  int size() const { return sz; }
+  std::mt19937& rng() { return gen; }
+
+  /** number of items processed by every iteration, for throughput numbers */
+  void setItems(uint64_t n) { items = n; }
+  /** reports an additional metric of the benchmark */
+  void setCounter(const std::string& name, double val) {
+    res.counters.push_back({name, val});
+  }
+
+  /**
+   * @brief times the given function until atleast 'minTime' has elapsed and it
+   * has been run 5 times (excluding a warmup run)
+   * @param func the function to be timed
+   * @param setup if given, is run (untimed) before every iteration
+   */
+  void measure(std::function<void()> func, std::function<void()> setup = {});
+
+  const Result& result() const { return res; }
+
+private:
+  int sz;
+  double minTime;
+  uint64_t items;
+  std::mt19937 gen;
+  Result res;
+};
+
+
+typedef void (*BenchFunc)(State&);
+
+/** all the registered benchmarks, in the order of their names */
+struct Registry {
+  static std::vector<std::pair<std::string, BenchFunc>>& all();
+
+  struct Registrar {
+    Registrar(const std::string& name, BenchFunc f);
+  };
+};
+
+/**
+ * @brief Defines a benchmark
+ * @param Func name of the function implementing it
+ * @param Name name of the benchmark as seen in the reports
+ */
+#define DEF_BENCH(Func, Name)                                   \
+  void Func(State& st);                                         \
+  static Registry::Registrar Func ## _registrar(Name, Func);    \
+  void Func(State& st)
+
+
+/** generates a random lowercase word of length in [minLen, maxLen] */
+std::string randomWord(std::mt19937& rng, int minLen, int maxLen);
+
+/** generates 'n' lines of random words, looking like prose or code */
+std::string randomText(std::mt19937& rng, int n, int maxWords);
+
+/** writes the given contents into a temporary file and returns its path */
+std::string writeTempFile(const std::string& contents);
+
+/**
+ * @brief Replays the keystroke script (see `HeadlessTerminal::addScript`) on
+ * a fresh editor with the given files opened, and reports the keystroke to
+ * frame latencies and output bytes per frame along with the replay times
+ */
+void replayScript(State& st, const std::string& script,
+                  const std::vector<std::string>& files);
+
+}  // namespace bench
+}  // namespace teditor
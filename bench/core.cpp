@@ -0,0 +1,194 @@
+#include "bench.h"
+#include "core/buffer.h"
+#include "core/cell_buffer.h"
+#include "core/isearch.h"
+#include "core/lrucache.hpp"
+#include "core/parser/lexer.h"
+#include "core/parser/nfa.h"
+#include "core/parser/regexs.h"
+#include "core/parser/scanner.h"
+#include "core/window.h"
+#include <memory>
+#include <unistd.h>
+
+namespace teditor {
+namespace bench {
+
+DEF_BENCH(bufferLoad, "Buffer::load") {
+  int n = 5000 * st.size();
+  auto file = writeTempFile(randomText(st.rng(), n, 12));
+  st.setItems(n);
+  st.measure([&]() {
+    Buffer buf;
+    buf.load(file);
+  });
+  unlink(file.c_str());
+}
+
+DEF_BENCH(bufferInsert, "Buffer::insert") {
+  auto text = randomText(st.rng(), 200 * st.size(), 12);
+  std::unique_ptr<Buffer> buf;
+  st.setItems(text.size());
+  // one char at a time, as if typed
+  st.measure([&]() { for(auto c : text) buf->insert(c); },
+             [&]() { buf.reset(new Buffer); });
+}
+
+DEF_BENCH(bufferRemove, "Buffer::remove") {
+  auto text = randomText(st.rng(), 200 * st.size(), 12);
+  std::unique_ptr<Buffer> buf;
+  st.setItems(text.size());
+  st.measure([&]() { for(size_t i = 0; i < text.size(); ++i) buf->remove(); },
+             [&]() {
+               buf.reset(new Buffer);
+               buf->insert(text);
+               buf->end();
+             });
+}
+
+DEF_BENCH(bufferUndo, "Buffer::undo") {
+  int n = 2000 * st.size();
+  std::vector<std::string> words;
+  for(int i = 0; i < n; ++i) words.push_back(randomWord(st.rng(), 1, 10) + ' ');
+  std::unique_ptr<Buffer> buf;
+  st.setItems(n);
+  st.measure([&]() { while(buf->undo()) {} },
+             [&]() {
+               buf.reset(new Buffer);
+               for(const auto& w : words) buf->insert(w);
+             });
+}
+
+DEF_BENCH(renderDiff, "Editor::render") {
+  // what 'Editor::render' does, minus the terminal. Every frame changes a few
+  // lines, like it happens when typing or moving the cursor around
+  const int W = 200, H = 60, Frames = 100 * st.size();
+  CellBuffer front(W, H), back(W, H);
+  auto& rng = st.rng();
+  const AttrColor fg(7), bg(0);
+  std::vector<std::string> rows;
+  for(int i = 0; i < H; ++i) rows.push_back(randomText(rng, 1, 30));
+  auto paint = [&](int y) {
+    const auto& r = rows[y];
+    for(int x = 0; x < W; ++x)
+      back.at(x, y).set(x < (int)r.size() ? r[x] : ' ', fg, bg);
+  };
+  for(int y = 0; y < H; ++y) paint(y);
+  st.setItems(Frames);
+  st.measure([&]() {
+    for(int f = 0; f < Frames; ++f) {
+      for(int i = 0; i < 3; ++i) {
+        int y = int(rng() % H);
+        rows[y][rng() % rows[y].size()] = char('a' + rng() % 26);
+        paint(y);
+      }
+      syncCells(front, back, [](int, int, const Cell&, int) {});
+    }
+  }, [&]() { front.clear(bg, bg); });
+}
+
+DEF_BENCH(nfaFindAny, "NFA::findAny") {
+  auto text = randomText(st.rng(), 1000 * st.size(), 12);
+  auto lines = split(text, '\n');
+  parser::NFA nfa("[a-z]+q[a-z]*");
+  st.setItems(text.size());
+  st.measure([&]() {
+    size_t start;
+    for(const auto& l : lines) nfa.findAny(l, start);
+  });
+}
+
+enum LexTokens {
+  Lex_Float,
+  Lex_Int,
+  Lex_Assignment,
+  Lex_BrktOpen,
+  Lex_BrktClose,
+  Lex_SemiColon,
+  Lex_Symbol,
+  Lex_Operators,
+  Lex_WhiteSpace,
+};
+
+DEF_BENCH(lexerNext, "Lexer::next") {
+  parser::Lexer lex({
+      {Lex_Float,      parser::Regexs::FloatingPt, "Float"},
+      {Lex_Int,        parser::Regexs::Integer,    "Int"},
+      {Lex_Assignment, "=",                        "Assignment"},
+      {Lex_BrktOpen,   "\\(",                      "BrktOpen"},
+      {Lex_BrktClose,  "\\)",                      "BrktClose"},
+      {Lex_SemiColon,  ";",                        "SemiColon"},
+      {Lex_Symbol,     parser::Regexs::Variable,   "Symbol"},
+      {Lex_Operators,  "[-+*/]",                   "Operators"},
+      {Lex_WhiteSpace, "\\s+",                     "WhiteSpace"},
+    });
+  static const char* Ops[] = {" + ", " - ", " * ", " / "};
+  auto& rng = st.rng();
+  std::string expr;
+  int n = 2000 * st.size();
+  for(int i = 0; i < n; ++i) {
+    switch(rng() % 4) {
+    case 0: expr += format("%u", unsigned(rng() % 100000)); break;
+    case 1: expr += format("%u.%u", unsigned(rng() % 1000),
+                           unsigned(rng() % 1000)); break;
+    case 2: expr += "(" + randomWord(rng, 1, 8) + ")"; break;
+    default: expr += randomWord(rng, 1, 8) + " = 1;"; break;
+    }
+    expr += Ops[rng() % 4];
+  }
+  expr += "0";
+  uint64_t tokens = 0;
+  {
+    parser::StringScanner sc(expr);
+    while(lex.next(&sc).type != parser::Token::End) ++tokens;
+  }
+  st.setItems(tokens);
+  st.measure([&]() {
+    parser::StringScanner sc(expr);
+    while(lex.next(&sc).type != parser::Token::End) {}
+  });
+}
+
+DEF_BENCH(isearchUpdate, "ISearch::updateChoices") {
+  int n = 2000 * st.size();
+  auto& rng = st.rng();
+  auto file = writeTempFile(randomText(rng, n, 12));
+  Buffers bufs;
+  bufs.push_back(new Buffer);
+  bufs[0]->load(file);
+  Window win;
+  win.attachBuffs(&bufs);
+  win.resize({0, 0}, {200, 60});
+  ISearch is(win, false);
+  std::vector<std::string> queries;
+  for(int i = 0; i < 4; ++i) queries.push_back(randomWord(rng, 4, 6));
+  st.setItems(n);
+  // search string being typed in, one char at a time
+  st.measure([&]() {
+    for(const auto& q : queries) {
+      is.reset();
+      for(size_t len = 1; len <= q.size(); ++len)
+        is.updateChoices(q.substr(0, len));
+    }
+  });
+  unlink(file.c_str());
+}
+
+DEF_BENCH(lruCache, "LRUCache") {
+  const int Cap = 1024, N = 100000 * st.size();
+  LRUCache<int, int> cache(Cap);
+  std::vector<int> keys;
+  // a working set slightly larger than the capacity, to exercise evictions
+  auto& rng = st.rng();
+  for(int i = 0; i < N; ++i) keys.push_back(int(rng() % (Cap * 5 / 4)));
+  st.setItems(N);
+  st.measure([&]() {
+    for(auto k : keys) {
+      if(cache.exists(k)) ++cache.get(k);
+      else cache.put(k, k);
+    }
+  });
+}
+
+}  // namespace bench
+}  // namespace teditor
@@ -0,0 +1,112 @@
+#include "bench.h"
+#include "core/editor.h"
+#include "core/file_utils.h"
+#include "core/headless_terminal.h"
+#include "core/option.h"
+#include <algorithm>
+#include <memory>
+#include <unistd.h>
+
+namespace teditor {
+namespace bench {
+
+void replayScript(State& st, const std::string& script,
+                  const std::vector<std::string>& files) {
+  auto hist = tempFileName();
+  Option::set("histFile", hist);
+  std::vector<FileInfo> fInfos;
+  for(const auto& f : files) fInfos.push_back({f, 0});
+  typedef SingletonHandler<HeadlessTerminal, Pos2di> TermHandler;
+  std::unique_ptr<Editor> ed;
+  std::unique_ptr<TermHandler> th;
+  auto term = [] () -> HeadlessTerminal& {
+    return static_cast<HeadlessTerminal&>(Terminal::getInstance());
+  };
+  st.measure([&]() { ed->run(); },
+             [&]() {
+               // editor needs to go away before its terminal
+               ed.reset();
+               th.reset();
+               th.reset(new TermHandler({160, 48}));
+               term().addScript(script);
+               st.setItems(term().pending());
+               ed.reset(new Editor(fInfos));
+             });
+  // latencies as seen in the last replay
+  std::vector<double> lat;
+  size_t bytes = 0;
+  for(const auto& f : term().frames()) {
+    if(f.latencyUs < 0.0) continue;
+    lat.push_back(f.latencyUs);
+    bytes += f.bytes;
+  }
+  ed.reset();
+  th.reset();
+  unlink(hist.c_str());
+  if(lat.empty()) return;
+  std::sort(lat.begin(), lat.end());
+  auto pct = [&lat](double p) { return lat[size_t(p * (lat.size() - 1))]; };
+  st.setCounter("latency_p50_us", pct(0.5));
+  st.setCounter("latency_p99_us", pct(0.99));
+  st.setCounter("latency_max_us", lat.back());
+  st.setCounter("bytes_per_frame", double(bytes) / lat.size());
+}
+
+DEF_BENCH(terminalDecode, "Terminal::decode") {
+  // typed keys, escape sequences, UTF-8 chars and a paste, all in one go
+  static const char* Keys[] = {"a", "C-X", "up", "C-right", "M-x", "pagedown",
+                               "enter", "F5"};
+  auto& rng = st.rng();
+  std::string input;
+  int n = 500 * st.size();
+  for(int i = 0; i < n; ++i) {
+    input += key2seq(Keys[rng() % 8]);
+    if(rng() % 4 == 0) input += "\xc3\xa9";
+  }
+  input += Terminal::PasteStart + randomText(rng, 200, 12) + Terminal::PasteEnd;
+  typedef SingletonHandler<HeadlessTerminal, Pos2di> TermHandler;
+  TermHandler th({80, 24});
+  auto& term = static_cast<HeadlessTerminal&>(Terminal::getInstance());
+  st.setItems(input.size());
+  st.measure([&]() { while(term.waitAndFill(nullptr) >= 0) {} },
+             [&]() { term.addKeySeq(input); });
+}
+
+DEF_BENCH(editorKeystroke, "Editor::keystroke") {
+  static const char* Moves[] = {"down", "up", "right", "left", "end", "home",
+                                "pagedown", "pageup", "C-right", "C-left"};
+  auto& rng = st.rng();
+  auto file = writeTempFile(randomText(rng, 2000, 12));
+  std::string script;
+  int n = 200 * st.size();
+  for(int i = 0; i < n; ++i) {
+    switch(rng() % 8) {
+    case 0: case 1: case 2:
+      script += std::string("keys ") + Moves[rng() % 10] + "\n";
+      break;
+    case 3: case 4:
+      script += "type  " + randomWord(rng, 1, 8) + "\n";
+      break;
+    case 5: script += "keys backspace backspace\n"; break;
+    case 6: script += "keys enter\n"; break;
+    default: script += "keys C-U\n"; break;
+    }
+  }
+  replayScript(st, script, {file});
+  unlink(file.c_str());
+}
+
+DEF_BENCH(editorRedraw, "Editor::redraw") {
+  // paging through a file repaints every cell of the screen on each frame
+  auto& rng = st.rng();
+  auto file = writeTempFile(randomText(rng, 5000, 12));
+  std::string script;
+  int n = 50 * st.size();
+  for(int i = 0; i < n; ++i)
+    script += (i % 8) < 6 ? "keys pagedown\n" : "keys pageup\n";
+  replayScript(st, script, {file});
+  unlink(file.c_str());
+}
+
+}  // namespace bench
+}  // namespace teditor
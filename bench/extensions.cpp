@@ -0,0 +1,52 @@
+#include "bench.h"
+#include "core/utils.h"
+#include "extensions/ledger/parser.h"
+#include "extensions/todo/parser.h"
+#include <unistd.h>
+
+namespace teditor {
+namespace bench {
+
+DEF_BENCH(ledgerParse, "ledger::Parser") {
+  const int NumAccts = 20, NumTrans = 1000 * st.size();
+  auto& rng = st.rng();
+  std::string contents;
+  for(int i = 0; i < NumAccts; ++i) {
+    contents += format("account Assets:Acct%d\n", i);
+    contents += "  description " + randomWord(rng, 4, 10) + "\n";
+    contents += format("  alias       A%d\n\n", i);
+  }
+  for(int i = 0; i < NumTrans; ++i) {
+    contents += format("2020-%02d-%02d %s\n", 1 + i % 12, 1 + i % 28,
+                       randomWord(rng, 4, 12).c_str());
+    int from = int(rng() % NumAccts), to = (from + 1) % NumAccts;
+    contents += format("  A%d  %u.%02u\n", to, unsigned(rng() % 10000),
+                       unsigned(rng() % 100));
+    contents += format("  Assets:Acct%d\n\n", from);
+  }
+  auto file = writeTempFile(contents);
+  st.setItems(NumTrans);
+  st.measure([&]() { ledger::Parser p(file); });
+  unlink(file.c_str());
+}
+
+DEF_BENCH(todoParse, "todo::Parser") {
+  static const char* Repeats[] = {"", " repeat daily", " repeat weekly",
+                                  " repeat monthly", " repeat yearly"};
+  const int N = 2000 * st.size();
+  auto& rng = st.rng();
+  std::string contents;
+  for(int i = 0; i < N; ++i) {
+    contents += format("on 2020-%02d-%02d", 1 + i % 12, 1 + i % 28);
+    if(rng() % 2) contents += format(" %02u:00:00", unsigned(rng() % 24));
+    contents += format(" for \"Task%d\"%s\n", i, Repeats[rng() % 5]);
+    if(rng() % 8 == 0) contents += "# " + randomWord(rng, 4, 10) + "\n";
+  }
+  auto file = writeTempFile(contents);
+  st.setItems(N);
+  st.measure([&]() { todo::Parser p(file); });
+  unlink(file.c_str());
+}
+
+}  // namespace bench
+}  // namespace teditor
@@ -0,0 +1,191 @@
+#include "bench.h"
+#include "core/option.h"
+#include "core/utils.h"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string.h>
+
+using namespace teditor;
+using namespace teditor::bench;
+
+struct Args {
+  int size;
+  double minTime, threshold;
+  std::string filter, json, baseline;
+  Strings scripts;
+  bool list;
+
+  Args(): size(1), minTime(0.2), threshold(10.0), filter(), json(),
+          baseline(), list(false) {}
+};
+
+bool parseBenchArgs(int argc, char** argv, Args& args) {
+  for(int i = 1; i < argc; ++i) {
+    if(!strcmp(argv[i], "-h")) {
+      printf("teditor-bench: Benchmarks of the core subsystems of teditor.\n"
+             "USAGE:\n"
+             "  teditor-bench [-h] [-list] [-size <n>] [-min-time <sec>]\n"
+             "                [-filter <str>] [-json <file>]\n"
+             "                [-baseline <file>] [-threshold <pct>]\n"
+             "                [-script <file>]\n"
+             "OPTIONS:\n"
+             "  -h                Print this help and exit.\n"
+             "  -list             List all benchmarks and exit.\n"
+             "  -size <n>         Scale factor of the generated inputs. [1]\n"
+             "  -min-time <sec>   Min time to spend per benchmark. [0.2]\n"
+             "  -filter <str>     Run only benchmarks containing this.\n"
+             "  -json <file>      Write the results as JSON into this file.\n"
+             "  -baseline <file>  Compare against the results in this JSON\n"
+             "                    file (written by an earlier '-json' run).\n"
+             "  -threshold <pct>  Slowdown beyond this percentage (of median\n"
+             "                    time) w.r.t. baseline is a regression. [10]\n"
+             "  -script <file>    Also replay this keystroke script, with an\n"
+             "                    empty buffer. Can be passed multiple times.\n");
+      return false;
+    } else if(!strcmp(argv[i], "-list")) {
+      args.list = true;
+    } else {
+      ASSERT(i + 1 < argc, "'%s' option expects an argument!", argv[i]);
+      std::string opt(argv[i]), val(argv[++i]);
+      if(opt == "-size") args.size = str2num(val);
+      else if(opt == "-min-time") args.minTime = str2real(val);
+      else if(opt == "-filter") args.filter = val;
+      else if(opt == "-json") args.json = val;
+      else if(opt == "-baseline") args.baseline = val;
+      else if(opt == "-threshold") args.threshold = str2real(val);
+      else if(opt == "-script") args.scripts.push_back(val);
+      else ASSERT(false, "Invalid arg passed! '%s'", opt.c_str());
+    }
+  }
+  ASSERT(args.size > 0, "'-size' must be positive! [%d]", args.size);
+  return true;
+}
+
+void writeJson(const std::string& file, const Args& args,
+               const std::vector<Result>& results) {
+  std::ofstream fp(file.c_str());
+  ASSERT(fp.is_open(), "Failed to open file '%s'!", file.c_str());
+  fp << "{\n";
+  fp << "  \"version\": \"" << TEDITOR_VERSION_INFO << "\",\n";
+  fp << "  \"size\": " << args.size << ",\n";
+  fp << "  \"benchmarks\": [\n";
+  for(size_t i = 0; i < results.size(); ++i) {
+    const auto& r = results[i];
+    // one benchmark per line, which is what 'readBaseline' relies on
+    fp << format("    {\"name\": \"%s\", \"iterations\": %d, \"min_ns\": %.1f, "
+                 "\"median_ns\": %.1f, \"mean_ns\": %.1f, "
+                 "\"items_per_sec\": %.1f", r.name.c_str(), r.iters, r.minNs,
+                 r.medianNs, r.meanNs, r.itemsPerSec);
+    if(!r.counters.empty()) {
+      fp << ", \"counters\": {";
+      for(size_t j = 0; j < r.counters.size(); ++j)
+        fp << format("%s\"%s\": %.3f", j > 0 ? ", " : "",
+                     r.counters[j].first.c_str(), r.counters[j].second);
+      fp << "}";
+    }
+    fp << (i + 1 < results.size() ? "},\n" : "}\n");
+  }
+  fp << "  ]\n}\n";
+}
+
+/** reads the median times from a JSON file written by 'writeJson' */
+std::map<std::string, double> readBaseline(const std::string& file, int& size) {
+  std::map<std::string, double> ret;
+  std::ifstream fp(file.c_str());
+  ASSERT(fp.is_open(), "Failed to open file '%s'!", file.c_str());
+  std::string line;
+  size = 0;
+  while(std::getline(fp, line)) {
+    char name[256];
+    double median;
+    if(sscanf(line.c_str(), " \"size\": %d", &size) == 1) continue;
+    if(sscanf(line.c_str(), " {\"name\": \"%255[^\"]\", \"iterations\": %*d, "
+              "\"min_ns\": %*f, \"median_ns\": %lf", name, &median) == 2)
+      ret[name] = median;
+  }
+  return ret;
+}
+
+/** returns the number of regressions */
+int compare(const Args& args, const std::vector<Result>& results) {
+  int baseSize;
+  auto base = readBaseline(args.baseline, baseSize);
+  if(baseSize != args.size)
+    printf("WARNING: baseline was run with -size %d, current with -size %d\n",
+           baseSize, args.size);
+  printf("\nComparison against the baseline '%s':\n", args.baseline.c_str());
+  printf("%-28s %14s %14s %9s\n", "Benchmark", "Base(us)", "Curr(us)",
+         "Change");
+  int regressions = 0;
+  for(const auto& r : results) {
+    auto itr = base.find(r.name);
+    if(itr == base.end()) {
+      printf("%-28s %14s %14.2f %9s\n", r.name.c_str(), "-",
+             r.medianNs / 1e3, "new");
+      continue;
+    }
+    double change = (r.medianNs - itr->second) * 100.0 / itr->second;
+    bool bad = change > args.threshold;
+    if(bad) ++regressions;
+    printf("%-28s %14.2f %14.2f %+8.1f%%%s\n", r.name.c_str(),
+           itr->second / 1e3, r.medianNs / 1e3, change,
+           bad ? "  REGRESSION" : "");
+  }
+  return regressions;
+}
+
+int main(int argc, char** argv) {
+  try {
+    Args args;
+    if(!parseBenchArgs(argc, argv, args)) return 0;
+    std::vector<FileInfo> files;
+    parseArgs(1, argv, files);  // registers all the options
+    const auto& benches = Registry::all();
+    if(args.list) {
+      for(const auto& b : benches) printf("%s\n", b.first.c_str());
+      return 0;
+    }
+    std::vector<Result> results;
+    printf("%-28s %8s %14s %14s %14s\n", "Benchmark", "Iters", "Min(us)",
+           "Median(us)", "Items/s");
+    auto report = [&results](const State& st) {
+      const auto& r = st.result();
+      printf("%-28s %8d %14.2f %14.2f %14.0f\n", r.name.c_str(), r.iters,
+             r.minNs / 1e3, r.medianNs / 1e3, r.itemsPerSec);
+      for(const auto& c : r.counters)
+        printf("    %-24s %12.3f\n", c.first.c_str(), c.second);
+      fflush(stdout);
+      results.push_back(r);
+    };
+    for(const auto& b : benches) {
+      if(b.first.find(args.filter) == std::string::npos) continue;
+      State st(b.first, args.size, args.minTime);
+      b.second(st);
+      report(st);
+    }
+    for(const auto& s : args.scripts) {
+      State st("replay:" + basename(s), args.size, args.minTime);
+      replayScript(st, slurp(s), {});
+      report(st);
+    }
+    if(!args.json.empty()) writeJson(args.json, args, results);
+    if(!args.baseline.empty()) {
+      if(!isFile(args.baseline)) {
+        printf("\nBaseline '%s' not found. Skipping comparison.\n",
+               args.baseline.c_str());
+        return 0;
+      }
+      int n = compare(args, results);
+      if(n > 0) {
+        printf("\n%d benchmark(s) regressed beyond %.1f%%!\n", n,
+               args.threshold);
+        return 1;
+      }
+    }
+    return 0;
+  } catch(const std::runtime_error& e) {
+    printf("teditor-bench: Error: %s\n", e.what());
+    return -1;
+  }
+}
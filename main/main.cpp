@@ -5,23 +5,41 @@
 #include "core/logger.h"
 #include "core/option.h"
 #include "core/file_utils.h"
+#include "core/mode.h"
+#include "core/profiler.h"
 #include <memory>
+#include <clocale>
 
 int main(int argc, char** argv) {
   using namespace teditor;
   ///@todo: add more relevant catch statements in future!
   try {
+    StartupTimeline::begin();
+    // needed for the display widths of non-ASCII chars
+    setlocale(LC_CTYPE, "");
     SingletonHandler<Logger, std::string> shl("debug.log");
     std::vector<FileInfo> files;
     if (!parseArgs(argc, argv, files)) return 0;
     Logger::setLevel(Option::get("logLevel").getInt());
+    Logger::setRotation(size_t(Option::get("logMaxSizeKB").getInt()) * 1024,
+                        Option::get("logNumBackups").getInt());
     makeDir(Option::get("homeFolder").getStr());
-    SingletonHandler<Terminal, std::string> term(Option::get("tty").getStr());
+    StartupTimeline::mark("options");
     {
+      SingletonHandler<TtyTerminal, std::string> term(
+        Option::get("tty").getStr());
+      StartupTimeline::mark("terminal");
       std::shared_ptr<Editor> ed(new Editor(files));
       ed->setTitle(Option::get("title").getStr());
+      StartupTimeline::mark("editor");
       ed->run();
     }
+    if(Option::get("profileStartup").getBool()) {
+      for(const auto& line : StartupTimeline::report())
+        printf("%s\n", line.c_str());
+      printf("Modes: %d created, %d key/color tables built\n",
+             Mode::numCreated(), Mode::numTablesBuilt());
+    }
     DEBUG("Editor: dtor finished. Closing teditor\n");
     return 0;
   } catch(const std::runtime_error& e) {
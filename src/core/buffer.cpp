@@ -3,19 +3,21 @@
 #include <unistd.h>
 #include "editor.h"
 #include "logger.h"
+#include "profiler.h"
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <iterator>
 #include "window.h"
 
 
 namespace teditor {
 
 Buffer::Buffer(const std::string& name, bool noUndoRedo):
-  lines(), startLine(0), modified(false), readOnly(false), buffName(name),
+  arena(), lines(), startLine(0), modified(false), readOnly(false), buffName(name),
   fileName(), dirName(), tmpFileName(), region(-1, -1),
-  mode(Mode::createMode("text")), cu(0, 0), longestX(0), undoStack(),
-  redoStack(), disableStack(noUndoRedo) {
+  mode(Mode::createMode("text")), keyState(KeyCmdMap::Root), cu(0, 0),
+  longestX(0), undoStack(), redoStack(), disableStack(noUndoRedo) {
   addLine();
   dirName = getpwd();
   begin();
@@ -89,7 +91,8 @@ std::string Buffer::removeChar() {
   if(cu.x == minLoc && cu.y == 0) return del;
   if(cu.x > 0) {
     left();
-    del = at(cu.y).erase(cu.x, 1);
+    auto& line = at(cu.y);
+    del = line.erase(cu.x, line.nextChar(cu.x) - cu.x);
     return del;
   }
   int oldy = cu.y;
@@ -121,34 +124,24 @@ std::string Buffer::removeFrom(const Point& start, const Point& end) {
     del = at(small.y).erase(small.x, len);
     return del;
   }
-  auto& curr = at(small.y);
-  if(small.x == curr.length()) {
-    curr.join(at(small.y + 1));
-    lines.erase(lines.begin()+small.y+1);
-    --big.y;
+  auto& first = at(small.y);
+  const auto& last = at(big.y);
+  // compute the size of the removed text upfront to avoid reallocations
+  size_t size = first.length() - small.x + big.x + big.y - small.y;
+  for(int i = small.y + 1; i < big.y; ++i) size += lengthOf(i);
+  del.reserve(size);
+  del.append(first.c_str() + small.x, first.length() - small.x);
+  for(int i = small.y + 1; i < big.y; ++i) {
     del += '\n';
-    if(big.y == small.y) {
-      del += at(small.y).erase(small.x, big.x);
-      return del;
-    }
-  }
-  bool isFullLine = small.x == 0;
-  int actualIdx = small.y;
-  del += curr.erase(small.x, curr.length()-small.x);
-  if(isFullLine)
-    lines.erase(lines.begin()+small.y);
-  else
-    ++actualIdx;
-  for(int line=small.y+1;line<big.y;++line) {
-    del += '\n';
-    del += at(actualIdx).get();
-    lines.erase(lines.begin()+actualIdx);
+    del.append(at(i).c_str(), at(i).length());
   }
   del += '\n';
-  if(big.x > 0) {
-    auto& last = at(actualIdx);
-    del += last.erase(0, big.x);
-  }
+  del.append(last.c_str(), big.x);
+  // stitch the remainder of the last line onto the first one and then remove
+  // all the lines in between in one shot
+  first.erase(small.x, first.length() - small.x);
+  first.append(last.c_str() + big.x, last.length() - big.x);
+  lines.erase(lines.begin() + small.y + 1, lines.begin() + big.y + 1);
   return del;
 }
 
@@ -158,7 +151,8 @@ std::string Buffer::removeCurrentChar() {
     return del;
   }
   if(cu.x < lengthOf(cu.y)) {
-    del = lines[cu.y].erase(cu.x, 1);
+    auto& line = lines[cu.y];
+    del = line.erase(cu.x, line.nextChar(cu.x) - cu.x);
     return del;
   }
   int y = cu.y;
@@ -171,8 +165,10 @@ std::string Buffer::removeCurrentChar() {
 }
 
 void Buffer::clear() {
-  for(auto& line : lines) line.clear();
+  // all the line contents are freed in bulk by the arena
+  arena.beginRelease();
   lines.clear();
+  arena.release();
   addLine();
   startLine = 0;
   begin();
@@ -181,6 +177,47 @@ void Buffer::clear() {
   clearStack(redoStack);
 }
 
+void Buffer::replaceLines(int start, int count, const Strings& strs) {
+  int n = (int)strs.size(), common = std::min(count, n);
+  for(int i = 0; i < common; ++i) {
+    auto& line = lines[start + i];
+    line.clear();
+    line.append(strs[i]);
+  }
+  if(n > count) {
+    std::vector<Line> extra;
+    extra.reserve(n - count);
+    for(int i = count; i < n; ++i) {
+      extra.push_back(Line(&arena));
+      extra.back().append(strs[i]);
+    }
+    lines.insert(lines.begin() + start + count,
+                 std::make_move_iterator(extra.begin()),
+                 std::make_move_iterator(extra.end()));
+  } else if(n < count) {
+    lines.erase(lines.begin() + start + n, lines.begin() + start + count);
+  }
+  if(lines.empty()) addLine();
+  // lines after the replaced ones just get shifted
+  int delta = n - count, last = length() - 1;
+  if(cu.y >= start + count) cu.y += delta;
+  if(startLine >= start + count) startLine += delta;
+  cu.y = std::min(std::max(cu.y, 0), last);
+  cu.x = std::min(cu.x, lengthOf(cu.y));
+  startLine = std::min(std::max(startLine, 0), last);
+  stopRegion();
+  clearStack(undoStack);
+  clearStack(redoStack);
+}
+
+Buffer::MemStats Buffer::memStats() const {
+  MemStats ms;
+  ms.numLines = lines.size();
+  ms.lineBytes = lines.capacity() * sizeof(Line);
+  ms.arena = arena.stats();
+  return ms;
+}
+
 std::string Buffer::killLine(bool pushToStack) {
   OpData op;
   op.type = OpKillLine;
@@ -193,7 +230,7 @@ std::string Buffer::killLine(bool pushToStack) {
       op.str = "";
     } else {
       auto& next = lines.at(cu.y + 1);
-      line.insert(next.get(), cu.x);
+      line.insert(next.c_str(), cu.x);
       lines.erase(lines.begin() + cu.y + 1);
       op.str = "\n";
     }
@@ -222,6 +259,10 @@ bool Buffer::undo() {
     }
     addLines(top.rlines);
     cu = top.before;
+  } else if(top.type == OpSortLines) {
+    revertPermutation(top);
+    cu = top.before;
+    modified = true;
   }
   redoStack.push(top);
   undoStack.pop();
@@ -241,6 +282,11 @@ bool Buffer::redo() {
   } else if(top.type == OpKeepRemoveLines) {
     removeLines(top.rlines);
     cu = top.before;
+  } else if(top.type == OpSortLines) {
+    applyPermutation(top.permStart, top.perm,
+                     (int)(top.perm.size() - top.rlines.size()), nullptr);
+    cu = top.after;
+    modified = true;
   }
   undoStack.push(top);
   redoStack.pop();
@@ -252,7 +298,8 @@ void Buffer::applyInsertOp(OpData& op, bool pushToStack) {
     op.before = cu;
   else
     cu = op.before;
-  for (auto c : op.str) insertImpl(c);
+  if(op.str.length() == 1) insertImpl(op.str[0]);
+  else insertImpl(op.str);
   modified = true;
   if(pushToStack) {
     op.after = cu;
@@ -266,14 +313,50 @@ void Buffer::applyInsertOp(OpData& op, bool pushToStack) {
 void Buffer::insertImpl(char c) {
   if(c == '\n' || c == (char)Key_Enter) {
     auto newLine = at(cu.y).split(cu.x);
-    lines.insert(lines.begin() + cu.y + 1, newLine);
+    lines.insert(lines.begin() + cu.y + 1, std::move(newLine));
     cu.x = 0;
     ++cu.y;
     return;
   }
   auto& line = lines[cu.y];
   line.insert(c, cu.x);
-  right();
+  ++cu.x;
+  saveLongestX();
+}
+
+void Buffer::insertImpl(const std::string& str) {
+  if(str.empty()) return;
+  auto isNewLine = [](char c) { return c == '\n' || c == (char)Key_Enter; };
+  const char* data = str.c_str();
+  int len = (int)str.length();
+  int pos = 0;
+  while(pos < len && !isNewLine(data[pos])) ++pos;
+  auto& line = lines[cu.y];
+  // fast path: no newlines in the input
+  if(pos == len) {
+    line.insert(str, cu.x);
+    cu.x += len;
+    saveLongestX();
+    return;
+  }
+  auto tail = line.split(cu.x);
+  line.append(data, pos);
+  std::vector<Line> newLines;
+  newLines.reserve(std::count_if(str.begin() + pos, str.end(), isNewLine));
+  while(pos < len) {
+    int start = ++pos;
+    while(pos < len && !isNewLine(data[pos])) ++pos;
+    newLines.push_back(Line(&arena));
+    newLines.back().append(data + start, pos - start);
+  }
+  auto& last = newLines.back();
+  cu.x = last.length();
+  last.join(tail);
+  lines.insert(lines.begin() + cu.y + 1,
+               std::make_move_iterator(newLines.begin()),
+               std::make_move_iterator(newLines.end()));
+  cu.y += (int)newLines.size();
+  saveLongestX();
 }
 
 void Buffer::applyDeleteOp(OpData& op) {
@@ -300,8 +383,8 @@ void Buffer::clearStack(OpStack& st) {
 }
 ////// End: Buffer undo/redo //////
 
-const AttrColor& Buffer::getColor(const std::string& name) const {
-  return mode->getColorMap().get(name);
+const AttrColor& Buffer::getColor(ColorSlot id) const {
+  return mode->getColorMap().get(id);
 }
 
 std::string Buffer::regionAsStr() const {
@@ -315,22 +398,21 @@ std::string Buffer::regionAsStr(const Point& start, const Point& end) const {
   Point small, big;
   if(0 == start.find(small, big, end)) {
     int len = big.x - small.x;
-    const auto& line = at(small.y);
-    auto out = line.get().substr(small.x, len);
-    return out;
+    return std::string(at(small.y).c_str() + small.x, len);
   }
-  std::string out = at(small.y).get().substr(small.x);
+  const auto& first = at(small.y);
+  std::string out(first.c_str() + small.x, first.length() - small.x);
   for(int i=small.y+1;i<big.y;++i) {
     out += '\n';
-    out += at(i).get();
+    out.append(at(i).c_str(), at(i).length());
   }
   out += '\n';
-  const auto& line = at(big.y);
-  out += line.get().substr(0, big.x);
+  out.append(at(big.y).c_str(), big.x);
   return out;
 }
 
 void Buffer::load(const std::string& file, int line) {
+  PROBE(BufferLoad);
   ASSERT(isAbs(file), "Buffer::load file must be abs-path! '%s'", file.c_str());
   bool dir = isDir(file);
   dir ? loadDir(file) : loadFile(file, line);
@@ -362,15 +444,24 @@ void Buffer::loadFile(const std::string& file, int line) {
   } else {
     inFile = file;
   }
-  std::fstream fp;
-  fp.open(inFile.c_str(), std::fstream::in);
+  std::ifstream fp(inFile.c_str(), std::ios::in | std::ios::binary);
   if(fp.is_open()) {
-    std::string currLine;
-    while(std::getline(fp, currLine, '\n')) {
-      lines.back().append(currLine);
+    // read the whole file in one shot and then split it into lines
+    fp.seekg(0, std::ios::end);
+    std::string data((size_t)std::max<std::streamoff>(fp.tellg(), 0), '\0');
+    fp.seekg(0, std::ios::beg);
+    fp.read(&data[0], data.size());
+    data.resize((size_t)fp.gcount());
+    fp.close();
+    lines.reserve(lines.size() + std::count(data.begin(), data.end(), '\n') + 1);
+    size_t start = 0, len = data.size();
+    while(start < len) {
+      auto pos = data.find('\n', start);
+      if(pos == std::string::npos) pos = len;
+      lines.back().append(data.c_str() + start, (int)(pos - start));
       addLine();
+      start = pos + 1;
     }
-    fp.close();
   }
   line = std::min(std::max(0, line), length() - 1);
   resetBufferState(line, file, false);
@@ -389,25 +480,30 @@ void Buffer::resetBufferState(int line, const std::string& file, bool dir) {
 }
 
 void Buffer::draw(Editor& ed, const Window& win) {
+  mode->beforeDraw(*this);
   const auto& start = win.start();
   const auto& dim = win.dim();
   // draw current buffer (-1 for the status bar)
   int h = start.y + dim.y - 1;
   int len = length();
   for(int y = start.y, idx = startLine; y < h && idx < len; ++idx)
-    y = drawLine(y, lines[idx].get(), ed, idx, win);
+    y = drawLine(y, lines[idx], ed, idx, win);
   drawStatusBar(ed, win);
 }
 
 void Buffer::drawPoint(Editor& ed, const AttrColor& bg, const Window& win) {
   const auto& start = win.start();
   const auto& dim = win.dim();
-  const auto& fg = getColor("cursorfg");
-  char c = charAt(cu);
+  const auto& fg = getColor(Slot_cursorfg);
   auto screenloc = buffer2screen(cu, start, dim);
   DEBUG("drawPoint: x,y=%d,%d sloc=%d,%d start=%d\n", cu.x, cu.y, screenloc.x,
         screenloc.y, startLine);
-  ed.sendChar(screenloc.x, screenloc.y, fg, bg, c);
+  const auto& line = at(cu.y);
+  int n = line.nextChar(cu.x) - cu.x;
+  if(cu.x < line.length() && n > 1)
+    ed.sendString(screenloc.x, screenloc.y, fg, bg, line.c_str() + cu.x, n);
+  else
+    ed.sendChar(screenloc.x, screenloc.y, fg, bg, charAt(cu));
 }
 
 void Buffer::drawStatusBar(Editor& ed, const Window& win) {
@@ -420,9 +516,9 @@ void Buffer::drawStatusBar(Editor& ed, const Window& win) {
   int x = start.x;
   // -1 is for the status bar
   int y = start.y + dim.y - 1;
-  const auto& fg = getColor("statusfg");
-  const auto& bg = getColor("statusbg");
-  const auto& namefg = getColor("statusnamefg");
+  const auto& fg = getColor(Slot_statusfg);
+  const auto& bg = getColor(Slot_statusbg);
+  const auto& namefg = getColor(Slot_statusnamefg);
   ed.sendString(x, y, fg, bg, line.c_str(), dim.x);
   int count = 0;
   // mode
@@ -442,35 +538,45 @@ void Buffer::drawStatusBar(Editor& ed, const Window& win) {
 
 std::string Buffer::dirModeGetFileAtLine(int line) {
   if(line == 0) return "";
-  auto& str = at(line).get();
+  auto str = at(line).get();
   if (str.empty()) return "";
   return str.substr(dirModeFileOffset());
 }
 
-int Buffer::drawLine(int y, const std::string& line, Editor& ed, int lineNum,
+int Buffer::drawLine(int y, const Line& line, Editor& ed, int lineNum,
                      const Window& win) {
   const auto& st = win.start();
   const auto& dim = win.dim();
-  int xStart = st.x, wid = dim.x, start = 0;
-  int len = (int)line.size();
+  int xStart = st.x, wid = dim.x;
+  int len = line.length();
   const auto* str = line.c_str();
-  ULTRA_DEBUG("Buffer::drawLine: y=%d line=%s len=%d\n", y, line.c_str(), len);
-  auto maxLen = std::max(len, wid);
-  while(start < maxLen) {
-    int diff = maxLen - start;
-    int count = std::min(diff, wid);
-    for(int i = 0; i < count; ++i) {
-      // under the highlighted region
-      auto c = start + i < len ? str[start + i] : ' ';
-      auto highlighted = region.isInside(lineNum, start + i, cu);
-      AttrColor fg, bg;
-      mode->getColorFor(fg, bg, lineNum, start + i, *this, highlighted);
-      ed.sendChar(xStart + i, y, fg, bg, c);
+  ULTRA_DEBUG("Buffer::drawLine: y=%d line=%s len=%d\n", y, str, len);
+  AttrColor fg, bg;
+  int x, row, prevRow = 0, prevEnd = 0;
+  auto pad = [&](int from, int to, int r, int idx) {
+    for(int i = from; i < to; ++i, ++idx) {
+      auto highlighted = region.isInside(lineNum, idx, cu);
+      mode->getColorFor(fg, bg, lineNum, idx, *this, highlighted);
+      ed.sendChar(xStart + i, y + r, fg, bg, ' ');
     }
-    start += wid;
-    ++y;
+  };
+  for(int i = 0; i < len;) {
+    int next = line.nextChar(i);
+    line.screenPos(i, wid, x, row);
+    // the gap left behind by a wide char moved to the next row
+    if(row != prevRow) pad(prevEnd, wid, prevRow, i);
+    auto highlighted = region.isInside(lineNum, i, cu);
+    mode->getColorFor(fg, bg, lineNum, i, *this, highlighted);
+    if(next - i > 1) ed.sendString(xStart + x, y + row, fg, bg, str + i, next - i);
+    else ed.sendChar(xStart + x, y + row, fg, bg, str[i]);
+    prevRow = row;
+    prevEnd = x + line.byte2col(next) - line.byte2col(i);
+    i = next;
   }
-  ULTRA_DEBUG("Buffer::drawLine: ended y=%d line=%s\n", y, line.c_str());
+  // fill the rest of a line shorter than the window with blanks
+  if(prevRow == 0 && prevEnd < wid) pad(prevEnd, wid, 0, len);
+  y += line.numLinesNeeded(wid);
+  ULTRA_DEBUG("Buffer::drawLine: ended y=%d line=%s\n", y, str);
   return y;
 }
 
@@ -479,9 +585,12 @@ Point Buffer::buffer2screen(const Point& loc, const Point& start,
   int w = dim.x;
   Point ret = start;
   int relY = loc.y - startLine;
-  for(int idx=0;idx<relY;++idx) ret.y += lines[idx].numLinesNeeded(w);
-  ret.y += (loc.x / w);
-  ret.x += loc.x % w;
+  for(int idx=0;idx<relY;++idx)
+    ret.y += lines[startLine + idx].numLinesNeeded(w);
+  int x, row;
+  at(loc.y).screenPos(loc.x, w, x, row);
+  ret.y += row;
+  ret.x += x;
   return ret;
 }
 
@@ -493,7 +602,7 @@ Point Buffer::screen2buffer(const Point& loc, const Point& start,
   for(;sy<=rel.y;++res.y) sy += at(res.y).numLinesNeeded(w);
   if(sy > rel.y) --res.y;
   int dely = rel.y - sy + at(res.y).numLinesNeeded(w);
-  res.x = dely * w + rel.x;
+  res.x = at(res.y).screenIdx(rel.x, dely, w);
   return res;
 }
 
@@ -510,16 +619,20 @@ void Buffer::keepRemoveLines(parser::NFA& regex, bool keep) {
     small = {0, cu.y};
     big = {0, length() - 1};
   }
+  // single stable compaction pass over the lines of interest
+  int pos = small.y;
   for(int i = small.y; i <= big.y; ++i) {
-    auto str = at(i).get();
+    const auto& str = at(i).get();
     size_t tmp;
     bool match = regex.findAny(str, tmp) != parser::NFA::NoMatch;
-    if((match && keep) || (!match && !keep)) continue;
-    lines.erase(lines.begin() + i);
+    if((match && keep) || (!match && !keep)) {
+      if(pos != i) lines[pos] = std::move(lines[i]);
+      ++pos;
+      continue;
+    }
     op.rlines.push_back({str, i});
-    --big.y;
-    --i;
   }
+  lines.erase(lines.begin() + pos, lines.begin() + big.y + 1);
   if(!op.rlines.empty()) {
     begin();
     modified = true;
@@ -530,20 +643,32 @@ void Buffer::keepRemoveLines(parser::NFA& regex, bool keep) {
 }
 
 void Buffer::addLines(const RemovedLines& rlines) {
-  // insert from back of the vector to restore the original state!
-  for(int i = (int)rlines.size() - 1; i >= 0; --i) {
-    const auto& rl = rlines[i];
-    lines.insert(lines.begin() + rl.num, Line());
-    lines[rl.num].append(rl.str);
+  // merge the removed lines back at their original locations in one pass
+  std::vector<Line> merged;
+  merged.reserve(lines.size() + rlines.size());
+  size_t src = 0;
+  for(const auto& rl : rlines) {
+    while((int)merged.size() < rl.num && src < lines.size())
+      merged.push_back(std::move(lines[src++]));
+    merged.push_back(Line(&arena));
+    merged.back().append(rl.str);
   }
+  for(; src < lines.size(); ++src) merged.push_back(std::move(lines[src]));
+  lines.swap(merged);
 }
 
 void Buffer::removeLines(const RemovedLines& rlines) {
-  // remove from back of the vector to restore the original state!
-  for(int i = (int)rlines.size() - 1; i >= 0; --i) {
-    const auto& rl = rlines[i];
-    lines.erase(lines.begin() + rl.num);
+  int len = length(), pos = 0;
+  size_t idx = 0;
+  for(int i = 0; i < len; ++i) {
+    if(idx < rlines.size() && rlines[idx].num == i) {
+      ++idx;
+      continue;
+    }
+    if(pos != i) lines[pos] = std::move(lines[i]);
+    ++pos;
   }
+  lines.erase(lines.begin() + pos, lines.end());
   // ensure that you don't segfault on full buffer removal!
   if(length() <= 0) addLine();
 }
@@ -555,8 +680,7 @@ bool Buffer::matchCurrentParen() {
 }
 
 Point Buffer::matchCurrentParen(bool& isOpen) {
-  const auto& line = at(cu.y).get();
-  char c = line[cu.x];
+  char c = at(cu.y).c_str()[cu.x];
   char mc = getMatchingParen(c);
   std::stack<char> st;
   if(isOpenParen(c)) {
@@ -565,7 +689,7 @@ Point Buffer::matchCurrentParen(bool& isOpen) {
     for(int y=cu.y;y<len;++y) {
       int x = (y == cu.y)? cu.x : 0;
       int xlen = lengthOf(y);
-      const auto& str = at(y).get();
+      const auto* str = at(y).c_str();
       for(;x<xlen;++x) {
         if(str[x] == c)
           st.push(c);
@@ -579,7 +703,7 @@ Point Buffer::matchCurrentParen(bool& isOpen) {
     isOpen = false;
     for(int y=cu.y;y>=0;--y) {
       int x = (y == cu.y)? cu.x : lengthOf(y);
-      const auto& str = at(y).get();
+      const auto* str = at(y).c_str();
       for(;x>=0;--x) {
         if(str[x] == c)
           st.push(c);
@@ -593,14 +717,54 @@ Point Buffer::matchCurrentParen(bool& isOpen) {
   return cu;
 }
 
-void Buffer::sortRegion() {
+void Buffer::sortRegion(int flags) {
+  if(!isRegionActive()) return;
+  OpData op;
+  op.type = OpSortLines;
+  op.before = cu;
+  Point small, big;
+  cu.find(small, big, region);
+  int numKept;
+  DEBUG("sortRegion: start=%d end=%d flags=%d\n", small.y, big.y, flags);
+  op.permStart = small.y;
+  op.perm = sortPermutation(lines, small.y, big.y + 1, flags, numKept);
+  applyPermutation(op.permStart, op.perm, numKept, &op.rlines);
+  DEBUG("sortRegion: done numKept=%d\n", numKept);
   modified = true;
-  int cuy = cu.y;
-  int ry = region.y;
-  DEBUG("sortRegion: cuy=%d ry=%d\n", cuy, ry);
-  std::sort(lines.begin()+ry, lines.begin()+cuy+1, LineCompare);
-  DEBUG("sortRegion: done\n");
-  cu.x = lines[cuy].length();
+  cu.y = small.y + numKept - 1;
+  cu.x = lengthOf(cu.y);
+  saveLongestX();
+  op.after = cu;
+  pushNewOp(op);
+}
+
+void Buffer::applyPermutation(int start, const std::vector<int>& perm,
+                              int numKept, RemovedLines* rlines) {
+  int len = (int)perm.size();
+  std::vector<Line> sorted;
+  sorted.reserve(numKept);
+  for(int i = 0; i < numKept; ++i)
+    sorted.push_back(std::move(lines[start + perm[i]]));
+  // rest are the duplicates removed
+  if(rlines != nullptr) {
+    for(int i = numKept; i < len; ++i) {
+      int idx = start + perm[i];
+      rlines->push_back({lines[idx].get(), idx});
+    }
+  }
+  std::move(sorted.begin(), sorted.end(), lines.begin() + start);
+  lines.erase(lines.begin() + start + numKept, lines.begin() + start + len);
+}
+
+void Buffer::revertPermutation(const OpData& op) {
+  int start = op.permStart, len = (int)op.perm.size();
+  int numKept = len - (int)op.rlines.size();
+  std::vector<Line> orig(len, Line(&arena));
+  for(int i = 0; i < numKept; ++i)
+    orig[op.perm[i]] = std::move(lines[start + i]);
+  for(const auto& rl : op.rlines) orig[rl.num - start].append(rl.str);
+  lines.insert(lines.begin() + start + numKept, len - numKept, Line(&arena));
+  std::move(orig.begin(), orig.end(), lines.begin() + start);
 }
 
 char Buffer::charAt(const Point& pos) const {
@@ -636,6 +800,7 @@ void Buffer::lineEnd(const Point& start, const Point& dim) {
 }
 
 bool Buffer::save(const std::string& fName) {
+  PROBE(BufferSave);
   auto f = fName;
   if(f.empty()) f = fileName;
   if(f.empty()) return false;
@@ -652,7 +817,8 @@ bool Buffer::save(const std::string& fName) {
   for(int i=0;i<len;++i) {
     // don't write the final line if it is empty
     if(i == len-1 && lines[i].empty()) continue;
-    fp << lines[i].get() << "\n";
+    fp.write(lines[i].c_str(), lines[i].length());
+    fp << "\n";
   }
   fp.close();
   if (!isRemote(fileName)) {
@@ -669,7 +835,7 @@ bool Buffer::save(const std::string& fName) {
 ////// Start: Cursor movements //////
 void Buffer::left() {
   int minLoc = getMinStartLoc();
-  --cu.x;
+  cu.x = at(cu.y).prevChar(cu.x);
   if(cu.x < minLoc) {
     if(cu.y >= 1) {
       --cu.y;
@@ -680,11 +846,11 @@ void Buffer::left() {
     }
   }
   lineDown();
-  longestX = cu.x;
+  saveLongestX();
 }
 
 void Buffer::right() {
-  ++cu.x;
+  cu.x = at(cu.y).nextChar(cu.x);
   if(cu.x > lengthOf(cu.y)) {
     if(cu.y < length()-1) {
       ++cu.y;
@@ -692,20 +858,20 @@ void Buffer::right() {
     } else
       --cu.x;
   }
-  longestX = cu.x;
+  saveLongestX();
 }
 
 void Buffer::down() {
   if(cu.y < length()-1) {
     ++cu.y;
-    cu.x = std::min(lengthOf(cu.y), longestX);
+    restoreLongestX();
   }
 }
 
 void Buffer::up() {
   if(cu.y >= 1) {
     --cu.y;
-    cu.x = std::min(lengthOf(cu.y), longestX);
+    restoreLongestX();
   }
   lineDown();
 }
@@ -717,18 +883,19 @@ void Buffer::begin() {
 
 void Buffer::end() {
   cu.y = std::max(0, length() - 1);
-  longestX = cu.x = lengthOf(cu.y);
+  cu.x = lengthOf(cu.y);
+  saveLongestX();
 }
 
 void Buffer::pageDown(int ijump) {
   cu.y = std::min(length() - 1, cu.y + ijump);
-  cu.x = std::min(lengthOf(cu.y), longestX);
+  restoreLongestX();
 }
 
 void Buffer::pageUp(int ijump) {
   cu.y = std::max(0, cu.y - ijump);
   lineDown();
-  cu.x = std::min(lengthOf(cu.y), longestX);
+  restoreLongestX();
 }
 
 void Buffer::nextPara() {
@@ -739,7 +906,7 @@ void Buffer::nextPara() {
     prevLen = lengthOf(cu.y);
   }
   cu.y = std::min(cu.y, len-1);
-  cu.x = std::min(lengthOf(cu.y), longestX);
+  restoreLongestX();
 }
 
 void Buffer::previousPara() {
@@ -750,7 +917,7 @@ void Buffer::previousPara() {
   }
   cu.y = std::max(cu.y, 0);
   lineDown();
-  cu.x = std::min(lengthOf(cu.y), longestX);
+  restoreLongestX();
 }
 
 void Buffer::nextWord() {
@@ -770,7 +937,7 @@ void Buffer::nextWord() {
     cu.x = line.findFirstNotOf(word, cu.x + 1);
     break;
   }
-  longestX = cu.x;
+  saveLongestX();
 }
 
 void Buffer::previousWord() {
@@ -791,7 +958,7 @@ void Buffer::previousWord() {
     break;
   }
   lineDown();
-  longestX = cu.x;
+  saveLongestX();
 }
 
 void Buffer::gotoLine(int lineNum, const Point& dim) {
@@ -7,6 +7,7 @@
 #include "key_cmd_map.h"
 #include "command.h"
 #include "line.h"
+#include "line_sort.h"
 #include "mode.h"
 #include "pos2d.h"
 #include <stack>
@@ -52,8 +53,11 @@ public:
   std::string removeRegion(const Point& start, const Point& end);
   /** kills lines at current cursor location onwards */
   std::string killLine(bool pushToStack=true);
-  /** sorts the lines in the region */
-  void sortRegion();
+  /**
+   * @brief sorts the lines in the region
+   * @param flags bitwise OR of `SortFlags` to control the sort behavior
+   */
+  void sortRegion(int flags=Sort_Default);
   /**
    * @brief Keep/Remove lines that match the input regex.
    * @param regex the regular expression that needs to be matched
@@ -62,6 +66,13 @@ public:
   void keepRemoveLines(parser::NFA& regex, bool keep);
   /** clear buffer contents */
   virtual void clear();
+  /**
+   * @brief Replaces 'count' lines starting at 'start' with the given ones. This
+   * is meant for buffers whose contents are generated programmatically, hence
+   * it is not undoable (and it clears the undo/redo stacks). Cursor and the
+   * scroll position stay on the same lines as long as they are not replaced.
+   */
+  void replaceLines(int start, int count, const Strings& strs);
   /** @} */
 
   /**
@@ -125,9 +136,9 @@ public:
    * @{
    */
   /** move to begining of line */
-  void startOfLine() { longestX = cu.x = getMinStartLoc(); }
+  void startOfLine() { cu.x = getMinStartLoc(); saveLongestX(); }
   /** move to end of line */
-  void endOfLine() { longestX = cu.x = lengthOf(cu.y); }
+  void endOfLine() { cu.x = lengthOf(cu.y); saveLongestX(); }
   /** move left */
   void left();
   /** move right */
@@ -186,6 +197,17 @@ public:
   /** length of a given line in this buffer */
   int lengthOf(int i) const { return lines[i].length(); }
 
+  /** memory footprint of the contents of this buffer */
+  struct MemStats {
+    /** number of lines */
+    size_t numLines;
+    /** bytes of the line objects themselves (including unused capacity) */
+    size_t lineBytes;
+    /** counters of the arena storing the longer lines */
+    ArenaStats arena;
+  };
+  MemStats memStats() const;
+
   /** indent the current line */
   void indent();
 
@@ -206,11 +228,11 @@ public:
   std::string dirModeGetFileAtLine(int line);
 
   void reload();
-  const AttrColor& getColor(const std::string& name) const;
+  const AttrColor& getColor(ColorSlot id) const;
   const std::string& getWord() const { return mode->word(); }
   const std::string& modeName() const { return mode->name(); }
   void makeReadOnly();
-  void setMode(ModePtr m) { mode = m; }
+  void setMode(ModePtr m) { mode = m; keyState = KeyCmdMap::Root; }
 
   template <typename ModeT>
   ModeT* getMode(const std::string& name) {
@@ -226,7 +248,7 @@ protected:
   struct RemovedLine {
     /** the removed line */
     std::string str;
-    /** line number */
+    /** line number (in the buffer before the removal) */
     int num;
   };
   /** list of removed lines */
@@ -243,6 +265,8 @@ protected:
     OpKillLine,
     /** keep/remove lines */
     OpKeepRemoveLines,
+    /** sorting of lines */
+    OpSortLines,
   };
 
 
@@ -257,8 +281,12 @@ protected:
     Point after;
     /** characters that were inserted/deleted in the above range */
     std::string str;
-    /** for keep/remove lines */
+    /** for keep/remove lines (and the duplicates removed while sorting) */
     RemovedLines rlines;
+    /** for sorting, the order in which lines were arranged */
+    std::vector<int> perm;
+    /** for sorting, the first line from where the permutation applies */
+    int permStart;
     /** type of operation */
     OpType type;
   }; // end class OpData
@@ -268,6 +296,8 @@ protected:
   typedef std::stack<OpData> OpStack;
 
 
+  /** storage for the contents of the lines (must outlive them!) */
+  LineArena arena;
   std::vector<Line> lines;
   int startLine;
   bool modified, readOnly;
@@ -276,9 +306,14 @@ protected:
   Point region;
   ///@todo: support applying multiple modes
   ModePtr mode;
+  /**
+   * state of the key sequence typed so far in this buffer. It is kept here, as
+   * the key bindings are shared by all the buffers of a mode
+   */
+  int keyState;
   /** cursor */
   Point cu;
-  /** cursor's longest 'x' location */
+  /** cursor's longest display column (to be retained across lines) */
   int longestX;
   /** stack of operations for undo */
   OpStack undoStack;
@@ -289,7 +324,13 @@ protected:
 
 
   void insertImpl(char c);
-  void addLine() { lines.push_back(Line()); }
+  /**
+   * @brief Bulk insertion of a string at the current cursor location. The
+   * input is split on newlines only once and all the resulting lines are
+   * spliced into the buffer in one go.
+   */
+  void insertImpl(const std::string& str);
+  void addLine() { lines.push_back(Line(&arena)); }
   void resetBufferState(int line, const std::string& file, bool dir);
   KeyCmdMap& getKeyCmdMap() { return mode->getKeyCmdMap(); }
   void loadFile(const std::string& file, int line);
@@ -304,10 +345,18 @@ protected:
    * @{
    */
   void drawStatusBar(Editor& ed, const Window& win);
-  virtual int drawLine(int y, const std::string& line, Editor& ed, int lineNum,
+  virtual int drawLine(int y, const Line& line, Editor& ed, int lineNum,
                        const Window &win);
   /** @} */
 
+  /**
+   * @defgroup LongestX Retaining the cursor column during vertical movements
+   * @{
+   */
+  void saveLongestX() { longestX = lines[cu.y].byte2col(cu.x); }
+  void restoreLongestX() { cu.x = lines[cu.y].col2byte(longestX); }
+  /** @} */
+
   /**
    * @defgroup BufferOpsImpl Internal buffer edit operations
    * @{
@@ -338,6 +387,17 @@ protected:
   void addLines(const RemovedLines& rlines);
   /** remove the lines as part of the redo operation on keepRemoveLines */
   void removeLines(const RemovedLines& rlines);
+  /**
+   * @brief Rearrange lines according to the permutation computed by sorting
+   * @param start first line from where the permutation applies
+   * @param perm the permutation (as returned by `sortPermutation`)
+   * @param numKept number of lines to be kept
+   * @param rlines if not null, the duplicate lines removed are stored here
+   */
+  void applyPermutation(int start, const std::vector<int>& perm, int numKept,
+                        RemovedLines* rlines);
+  /** undo the effect of the above method */
+  void revertPermutation(const OpData& op);
   /**
    * pushing a new op onto the undo stack. It has the side-effect of clearing
    * the redo stack so far accumulated!
@@ -3,6 +3,9 @@
 #endif
 
 #include "cell_buffer.h"
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
 #include <wchar.h>
 
 
@@ -34,21 +37,133 @@ bool operator==(const Cell& a, const Cell& b) {
   return (a.ch == b.ch) && (a.fg == b.fg) && (a.bg == b.bg);
 }
 
-CellBuffer::CellBuffer(int w, int h): width(w), height(h), cells(w*h) {
+static uint64_t mix(uint64_t h, const Cell& c) {
+  uint64_t v;
+  memcpy(&v, &c, sizeof(v));
+  h = (h ^ v) * 0x9e3779b97f4a7c15ULL;
+  return h ^ (h >> 32);
+}
+
+static const uint64_t HashSeed = 0xcbf29ce484222325ULL;
+
+CellBuffer::CellBuffer(int w, int h): width(w), height(h), cells(w*h),
+                                      hashes(h), dirty(h, true) {
 }
 
 void CellBuffer::clear(AttrColor fg, AttrColor bg) {
-  int len = width * height;
-  for(int i=0;i<len;++i) {
-    cells[i].set(' ', fg, bg);
+  Cell blank = {' ', fg, bg};
+  uint64_t hash = HashSeed;
+  for(int x=0;x<width;++x) hash = mix(hash, blank);
+  for(int y=0;y<height;++y) {
+    // untouched since it was last cleared with the same colors
+    if(!dirty[y] && hashes[y] == hash) continue;
+    auto itr = cells.begin() + y*width;
+    std::fill(itr, itr + width, blank);
+    hashes[y] = hash;
+    dirty[y] = false;
   }
 }
 
 void CellBuffer::resize(int w, int h) {
   if(width == w && height == h) return;
   cells.resize(w*h);
+  hashes.resize(h);
+  dirty.assign(h, true);
   width = w;
   height = h;
 }
 
+uint64_t CellBuffer::rowHash(int y) const {
+  if(!dirty[y]) return hashes[y];
+  uint64_t hash = HashSeed;
+  const auto* r = row(y);
+  for(int x=0;x<width;++x) hash = mix(hash, r[x]);
+  hashes[y] = hash;
+  dirty[y] = false;
+  return hash;
+}
+
+bool CellBuffer::sameRow(int y, const CellBuffer& other, int oy) const {
+  if(width != other.width) return false;
+  if(!dirty[y] && !other.dirty[oy] && hashes[y] != other.hashes[oy])
+    return false;
+  return memcmp(row(y), other.row(oy), sizeof(Cell) * width) == 0;
+}
+
+void CellBuffer::copyRow(int y, const CellBuffer& other) {
+  memcpy(cells.data() + y*width, other.row(y), sizeof(Cell) * width);
+  hashes[y] = other.hashes[y];
+  dirty[y] = other.dirty[y];
+}
+
+void CellBuffer::scroll(int top, int bot, int n) {
+  int m = n > 0 ? n : -n;
+  if(m == 0 || top < 0 || bot >= height || bot - top < m) return;
+  int len = bot - top + 1 - m;
+  int from = n > 0 ? top + m : top, to = n > 0 ? top : top + m;
+  memmove(cells.data() + to*width, cells.data() + from*width,
+          sizeof(Cell) * width * len);
+  memmove(hashes.data() + to, hashes.data() + from, sizeof(uint64_t) * len);
+  memmove(dirty.data() + to, dirty.data() + from, len);
+  Cell invalid = {~Chr(0), AttrColor(), AttrColor()};
+  int exposed = n > 0 ? bot - m + 1 : top;
+  std::fill(cells.begin() + exposed*width,
+            cells.begin() + (exposed + m)*width, invalid);
+  std::fill(dirty.begin() + exposed, dirty.begin() + exposed + m, true);
+}
+
+
+// scrolls which bring in fewer rows than this aren't worth it
+static const int MinScrollGain = 2;
+
+int findScroll(const CellBuffer& front, const CellBuffer& back, int& top,
+               int& bot) {
+  int h = (int)back.h();
+  if(front.w() != back.w() || front.h() != back.h()) return 0;
+  std::vector<uint64_t> fh(h), bh(h);
+  std::vector<char> same(h);
+  int changed = 0;
+  for(int y=0;y<h;++y) {
+    fh[y] = front.rowHash(y);
+    bh[y] = back.rowHash(y);
+    same[y] = fh[y] == bh[y];
+    if(!same[y]) ++changed;
+  }
+  if(changed < MinScrollGain) return 0;
+  int best = 0, bestGain = MinScrollGain - 1;
+  for(int m=1;m<h;++m) {
+    for(int n : {m, -m}) {
+      // runs of rows with back[y] == front[y + n]
+      int y = n > 0 ? 0 : m, end = n > 0 ? h - m : h;
+      while(y < end) {
+        if(bh[y] != fh[y + n]) {
+          ++y;
+          continue;
+        }
+        int start = y, gain = 0;
+        for(;y<end && bh[y]==fh[y+n];++y) if(!same[y]) ++gain;
+        // rows exposed by the scroll will have to be redrawn
+        int exposed = n > 0 ? y : start - m;
+        for(int e=exposed;e<exposed+m;++e) if(same[e]) --gain;
+        if(gain <= bestGain) continue;
+        bestGain = gain;
+        best = n;
+        top = n > 0 ? start : start - m;
+        bot = n > 0 ? y - 1 + m : y - 1;
+      }
+    }
+  }
+  if(best == 0) return 0;
+  // rows differing only in a few cells are cheaper to be redrawn in place,
+  // whereas the rows exposed by a scroll have to be redrawn fully
+  int w = (int)back.w(), inPlace = 0;
+  for(int y=top;y<=bot;++y) {
+    if(same[y]) continue;
+    const auto* b = back.row(y);
+    const auto* f = front.row(y);
+    for(int x=0;x<w;++x) if(!(b[x] == f[x])) ++inPlace;
+  }
+  return std::abs(best) * w < inPlace ? best : 0;
+}
+
 } // end namespace teditor
@@ -22,21 +22,97 @@ struct Cell {
 
 bool operator==(const Cell& a, const Cell& b);
 
+static_assert(sizeof(Cell) == sizeof(Chr) + 2 * sizeof(AttrColor),
+              "Cell is expected to have no padding!");
 
-/** list of cells */
+
+/**
+ * @brief Cells of the screen, stored row after row. Since a cell has no
+ * padding, rows can be compared and copied as raw memory. Every row also has
+ * a hash of its contents, which is recomputed lazily only for those rows that
+ * have been written into since then.
+ */
 class CellBuffer {
 public:
   CellBuffer(int w=0, int h=0);
+  /** resets all cells, while skipping the rows which are already so */
   void clear(AttrColor fg, AttrColor bg);
   void resize(int w, int h);
   const Cell& at(int x, int y) const { return cells[y*width+x]; }
-  Cell& at(int x, int y) { return cells[y*width+x]; }
+  Cell& at(int x, int y) {
+    dirty[y] = true;
+    return cells[y*width+x];
+  }
+  const Cell* row(int y) const { return cells.data() + y*width; }
   unsigned w() const { return (unsigned)width; }
   unsigned h() const { return (unsigned)height; }
 
+  uint64_t rowHash(int y) const;
+  /** whether the given row is the same as the other buffer's row 'oy' */
+  bool sameRow(int y, const CellBuffer& other, int oy) const;
+  /** copies the whole of the other buffer's row 'y' into this one's */
+  void copyRow(int y, const CellBuffer& other);
+  /**
+   * @brief scrolls the rows [top, bot] by 'n' rows, the way terminals do. The
+   * rows thus exposed are filled with cells which compare unequal to any
+   * valid one, so that they get redrawn
+   * @param n positive to scroll up (contents move up), negative for down
+   */
+  void scroll(int top, int bot, int n);
+
 private:
   int width, height;
   std::vector<Cell> cells;
+  mutable std::vector<uint64_t> hashes;
+  /** whether a row has been written into after its hash was computed */
+  mutable std::vector<char> dirty;
 };
 
+
+/**
+ * @brief Finds the scroll, within a range of rows, which turns the maximum
+ * number of rows of the front buffer into those of the back buffer. Only the
+ * row hashes are looked at, as a wrong guess just costs a few more redraws. A
+ * scroll is suggested only if it would redraw fewer cells than otherwise.
+ * @param top first row of the region to be scrolled
+ * @param bot last row of the region to be scrolled
+ * @return number of rows to scroll by (as in `CellBuffer::scroll`), 0 if no
+ * scroll is worth it
+ */
+int findScroll(const CellBuffer& front, const CellBuffer& back, int& top,
+               int& bot);
+
+
+/**
+ * @brief Brings the front buffer in sync with the back buffer, one cell at a
+ * time, thereby letting the caller redraw only those cells which have changed.
+ * Rows which are the same in both are skipped wholesale.
+ * @param front the buffer representing what is currently on screen
+ * @param back the buffer representing what needs to be on screen
+ * @param changed called as `changed(x, y, cell, width)` for every cell updated
+ * @return number of cells updated
+ */
+template <typename Func>
+int syncCells(CellBuffer& front, const CellBuffer& back, Func changed) {
+  auto h = (int)front.h();
+  auto w = (int)front.w();
+  int count = 0;
+  for(int y=0;y<h;++y) {
+    if(front.sameRow(y, back, y)) continue;
+    const auto* b = back.row(y);
+    const auto* f = front.row(y);
+    for(int x=0;x<w;) {
+      int wid = b[x].width();
+      if(wid < 1) wid = 1;
+      if(!(f[x] == b[x])) {
+        changed(x, y, b[x], wid);
+        ++count;
+      }
+      x += wid;
+    }
+    front.copyRow(y, back);
+  }
+  return count;
+}
+
 }; // end namespace teditor
@@ -38,44 +38,58 @@ void CmdMsgBar::draw(Editor& ed, const Window& win) {
   const auto& start = win.start();
   const auto& dim = win.dim();
   // first line is always the cmd prompt!
-  int y = drawLine(start.y, lines[0].get(), ed, 0, win);
+  int y = drawLine(start.y, lines[0], ed, 0, win);
   if(!usingChoices()) return;
   int len = choices->size();
   int h = start.y + dim.y;
   const auto str = getStr();
+  Line line;
   for(int idx=startLine;y<h&&idx<len;++idx) {
-    const auto& line = choices->at(idx);
-    if(!choices->match(line, str)) continue;
+    const auto opt = choices->at(idx);
+    if(!choices->match(opt, str)) continue;
+    line.clear();
+    line.append(opt);
     y = drawLine(y, line, ed, idx, win);
   }
 }
 
-int CmdMsgBar::drawLine(int y, const std::string& line, Editor& ed,
-                         int lineNum, const Window& win) {
+int CmdMsgBar::drawLine(int y, const Line& line, Editor& ed, int lineNum,
+                        const Window& win) {
   const auto& st = win.start();
   const auto& dim = win.dim();
-  int xStart = st.x, wid = dim.x, start = 0;
-  int len = (int)line.size();
+  int xStart = st.x, wid = dim.x;
+  int len = line.length();
   const auto* str = line.c_str();
-  ULTRA_DEBUG("CmdMsgBar::drawLine: y=%d line=%s len=%d\n", y, line.c_str(),
-              len);
-  auto maxLen = std::max(len, wid);
-  while(start < maxLen) {
-    int diff = maxLen - start;
-    int count = std::min(diff, wid);
-    for(int i = 0; i < count; ++i) {
-      auto c = start + i < len ? str[start + i] : ' ';
-      // under the highlighted region
-      auto highlighted = lineNum && lineNum == optLoc;
-      AttrColor fg, bg;
-      mode->getColorFor(fg, bg, lineNum, start + i, *(Buffer*)this,
-                        highlighted);
-      ed.sendChar(xStart + i, y, fg, bg, c);
+  ULTRA_DEBUG("CmdMsgBar::drawLine: y=%d line=%s len=%d\n", y, str, len);
+  // under the highlighted region
+  auto highlighted = lineNum && lineNum == optLoc;
+  AttrColor fg, bg;
+  int rows = line.numLinesNeeded(wid), x, row, idx = 0;
+  // walk the chars by their display columns, padding the rest with blanks
+  for(int r = 0; r < rows; ++r) {
+    for(int col = 0; col < wid;) {
+      int next = idx < len ? line.nextChar(idx) : idx + 1;
+      if(idx < len) line.screenPos(idx, wid, x, row);
+      else x = col, row = r;
+      mode->getColorFor(fg, bg, lineNum, idx, *(Buffer*)this, highlighted);
+      // a wide char that got moved to the next row
+      if(row != r || x != col) {
+        ed.sendChar(xStart + col, y + r, fg, bg, ' ');
+        ++col;
+        continue;
+      }
+      if(next - idx > 1) {
+        ed.sendString(xStart + col, y + r, fg, bg, str + idx, next - idx);
+        col += line.byte2col(next) - line.byte2col(idx);
+      } else {
+        ed.sendChar(xStart + col, y + r, fg, bg, idx < len ? str[idx] : ' ');
+        ++col;
+      }
+      idx = next;
     }
-    start += wid;
-    ++y;
   }
-  ULTRA_DEBUG("CmdMsgBar::drawLine: ended y=%d line=%s\n", y, line.c_str());
+  y += rows;
+  ULTRA_DEBUG("CmdMsgBar::drawLine: ended y=%d line=%s\n", y, str);
   return y;
 }
 
@@ -85,9 +99,9 @@ std::string CmdMsgBar::getFinalChoice() const {
 }
 
 int CmdMsgBar::linesNeeded(const std::string& str, int wid) const {
-  int len = (int)str.size();
-  if(len <= 0) return 1;
-  return (len + wid - 1) / wid;
+  Line line;
+  line.append(str);
+  return line.numLinesNeeded(wid);
 }
 
 int CmdMsgBar::totalLinesNeeded(const Point& dim) const {
@@ -16,7 +16,7 @@ class Choices {
 public:
   Choices(ChoicesFilter cf): filter(cf), choiceIdx(-1) {}
   virtual ~Choices() {}
-  virtual const std::string& at(int idx) const = 0;
+  virtual std::string at(int idx) const = 0;
   virtual int size() const = 0;
   virtual bool updateChoices(const std::string& str) { return false; }
   virtual std::string getFinalStr(int idx, const std::string& str) const = 0;
@@ -38,7 +38,7 @@ private:
 class StringChoices: public Choices {
 public:
   StringChoices(const Strings& arr, ChoicesFilter cf=strFind);
-  const std::string& at(int idx) const { return options[idx]; }
+  std::string at(int idx) const { return options[idx]; }
   std::string getFinalStr(int idx, const std::string& str) const;
   int size() const { return (int)options.size(); }
 
@@ -53,7 +53,7 @@ public:
   void insert(char c) override;
   void insert(const std::string& str) override;
   void draw(Editor& ed, const Window& win) override;
-  int drawLine(int y, const std::string& line, Editor& ed, int lineNum,
+  int drawLine(int y, const Line& line, Editor& ed, int lineNum,
                const Window& win) override;
   void load(const std::string& file, int line=0) override {}
   bool save(const std::string& fName="") override { return false; }
@@ -64,7 +64,7 @@ public:
   void setChoices(Choices* ch) { choices = ch; }
   void clearChoices();
   bool usingChoices() const { return choices != nullptr; }
-  std::string getStr() const { return lines[0].get().substr(minLoc); }
+  std::string getStr() const { return lines[0].c_str() + minLoc; }
   std::string getFinalChoice() const;
   void down();
   void up();
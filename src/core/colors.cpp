@@ -59,9 +59,30 @@ bool operator!=(const AttrColor& a, const AttrColor& b) { return a.ac != b.ac; }
 const color_t AttrColor::Mask = (color_t)(1 << 8) - 1;
 
 
+ColorSlot colorSlot(const std::string& name) {
+  static const std::unordered_map<std::string, ColorSlot> ids = {
+#define DEF_COLOR_SLOT(name) {#name, Slot_ ## name},
+#include "def_color_slots.h"
+#undef DEF_COLOR_SLOT
+  };
+  const auto itr = ids.find(name);
+  return itr == ids.end() ? Slot_Count : itr->second;
+}
+
+
 void ColorMap::add(const NameColorPair& ncp) {
   const auto itr = colors.find(ncp.color);
-  colors[ncp.name] = (itr!=colors.end())? itr->second : readColor(ncp.color);
+  const auto& ac = colors[ncp.name] =
+    (itr!=colors.end())? itr->second : readColor(ncp.color);
+  auto id = colorSlot(ncp.name);
+  if(id == Slot_Count) return;
+  slots[id] = ac;
+  known[id] = true;
+}
+
+void ColorMap::clear() {
+  colors.clear();
+  for(auto& k : known) k = false;
 }
 
 const AttrColor& ColorMap::get(const std::string& name) const {
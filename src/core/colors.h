@@ -4,6 +4,7 @@
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include "utils.h"
 
 
 namespace teditor {
@@ -77,15 +78,33 @@ bool operator==(const AttrColor& a, const AttrColor& b);
 bool operator!=(const AttrColor& a, const AttrColor& b);
 
 
+/** IDs of the well-known color names, see def_color_slots.h */
+enum ColorSlot {
+#define DEF_COLOR_SLOT(name) Slot_ ## name,
+#include "def_color_slots.h"
+#undef DEF_COLOR_SLOT
+  Slot_Count
+};
+
+/** ID of the given color name, Slot_Count if it is not a well-known one */
+ColorSlot colorSlot(const std::string& name);
+
+
 /** name and color pair for constructing color map */
 struct NameColorPair {
   std::string name, color;
 };
 
 
-/** Color map used for highlights/colors by the editor */
+/**
+ * @brief Color map used for highlights/colors by the editor. Colors with a
+ * ColorSlot are also kept in a flat array, for the per-cell lookups to be
+ * just an index
+ */
 class ColorMap {
 public:
+  ColorMap(): colors(), slots(), known() {}
+
   /**
    * @brief populate the map with the name-color pair
    * At first, the color string is assumed to be another key to the already
@@ -96,13 +115,20 @@ public:
 
   const AttrColor& get(const std::string& name) const;
 
-  void clear() { colors.clear(); }
+  const AttrColor& get(ColorSlot id) const {
+    ASSERT(known[id], "ColorMap: unable to find color for slot '%d'!", id);
+    return slots[id];
+  }
+
+  void clear();
 
   /** convert attribute/color description into AttrColor */
   AttrColor readColor(const std::string& str);
 
 private:
   std::unordered_map<std::string, AttrColor> colors;
+  AttrColor slots[Slot_Count];
+  bool known[Slot_Count];
 };
 
 
@@ -27,6 +27,12 @@ const Command& getCmd(const std::string& cmd) {
   return itr->second;
 }
 
+OperateFunc findCmd(const std::string& cmd) {
+  auto& c = cmds();
+  const auto itr = c.find(cmd);
+  return itr == c.end() ? nullptr : itr->second.first;
+}
+
 Strings allCmdNames(CmdFilterOp filterOp) {
   auto& cs = cmds();
   Strings ret;
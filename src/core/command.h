@@ -33,6 +33,12 @@ bool defaultCmdFilterOp(const std::string& name);
  * @return the command object
  */
 const Command& getCmd(const std::string& cmd);
+/**
+ * @brief Same as getCmd, but doesn't complain about unknown commands
+ * @param cmd name of the command
+ * @return the command function, nullptr if no such command is registered
+ */
+OperateFunc findCmd(const std::string& cmd);
 /**
  * @brief Accessor function to the list of command names
  * @param filterOp filter to be applied on the command names. If the filter
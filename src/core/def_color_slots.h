@@ -0,0 +1,21 @@
+// names of all the colors looked up by the editor and its modes. Every one of
+// these gets an ID in 'ColorSlot', for the draw loop to index into a ColorMap
+// without having to hash any strings
+DEF_COLOR_SLOT(clearfg)
+DEF_COLOR_SLOT(defaultfg)
+DEF_COLOR_SLOT(defaultbg)
+DEF_COLOR_SLOT(highlightfg)
+DEF_COLOR_SLOT(highlightbg)
+DEF_COLOR_SLOT(cursorfg)
+DEF_COLOR_SLOT(cursorbg)
+DEF_COLOR_SLOT(inactivecursorbg)
+DEF_COLOR_SLOT(winframefg)
+DEF_COLOR_SLOT(winframebg)
+DEF_COLOR_SLOT(statusfg)
+DEF_COLOR_SLOT(statusbg)
+DEF_COLOR_SLOT(statusnamefg)
+DEF_COLOR_SLOT(changedfg)
+DEF_COLOR_SLOT(changedbg)
+DEF_COLOR_SLOT(titlefg)
+DEF_COLOR_SLOT(dirfg)
+DEF_COLOR_SLOT(filefg)
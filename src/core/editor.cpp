@@ -19,6 +19,7 @@
 #include "key_cmd_map.h"
 #include "option.h"
 #include "terminal.h"
+#include "profiler.h"
 
 namespace teditor {
 
@@ -35,19 +36,18 @@ std::vector<KeyCmdPair> PromptYesNoKeys::All = {
 Editor::Editor(const std::vector<FileInfo>& _files):
   backbuff(), frontbuff(), lastfg(), lastbg(), cmBar(new CmdMsgBar), buffs(),
   cmBarArr(), windows(), quitEventLoop(false), quitPromptLoop(false),
-  cancelPromptLoop(false), cmdMsgBarActive(false), defcMap(), ynMap(),
+  cancelPromptLoop(false), cmdMsgBarActive(false), ynMap(),
   files(_files), timeout(),
   fileshist(Option::get("histFile").getStr(), Option::get("maxHistory").getInt()) {
   DEBUG("Editor: ctor started\n");
   timeout.tv_sec = 0;
   timeout.tv_usec = Option::get("editor:pollTimeoutMs").getInt() * 1000;
+  Profiler::setEnabled(Option::get("profile:enable").getBool());
   // This array is here only to make sure we get consistent interface to the
   // Window API.
   cmBarArr.push_back(cmBar);
   getCmBarWindow().attachBuffs(&cmBarArr);
   getWindow().attachBuffs(&buffs);
-  auto m = Mode::createMode("text");
-  defcMap = m->getColorMap();
   populateKeyMap<PromptYesNoKeys>(ynMap, true);
   resize();
   DEBUG("Editor: ctor finished\n");
@@ -109,18 +109,31 @@ int Editor::cmBarHeight() const {
   return Option::get("cmBar:height").getInt();
 }
 
-const AttrColor& Editor::getColor(const std::string& name) const {
-  if(buffs.empty()) return defcMap.get(name);
-  ULTRA_DEBUG("getColor: name=%s value=%u\n", name.c_str(),
-              getBuff().getColor(name));
-  return getBuff().getColor(name);
+const AttrColor& Editor::getColor(ColorSlot id) const {
+  // the command bar has all the basic colors too
+  if(buffs.empty()) return cmBar->getColor(id);
+  ULTRA_DEBUG("getColor: id=%d value=%u\n", id, getBuff().getColor(id).ac);
+  return getBuff().getColor(id);
 }
 
 void Editor::runCmd(const std::string& cmd) {
   if(cmd.empty()) return;
+  PROBE(EditorRunCmd);
   getCmd(cmd).first(*this);
 }
 
+void Editor::runCmd(OperateFunc op) {
+  PROBE(EditorRunCmd);
+  op(*this);
+}
+
+void Editor::runBoundCmd(const KeyCmdMap& kcMap, int state) {
+  auto op = kcMap.getFunc(state);
+  // unregistered commands are reported with their names
+  if(op == nullptr) runCmd(kcMap.getCmd(state));
+  else runCmd(op);
+}
+
 void Editor::createScratchBuff(bool switchToIt) {
   buffs.push_back("*scratch");
   if(switchToIt) setCurrBuff((int)buffs.size() - 1);
@@ -211,14 +224,19 @@ void Editor::deleteBuffer(int idx) {
 
 void Editor::run() {
   loadFiles();
+  StartupTimeline::mark("load-files");
   setCurrBuff(0);
   quitEventLoop = false;
   TrieStatus state = TS_NULL;
-  std::string keySoFar, currKey;
+  std::string keySoFar;
   auto& term = Terminal::getInstance();
+  bool profileStartup = Option::get("profileStartup").getBool();
   while(true) {
     refresh();
-    auto& kcMap = getBuff().getKeyCmdMap();
+    StartupTimeline::finish("first-frame");
+    if(profileStartup) break;
+    auto& buf = getBuff();
+    auto& kcMap = buf.getKeyCmdMap();
     int status = pollEvent();
     DEBUG("Editor:run: status=%d meta=%u key=%u keystr='%s'\n", status,
           term.mk.getMeta(), term.mk.getKey(), term.mk.toStr().c_str());
@@ -237,24 +255,28 @@ void Editor::run() {
       resize();
       break;
     case Event_Key:
-      currKey = term.mk.toStr();
-      state = kcMap.traverse(currKey);
+      state = kcMap.traverse(buf.keyState, term.mk);
       if(state == TS_LEAF) {
+        // reset before running, as the command might as well kill the buffer
+        int leaf = buf.keyState;
+        buf.keyState = KeyCmdMap::Root;
         CMBAR(*this, "\n");
-        std::string cmd = kcMap.getCmd();
-        runCmd(cmd);
-        kcMap.resetTraversal();
+        runBoundCmd(kcMap, leaf);
         keySoFar.clear();
       } else if(state == TS_NULL) {
-        keySoFar += " " + currKey;
+        keySoFar += " " + term.mk.toStr();
         CMBAR(*this, "Unknown key %s!\n", keySoFar.c_str());
         keySoFar.clear();
-        kcMap.resetTraversal();
       } else {
-        keySoFar += " " + currKey;
+        keySoFar += " " + term.mk.toStr();
         CMBAR(*this, "%s - ", keySoFar.c_str());
       }
       break;
+    case Event_Text:
+      // only into the buffers which accept typed chars
+      if(kcMap.hasCmd(".insert-char")) runCmd(".insert-text");
+      else CMBAR(*this, "Buffer does not accept text input!\n");
+      break;
       ///@todo: mouse support
     default:
       break;
@@ -313,7 +335,7 @@ void Editor::resize() {
   term.updateTermSize();
   backbuff.resize(term.width(), term.height());
   frontbuff.resize(term.width(), term.height());
-  const auto& clearfg = getColor("clearfg");
+  const auto& clearfg = getColor(Slot_clearfg);
   frontbuff.clear(clearfg, clearfg);
   clearBackBuff();
   bufResize();
@@ -321,8 +343,8 @@ void Editor::resize() {
 }
 
 void Editor::clearBackBuff() {
-  const auto& defaultfg = getColor("defaultfg");
-  const auto& defaultbg = getColor("defaultbg");
+  const auto& defaultfg = getColor(Slot_defaultfg);
+  const auto& defaultbg = getColor(Slot_defaultbg);
   backbuff.clear(defaultfg, defaultbg);
 }
 
@@ -379,8 +401,8 @@ void Editor::setColors(AttrColor fg, AttrColor bg) {
 }
 
 void Editor::clearScreen() {
-  const auto& defaultfg = getColor("defaultfg");
-  const auto& defaultbg = getColor("defaultbg");
+  const auto& defaultfg = getColor(Slot_defaultfg);
+  const auto& defaultbg = getColor(Slot_defaultbg);
   setColors(defaultfg, defaultbg);
   Terminal::getInstance().puts(Func_ClearScreen);
   clearBackBuff();
@@ -403,6 +425,7 @@ std::string Editor::promptEnum(const std::string& msg, OptionMap& opts) {
   }
   m += "? ";
   eMap.add("esc", "prompt-cancel");
+  eMap.compile();
   const auto res = prompt(m, &eMap);
   // cancel requested
   if(res.empty()) return "";
@@ -420,8 +443,8 @@ std::string Editor::prompt(const std::string& msg, KeyCmdMap* kcMap,
   quitPromptLoop = cancelPromptLoop = false;
   cmBar->insert(msg.c_str());
   if(!defVal.empty()) cmBar->insert(defVal.c_str());
-  std::string currKey;
   TrieStatus state = TS_NULL;
+  int keyState = KeyCmdMap::Root;
   auto& term = Terminal::getInstance();
   while(!quitPromptLoop) {
     refresh();
@@ -435,14 +458,16 @@ std::string Editor::prompt(const std::string& msg, KeyCmdMap* kcMap,
       break;
     } else if(status < 0) break;
     if(term.type == Event_Key) {
-      currKey = term.mk.toStr();
-      state = kcMap->traverse(currKey);
+      state = kcMap->traverse(keyState, term.mk);
       if(state == TS_LEAF) {
-        std::string cmd = kcMap->getCmd();
-        runCmd(cmd);
-        kcMap->resetTraversal();
-      } else if(state == TS_NULL)
-        kcMap->resetTraversal();
+        runBoundCmd(*kcMap, keyState);
+        keyState = KeyCmdMap::Root;
+      }
+    } else if(term.type == Event_Text) {
+      // prompts are single-line
+      auto str = term.text;
+      std::replace(str.begin(), str.end(), '\n', ' ');
+      cmBar->insert(str);
     }
   }
   auto ret = cmBar->getFinalChoice();
@@ -459,6 +484,7 @@ std::string Editor::prompt(const std::string& msg, KeyCmdMap* kcMap,
 }
 
 void Editor::draw() {
+  PROBE(EditorDraw);
   clearBackBuff();
   windows.draw(*this, cmdMsgBarActive);
 }
@@ -469,43 +495,48 @@ void Editor::bufResize() {
 }
 
 void Editor::render() {
+  PROBE(EditorRender);
   auto& term = Terminal::getInstance();
   if(term.bufferResize()) {
     term.disableResize();
     resize();
   }
-  auto h = (int)frontbuff.h();
+  scrollScreen();
   auto w = (int)frontbuff.w();
-  for(int y=0;y<h;++y) {
-    for(int x=0;x<w;) {
-      const auto& back = backbuff.at(x, y);
-      auto& front = frontbuff.at(x, y);
-      int wid = back.width();
-      if(wid < 1) wid = 1;
-      if(front == back) {
-        x += wid;
-        continue;
-      }
-      ULTRA_DEBUG("render: y,x=%d,%d back=%u,%hu,%hu front=%u,%hu,%hu\n",
-                  y, x, back.ch, back.fg, back.bg, front.ch, front.fg,
-                  front.bg);
-      front.copy(back);
-      setColors(back.fg, back.bg);
-      // if character exceeds the screen width
-      if(x >= w - wid + 1) {
-        ASSERT(false, "Character exceeding screen width is not supported!");
-        for (int i=x;i<w;++i) writeChar(' ', i, y);
-      } else {
-        writeChar(back.ch, x, y);
-      }
-      x += wid;
+  syncCells(frontbuff, backbuff,
+            [this, w](int x, int y, const Cell& back, int wid) {
+    ULTRA_DEBUG("render: y,x=%d,%d back=%u,%hu,%hu\n", y, x, back.ch,
+                back.fg, back.bg);
+    setColors(back.fg, back.bg);
+    // if character exceeds the screen width
+    if(x >= w - wid + 1) {
+      ASSERT(false, "Character exceeding screen width is not supported!");
+      for (int i=x;i<w;++i) writeChar(' ', i, y);
+    } else {
+      writeChar(back.ch, x, y);
     }
-  }
+  });
   Terminal::getInstance().flush();
 }
 
+void Editor::scrollScreen() {
+  int top, bot;
+  int n = findScroll(frontbuff, backbuff, top, bot);
+  if(n == 0) return;
+  DEBUG("scrollScreen: top=%d bot=%d n=%d\n", top, bot, n);
+  // set the scroll region, scroll it and then reset the region
+  writeLiteral("\033[%d;%dr", top+1, bot+1);
+  writeLiteral(n > 0 ? "\033[%dS" : "\033[%dT", n > 0 ? n : -n);
+  writeLiteral("\033[r");
+  frontbuff.scroll(top, bot, n);
+}
+
 int Editor::pollEvent() { return Terminal::getInstance().waitAndFill(&timeout); }
 
 key_t Editor::getKey() const { return Terminal::getInstance().mk.getKey(); }
 
+const std::string& Editor::getText() const {
+  return Terminal::getInstance().text;
+}
+
 } // end namespace teditor
@@ -39,6 +39,8 @@ public:
   std::string promptEnum(const std::string& msg, OptionMap& opts);
   void load(const std::string& file, int line);
   void runCmd(const std::string& cmd);
+  /** runs an already looked up command */
+  void runCmd(OperateFunc op);
   const std::string clipboard() const;
   void setClipboard(const std::string& in);
 
@@ -70,6 +72,8 @@ public:
   Strings buffNamesToString() const { return buffs.namesList(); }
   void saveBuffer(Buffer& buf);
   key_t getKey() const;
+  /** text of the current text event (a non-ASCII char or a paste) */
+  const std::string& getText() const;
   bool splitVertically() { return windows.splitVertically(); }
   void clearAllWindows() { return windows.clearAll(); }
   void incrementCurrWin() { windows.incrementCurrWin(); }
@@ -82,7 +86,6 @@ private:
   Buffers buffs, cmBarArr;
   Windows windows;
   bool quitEventLoop, quitPromptLoop, cancelPromptLoop, cmdMsgBarActive;
-  ColorMap defcMap;
   KeyCmdMap ynMap;
   std::vector<FileInfo> files;
   struct timeval timeout;
@@ -93,6 +96,11 @@ private:
    * @{
    */
   void render();
+  /**
+   * scrolls the screen when most of its rows have just moved up or down, to
+   * avoid redrawing all of them
+   */
+  void scrollScreen();
   int pollEvent();
   /** @} */
 
@@ -105,11 +113,13 @@ private:
   void draw();
   void loadFiles();
   void bufResize();
-  const AttrColor& getColor(const std::string& name) const;
+  const AttrColor& getColor(ColorSlot id) const;
   int cmBarHeight() const;
   void deleteBuffer(int idx);
   void setCurrBuff(int i) { getWindow().setCurrBuff(i); }
   void checkForModifiedBuffer(Buffer* mlb);
+  /** runs the command at the given (leaf) state of the key map */
+  void runBoundCmd(const KeyCmdMap& kcMap, int state);
 };
 
 }; // end namespace teditor
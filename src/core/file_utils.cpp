@@ -13,22 +13,25 @@
 #include <cctype>
 #include <algorithm>
 #include "logger.h"
+#include "remote_session.h"
 
 namespace teditor {
 
-std::string remoteFileType(const std::string& f) {
-  Remote r(f);
-  auto cmd = format("ssh %s /bin/bash -c \\\"file %s\\\"",
-                    r.host.c_str(), r.file.c_str());
-  auto out = check_output(cmd);
-  auto str = out.output;
-  // "<file>: " removed
-  str.erase(0, r.file.size() + 2);
-  return str;
+/** 'd' for dirs, 'f' for other files and '-' for missing ones */
+static std::vector<char> remoteStat(const Strings& files) {
+  // all of them are on the same host, so they go in a single round trip
+  std::vector<RemoteRequest> reqs;
+  for(const auto& f : files) reqs.push_back({"stat", Remote(f).file, ""});
+  auto replies = RemoteSession::get(Remote(files[0]).host).request(reqs);
+  std::vector<char> ret;
+  for(const auto& r : replies) ret.push_back(r.data.empty() ? '-' : r.data[0]);
+  return ret;
 }
 
-bool isRemoteDir(const std::string& type) {
-  return type.find("directory") != std::string::npos;
+static RemoteReply remoteRequest(const std::string& op, const std::string& f,
+                                 const std::string& payload = "") {
+  Remote r(f);
+  return RemoteSession::get(r.host).request({op, r.file, payload});
 }
 
 bool isDir(const std::string& f) {
@@ -37,7 +40,7 @@ bool isDir(const std::string& f) {
     if(stat(f.c_str(), &st) != 0) return false;
     return S_ISDIR(st.st_mode);
   }
-  return isRemoteDir(remoteFileType(f));
+  return remoteStat({f})[0] == 'd';
 }
 
 bool isFile(const std::string& f) {
@@ -46,7 +49,7 @@ bool isFile(const std::string& f) {
     if(stat(f.c_str(), &st) != 0) return false;
     return S_ISREG(st.st_mode);
   }
-  return !isRemoteDir(remoteFileType(f));
+  return remoteStat({f})[0] == 'f';
 }
 
 bool isReadOnly(const char* f) {
@@ -59,11 +62,9 @@ void makeDir(const std::string& d) {
     int ret = mkdir(d.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
     ASSERT(ret >= 0, "makeDir: '%s' failed!", d.c_str());
   } else {
-    Remote r(d);
-    auto cmd = format("ssh %s mkdir -p %s", r.host, r.file);
-    auto out = check_output(cmd);
-    ASSERT(out.status == 0, "makeDir: cmd='%s' failed! code=%d\n", cmd.c_str(),
-           out.status);
+    auto out = remoteRequest("mkdir", d);
+    ASSERT(out.status == 0, "makeDir: '%s' failed! %s\n", d.c_str(),
+           out.data.c_str());
   }
 }
 
@@ -159,13 +160,20 @@ std::string findFirstUpwards(const std::string& dir, const std::string& file) {
   if(dir.empty() || file.empty()) return "";
   auto d = dir;
   if(d.back() == '/') d.pop_back();
-  auto f = d + '/' + file;
-  if(isFile(f) || isDir(f)) return f;
+  Strings candidates = {d + '/' + file};
   while(!d.empty() && d != "/") {
     d = dirname(d);
-    f = d + '/' + file;
-    if(isFile(f) || isDir(f)) return f;
+    candidates.push_back(d + '/' + file);
   }
+  if(isRemote(dir)) {
+    // remote ones can't be empty, but the walk above ends with "/<file>"
+    if(!isRemote(candidates.back())) candidates.pop_back();
+    auto types = remoteStat(candidates);
+    for(size_t i = 0; i < types.size(); ++i)
+      if(types[i] != '-') return candidates[i];
+    return "";
+  }
+  for(const auto& f : candidates) if(isFile(f) || isDir(f)) return f;
   return "";
 }
 
@@ -229,29 +237,21 @@ Strings listDirRel(const std::string& dir) {
     std::sort(f.begin(), f.end());
     return f;
   } else {
-    Remote r(dir);
-    auto cmd = format("ssh %s /bin/bash -c '\"cd %s && ls -a |"
-                      " xargs -d \\\"\n\\\" stat --format \\\"%%n\\\"\"'",
-                      r.host.c_str(), r.file.c_str());
-    auto out = check_output(cmd);
-    return split(out.output, '\n');
+    return DirCache::names(remoteRequest("list", dir).data);
   }
 }
 
 std::string listDir2str(const std::string& dir) {
-  std::string cmd;
+  std::string out;
   if (isRemote(dir)) {
-    Remote r(dir);
-    cmd = format("ssh %s /bin/bash -c '\"cd %s && ls -a |"
-                 " xargs -d \\\"\n\\\" stat --format \\\"  %%A  %%8s  %%n\\\"\"'",
-                 r.host.c_str(), r.file.c_str());
+    out = remoteRequest("list", dir).data;
   } else {
-    cmd = format("cd %s && ls -a | xargs -d '\n' stat --format '  %%A  %%8s  %%n'",
-                 dir.c_str());
+    auto cmd = format("cd %s && ls -a | xargs -d '\n' stat --format"
+                      " '  %%A  %%8s  %%n'", dir.c_str());
+    out = check_output(cmd).output;
   }
-  auto out = check_output(cmd);
-  DirCache::forceUpdateAt(dir, out.output);
-  return out.output;
+  DirCache::forceUpdateAt(dir, out);
+  return out;
 }
 
 void copyFile(const std::string& in, const std::string& out) {
@@ -305,18 +305,21 @@ bool isCurrentOrParentDir(const std::string& dir) {
 
 std::string copyFromRemote(const std::string& file) {
   std::string tmp = tempFileName();
-  Remote r(file);
-  auto cmd = format("scp %s:%s %s", r.host.c_str(), r.file.c_str(),
-                    tmp.c_str());
-  check_output(cmd);
+  auto out = remoteRequest("load", file);
+  // a missing file is left as such, just like the local ones
+  if(out.status != 0) return tmp;
+  FILE* fp = fopen(tmp.c_str(), "wb");
+  ASSERT(fp, "copyFromRemote: failed to open '%s'!", tmp.c_str());
+  bool ok = fwrite(out.data.data(), 1, out.data.size(), fp) == out.data.size();
+  fclose(fp);
+  ASSERT(ok, "copyFromRemote: failed to write '%s'!", tmp.c_str());
   return tmp;
 }
 
 void copyToRemote(const std::string& rfile, const std::string& local) {
-  Remote r(rfile);
-  auto cmd = format("scp %s %s:%s", local.c_str(), r.host.c_str(),
-                    r.file.c_str());
-  check_output(cmd);
+  auto out = remoteRequest("save", rfile, slurp(local));
+  ASSERT(out.status == 0, "copyToRemote: failed to save '%s'!",
+         rfile.c_str());
 }
 
 
@@ -334,15 +337,19 @@ void DirCache::forceUpdateAt(const std::string& dir, const Files& fs) {
 }
 
 void DirCache::forceUpdateAt(const std::string& dir, const std::string& res) {
+  auto& obj = getInstance();
+  auto d = obj.noTrailingSlash(dir);
+  obj.cache[d] = names(res);
+}
+
+Strings DirCache::names(const std::string& res) {
   Strings fileInfo = split(res, '\n');
   Strings files;
   for (const auto& fi : fileInfo) {
     if (fi.size() <= FilePerm::DirModeFileOffset) continue;
     files.push_back(fi.substr(FilePerm::DirModeFileOffset));
   }
-  auto& obj = getInstance();
-  auto d = obj.noTrailingSlash(dir);
-  obj.cache[d] = files;
+  return files;
 }
 
 Strings& DirCache::getDirContents(const std::string& dir) {
@@ -86,6 +86,9 @@ class DirCache {
   /** get the contents of dir */
   static Strings& getDirContents(const std::string& dir);
 
+  /** names of the files in the output of `listDir2str` */
+  static Strings names(const std::string& res);
+
  private:
   std::unordered_map<std::string, Strings> cache;
 
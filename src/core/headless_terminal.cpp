@@ -0,0 +1,124 @@
+#include "headless_terminal.h"
+#include "logger.h"
+
+
+namespace teditor {
+
+// what xterm's terminfo entry says
+static const char* XtermFuncs[] = {
+  "\033[?1049h",        // smcup
+  "\033[?1049l",        // rmcup
+  "\033[?12l\033[?25h", // cnorm
+  "\033[?25l",          // civis
+  "\033[H\033[2J",      // clear
+  "\033(B\033[m",       // sgr0
+  "\033[4m",            // smul
+  "\033[3m",            // sitm
+  "\033[1m",            // bold
+  "\033[5m",            // blink
+  "\033[?1h\033=",      // smkx
+  "\033[?1l\033>",      // rmkx
+};
+
+HeadlessTerminal::HeadlessTerminal(const Pos2di& dim):
+  Terminal(), inputs(), vt(dim.x, dim.y), frameStats(), keyPending(false),
+  keyTime() {
+  for(int i = 0; i < Func_EnterMouse; ++i) funcs.push_back(XtermFuncs[i]);
+  addNonTerminfoFuncs();
+  tsize = dim;
+  puts(Func_EnterKeypad);
+  puts(Func_EnterCA);
+  puts(Func_HideCursor);
+  puts(Func_EnterPaste);
+  reset();
+}
+
+void HeadlessTerminal::flush() {
+  auto now = Clock::now();
+  double lat = -1.0;
+  if(keyPending) {
+    lat = std::chrono::duration<double, std::micro>(now - keyTime).count();
+    keyPending = false;
+  }
+  frameStats.push_back({outbuff.size(), lat});
+  vt.feed(outbuff);
+  outbuff.clear();
+}
+
+int HeadlessTerminal::waitAndFill(struct timeval* timeout) {
+  (void)timeout;
+  reset();
+  if(!inbuf.empty()) return readKey();
+  if(inputs.empty()) return -1;
+  auto in = inputs.front();
+  inputs.pop_front();
+  if(in.resize) {
+    tsize = in.dim;
+    vt.resize(in.dim.x, in.dim.y);
+    buffResize = true;
+    type = Event_Resize;
+    return type;
+  }
+  disableResize();
+  ASSERT(inbuf.push(in.seq.c_str(), in.seq.size()) == in.seq.size(),
+         "HeadlessTerminal: key sequence too long!");
+  keyPending = true;
+  keyTime = Clock::now();
+  return readKey();
+}
+
+void HeadlessTerminal::addKeySeq(const std::string& s) {
+  ASSERT(!s.empty(), "HeadlessTerminal: empty key sequence!");
+  inputs.push_back({false, s, Pos2di()});
+}
+
+void HeadlessTerminal::addResize(int w, int h) {
+  ASSERT(w > 0 && h > 0, "HeadlessTerminal: bad resize %dx%d!", w, h);
+  inputs.push_back({true, "", Pos2di(w, h)});
+}
+
+/** expands the `\n` and `\\` escapes */
+static std::string unescape(const std::string& str) {
+  std::string ret;
+  for(size_t i = 0; i < str.size(); ++i) {
+    if(str[i] == '\\' && i + 1 < str.size()) {
+      ++i;
+      ret += str[i] == 'n' ? '\n' : str[i];
+    } else {
+      ret += str[i];
+    }
+  }
+  return ret;
+}
+
+void HeadlessTerminal::addScript(const std::string& script) {
+  int num = 0;
+  for(auto line : split(script, '\n')) {
+    ++num;
+    auto start = line.find_first_not_of(" \t\r");
+    if(start == std::string::npos || line[start] == '#') continue;
+    line.erase(0, start);
+    line.erase(line.find_last_not_of(" \t\r") + 1);
+    auto pos = line.find(' ');
+    auto cmd = line.substr(0, pos);
+    auto rest = pos == std::string::npos ? "" : line.substr(pos + 1);
+    if(cmd == "type") {
+      for(auto c : rest) addKeySeq(std::string(1, c));
+    } else if(cmd == "paste") {
+      addKeySeq(PasteStart + unescape(rest) + PasteEnd);
+    } else if(cmd == "keys") {
+      for(const auto& k : split(rest, ' '))
+        if(!k.empty()) addKey(k);
+    } else if(cmd == "resize") {
+      auto dims = split(rest, ' ');
+      ASSERT(dims.size() == 2, "addScript: line %d: bad resize '%s'!", num,
+             rest.c_str());
+      addResize(str2num(dims[0]), str2num(dims[1]));
+    } else {
+      ASSERT(false, "addScript: line %d: unknown directive '%s'!", num,
+             cmd.c_str());
+    }
+  }
+}
+
+}; // end namespace teditor
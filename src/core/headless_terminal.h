@@ -0,0 +1,83 @@
+#pragma once
+
+#include "terminal.h"
+#include "vt_screen.h"
+#include <chrono>
+#include <deque>
+#include <vector>
+
+
+namespace teditor {
+
+/** output of the editor during a single `flush` */
+struct FrameStats {
+  /** number of bytes written out */
+  size_t bytes;
+  /**
+   * time between the key being handed over to the editor and this frame.
+   * Negative if this frame wasn't triggered by a key.
+   */
+  double latencyUs;
+};
+
+
+/**
+ * @brief A terminal which lives purely in memory. Its input comes from a queue
+ * of scripted events and its output is decoded onto a virtual screen, thus
+ * making the editor's behavior and its output fully deterministic. Once the
+ * input queue is exhausted, `waitAndFill` reports the end of input, which
+ * makes `Editor::run` return.
+ */
+class HeadlessTerminal: public Terminal {
+public:
+  void flush() override;
+  /** size changes only via the scripted resize events */
+  void updateTermSize() override {}
+  int waitAndFill(struct timeval* timeout) override;
+
+  /** queues up a key, given its name as used in the keybindings */
+  void addKey(const std::string& key) { addKeySeq(key2seq(key)); }
+  /** queues up raw input bytes to be delivered in one go */
+  void addKeySeq(const std::string& seq);
+  /** queues up a terminal resize event */
+  void addResize(int w, int h);
+  /**
+   * @brief queues up the events of a keystroke script. Each line of it is one
+   * of the following:
+   * - `keys <key> <key> ...` keys by their names, as used in the keybindings
+   * - `type <text>` ASCII text to be typed in, one char at a time
+   * - `paste <text>` text to be sent as a bracketed paste, with `\n` for
+   *   newlines
+   * - `resize <width> <height>` terminal resize event
+   * Empty lines and the ones starting with '#' are ignored.
+   */
+  void addScript(const std::string& script);
+  /** number of input events yet to be delivered */
+  size_t pending() const { return inputs.size(); }
+
+  const VtScreen& screen() const { return vt; }
+  const std::vector<FrameStats>& frames() const { return frameStats; }
+  void clearFrames() { frameStats.clear(); }
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Input {
+    bool resize;
+    std::string seq;
+    Pos2di dim;
+  };
+
+  std::deque<Input> inputs;
+  VtScreen vt;
+  std::vector<FrameStats> frameStats;
+  /** whether a key has been handed over, but not yet drawn */
+  bool keyPending;
+  Clock::time_point keyTime;
+
+  HeadlessTerminal(const Pos2di& dim);
+
+  template <typename A, typename B> friend class SingletonHandler;
+};
+
+}; // end namespace teditor
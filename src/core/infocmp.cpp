@@ -1,9 +1,344 @@
 #include "infocmp.h"
+#include "file_utils.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace teditor {
 
-InfoCmp::InfoCmp(): header(), boolCaps(), numCaps(), strCaps() {
-  auto ret = check_output("infocmp -1 -G");
+// names of the predefined capabilities, in the order of their appearance in
+// the compiled terminfo entries. Same as ncurses' 'boolnames', 'numnames' and
+// 'strnames' arrays
+static const char* BoolNames[] = {
+  "bw", "am", "xsb", "xhp", "xenl", "eo", "gn", "hc", "km", "hs", "in", "da",
+  "db", "mir", "msgr", "os", "eslok", "xt", "hz", "ul", "xon", "nxon", "mc5i",
+  "chts", "nrrmc", "npc", "ndscr", "ccc", "bce", "hls", "xhpa", "crxm",
+  "daisy", "xvpa", "sam", "cpix", "lpix", "OTbs", "OTns", "OTnc", "OTMT",
+  "OTNL", "OTpt", "OTxr",
+};
+
+static const char* NumNames[] = {
+  "cols", "it", "lines", "lm", "xmc", "pb", "vt", "wsl", "nlab", "lh", "lw",
+  "ma", "wnum", "colors", "pairs", "ncv", "bufsz", "spinv", "spinh", "maddr",
+  "mjump", "mcs", "mls", "npins", "orc", "orl", "orhi", "orvi", "cps", "widcs",
+  "btns", "bitwin", "bitype", "OTug", "OTdC", "OTdN", "OTdB", "OTdT", "OTkn",
+};
+
+static const char* StrNames[] = {
+  "cbt", "bel", "cr", "csr", "tbc", "clear", "el", "ed", "hpa", "cmdch", "cup",
+  "cud1", "home", "civis", "cub1", "mrcup", "cnorm", "cuf1", "ll", "cuu1",
+  "cvvis", "dch1", "dl1", "dsl", "hd", "smacs", "blink", "bold", "smcup",
+  "smdc", "dim", "smir", "invis", "prot", "rev", "smso", "smul", "ech",
+  "rmacs", "sgr0", "rmcup", "rmdc", "rmir", "rmso", "rmul", "flash", "ff",
+  "fsl", "is1", "is2", "is3", "if", "ich1", "il1", "ip", "kbs", "ktbc", "kclr",
+  "kctab", "kdch1", "kdl1", "kcud1", "krmir", "kel", "ked", "kf0", "kf1",
+  "kf10", "kf2", "kf3", "kf4", "kf5", "kf6", "kf7", "kf8", "kf9", "khome",
+  "kich1", "kil1", "kcub1", "kll", "knp", "kpp", "kcuf1", "kind", "kri",
+  "khts", "kcuu1", "rmkx", "smkx", "lf0", "lf1", "lf10", "lf2", "lf3", "lf4",
+  "lf5", "lf6", "lf7", "lf8", "lf9", "rmm", "smm", "nel", "pad", "dch", "dl",
+  "cud", "ich", "indn", "il", "cub", "cuf", "rin", "cuu", "pfkey", "pfloc",
+  "pfx", "mc0", "mc4", "mc5", "rep", "rs1", "rs2", "rs3", "rf", "rc", "vpa",
+  "sc", "ind", "ri", "sgr", "hts", "wind", "ht", "tsl", "uc", "hu", "iprog",
+  "ka1", "ka3", "kb2", "kc1", "kc3", "mc5p", "rmp", "acsc", "pln", "kcbt",
+  "smxon", "rmxon", "smam", "rmam", "xonc", "xoffc", "enacs", "smln", "rmln",
+  "kbeg", "kcan", "kclo", "kcmd", "kcpy", "kcrt", "kend", "kent", "kext",
+  "kfnd", "khlp", "kmrk", "kmsg", "kmov", "knxt", "kopn", "kopt", "kprv",
+  "kprt", "krdo", "kref", "krfr", "krpl", "krst", "kres", "ksav", "kspd",
+  "kund", "kBEG", "kCAN", "kCMD", "kCPY", "kCRT", "kDC", "kDL", "kslt", "kEND",
+  "kEOL", "kEXT", "kFND", "kHLP", "kHOM", "kIC", "kLFT", "kMSG", "kMOV",
+  "kNXT", "kOPT", "kPRV", "kPRT", "kRDO", "kRPL", "kRIT", "kRES", "kSAV",
+  "kSPD", "kUND", "rfi", "kf11", "kf12", "kf13", "kf14", "kf15", "kf16",
+  "kf17", "kf18", "kf19", "kf20", "kf21", "kf22", "kf23", "kf24", "kf25",
+  "kf26", "kf27", "kf28", "kf29", "kf30", "kf31", "kf32", "kf33", "kf34",
+  "kf35", "kf36", "kf37", "kf38", "kf39", "kf40", "kf41", "kf42", "kf43",
+  "kf44", "kf45", "kf46", "kf47", "kf48", "kf49", "kf50", "kf51", "kf52",
+  "kf53", "kf54", "kf55", "kf56", "kf57", "kf58", "kf59", "kf60", "kf61",
+  "kf62", "kf63", "el1", "mgc", "smgl", "smgr", "fln", "sclk", "dclk", "rmclk",
+  "cwin", "wingo", "hup", "dial", "qdial", "tone", "pulse", "hook", "pause",
+  "wait", "u0", "u1", "u2", "u3", "u4", "u5", "u6", "u7", "u8", "u9", "op",
+  "oc", "initc", "initp", "scp", "setf", "setb", "cpi", "lpi", "chr", "cvr",
+  "defc", "swidm", "sdrfq", "sitm", "slm", "smicm", "snlq", "snrmq", "sshm",
+  "ssubm", "ssupm", "sum", "rwidm", "ritm", "rlm", "rmicm", "rshm", "rsubm",
+  "rsupm", "rum", "mhpa", "mcud1", "mcub1", "mcuf1", "mvpa", "mcuu1", "porder",
+  "mcud", "mcub", "mcuf", "mcuu", "scs", "smgb", "smgbp", "smglp", "smgrp",
+  "smgt", "smgtp", "sbim", "scsd", "rbim", "rcsd", "subcs", "supcs", "docr",
+  "zerom", "csnm", "kmous", "minfo", "reqmp", "getm", "setaf", "setab", "pfxl",
+  "devt", "csin", "s0ds", "s1ds", "s2ds", "s3ds", "smglr", "smgtb", "birep",
+  "binel", "bicr", "colornm", "defbi", "endbi", "setcolor", "slines", "dispc",
+  "smpch", "rmpch", "smsc", "rmsc", "pctrm", "scesc", "scesa", "ehhlm",
+  "elhlm", "elohlm", "erhlm", "ethlm", "evhlm", "sgr1", "slength", "OTi2",
+  "OTrs", "OTnl", "OTbc", "OTko", "OTma", "OTG2", "OTG3", "OTG1", "OTG4",
+  "OTGR", "OTGL", "OTGU", "OTGD", "OTGH", "OTGV", "OTGC", "meml", "memu",
+  "box1",
+};
+static const int NumBoolNames = sizeof(BoolNames) / sizeof(BoolNames[0]);
+static const int NumNumNames = sizeof(NumNames) / sizeof(NumNames[0]);
+static const int NumStrNames = sizeof(StrNames) / sizeof(StrNames[0]);
+
+// see term(5)
+static const int MagicLegacy = 0432;
+static const int Magic32Bit = 01036;
+static const int HeaderSize = 12;
+static const int ExtHeaderSize = 10;
+
+static const char* CacheVersion = "teditor-terminfo-cache 1";
+
+static int readShort(const std::string& data, size_t pos) {
+  auto lo = (uint8_t)data[pos], hi = (uint8_t)data[pos + 1];
+  return (int)(int16_t)(lo | (hi << 8));
+}
+
+static int readNum(const std::string& data, size_t pos, int numSize) {
+  if (numSize == 2) return readShort(data, pos);
+  uint32_t val = 0;
+  for (int i = 3; i >= 0; --i) val = (val << 8) | (uint8_t)data[pos + i];
+  return (int)(int32_t)val;
+}
+
+/** the NUL terminated string at 'pos', but without crossing 'end' */
+static std::string readStr(const std::string& data, size_t pos, size_t end) {
+  const char* start = data.data() + pos;
+  return std::string(start, strnlen(start, end - pos));
+}
+
+static int64_t mtimeOf(const std::string& file) {
+  struct stat st;
+  if (stat(file.c_str(), &st) != 0) return -1;
+  return int64_t(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+static std::string escape(const std::string& str) {
+  std::string ret;
+  for (auto c : str) {
+    if (c == '\\') ret += "\\\\";
+    else if (c == '\n') ret += "\\n";
+    else if (c == '\t') ret += "\\t";
+    else ret += c;
+  }
+  return ret;
+}
+
+static std::string unescape(const std::string& str) {
+  std::string ret;
+  for (size_t i = 0; i < str.size(); ++i) {
+    if (str[i] != '\\' || i + 1 >= str.size()) {
+      ret += str[i];
+      continue;
+    }
+    char c = str[++i];
+    if (c == 'n') ret += '\n';
+    else if (c == 't') ret += '\t';
+    else ret += c;
+  }
+  return ret;
+}
+
+
+InfoCmp::InfoCmp(): InfoCmp(env("TERM")) {}
+
+InfoCmp::InfoCmp(const std::string& term, const std::string& cacheDir):
+  header(), boolCaps(), numCaps(), strCaps(), source(Src_InfoCmp) {
+  if (term.empty()) return;
+  auto compiled = findCompiled(term);
+  if (compiled.empty()) {
+    INFO("InfoCmp: no compiled terminfo entry for '%s'\n", term.c_str());
+    runInfoCmp(term);
+    return;
+  }
+  auto mtime = mtimeOf(compiled);
+  std::string cache;
+  if (!cacheDir.empty()) {
+    cache = cacheDir + "/" + term;
+    if (loadCache(cache, compiled, mtime)) {
+      source = Src_Cache;
+      return;
+    }
+  }
+  if (!parseCompiled(compiled)) {
+    INFO("InfoCmp: bad compiled terminfo entry '%s'\n", compiled.c_str());
+    runInfoCmp(term);
+    return;
+  }
+  source = Src_Compiled;
+  if (!cache.empty()) saveCache(cache, compiled, mtime);
+}
+
+void InfoCmp::clear() {
+  header.clear();
+  boolCaps.clear();
+  numCaps.clear();
+  strCaps.clear();
+}
+
+std::string InfoCmp::findCompiled(const std::string& term) {
+  if (term.empty() || term.find('/') != std::string::npos) return "";
+  Strings dirs;
+  auto dir = env("TERMINFO");
+  if (!dir.empty()) dirs.push_back(dir);
+  dir = env("HOME");
+  if (!dir.empty()) dirs.push_back(dir + "/.terminfo");
+  // empty entries in TERMINFO_DIRS stand for the system folders
+  auto tdirs = env("TERMINFO_DIRS");
+  bool sysDirs = tdirs.empty();
+  for (const auto& d : split(tdirs, ':')) {
+    if (d.empty()) sysDirs = true;
+    else dirs.push_back(d);
+  }
+  if (sysDirs) {
+    for (auto* d : {"/etc/terminfo", "/lib/terminfo", "/usr/share/terminfo",
+                   "/usr/lib/terminfo"})
+      dirs.push_back(d);
+  }
+  // entries are under the folder named after their first char, which on some
+  // systems is in hex
+  std::string first(1, term[0]);
+  auto hex = format("%02x", (unsigned)(uint8_t)term[0]);
+  for (const auto& d : dirs) {
+    auto f = d + "/" + first + "/" + term;
+    if (isFile(f)) return f;
+    f = d + "/" + hex + "/" + term;
+    if (isFile(f)) return f;
+  }
+  return "";
+}
+
+bool InfoCmp::parseCompiled(const std::string& file) {
+  clear();
+  if (!isFile(file)) return false;
+  auto data = slurp(file);
+  size_t len = data.size();
+  if (len < HeaderSize) return false;
+  int magic = readShort(data, 0), numSize;
+  if (magic == MagicLegacy) numSize = 2;
+  else if (magic == Magic32Bit) numSize = 4;
+  else return false;
+  int namesSize = readShort(data, 2), nBools = readShort(data, 4);
+  int nNums = readShort(data, 6), nStrs = readShort(data, 8);
+  int tableSize = readShort(data, 10);
+  if (namesSize < 0 || nBools < 0 || nNums < 0 || nStrs < 0 || tableSize < 0)
+    return false;
+  size_t boolsAt = HeaderSize + namesSize;
+  // numbers always start at an even offset
+  size_t numsAt = boolsAt + nBools + ((boolsAt + nBools) % 2);
+  size_t strsAt = numsAt + nNums * numSize;
+  size_t tableAt = strsAt + 2 * nStrs, end = tableAt + tableSize;
+  if (end > len) return false;
+  header = readStr(data, HeaderSize, boolsAt);
+  for (int i = 0; i < nBools && i < NumBoolNames; ++i)
+    if (data[boolsAt + i] == 1) boolCaps.push_back(BoolNames[i]);
+  for (int i = 0; i < nNums && i < NumNumNames; ++i) {
+    int val = readNum(data, numsAt + i * numSize, numSize);
+    // negative values are for absent or cancelled capabilities
+    if (val >= 0) numCaps[NumNames[i]] = unsigned(val);
+  }
+  for (int i = 0; i < nStrs && i < NumStrNames; ++i) {
+    int off = readShort(data, strsAt + 2 * i);
+    if (off >= 0 && off < tableSize)
+      strCaps[StrNames[i]] = readStr(data, tableAt + off, end);
+  }
+  // extended (user-defined) capabilities, if any, follow at an even offset
+  size_t pos = end + (end % 2);
+  if (pos + ExtHeaderSize > len) return true;
+  int eBools = readShort(data, pos), eNums = readShort(data, pos + 2);
+  int eStrs = readShort(data, pos + 4), eItems = readShort(data, pos + 6);
+  int eTableSize = readShort(data, pos + 8);
+  int eNames = eBools + eNums + eStrs;
+  if (eBools < 0 || eNums < 0 || eStrs < 0 || eTableSize < 0 ||
+     eItems < eStrs + eNames) return true;
+  size_t eBoolsAt = pos + ExtHeaderSize;
+  size_t eNumsAt = eBoolsAt + eBools + ((eBoolsAt + eBools) % 2);
+  size_t eStrsAt = eNumsAt + eNums * numSize;
+  size_t eNamesAt = eStrsAt + 2 * eStrs;
+  size_t eTableAt = eStrsAt + 2 * eItems, eEnd = eTableAt + eTableSize;
+  if (eEnd > len) return true;
+  // the table has all the values first, followed by all the names
+  size_t namesBase = 0;
+  for (int i = 0; i < eStrs; ++i) {
+    int off = readShort(data, eStrsAt + 2 * i);
+    if (off < 0 || off >= eTableSize) continue;
+    auto valEnd = off + readStr(data, eTableAt + off, eEnd).size() + 1;
+    namesBase = std::max(namesBase, valEnd);
+  }
+  auto name = [&](int i) -> std::string {
+    int off = readShort(data, eNamesAt + 2 * i);
+    if (off < 0 || namesBase + off >= (size_t)eTableSize) return "";
+    return readStr(data, eTableAt + namesBase + off, eEnd);
+  };
+  for (int i = 0; i < eBools; ++i) {
+    auto n = name(i);
+    if (data[eBoolsAt + i] == 1 && !n.empty()) boolCaps.push_back(n);
+  }
+  for (int i = 0; i < eNums; ++i) {
+    int val = readNum(data, eNumsAt + i * numSize, numSize);
+    auto n = name(eBools + i);
+    if (val >= 0 && !n.empty()) numCaps[n] = unsigned(val);
+  }
+  for (int i = 0; i < eStrs; ++i) {
+    int off = readShort(data, eStrsAt + 2 * i);
+    auto n = name(eBools + eNums + i);
+    if (off >= 0 && off < eTableSize && !n.empty())
+      strCaps[n] = readStr(data, eTableAt + off, eEnd);
+  }
+  return true;
+}
+
+bool InfoCmp::loadCache(const std::string& file, const std::string& compiled,
+                        int64_t mtime) {
+  if (!isFile(file)) return false;
+  auto lines = split(slurp(file), '\n');
+  if (lines.size() < 2 || lines[0] != CacheVersion ||
+     lines[1] != format("%s\t%lld", compiled.c_str(), (long long)mtime))
+    return false;
+  clear();
+  for (size_t i = 2; i < lines.size(); ++i) {
+    const auto& line = lines[i];
+    auto tab = line.find('\t', 2);
+    bool ok = line.size() >= 2 && line[1] == '\t';
+    if (ok && line[0] == 'h') header = unescape(line.substr(2));
+    else if (ok && line[0] == 'b') boolCaps.push_back(line.substr(2));
+    else if (ok && line[0] == 'n' && tab != std::string::npos)
+      numCaps[line.substr(2, tab - 2)] =
+        unsigned(str2num(line.substr(tab + 1)));
+    else if (ok && line[0] == 's' && tab != std::string::npos)
+      strCaps[line.substr(2, tab - 2)] = unescape(line.substr(tab + 1));
+    else {
+      INFO("InfoCmp: corrupt cache '%s' at line %lu\n", file.c_str(), i + 1);
+      clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+void InfoCmp::saveCache(const std::string& file, const std::string& compiled,
+                        int64_t mtime) const {
+  makeDir(dirname(file));
+  // write and rename, so that concurrent readers never see a partial cache
+  auto tmp = format("%s.%d", file.c_str(), (int)getpid());
+  FILE* fp = fopen(tmp.c_str(), "w");
+  if (fp == nullptr) {
+    INFO("InfoCmp: failed to write cache '%s'\n", tmp.c_str());
+    return;
+  }
+  fprintf(fp, "%s\n%s\t%lld\n", CacheVersion, compiled.c_str(),
+          (long long)mtime);
+  fprintf(fp, "h\t%s\n", escape(header).c_str());
+  for (const auto& b : boolCaps) fprintf(fp, "b\t%s\n", b.c_str());
+  for (const auto& n : numCaps)
+    fprintf(fp, "n\t%s\t%u\n", n.first.c_str(), n.second);
+  for (const auto& s : strCaps)
+    fprintf(fp, "s\t%s\t%s\n", s.first.c_str(), escape(s.second).c_str());
+  fclose(fp);
+  if (rename(tmp.c_str(), file.c_str()) != 0) remove(tmp.c_str());
+}
+
+void InfoCmp::runInfoCmp(const std::string& term) {
+  clear();
+  source = Src_InfoCmp;
+  auto ret = check_output("infocmp -1 -G " + term);
   ASSERT(ret.status == 0, "'infocmp' command failed! status=%d err=%s",
          ret.status, ret.error.c_str());
   auto lines = split(ret.output, '\n');
@@ -1,11 +1,24 @@
 #pragma once
 
 #include "utils.h"
+#include <stdint.h>
 #include <unordered_map>
 
 namespace teditor {
 
+/**
+ * @brief Capabilities of a terminal. These are read, in the order of
+ * preference, from the cache (if asked for), by directly parsing its compiled
+ * terminfo entry or as the last resort by running the 'infocmp' command.
+ */
 struct InfoCmp {
+  /** where the capabilities were read from */
+  enum Source {
+    Src_Cache,
+    Src_Compiled,
+    Src_InfoCmp
+  };
+
   // header
   std::string header;
   // boolean capabilities
@@ -14,10 +27,43 @@ struct InfoCmp {
   std::unordered_map<std::string, unsigned> numCaps;
   // string capabilities
   std::unordered_map<std::string, std::string> strCaps;
+  Source source;
 
+  /** capabilities of the current terminal (as per $TERM), without caching */
   InfoCmp();
 
+  /**
+   * @brief ctor
+   * @param term name of the terminal. Empty string creates an empty database
+   * @param cacheDir folder to cache the parsed capabilities in. Cache entries
+   *                 are keyed by the terminal name and the mtime of its
+   *                 compiled terminfo entry. Empty string disables caching.
+   */
+  InfoCmp(const std::string& term, const std::string& cacheDir="");
+
   std::string getStrCap(const std::string& cap) const;
+
+  /**
+   * @brief parses a compiled terminfo entry, in both the legacy and the 32-bit
+   * number formats, along with its extended capabilities, if any
+   * @return false if the file is not a valid terminfo entry
+   */
+  bool parseCompiled(const std::string& file);
+
+  /**
+   * @brief finds the compiled terminfo entry of a terminal, by looking into
+   * the same set of folders as ncurses does
+   * @return path to the entry, empty string if none could be found
+   */
+  static std::string findCompiled(const std::string& term);
+
+private:
+  void clear();
+  void runInfoCmp(const std::string& term);
+  bool loadCache(const std::string& file, const std::string& compiled,
+                 int64_t mtime);
+  void saveCache(const std::string& file, const std::string& compiled,
+                 int64_t mtime) const;
 };  // struct InfoCmp
 
 }  // namespace teditor
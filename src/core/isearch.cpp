@@ -27,7 +27,7 @@ std::string ISearch::getFinalStr(int idx, const std::string& str) const {
   return at(idx);
 }
 
-const std::string& ISearch::at(int idx) const {
+std::string ISearch::at(int idx) const {
   return ml.at(idx).get();
 }
 
@@ -53,7 +53,7 @@ void ISearch::reset() {
 void ISearch::searchBuffer() {
   int len = ml.length();
   for(int i=0;i<len;++i) {
-    const auto& str = ml.at(i).get();
+    const auto& str = ml.at(i);
     std::vector<int> res;
     noCase ? iSearchLine(str, res) : searchLine(str, res);
     if(!res.empty()) matches[i] = res;
@@ -70,26 +70,27 @@ void ISearch::updateMainBuffer(CmdMsgBar& cmBar) {
   ml.gotoLine(loc, win.dim());
 }
 
-void ISearch::searchLine(const std::string& str, std::vector<int>& res) {
-  size_t len = str.size();
-  size_t loc = 0;
-  while(loc < len) {
-    loc = str.find(curr, loc);
-    if(loc == std::string::npos) break;
-    res.push_back((int)loc);
-    loc += curr.size();
+void ISearch::searchLine(const Line& line, std::vector<int>& res) {
+  const char* str = line.c_str();
+  auto itr = str, end = str + line.length();
+  while(itr != end) {
+    auto pos = std::search(itr, end, curr.begin(), curr.end());
+    if(pos == end) break;
+    res.push_back(int(pos - str));
+    itr = pos + curr.size();
   }
 }
 
-void ISearch::iSearchLine(const std::string& str, std::vector<int>& res) {
-  auto itr = str.begin(), end = str.end();
+void ISearch::iSearchLine(const Line& line, std::vector<int>& res) {
+  const char* str = line.c_str();
+  auto itr = str, end = str + line.length();
   while (itr != end) {
     auto pos = std::search(itr, end, curr.begin(), curr.end(),
                            [] (char a, char b) {
                              return std::tolower(a) == std::tolower(b);
                            });
     if (pos == end) break;
-    int loc = pos - str.begin();
+    int loc = pos - str;
     res.push_back(loc);
     itr = pos + curr.size();
   }
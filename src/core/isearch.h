@@ -20,7 +20,7 @@ class ISearch: public Choices {
 public:
   ISearch(Window& w, bool _noCase);
 
-  const std::string& at(int idx) const;
+  std::string at(int idx) const;
   int size() const { return ml.length(); }
   bool updateChoices(const std::string& str);
   std::string getFinalStr(int idx, const std::string& str) const;
@@ -49,8 +49,8 @@ private:
   bool noCase;
 
   void searchBuffer();
-  void searchLine(const std::string& str, std::vector<int>& res);
-  void iSearchLine(const std::string& str, std::vector<int>& res);
+  void searchLine(const Line& line, std::vector<int>& res);
+  void iSearchLine(const Line& line, std::vector<int>& res);
 };
 
 } // end namespace teditor
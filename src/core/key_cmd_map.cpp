@@ -1,5 +1,6 @@
 #include "key_cmd_map.h"
 #include "utils.h"
+#include <algorithm>
 
 namespace teditor {
 
@@ -10,42 +11,138 @@ void KeyCmdMap::add(char key, const std::string& cmd) {
 }
 
 void KeyCmdMap::add(const std::string& keySeq, const std::string& cmd) {
-  keyTree.add(keySeq, cmd);
-  key2cmd[keySeq] = cmd;
-  cmd2key[cmd] = keySeq;
+  KeySeq seq;
+  bool ok = parseKeySeq(keySeq, seq);
+  ASSERT(ok, "KeyCmdMap::add: bad key sequence '%s'!",
+         keySeq.c_str());
+  if(seq.empty()) return;
+  // a key sequence can neither be a prefix of nor be prefixed by another one
+  auto itr = bindings.lower_bound(seq);
+  if(itr != bindings.end() && itr->first.size() > seq.size())
+    ASSERT(!std::equal(seq.begin(), seq.end(), itr->first.begin()),
+           "KeyCmdMap::add: '%s' is a prefix of another key sequence!",
+           keySeq.c_str());
+  for(size_t len = 1; len < seq.size(); ++len)
+    ASSERT(bindings.find(KeySeq(seq.begin(), seq.begin() + len)) ==
+           bindings.end(),
+           "KeyCmdMap::add: '%s' is prefixed by another key sequence!",
+           keySeq.c_str());
+  auto& old = bindings[seq];
+  auto citr = cmd2key.find(old);
+  if(citr != cmd2key.end() && citr->second == seq) cmd2key.erase(citr);
+  old = cmd;
+  cmd2key[cmd] = seq;
+  dirty = true;
 }
 
-TrieStatus KeyCmdMap::traverse(const std::string& currKey) {
-  if (currNode == nullptr) currNode = keyTree.getRoot();
-  currNode = currNode->getNode(currKey);
-  if(currNode == nullptr) return TS_NULL;
-  if(currNode->leaf()) return TS_LEAF;
-  return TS_NON_LEAF;
+const int KeyCmdMap::Root;
+
+TrieStatus KeyCmdMap::traverse(int& state, const MetaKey& currKey) const {
+  ASSERT(!dirty, "KeyCmdMap::traverse: map not compiled after its change!");
+  const auto& st = states[state < 0 ? 0 : state];
+  const auto* begin = edges.data() + st.begin;
+  const auto* end = edges.data() + st.end;
+  key_t k = currKey.intern();
+  const auto* itr = std::lower_bound(
+    begin, end, k, [](const Edge& e, key_t key) { return e.key < key; });
+  if(itr == end || itr->key != k) {
+    state = Root;
+    return TS_NULL;
+  }
+  state = itr->next;
+  return states[state].leaf >= 0 ? TS_LEAF : TS_NON_LEAF;
+}
+
+TrieStatus KeyCmdMap::traverse(int& state, const std::string& currKey) const {
+  MetaKey mk;
+  if(!MetaKey::parse(currKey, mk)) {
+    state = Root;
+    return TS_NULL;
+  }
+  return traverse(state, mk);
 }
 
-const std::string KeyCmdMap::getCmd() const {
-  if (currNode == nullptr || !currNode->leaf()) return "";
-  return currNode->data();
+const std::string KeyCmdMap::getCmd(int state) const {
+  if(dirty || state < 0 || states[state].leaf < 0) return "";
+  return leaves[states[state].leaf].cmd;
+}
+
+OperateFunc KeyCmdMap::getFunc(int state) const {
+  if(dirty || state < 0 || states[state].leaf < 0) return nullptr;
+  return leaves[states[state].leaf].func;
 }
 
 void KeyCmdMap::eraseKey(const std::string& key) {
-  auto itr = key2cmd.find(key);
-  if (itr == key2cmd.end()) return;
-  keyTree.del(key);
-  key2cmd.erase(itr);
-  for (auto& cmditr : cmd2key) {
-    if (cmditr.second == key) {
-      cmd2key.erase(cmditr.first);
-      break;
-    }
-  }
+  KeySeq seq;
+  if(!parseKeySeq(key, seq)) return;
+  auto itr = bindings.find(seq);
+  if(itr == bindings.end()) return;
+  auto citr = cmd2key.find(itr->second);
+  if(citr != cmd2key.end() && citr->second == seq) cmd2key.erase(citr);
+  bindings.erase(itr);
+  dirty = true;
 }
 
 void KeyCmdMap::clear() {
-  key2cmd.clear();
+  bindings.clear();
   cmd2key.clear();
-  keyTree.clear();
-  currNode = nullptr;
+  dirty = true;
+}
+
+void KeyCmdMap::compile() {
+  states.clear();
+  edges.clear();
+  leaves.clear();
+  std::vector<const Bindings::value_type*> bs;
+  for(const auto& b : bindings) bs.push_back(&b);
+  states.push_back({0, 0, -1});
+  build(0, bs, 0, (int)bs.size(), 0);
+  dirty = false;
+}
+
+void KeyCmdMap::build(int state,
+                      const std::vector<const Bindings::value_type*>& bs,
+                      int lo, int hi, size_t depth) {
+  // bs[lo, hi) share their first 'depth' keys and are all longer than that.
+  // Being sorted, those with the same next key are contiguous too
+  std::vector<int> starts;
+  for(int i = lo; i < hi; ++i)
+    if(i == lo || bs[i]->first[depth] != bs[i - 1]->first[depth])
+      starts.push_back(i);
+  starts.push_back(hi);
+  int begin = (int)edges.size(), num = (int)starts.size() - 1;
+  states[state].begin = begin;
+  states[state].end = begin + num;
+  for(int g = 0; g < num; ++g) {
+    edges.push_back({bs[starts[g]]->first[depth], (int)states.size()});
+    states.push_back({0, 0, -1});
+  }
+  for(int g = 0; g < num; ++g) {
+    int child = edges[begin + g].next;
+    const auto& b = *bs[starts[g]];
+    // prefixes are rejected in 'add', so a leaf is the only one in its group
+    if(b.first.size() == depth + 1) {
+      states[child].leaf = (int)leaves.size();
+      leaves.push_back({b.second, findCmd(b.second)});
+    } else {
+      build(child, bs, starts[g], starts[g + 1], depth + 1);
+    }
+  }
+}
+
+bool KeyCmdMap::parseKeySeq(const std::string& keySeq, KeySeq& seq) {
+  seq.clear();
+  // special case of just a space!
+  Strings keys;
+  if(keySeq == " ") keys.push_back(keySeq);
+  else keys = split(keySeq, ' ');
+  for(const auto& k : keys) {
+    if(k.empty()) continue;
+    MetaKey mk;
+    if(!MetaKey::parse(k, mk)) return false;
+    seq.push_back(mk.intern());
+  }
+  return true;
 }
 
 } // end namespace teditor
@@ -1,6 +1,12 @@
 #pragma once
 
-#include "trie.h"
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "command.h"
+#include "keys.h"
+#include "utils.h"
 
 namespace teditor {
 
@@ -16,22 +22,78 @@ struct KeyCmdPair {
 };
 
 
+/**
+ * @brief Key bindings of a mode. Key sequences are interned into lists of
+ * integers (see MetaKey::intern) while binding and the whole map gets compiled
+ * into a flat transition table, with the edges of every state sorted by their
+ * keys. Commands get resolved to their functions at the same time. Thus, the
+ * per-keystroke traversal is just a binary search over a handful of integers.
+ * The map holds no traversal state of its own, the callers keep that instead,
+ * so that the same map can be shared by all the buffers of a mode.
+ */
 class KeyCmdMap {
 public:
-  KeyCmdMap(): key2cmd(), cmd2key(), keyTree(), currNode(nullptr) {}
+  KeyCmdMap(): bindings(), cmd2key(), states(), edges(), leaves(),
+               dirty(true) {}
   void add(char key, const std::string& cmd);
   void add(const std::string& keySeq, const std::string& cmd);
   void add(const KeyCmdPair& pair) { add(pair.keySeq, pair.cmd); }
-  TrieStatus traverse(const std::string& currKey);
-  void resetTraversal() { currNode = keyTree.getRoot(); }
-  const std::string getCmd() const;
+  /**
+   * @brief moves the given state to the next one on the given key. On a miss,
+   * the state is reset to 'Root'. This allocates nothing. The map must have
+   * been compiled after its latest change
+   */
+  TrieStatus traverse(int& state, const MetaKey& currKey) const;
+  TrieStatus traverse(int& state, const std::string& currKey) const;
+  /** command at the given state, empty if it is not a leaf */
+  const std::string getCmd(int state) const;
+  /** function of the command at the given state, nullptr if unavailable */
+  OperateFunc getFunc(int state) const;
   void clear();
   void eraseKey(const std::string& key);
+  /** whether any key is bound to the given command */
+  bool hasCmd(const std::string& cmd) const {
+    return cmd2key.find(cmd) != cmd2key.end();
+  }
+  /** builds the transition table. To be called after changing the bindings */
+  void compile();
+
+  /** state to start every traversal from */
+  static const int Root = -1;
 
 private:
-  std::unordered_map<std::string, std::string> key2cmd, cmd2key;
-  Trie keyTree;
-  Node* currNode;
+  typedef std::vector<key_t> KeySeq;
+  typedef std::map<KeySeq, std::string> Bindings;
+
+  struct State {
+    /** range of this state's outgoing edges */
+    int begin, end;
+    /** index into 'leaves', -1 for non-leaf states */
+    int leaf;
+  };  // struct State
+
+  struct Edge {
+    key_t key;
+    int next;
+  };  // struct Edge
+
+  struct Leaf {
+    std::string cmd;
+    OperateFunc func;
+  };  // struct Leaf
+
+  /** all the key bindings, sorted by their interned key sequences */
+  Bindings bindings;
+  std::unordered_map<std::string, KeySeq> cmd2key;
+  /** the transition table, with 0 being the root state */
+  std::vector<State> states;
+  std::vector<Edge> edges;
+  std::vector<Leaf> leaves;
+  bool dirty;
+
+  static bool parseKeySeq(const std::string& keySeq, KeySeq& seq);
+  void build(int state, const std::vector<const Bindings::value_type*>& bs,
+             int lo, int hi, size_t depth);
 };
 
 
@@ -42,6 +104,7 @@ void populateKeyMap(KeyCmdMap& kcm, bool clear=false) {
     if (kc.cmd.empty()) kcm.eraseKey(kc.keySeq);
     else kcm.add(kc);
   }
+  kcm.compile();
 }
 
 }; // end namespace teditor
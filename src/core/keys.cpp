@@ -2,6 +2,9 @@
 #include "utf8.h"
 #include "logger.h"
 #include "utils.h"
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
 
 
 namespace teditor {
@@ -56,6 +59,56 @@ std::string MetaKey::toStr() const {
   return ret;
 }
 
+key_t MetaKey::intern() const {
+  if(isInvalid()) return key;
+  // keep this in sync with the aliases produced by 'toStr'
+  key_t k = getKey();
+  if(k == Key_CtrlTilde) k = Key_Tilde;
+  else if(Key_CtrlA <= k && k <= Key_CtrlZ) {
+    if(k == Key_Backspace) k = Key_Backspace2;
+    else if(k != Key_Tab && k != Key_Enter) k = k - Key_CtrlA + Key_A;
+  } else if(k == Key_CtrlBackslash) k = Key_BackSlash;
+  else if(k == Key_Ctrl6) k = Key_Six;
+  else if(k == Key_CtrlUnderscore) k = Key_Underscore;
+  return getMeta() | k;
+}
+
+bool MetaKey::parse(const std::string& str, MetaKey& mk) {
+  static const std::unordered_map<std::string, key_t> names = {
+    {"insert", Key_Insert}, {"del", Key_Delete}, {"home", Key_Home},
+    {"end", Key_End}, {"pageup", Key_PageUp}, {"pagedown", Key_PageDown},
+    {"left", Key_ArrowLeft}, {"right", Key_ArrowRight},
+    {"down", Key_ArrowDown}, {"up", Key_ArrowUp}, {"tab", Key_Tab},
+    {"enter", Key_Enter}, {"esc", Key_Esc}, {"backspace", Key_Backspace2}};
+  key_t m = Meta_None;
+  size_t pos = 0;
+  for(; pos + 2 < str.size() && str[pos + 1] == '-'; pos += 2) {
+    if(str[pos] == 'C') m |= Meta_Ctrl;
+    else if(str[pos] == 'M') m |= Meta_Alt;
+    else if(str[pos] == 'S') m |= Meta_Shift;
+    else break;
+  }
+  auto k = str.substr(pos);
+  if(k.size() == 1) {
+    if((key_t)k[0] < Key_Space || (key_t)k[0] > Key_Tilde) return false;
+    mk = MetaKey(m, (key_t)k[0]);
+    return true;
+  }
+  auto itr = names.find(k);
+  if(itr != names.end()) {
+    mk = MetaKey(m, itr->second);
+    return true;
+  }
+  if(k.size() >= 2 && k.size() <= 3 && k[0] == 'F' &&
+     std::all_of(k.begin() + 1, k.end(), ::isdigit)) {
+    int num = str2num(k.substr(1));
+    if(num < 1 || num > 12) return false;
+    mk = MetaKey(m, Key_F1 - (key_t)(num - 1));
+    return true;
+  }
+  return false;
+}
+
 bool operator==(const MetaKey& mk1, const MetaKey& mk2) {
   return mk1.getFull() == mk2.getFull();
 }
@@ -197,6 +197,20 @@ struct MetaKey {
   void setMeta(key_t m) { key = (m & ~Mask) | getKey(); }
   void updateMeta(key_t m) { key = (m & ~Mask) | key; }
   std::string toStr() const;
+  /**
+   * @brief interned id of this key. Keys which have the same string
+   * representation (eg: 'C-h' and 'C-backspace') get the same id, thus making
+   * it usable for key lookups without ever going through the strings.
+   */
+  key_t intern() const;
+
+  /**
+   * @brief inverse of toStr
+   * @param str the key string, eg: 'C-M-x', 'F5', 'pageup'
+   * @param mk the parsed key
+   * @return false if the string does not represent a valid key
+   */
+  static bool parse(const std::string& str, MetaKey& mk);
 
 private:
   key_t key;
@@ -1,81 +1,408 @@
 #include "line.h"
+#include <algorithm>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <vector>
+#include "utf8.h"
+#include "utils.h"
 
 
 namespace teditor {
 
+const int Line::InlineCap;
+
+/**
+ * run of consecutive chars which all have the same encoded length and display
+ * width, at least one of them not being 1. Bytes outside of these runs are
+ * single column ASCII (or malformed) chars, mapping 1:1 to the columns.
+ */
+struct ColumnRun {
+  /** byte offset and display column of the first char */
+  int byte, col;
+  /** number of chars in this run */
+  int count;
+  /** encoded length and display width of each char */
+  uint8_t nBytes, wid;
+
+  int endByte() const { return byte + count * nBytes; }
+  int endCol() const { return col + count * wid; }
+};
+
+/**
+ * mapping between the byte offsets and display columns of non-ASCII lines. It
+ * only stores the runs of multibyte chars, so that mostly ASCII lines with a
+ * few of them, as well as lines full of (say) CJK text, need only a few runs.
+ */
+struct Line::ColumnIndex {
+  /** sorted by both their byte offsets and columns */
+  std::vector<ColumnRun> runs;
+  /** total number of columns in the line */
+  int numCols;
+  /** whether there's a char occupying more than one column */
+  bool hasWide;
+  /** width used for the cached wrapped layout below (0 if not computed) */
+  mutable int wrapWid;
+  /** byte offsets where each row of the wrapped layout starts */
+  mutable std::vector<int> rowStart;
+
+  /** the last run starting at or before the given byte offset (or null) */
+  const ColumnRun* runAtByte(int idx) const {
+    auto itr = std::upper_bound(runs.begin(), runs.end(), idx,
+      [](int i, const ColumnRun& r) { return i < r.byte; });
+    return itr == runs.begin() ? nullptr : &*(itr - 1);
+  }
+
+  /** the last run starting at or before the given column (or null) */
+  const ColumnRun* runAtCol(int c) const {
+    auto itr = std::upper_bound(runs.begin(), runs.end(), c,
+      [](int i, const ColumnRun& r) { return i < r.col; });
+    return itr == runs.begin() ? nullptr : &*(itr - 1);
+  }
+
+  int byte2col(int idx) const {
+    const auto* r = runAtByte(idx);
+    if(r == nullptr) return idx;
+    if(idx < r->endByte()) return r->col + (idx - r->byte) / r->nBytes * r->wid;
+    return r->endCol() + idx - r->endByte();
+  }
+
+  int col2byte(int c) const {
+    const auto* r = runAtCol(c);
+    if(r == nullptr) return c;
+    if(c < r->endCol()) return r->byte + (c - r->col) / r->wid * r->nBytes;
+    return r->endByte() + c - r->endCol();
+  }
+
+  int nextChar(int idx) const {
+    const auto* r = runAtByte(idx);
+    if(r == nullptr || idx >= r->endByte()) return idx + 1;
+    return r->byte + ((idx - r->byte) / r->nBytes + 1) * r->nBytes;
+  }
+};
+
+Line::ColumnIndex* Line::asciiIndex() {
+  static ColumnIndex ascii;
+  return &ascii;
+}
+
+static bool isAscii(const char* c, int count) {
+  int i = 0;
+  // 8 bytes at a time for the bulk of the line
+  for(; i + 8 <= count; i += 8) {
+    uint64_t word;
+    memcpy(&word, c + i, sizeof(word));
+    if(word & 0x8080808080808080ULL) return false;
+  }
+  for(; i < count; ++i)
+    if(c[i] & 0x80) return false;
+  return true;
+}
+
+Line::Line(const Line& other): arena(other.arena), len(0), cap(InlineCap),
+                               cols(nullptr) {
+  data.buff[0] = '\0';
+  append(other.c_str(), other.len);
+}
+
+Line::Line(Line&& other) noexcept: arena(other.arena), len(0),
+                                   cap(InlineCap), cols(nullptr) {
+  steal(other);
+}
+
+Line& Line::operator=(const Line& other) {
+  if(this == &other) return *this;
+  // keep storing in our own arena, if we have one
+  if(arena == nullptr) {
+    freeStorage();
+    arena = other.arena;
+  }
+  len = 0;
+  reserve(other.len);
+  memcpy(buff(), other.c_str(), other.len + 1);
+  len = other.len;
+  if(cols != asciiIndex()) delete cols;
+  cols = other.cols == asciiIndex() ? asciiIndex() : nullptr;
+  return *this;
+}
+
+Line& Line::operator=(Line&& other) noexcept {
+  if(this == &other) return *this;
+  freeStorage();
+  if(cols != asciiIndex()) delete cols;
+  arena = other.arena;
+  steal(other);
+  return *this;
+}
+
+void Line::steal(Line& other) {
+  len = other.len;
+  cap = other.cap;
+  if(other.isInline()) memcpy(data.buff, other.data.buff, len + 1);
+  else data.ptr = other.data.ptr;
+  other.len = 0;
+  other.cap = InlineCap;
+  other.data.buff[0] = '\0';
+  cols = other.cols;
+  other.cols = nullptr;
+}
+
+void Line::freeStorage() {
+  if(isInline()) return;
+  if(arena != nullptr) arena->free(data.ptr, cap);
+  else ::free(data.ptr);
+  cap = InlineCap;
+  len = 0;
+  data.buff[0] = '\0';
+}
+
+void Line::reserve(int size) {
+  if(size < cap) return;
+  int newCap = std::max(size + 1, cap * 2);
+  char* ptr;
+  if(arena != nullptr) {
+    ptr = arena->alloc(newCap);
+  } else {
+    ptr = (char*)malloc(newCap);
+    ASSERT(ptr != nullptr, "Line: failed to allocate %d B!", newCap);
+  }
+  memcpy(ptr, c_str(), len + 1);
+  int oldLen = len;
+  freeStorage();
+  data.ptr = ptr;
+  cap = newCap;
+  len = oldLen;
+}
+
+void Line::append(const char* c) { append(c, (int)strlen(c)); }
+
+void Line::append(const char* c, int n) {
+  if(n <= 0) return;
+  reserve(len + n);
+  auto* b = buff();
+  memcpy(b + len, c, n);
+  len += n;
+  b[len] = '\0';
+  resetCols(c, n);
+}
+
+void Line::insert(const char* c, int idx) { insert(c, (int)strlen(c), idx); }
+
+void Line::insert(const char* c, int count, int idx) {
+  if(idx >= length()) {
+    append(c, count);
+    return;
+  }
+  if(count <= 0) return;
+  reserve(len + count);
+  auto* b = buff();
+  memmove(b + idx + count, b + idx, len - idx + 1);
+  memcpy(b + idx, c, count);
+  len += count;
+  resetCols(c, count);
+}
+
 std::string Line::erase(int idx, int count) {
   std::string ret;
   if(idx >= length() || (idx+count) > length()) return ret;
-  ret = line.substr(idx, count);
-  line.erase(line.begin()+idx, line.begin()+idx+count);
+  auto* b = buff();
+  ret.assign(b + idx, count);
+  memmove(b + idx, b + idx + count, len - idx - count + 1);
+  len -= count;
+  resetCols();
   return ret;
 }
 
 Line Line::split(int idx) {
-  Line other;
+  Line other(arena);
   if(idx >= length() || idx < 0) return other;
-  auto del = erase(idx, length()-idx);
-  other.append(del);
+  other.append(c_str() + idx, len - idx);
+  len = idx;
+  buff()[len] = '\0';
+  resetCols();
   return other;
 }
 
-// This is wierd!! If empty check is not done, some garbage string seems to be
-// appended everytime!
-void Line::join(const Line& other) {
-  if(!other.empty()) append(other.get());
-}
+void Line::join(const Line& other) { append(other.c_str(), other.len); }
 
 void Line::prepend(char c, int count) {
   std::string tmp(count, c);
   prepend(tmp.c_str());
 }
 
-void Line::insert(char c, int idx) {
-  if(idx >= length()) append(c);
-  else line.insert(line.begin()+idx, c);
-}
-
-void Line::insert(const char* c, int idx) {
-  if(idx >= length()) append(c);
-  else line.insert(idx, c);
-}
-
-void Line::insert(const std::string& str, int idx) {
-  if(idx >= length()) append(str);
-  else line.insert(idx, str);
-}
-
 int Line::numLinesNeeded(int wid) const {
-  int len = length();
   // an empty line is still a line!
   if(len <= 0) return 1;
-  return (len + wid - 1) / wid;
+  const auto* ci = columns();
+  if(ci == nullptr || !ci->hasWide) return (numCols() + wid - 1) / wid;
+  wrap(ci, wid);
+  return (int)ci->rowStart.size();
 }
 
 int Line::findFirstNotOf(const std::string& str, int pos) const {
-  auto res = line.find_first_not_of(str, pos);
-  if(res == std::string::npos) return line.length();
-  return (int)res;
+  const auto* s = c_str();
+  for(int i = std::max(pos, 0); i < len; ++i)
+    if(str.find(s[i]) == std::string::npos) return i;
+  return len;
 }
 
 int Line::findLastNotOf(const std::string& str, int pos) const {
-  auto res = line.find_last_not_of(str, pos);
-  if(res == std::string::npos) return 0;
-  return (int)res;
+  const auto* s = c_str();
+  for(int i = std::min(pos, len - 1); i >= 0; --i)
+    if(str.find(s[i]) == std::string::npos) return i;
+  return 0;
 }
 
 int Line::indentSize() const {
-  auto pos = line.find_first_not_of(' ');
-  if(pos == std::string::npos) return 0;
-  return (int)pos;
+  const auto* s = c_str();
+  int i = 0;
+  while(i < len && s[i] == ' ') ++i;
+  return i < len ? i : 0;
+}
+
+
+void Line::resetCols(const char* c, int count) {
+  if(cols == nullptr) return;
+  if(cols == asciiIndex()) {
+    if(count <= 0 || isAscii(c, count)) return;
+  } else {
+    delete cols;
+  }
+  cols = nullptr;
+}
+
+const Line::ColumnIndex* Line::columns() const {
+  if(cols == asciiIndex()) return nullptr;
+  if(cols != nullptr) return cols;
+  const auto* s = c_str();
+  if(isAscii(s, len)) {
+    cols = asciiIndex();
+    return nullptr;
+  }
+  auto* ci = new ColumnIndex;
+  ci->hasWide = false;
+  ci->wrapWid = 0;
+  int col = 0;
+  for(int i = 0; i < len;) {
+    int n = Utf8::charLen(s[i]), w = 1;
+    bool valid = n > 1 && i + n <= len;
+    for(int j = 1; valid && j < n; ++j) valid = (s[i + j] & 0xC0) == 0x80;
+    // malformed sequences are shown one byte at a time
+    if(valid) {
+      uint32_t u;
+      Utf8::char2unicode(&u, s + i);
+      w = Utf8::width(u);
+    } else {
+      n = 1;
+    }
+    if(w > 1) ci->hasWide = true;
+    if(n != 1 || w != 1) {
+      auto& runs = ci->runs;
+      if(!runs.empty() && runs.back().nBytes == n && runs.back().wid == w &&
+         runs.back().endByte() == i)
+        ++runs.back().count;
+      else
+        runs.push_back({i, col, 1, (uint8_t)n, (uint8_t)w});
+    }
+    col += w;
+    i += n;
+  }
+  ci->numCols = col;
+  ci->runs.shrink_to_fit();
+  cols = ci;
+  return ci;
 }
 
+int Line::byte2col(int idx) const {
+  const auto* ci = columns();
+  if(ci == nullptr || idx < 0) return idx;
+  if(idx >= len) return ci->numCols + idx - len;
+  return ci->byte2col(idx);
+}
+
+int Line::col2byte(int col) const {
+  const auto* ci = columns();
+  if(ci == nullptr) return std::min(col, len);
+  if(col < 0) return 0;
+  if(col >= ci->numCols) return len;
+  return ci->col2byte(col);
+}
+
+int Line::numCols() const {
+  const auto* ci = columns();
+  return ci == nullptr ? len : ci->numCols;
+}
+
+int Line::nextChar(int idx) const {
+  const auto* ci = columns();
+  if(ci == nullptr || idx < 0 || idx >= len) return idx + 1;
+  return ci->nextChar(idx);
+}
+
+int Line::prevChar(int idx) const {
+  const auto* ci = columns();
+  if(ci == nullptr || idx <= 0 || idx > len) return idx - 1;
+  int col = byte2col(idx);
+  return col <= 0 ? 0 : ci->col2byte(col - 1);
+}
+
+void Line::wrap(const ColumnIndex* ci, int wid) const {
+  if(ci->wrapWid == wid) return;
+  ci->wrapWid = wid;
+  ci->rowStart.assign(1, 0);
+  int x = 0;
+  for(int i = 0; i < len; i = nextChar(i)) {
+    int w = byte2col(nextChar(i)) - byte2col(i);
+    if(x > 0 && x + w > wid) {
+      ci->rowStart.push_back(i);
+      x = 0;
+    }
+    x += w;
+  }
+}
+
+void Line::screenPos(int idx, int wid, int& x, int& row) const {
+  const auto* ci = columns();
+  if(ci == nullptr || !ci->hasWide) {
+    int col = byte2col(idx);
+    x = col % wid;
+    row = col / wid;
+    return;
+  }
+  wrap(ci, wid);
+  const auto& rs = ci->rowStart;
+  row = int(std::upper_bound(rs.begin(), rs.end(), std::min(idx, len)) -
+            rs.begin()) - 1;
+  x = byte2col(idx) - byte2col(rs[row]);
+  // cursor at the end of a completely filled row goes to the next one
+  if(x >= wid) {
+    row += x / wid;
+    x %= wid;
+  }
+}
+
+int Line::screenIdx(int x, int row, int wid) const {
+  const auto* ci = columns();
+  if(ci == nullptr || !ci->hasWide) {
+    int col = row * wid + x;
+    return col < numCols() ? col2byte(col) : len + col - numCols();
+  }
+  wrap(ci, wid);
+  const auto& rs = ci->rowStart;
+  int nRows = (int)rs.size();
+  if(row >= nRows) return len + (row - nRows + 1) * wid + x;
+  int start = byte2col(rs[row]);
+  int end = row + 1 < nRows ? byte2col(rs[row + 1]) : numCols();
+  int col = start + x;
+  if(col < end) return col2byte(col);
+  // beyond the last char in this row
+  return row + 1 < nRows ? rs[row + 1] : len + col - end;
+}
 
 bool LineCompare(const Line& a, const Line& b) {
   if(a.empty()) return true;
   if(b.empty()) return false;
-  return strcmp(a.get().c_str(), b.get().c_str()) < 0;
+  return strcmp(a.c_str(), b.c_str()) < 0;
 }
 
 } // end namespace teditor
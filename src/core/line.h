@@ -1,30 +1,51 @@
 #pragma once
 
 #include <string>
+#include <type_traits>
+#include "line_arena.h"
 
 
 namespace teditor {
 
-///@todo: support for unicode in Line class
-
-/** Base class to store a line in the buffer */
+/**
+ * @brief Base class to store a line in the buffer. Short lines are stored
+ * inline in the object itself. Longer ones are stored in blocks obtained from
+ * the arena of the owning buffer (or from the system, if there's no arena).
+ * Contents are always null-terminated.
+ *
+ * Contents are UTF-8 encoded and all the editing functions work with byte
+ * offsets. The mapping between byte offsets and display columns is computed
+ * lazily and cached until the next edit. For pure ASCII lines, which is by far
+ * the most common case, this mapping is the identity and no index is stored.
+ */
 class Line {
 public:
-  Line() {}
+  Line(LineArena* a=nullptr): arena(a), len(0), cap(InlineCap),
+                              cols(nullptr) {
+    data.buff[0] = '\0';
+  }
+  Line(const Line& other);
+  Line(Line&& other) noexcept;
+  ~Line() { freeStorage(); resetCols(); }
+  Line& operator=(const Line& other);
+  Line& operator=(Line&& other) noexcept;
 
   /**
    * @defgroup Add Functions to append/prepend/insert chars to the line
    * @{
    */
-  void append(char c) { line.push_back(c); }
-  void append(const char* c) { line += c; }
-  void append(const std::string& str) { line += str; }
+  void append(char c) { append(&c, 1); }
+  void append(const char* c);
+  void append(const std::string& str) { append(str.c_str(), (int)str.size()); }
+  void append(const char* c, int n);
   void prepend(char c) { insert(c, 0); }
   void prepend(const char* c) { insert(c, 0); }
   void prepend(char c, int count);
-  void insert(char c, int idx);
+  void insert(char c, int idx) { insert(&c, 1, idx); }
   void insert(const char* c, int idx);
-  void insert(const std::string& str, int idx);
+  void insert(const std::string& str, int idx) {
+    insert(str.c_str(), (int)str.size(), idx);
+  }
   /** @} */
 
   /** erases from the given index and returns the erased chars */
@@ -42,19 +63,50 @@ public:
   int numLinesNeeded(int wid) const;
 
   /** Check for empty line */
-  bool empty() const { return line.empty(); }
+  bool empty() const { return len == 0; }
 
   /** Number of chars in the line */
-  int length() const { return (int)line.length(); }
+  int length() const { return len; }
+
+  /** get a copy of the string */
+  std::string get() const { return std::string(c_str(), len); }
 
-  /** get the string */
-  const std::string& get() const { return line; }
+  /** the null-terminated contents of the line */
+  const char* c_str() const { return isInline() ? data.buff : data.ptr; }
 
   /** access idx'th element in the line */
-  char at(int idx) const { return line[idx]; }
+  char at(int idx) const { return c_str()[idx]; }
 
   /** clear the line */
-  void clear() { line.clear(); }
+  void clear() { len = 0; buff()[0] = '\0'; resetCols(); }
+
+  /**
+   * @defgroup Columns Mapping between byte offsets and display columns
+   * @{
+   */
+  /** display column at which the char at the given byte offset starts */
+  int byte2col(int idx) const;
+  /** byte offset of the char covering the given display column */
+  int col2byte(int col) const;
+  /** number of display columns occupied by the whole line */
+  int numCols() const;
+  /** byte offset of the char following the one at idx */
+  int nextChar(int idx) const;
+  /** byte offset of the char preceding the one at idx */
+  int prevChar(int idx) const;
+  /**
+   * @brief screen location of the char at the given byte offset, when this
+   * line is wrapped at the given width. A wide char which doesn't fit at the
+   * end of a row is moved to the beginning of the next one.
+   * @param idx byte offset (can be the length of the line too)
+   * @param wid the width of the window
+   * @param x column inside the row
+   * @param row row relative to the first row of this line
+   */
+  void screenPos(int idx, int wid, int& x, int& row) const;
+  /** byte offset of the char at the given screen location (inverse of the above) */
+  int screenIdx(int x, int row, int wid) const;
+  /** @} */
 
   /**
    * Same as find_first_not_of function of std::string
@@ -71,11 +123,50 @@ public:
   /** measures the indentation at the beginning of this line */
   int indentSize() const;
 
+  /** bytes used by this line outside of the object itself */
+  int heapBytes() const { return isInline() ? 0 : cap; }
+
+  /** max storage (including the null char) available inside the object */
+  static const int InlineCap = 32;
+
 private:
-  /** string to be present on this line */
-  std::string line;
+  /** arena from where the storage of long lines are obtained */
+  LineArena* arena;
+  /** number of chars in the line */
+  int len;
+  /** size of the storage (including the null char) */
+  int cap;
+  union {
+    char buff[InlineCap];
+    char* ptr;
+  } data;
+
+  struct ColumnIndex;
+  /** lazily computed column index (see 'columns') */
+  mutable ColumnIndex* cols;
+  /** marker for the lines which are known to be pure ASCII */
+  static ColumnIndex* asciiIndex();
+
+  bool isInline() const { return cap <= InlineCap; }
+  char* buff() { return isInline() ? data.buff : data.ptr; }
+  void insert(const char* c, int count, int idx);
+  /** makes sure that there's room for atleast 'size' chars */
+  void reserve(int size);
+  void freeStorage();
+  /** takes over the storage of the other line and leaves it empty */
+  void steal(Line& other);
+  /** column index of this line, computing it if needed (null for ASCII) */
+  const ColumnIndex* columns() const;
+  /** invalidates the column index, but keeps the ASCII-ness if possible */
+  void resetCols(const char* c=nullptr, int count=0);
+  /** computes the wrapped layout of a line containing wide chars */
+  void wrap(const ColumnIndex* ci, int wid) const;
 };
 
+// else std::vector<Line> copies every line (and its storage) on reallocation
+static_assert(std::is_nothrow_move_constructible<Line>::value,
+              "Line must be nothrow move constructible!");
+
 
 /**
  * helper function to compare strings stored in the 2 lines.
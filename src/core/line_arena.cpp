@@ -0,0 +1,80 @@
+#include "line_arena.h"
+#include <stdlib.h>
+#include "utils.h"
+
+
+namespace teditor {
+
+const int LineArena::MinBlock;
+const int LineArena::MaxBlock;
+const int LineArena::SlabSize;
+
+LineArena::LineArena(): slabs(), curr(nullptr), left(0), st({0, 0, 0, 0}),
+                        releasing(false) {
+  for(int i = 0; i < NumClasses; ++i) freeLists[i] = nullptr;
+}
+
+LineArena::~LineArena() { release(); }
+
+int LineArena::sizeClass(int size) {
+  int cls = 0;
+  for(int blk = MinBlock; blk < size; blk <<= 1) ++cls;
+  return cls;
+}
+
+char* LineArena::alloc(int& size) {
+  if(size > MaxBlock) {
+    auto* ptr = (char*)malloc(size);
+    ASSERT(ptr != nullptr, "LineArena: failed to allocate %d B!", size);
+    st.largeBytes += size;
+    return ptr;
+  }
+  int cls = sizeClass(size);
+  size = MinBlock << cls;
+  st.usedBytes += size;
+  if(freeLists[cls] != nullptr) {
+    auto* blk = freeLists[cls];
+    freeLists[cls] = blk->next;
+    return (char*)blk;
+  }
+  // the leftover of the current slab (always a multiple of MinBlock) is simply
+  // abandoned, as it is never larger than the requested block
+  if(left < size) {
+    curr = (char*)malloc(SlabSize);
+    ASSERT(curr != nullptr, "LineArena: failed to allocate a slab!");
+    slabs.push_back(curr);
+    left = SlabSize;
+    st.slabBytes += SlabSize;
+    ++st.numSlabs;
+  }
+  auto* ptr = curr;
+  curr += size;
+  left -= size;
+  return ptr;
+}
+
+void LineArena::free(char* ptr, int size) {
+  if(size > MaxBlock) {
+    ::free(ptr);
+    st.largeBytes -= size;
+    return;
+  }
+  if(releasing) return;
+  int cls = sizeClass(size);
+  auto* blk = (FreeBlock*)ptr;
+  blk->next = freeLists[cls];
+  freeLists[cls] = blk;
+  st.usedBytes -= size;
+}
+
+void LineArena::release() {
+  for(auto* s : slabs) ::free(s);
+  slabs.clear();
+  curr = nullptr;
+  left = 0;
+  for(int i = 0; i < NumClasses; ++i) freeLists[i] = nullptr;
+  st.slabBytes = st.usedBytes = st.numSlabs = 0;
+  releasing = false;
+}
+
+} // end namespace teditor
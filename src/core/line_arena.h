@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+
+namespace teditor {
+
+/** memory footprint counters of a LineArena */
+struct ArenaStats {
+  /** total bytes reserved from the system for the slabs */
+  size_t slabBytes;
+  /** bytes of the slabs currently handed out to the lines */
+  size_t usedBytes;
+  /** bytes allocated outside of the slabs, for very long lines */
+  size_t largeBytes;
+  /** number of slabs */
+  size_t numSlabs;
+};
+
+
+/**
+ * @brief Slab allocator for the contents of the lines in a buffer. Blocks are
+ * carved out of large slabs in power-of-2 size classes and recycled through
+ * per-class free lists. Blocks larger than the biggest class are directly
+ * allocated from (and freed to) the system. The slabs are freed in one go when
+ * the arena is released or destroyed.
+ */
+class LineArena {
+public:
+  LineArena();
+  ~LineArena();
+
+  /**
+   * @brief allocates a block
+   * @param size minimum size in bytes. On return it contains the actual size
+   * of the block.
+   */
+  char* alloc(int& size);
+
+  /** returns the block (with the size as returned by alloc) to the arena */
+  void free(char* ptr, int size);
+
+  /**
+   * @brief Marks the beginning of a bulk release. Until release is called,
+   * free will not bother to recycle blocks.
+   */
+  void beginRelease() { releasing = true; }
+
+  /** frees all the memory. Every block handed out so far becomes invalid */
+  void release();
+
+  const ArenaStats& stats() const { return st; }
+
+  /** smallest block size handed out by the arena */
+  static const int MinBlock = 64;
+  /** largest block size handed out from the slabs */
+  static const int MaxBlock = 4096;
+  /** size of each slab */
+  static const int SlabSize = 64 * 1024;
+
+private:
+  /** intrusive free list node stored inside the freed blocks */
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  static const int NumClasses = 7;
+
+  std::vector<char*> slabs;
+  /** bump pointer and the remaining bytes in the current slab */
+  char* curr;
+  int left;
+  FreeBlock* freeLists[NumClasses];
+  ArenaStats st;
+  bool releasing;
+
+  static int sizeClass(int size);
+
+  LineArena(const LineArena&) = delete;
+  LineArena& operator=(const LineArena&) = delete;
+}; // end class LineArena
+
+}; // end namespace teditor
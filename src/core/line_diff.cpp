@@ -0,0 +1,82 @@
+#include "line_diff.h"
+#include <algorithm>
+
+
+namespace teditor {
+
+DiffHunks diffLines(const Strings& oldLines, const Strings& newLines,
+                    int maxEdits) {
+  DiffHunks ret;
+  int n = (int)oldLines.size(), m = (int)newLines.size();
+  // common prefix and suffix are very common in practice and cheap to find
+  int pre = 0;
+  while(pre < n && pre < m && oldLines[pre] == newLines[pre]) ++pre;
+  int suf = 0;
+  while(suf < n - pre && suf < m - pre &&
+        oldLines[n - 1 - suf] == newLines[m - 1 - suf]) ++suf;
+  const auto* a = oldLines.data() + pre;
+  const auto* b = newLines.data() + pre;
+  int na = n - pre - suf, nb = m - pre - suf;
+  if(na == 0 && nb == 0) return ret;
+  if(na == 0 || nb == 0) {
+    ret.push_back({pre, na, pre, nb});
+    return ret;
+  }
+  // forward search of Myers' algorithm. 'v[off + k]' is the furthest x reached
+  // on the diagonal k. Only the relevant part of 'v' is remembered after each
+  // step, for the backtracking later
+  int maxD = std::min(maxEdits, na + nb), off = maxD + 1;
+  std::vector<int> v(2 * off + 1, 0);
+  std::vector<std::vector<int>> trace;
+  int dFound = -1;
+  for(int d = 0; d <= maxD && dFound < 0; ++d) {
+    trace.push_back(std::vector<int>(v.begin() + off - d,
+                                     v.begin() + off + d + 1));
+    for(int k = -d; k <= d; k += 2) {
+      int x;
+      if(k == -d || (k != d && v[off + k - 1] < v[off + k + 1]))
+        x = v[off + k + 1];
+      else
+        x = v[off + k - 1] + 1;
+      int y = x - k;
+      while(x < na && y < nb && a[x] == b[y]) ++x, ++y;
+      v[off + k] = x;
+      if(x >= na && y >= nb) {
+        dFound = d;
+        break;
+      }
+    }
+  }
+  if(dFound < 0) {
+    ret.push_back({pre, na, pre, nb});
+    return ret;
+  }
+  // backtrack to collect the matching pairs of lines, in reverse order
+  std::vector<std::pair<int, int>> matches;
+  int x = na, y = nb;
+  for(int d = dFound; d > 0; --d) {
+    const auto& pv = trace[d];
+    auto at = [&](int k) { return pv[k + d]; };
+    int k = x - y;
+    int prevK = (k == -d || (k != d && at(k - 1) < at(k + 1))) ? k + 1 : k - 1;
+    int prevX = at(prevK), prevY = prevX - prevK;
+    int startX = prevK == k + 1 ? prevX : prevX + 1;
+    while(x > startX) matches.push_back({--x, --y});
+    x = prevX;
+    y = prevY;
+  }
+  while(x > 0) matches.push_back({--x, --y});
+  std::reverse(matches.begin(), matches.end());
+  // gaps between successive matches are the hunks
+  int pa = -1, pb = -1;
+  matches.push_back({na, nb});
+  for(const auto& mt : matches) {
+    int la = mt.first - pa - 1, lb = mt.second - pb - 1;
+    if(la > 0 || lb > 0) ret.push_back({pre + pa + 1, la, pre + pb + 1, lb});
+    pa = mt.first;
+    pb = mt.second;
+  }
+  return ret;
+}
+
+}; // end namespace teditor
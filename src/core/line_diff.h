@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include "utils.h"
+
+
+namespace teditor {
+
+/**
+ * @brief A contiguous change between two lists of lines. `oldLen` lines
+ * starting at `oldStart` in the old list got replaced with `newLen` lines
+ * starting at `newStart` in the new list. Either of the lengths can be 0.
+ */
+struct DiffHunk {
+  int oldStart, oldLen;
+  int newStart, newLen;
+
+  bool operator==(const DiffHunk& o) const {
+    return oldStart == o.oldStart && oldLen == o.oldLen &&
+      newStart == o.newStart && newLen == o.newLen;
+  }
+};
+
+typedef std::vector<DiffHunk> DiffHunks;
+
+
+/**
+ * @brief Computes a minimal line-level diff between the two lists of lines
+ * using Myers' O(ND) algorithm, after stripping their common prefix and suffix.
+ * @param oldLines the old list
+ * @param newLines the new list
+ * @param maxEdits beyond these many line insertions + deletions, the search for
+ *                 a minimal diff is abandoned and the whole region between the
+ *                 common prefix and suffix is reported as a single hunk
+ * @return the hunks in increasing order of their locations
+ */
+DiffHunks diffLines(const Strings& oldLines, const Strings& newLines,
+                    int maxEdits=2000);
+
+}; // end namespace teditor
@@ -0,0 +1,177 @@
+#include "line_sort.h"
+#include <algorithm>
+#include <ctype.h>
+#include <functional>
+#include <stdint.h>
+#include <stdlib.h>
+#include <thread>
+#include "utils.h"
+
+
+namespace teditor {
+
+/** minimum number of lines per thread, below which sorting is serial */
+static const size_t MinLinesPerThread = 16 * 1024;
+
+/** number of bytes cached from the beginning of each line */
+static const int PrefixLen = (int)sizeof(uint64_t);
+
+
+// the helpers below are private to this file
+namespace {
+
+/** cached key used during the comparison of lines */
+struct SortKey {
+  /** first few bytes of the line, packed in big-endian order */
+  uint64_t prefix;
+  /** leading number in the line (only for numeric sort) */
+  double num;
+};
+
+
+inline char lowerIf(char c, bool iCase) {
+  return iCase ? (char)tolower((unsigned char)c) : c;
+}
+
+SortKey makeKey(const Line& line, int flags) {
+  SortKey key = {0, 0.0};
+  if(flags & Sort_Numeric) {
+    const char* s = line.c_str();
+    while(*s == ' ' || *s == '\t') ++s;
+    key.num = strtod(s, nullptr);
+    // NaN's break the strict weak ordering needed for sorting
+    if(key.num != key.num) key.num = 0.0;
+    return key;
+  }
+  bool iCase = flags & Sort_ICase;
+  int len = std::min(line.length(), PrefixLen);
+  for(int i = 0; i < PrefixLen; ++i) {
+    auto c = i < len ? (unsigned char)lowerIf(line.at(i), iCase) : 0;
+    key.prefix = (key.prefix << 8) | c;
+  }
+  return key;
+}
+
+
+class LineSorter {
+public:
+  LineSorter(const std::vector<Line>& l, int s, int e, int f):
+    lines(l), start(s), flags(f), keys() {
+    keys.reserve(e - s);
+    for(int i = s; i < e; ++i) keys.push_back(makeKey(lines[i], flags));
+  }
+
+  // the std algorithms copy their comparator at every level of recursion,
+  // which must never end up copying the whole key cache. Pass via std::cref!
+  LineSorter(const LineSorter&) = delete;
+  LineSorter& operator=(const LineSorter&) = delete;
+
+  /** three-way comparison of the i'th and j'th lines (relative to start) */
+  int compare(int i, int j) const {
+    const auto& a = keys[i];
+    const auto& b = keys[j];
+    if(flags & Sort_Numeric) {
+      if(a.num < b.num) return -1;
+      return a.num > b.num ? 1 : 0;
+    }
+    if(a.prefix != b.prefix) return a.prefix < b.prefix ? -1 : 1;
+    return compareTail(lines[start + i], lines[start + j]);
+  }
+
+  bool operator()(int i, int j) const {
+    return (flags & Sort_Reverse) ? compare(j, i) < 0 : compare(i, j) < 0;
+  }
+
+private:
+  const std::vector<Line>& lines;
+  int start, flags;
+  std::vector<SortKey> keys;
+
+  /** compare the bytes after the cached prefix, once the prefixes match */
+  int compareTail(const Line& x, const Line& y) const {
+    bool iCase = flags & Sort_ICase;
+    const auto *a = x.c_str(), *b = y.c_str();
+    int la = x.length(), lb = y.length();
+    int len = std::min(la, lb);
+    for(int i = PrefixLen; i < len; ++i) {
+      auto ca = (unsigned char)lowerIf(a[i], iCase);
+      auto cb = (unsigned char)lowerIf(b[i], iCase);
+      if(ca != cb) return ca < cb ? -1 : 1;
+    }
+    if(la == lb) return 0;
+    return la < lb ? -1 : 1;
+  }
+};
+
+}  // end anonymous namespace
+
+
+/** stable merge sort, with each of the sorted runs being handled by a thread */
+static void parallelSort(std::vector<int>& idx, const LineSorter& less) {
+  size_t len = idx.size();
+  size_t nThreads = std::min((size_t)std::max(numThreads(), 1U),
+                             len / MinLinesPerThread);
+  if(nThreads <= 1) {
+    std::stable_sort(idx.begin(), idx.end(), std::cref(less));
+    return;
+  }
+  std::vector<size_t> bounds;
+  for(size_t i = 0; i <= nThreads; ++i) bounds.push_back(i * len / nThreads);
+  std::vector<std::thread> workers;
+  for(size_t i = 0; i < nThreads; ++i) {
+    auto first = idx.begin() + bounds[i], last = idx.begin() + bounds[i + 1];
+    workers.emplace_back([first, last, &less]() {
+        std::stable_sort(first, last, std::cref(less));
+      });
+  }
+  for(auto& w : workers) w.join();
+  // pairwise merge of the sorted runs, each merge running on its own thread
+  std::vector<int> tmp(len);
+  while(bounds.size() > 2) {
+    std::vector<size_t> next;
+    workers.clear();
+    size_t i = 0;
+    for(; i + 2 < bounds.size(); i += 2) {
+      auto b0 = bounds[i], b1 = bounds[i + 1], b2 = bounds[i + 2];
+      workers.emplace_back([b0, b1, b2, &idx, &tmp, &less]() {
+          std::merge(idx.begin() + b0, idx.begin() + b1, idx.begin() + b1,
+                     idx.begin() + b2, tmp.begin() + b0, std::cref(less));
+        });
+      next.push_back(b0);
+    }
+    // odd run out just needs to be carried over
+    if(i + 1 < bounds.size()) {
+      std::copy(idx.begin() + bounds[i], idx.begin() + bounds[i + 1],
+                tmp.begin() + bounds[i]);
+      next.push_back(bounds[i]);
+    }
+    next.push_back(len);
+    for(auto& w : workers) w.join();
+    idx.swap(tmp);
+    bounds.swap(next);
+  }
+}
+
+std::vector<int> sortPermutation(const std::vector<Line>& lines, int start,
+                                 int end, int flags, int& numKept) {
+  int len = std::max(end - start, 0);
+  std::vector<int> perm(len);
+  for(int i = 0; i < len; ++i) perm[i] = i;
+  numKept = len;
+  if(len <= 1) return perm;
+  LineSorter sorter(lines, start, end, flags);
+  parallelSort(perm, sorter);
+  if(!(flags & Sort_Unique)) return perm;
+  // move the duplicates to the end, while preserving the order of the rest
+  std::vector<int> dups;
+  int pos = 1;
+  for(int i = 1; i < len; ++i) {
+    if(sorter.compare(perm[pos - 1], perm[i]) == 0) dups.push_back(perm[i]);
+    else perm[pos++] = perm[i];
+  }
+  numKept = pos;
+  std::copy(dups.begin(), dups.end(), perm.begin() + pos);
+  return perm;
+}
+
+} // end namespace teditor
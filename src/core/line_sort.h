@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include "line.h"
+
+
+namespace teditor {
+
+/** flags to control the behavior of sorting of lines */
+enum SortFlags {
+  /** ascending lexicographic sort */
+  Sort_Default = 0x0,
+  /** compare the numbers found at the beginning of each line */
+  Sort_Numeric = 0x1,
+  /** sort in the descending order */
+  Sort_Reverse = 0x2,
+  /** only keep the first of the lines which compare equal */
+  Sort_Unique  = 0x4,
+  /** case insensitive comparison */
+  Sort_ICase   = 0x8,
+};
+
+
+/**
+ * @brief Computes the sorted order of a range of lines without moving any of
+ * them around. Comparisons are performed on cached key prefixes and large
+ * ranges are sorted in parallel using a merge sort across threads. The sort is
+ * stable.
+ * @param lines the list of lines
+ * @param start first line of the range (inclusive)
+ * @param end last line of the range (exclusive)
+ * @param flags bitwise OR of `SortFlags`
+ * @param numKept number of lines to be kept after sorting. It is always the
+ *                same as the range length, unless `Sort_Unique` is passed.
+ * @return the permutation. Its i'th element is the location (relative to
+ * start) of the line which should go to the i'th location. The first `numKept`
+ * elements are the lines to be kept and the rest are the duplicates removed.
+ */
+std::vector<int> sortPermutation(const std::vector<Line>& lines, int start,
+                                 int end, int flags, int& numKept);
+
+}; // end namespace teditor
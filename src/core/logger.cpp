@@ -2,25 +2,116 @@
 #include "utils.h"
 #include "editor.h"
 #include <string.h>
+#include <algorithm>
+#include <chrono>
 
 
 namespace teditor {
 
+/** single-producer single-consumer ring of length-prefixed log records */
+class LogRing {
+public:
+  LogRing(size_t cap): buf(cap), mask(cap - 1), head(0), tail(0), dropped(0) {
+    ASSERT((cap & mask) == 0, "LogRing: capacity must be a power of 2! [%lu]",
+           cap);
+  }
+
+  /** called only by the owning thread */
+  void push(const char* data, uint32_t len) {
+    size_t h = head.load(std::memory_order_relaxed);
+    size_t t = tail.load(std::memory_order_acquire);
+    size_t need = sizeof(len) + len;
+    if(buf.size() - (h - t) < need) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    copyIn(h, (const char*)&len, sizeof(len));
+    copyIn(h + sizeof(len), data, len);
+    head.store(h + need, std::memory_order_release);
+  }
+
+  /** called only by the writer, appends all the available records to 'out' */
+  size_t drain(std::string& out) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+    while(t < h) {
+      uint32_t len;
+      copyOut(t, (char*)&len, sizeof(len));
+      auto pos = out.size();
+      out.resize(pos + len);
+      copyOut(t + sizeof(len), &out[pos], len);
+      t += sizeof(len) + len;
+    }
+    tail.store(t, std::memory_order_release);
+    return dropped.exchange(0, std::memory_order_relaxed);
+  }
+
+private:
+  std::vector<char> buf;
+  size_t mask;
+  /** monotonically increasing write and read positions */
+  std::atomic<size_t> head, tail;
+  std::atomic<size_t> dropped;
+
+  void copyIn(size_t pos, const char* data, size_t len) {
+    for(size_t i = 0; i < len;) {
+      size_t off = (pos + i) & mask, n = std::min(len - i, buf.size() - off);
+      memcpy(&buf[off], data + i, n);
+      i += n;
+    }
+  }
+
+  void copyOut(size_t pos, char* data, size_t len) const {
+    for(size_t i = 0; i < len;) {
+      size_t off = (pos + i) & mask, n = std::min(len - i, buf.size() - off);
+      memcpy(data + i, &buf[off], n);
+      i += n;
+    }
+  }
+};
+
+
 Logger* Logger::inst = nullptr;
+std::atomic<int> Logger::level(-1);
+const size_t Logger::RingSize = 64 * 1024;
+const int Logger::MaxRecordLen = 4096;
+const int Logger::SyncLevel = 10;
+/** time given to a burst of records to accumulate, before they're written */
+static const auto BatchDelay = std::chrono::milliseconds(20);
+static std::atomic<unsigned> nextGeneration(1);
+
+struct ThreadRing {
+  unsigned generation;
+  LogRing* ring;
+};
+static thread_local ThreadRing tlRing = {0, nullptr};
 
 void Logger::setLevel(int le) {
-  if(inst != nullptr) inst->level = le;
+  if(inst != nullptr) level = le;
 }
 
-int Logger::logLevel() {
-  return (inst != nullptr)? inst->level : -1;
+void Logger::setRotation(size_t maxBytes, int numBackups) {
+  if(inst == nullptr) return;
+  std::unique_lock<std::mutex> lk(inst->mtx);
+  inst->maxBytes = maxBytes;
+  inst->numBackups = std::max(numBackups, 0);
 }
 
-Logger::Logger(const std::string& file_): file(file_), logfp(nullptr),
-                                          level(-1) {
+Logger::Logger(const std::string& file_):
+  file(file_), logfp(nullptr), generation(nextGeneration++), maxBytes(0),
+  written(0), numBackups(0), rings(), mtx(), pending(false), wakeMtx(), cv(),
+  quit(false), writer(), outBuff() {
 }
 
 Logger::~Logger() {
+  {
+    std::unique_lock<std::mutex> lk(wakeMtx);
+    quit = true;
+  }
+  cv.notify_all();
+  if(writer.joinable()) writer.join();
+  drain();
+  level = -1;
   if(logfp != nullptr) fclose(logfp);
 }
 
@@ -28,6 +119,7 @@ void Logger::open() {
   if(logfp == nullptr) {
     logfp = fopen(file.c_str(), "w");
     ASSERT(logfp, "Failed to open file '%s'!", file.c_str());
+    written = 0;
   }
 }
 
@@ -41,15 +133,102 @@ bool Logger::removeNewLine(std::string& buf) {
   return newLineFound;
 }
 
-void Logger::log(int lev, const char* fmt, ...) {
-  if(inst == nullptr || lev > inst->level) return;
-  inst->open();
+// NOTE: rings of the threads which have exited are retained until the end
+LogRing* Logger::threadRing() {
+  if(tlRing.generation == generation) return tlRing.ring;
+  std::unique_lock<std::mutex> lk(mtx);
+  // the writer is started lazily, so that nothing is spawned unless needed
+  if(!writer.joinable()) writer = std::thread([this]() { writerLoop(); });
+  rings.push_back(std::unique_ptr<LogRing>(new LogRing(RingSize)));
+  tlRing.generation = generation;
+  tlRing.ring = rings.back().get();
+  return tlRing.ring;
+}
+
+void Logger::log(int lev, const char* file, int line, const char* fmt, ...) {
+  if(inst == nullptr || lev > logLevel()) return;
+  char buf[MaxRecordLen];
+  int len = snprintf(buf, sizeof(buf), "%s:%d: Lev=%d DLev=%d ", file, line,
+                     lev, logLevel());
+  len = std::min(len, MaxRecordLen - 1);
   va_list vl;
   va_start(vl, fmt);
-  auto buf = format(fmt, vl);
+  len += vsnprintf(buf + len, sizeof(buf) - len, fmt, vl);
   va_end(vl);
-  fprintf(inst->logfp, "%s", buf.c_str());
-  fflush(inst->logfp);
+  len = std::min(len, MaxRecordLen - 1);
+  auto* ring = inst->threadRing();
+  if(lev > SyncLevel) {
+    ring->push(buf, (uint32_t)len);
+    inst->wakeWriter();
+    return;
+  }
+  // drain before too, so that this record is never dropped for lack of room
+  inst->drain();
+  ring->push(buf, (uint32_t)len);
+  inst->drain();
+}
+
+void Logger::flush() {
+  if(inst != nullptr) inst->drain();
+}
+
+// only the first record after the writer has gone to sleep wakes it up
+void Logger::wakeWriter() {
+  if(pending.load(std::memory_order_relaxed) || pending.exchange(true)) return;
+  // lest this wakeup be lost, in case the writer is just about to sleep
+  { std::unique_lock<std::mutex> lk(wakeMtx); }
+  cv.notify_one();
+}
+
+void Logger::writerLoop() {
+  std::unique_lock<std::mutex> lk(wakeMtx);
+  auto quitting = [this]() { return quit; };
+  while(true) {
+    cv.wait(lk, [this]() { return quit || pending.load(); });
+    if(quit) break;
+    cv.wait_for(lk, BatchDelay, quitting);
+    pending = false;
+    lk.unlock();
+    drain();
+    lk.lock();
+  }
+}
+
+void Logger::drain() {
+  std::unique_lock<std::mutex> lk(mtx);
+  outBuff.clear();
+  for(auto& r : rings) {
+    auto dropped = r->drain(outBuff);
+    if(dropped > 0)
+      outBuff += format("Logger: dropped %lu records!\n", dropped);
+  }
+  if(outBuff.empty()) return;
+  open();
+  for(size_t pos = 0; pos < outBuff.size();) {
+    size_t end = outBuff.size();
+    // upto the end of the record which crosses the size limit, if any
+    if(maxBytes > 0 && written + (end - pos) > maxBytes) {
+      size_t room = written < maxBytes ? maxBytes - written : 1;
+      auto nl = outBuff.find('\n', pos + room - 1);
+      if(nl != std::string::npos) end = nl + 1;
+    }
+    fwrite(outBuff.data() + pos, 1, end - pos, logfp);
+    written += end - pos;
+    pos = end;
+    if(maxBytes > 0 && written >= maxBytes) rotate();
+  }
+  fflush(logfp);
+}
+
+void Logger::rotate() {
+  fclose(logfp);
+  logfp = nullptr;
+  for(int i = numBackups - 1; i >= 1; --i) {
+    auto from = file + "." + num2str(i), to = file + "." + num2str(i + 1);
+    rename(from.c_str(), to.c_str());
+  }
+  if(numBackups > 0) rename(file.c_str(), (file + ".1").c_str());
+  open();
 }
 
 void Logger::msgBar(Editor& ed, const char* fmt, ...) {
@@ -2,7 +2,13 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 #include "utils.h"
 
 namespace teditor {
@@ -24,26 +30,73 @@ public:
 
 
 class Editor;
+class LogRing;
 
+/**
+ * @brief The logger. Each log record is formatted on the calling thread into a
+ * lock-free ring buffer owned by that thread. A background thread, woken up
+ * only when there are new records, drains all these rings into the log file,
+ * which is rotated as soon as a record takes it beyond a configured size. Records are dropped (and their count reported)
+ * instead of blocking the caller, in case a ring gets full. Records of ERROR
+ * (and FATAL) levels are written synchronously instead, as the process might
+ * be about to abort.
+ */
 class Logger {
 public:
   static void setLevel(int le);
-  static void log(int lev, const char* fmt, ...);
+  /**
+   * @brief sets up size-based rotation of the log file
+   * @param maxBytes max size of the log file before it gets rotated. A value
+   *                 of 0 disables rotation
+   * @param numBackups number of rotated files to retain, as file.1, file.2...
+   */
+  static void setRotation(size_t maxBytes, int numBackups);
+  static void log(int lev, const char* file, int line, const char* fmt, ...);
   static void messages(Editor& ed, const char* fmt, ...);
   static void msgBar(Editor& ed, const char* fmt, ...);
-  static int logLevel();
+  static int logLevel() { return level.load(std::memory_order_relaxed); }
+  static bool isEnabled(int lev) { return lev <= logLevel(); }
+  /** synchronously writes all the pending records into the log file */
+  static void flush();
+
+  /** capacity (in bytes) of the ring of each thread */
+  static const size_t RingSize;
+  /** longer records get truncated */
+  static const int MaxRecordLen;
+  /** records at or below this level are written out before 'log' returns */
+  static const int SyncLevel;
 
 private:
   Logger(const std::string& file_);
   ~Logger();
   void open();
   bool removeNewLine(std::string& buf);
+  LogRing* threadRing();
+  void writerLoop();
+  void drain();
+  void rotate();
+  void wakeWriter();
 
   friend class SingletonHandler<Logger, std::string>;
   static Logger* inst;
+  static std::atomic<int> level;
   std::string file;
   FILE* logfp;
-  int level;
+  /** unique for every Logger object, to detect stale per-thread rings */
+  unsigned generation;
+  size_t maxBytes, written;
+  int numBackups;
+  std::vector<std::unique_ptr<LogRing>> rings;
+  /** guards the rings list and the log file */
+  std::mutex mtx;
+  /** whether there are records not yet seen by the writer */
+  std::atomic<bool> pending;
+  /** guards only 'quit' and the wakeups of the writer, never held for I/O */
+  std::mutex wakeMtx;
+  std::condition_variable cv;
+  bool quit;
+  std::thread writer;
+  std::string outBuff;
 };
 
 #define CMBAR(ed, fmt, ...) Logger::msgBar(ed, fmt, ##__VA_ARGS__)
@@ -54,24 +107,28 @@ private:
     MESSAGE(ed, fmt, ##__VA_ARGS__);            \
   } while(0)
 
+/**
+ * Log records above this level are compiled out completely. Defaults to all
+ * levels in debug builds and upto WARN in release builds.
+ */
+#ifndef TEDITOR_MAX_LOG_LEVEL
+#ifdef DEBUG_BUILD
+#define TEDITOR_MAX_LOG_LEVEL 100000
+#else   // DEBUG_BUILD
+#define TEDITOR_MAX_LOG_LEVEL 100
+#endif  // DEBUG_BUILD
+#endif  // TEDITOR_MAX_LOG_LEVEL
+
 #define LOG(lev, fmt, ...) do {                                         \
-    Logger::log(lev, "%s:%d: Lev=%d DLev=%d ", __FILE__, __LINE__,      \
-                lev, Logger::logLevel());                               \
-    Logger::log(lev, fmt, ##__VA_ARGS__);                               \
+    if((lev) <= TEDITOR_MAX_LOG_LEVEL && Logger::isEnabled(lev))        \
+      Logger::log(lev, __FILE__, __LINE__, fmt, ##__VA_ARGS__);         \
   } while(0)
 
 #define FATAL(fmt, ...) LOG(0, fmt, ##__VA_ARGS__)
 #define ERROR(fmt, ...) LOG(10, fmt, ##__VA_ARGS__)
 #define WARN(fmt, ...) LOG(100, fmt, ##__VA_ARGS__)
-
-#ifdef DEBUG_BUILD
 #define INFO(fmt, ...) LOG(1000, fmt, ##__VA_ARGS__)
 #define DEBUG(fmt, ...) LOG(10000, fmt, ##__VA_ARGS__)
 #define ULTRA_DEBUG(fmt, ...) LOG(100000, fmt, ##__VA_ARGS__)
-#else   // DEBUG_BUILD
-#define INFO(fmt, ...)
-#define DEBUG(fmt, ...)
-#define ULTRA_DEBUG(fmt, ...)
-#endif  // DEBUG_BUILD
 
 } // end namespace teditor
@@ -13,6 +13,32 @@ ModeInferMap& infers() {
   return _infers;
 }
 
+typedef std::unordered_map<std::string, std::shared_ptr<ModeTables>>
+  ModeTablesMap;
+
+ModeTablesMap& modeTables() {
+  static ModeTablesMap _tables;
+  return _tables;
+}
+
+int Mode::created = 0;
+
+Mode::Mode(const std::string& n, const std::string& w):
+  name_(n), word_(w), tables(), building(false) {
+  ++created;
+  auto& t = modeTables();
+  auto itr = t.find(n);
+  if(itr != t.end()) {
+    tables = itr->second;
+    return;
+  }
+  tables = std::make_shared<ModeTables>();
+  t[n] = tables;
+  building = true;
+}
+
+int Mode::numTablesBuilt() { return (int)modeTables().size(); }
+
 Strings allModeNames() {
   auto& m = modes();
   Strings ret;
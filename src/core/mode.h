@@ -6,12 +6,11 @@
 #include "utils.h"
 #include "colors.h"
 #include "command.h"
+#include "key_cmd_map.h"
 
 namespace teditor {
 
 class Buffer;
-class KeyCmdMap;
-class ColorMap;
 class Mode;
 
 
@@ -23,6 +22,13 @@ typedef bool (*InferMode)(const std::string&);
 typedef std::unordered_map<std::string,InferMode> ModeInferMap;
 
 
+/** key bindings and colors of a mode, shared by all of its instances */
+struct ModeTables {
+  KeyCmdMap keys;
+  ColorMap colors;
+};  // struct ModeTables
+
+
 /** Mode attached with a buffer */
 class Mode {
 public:
@@ -31,7 +37,7 @@ public:
    * @param n name of the mode
    * @param w list of chars that define a word in this mode
    */
-  Mode(const std::string& n, const std::string& w): name_(n), word_(w) {}
+  Mode(const std::string& n, const std::string& w);
 
   /** dtor */
   virtual ~Mode() {}
@@ -46,10 +52,10 @@ public:
   virtual int indent(Buffer& buf, int line) = 0;
 
   /** get key-cmd map for the buffer this mode applies to */
-  virtual KeyCmdMap& getKeyCmdMap() = 0;
+  virtual KeyCmdMap& getKeyCmdMap() { return tables->keys; }
 
   /** get color map for the buffer this mode applies to */
-  virtual ColorMap& getColorMap() = 0;
+  virtual ColorMap& getColorMap() { return tables->colors; }
 
   /** get color for the given line */
   virtual void getColorFor(AttrColor& fg, AttrColor& bg, int lineNum, int pos,
@@ -58,6 +64,12 @@ public:
   /** list of all command names that are registered under this mode */
   virtual Strings cmdNames() const;
 
+  /**
+   * @brief called just before the buffer is drawn. Useful for modes which keep
+   *        the contents of their buffer updated live
+   */
+  virtual void beforeDraw(Buffer& buf) {}
+
   /**
    * @brief Helper to create mode object of the named mode
    * @param mode name of the mode
@@ -77,11 +89,28 @@ public:
     Registrar(const std::string& mode, ModeCreator fptr, InferMode iptr);
   };  // struct Registrar
 
+  /** number of mode objects created so far */
+  static int numCreated() { return created; }
+  /** number of modes whose key and color tables have been built so far */
+  static int numTablesBuilt();
+
+protected:
+  /**
+   * @brief The key and color tables of a mode are built lazily, by its first
+   * instance, and are then shared by all the later ones. So, every ctor in the
+   * hierarchy needs to populate its part of the tables only when this is true
+   */
+  bool buildingTables() const { return building; }
+
 private:
   /** mode name */
   std::string name_;
   /** list of chars that define a word */
   std::string word_;
+  std::shared_ptr<ModeTables> tables;
+  bool building;
+
+  static int created;
 };  // class Mode
 
 
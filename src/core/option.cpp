@@ -102,6 +102,10 @@ std::string Option::type2str(Option::Type t) {
 
 // NOTE: keep the options in alphabetical order
 void registerAllOptions() {
+  // parseArgs can get called more than once, eg: in unittests
+  static bool registered = false;
+  if(registered) return;
+  registered = true;
   Option::add("browserCmd", "cygstart firefox -private-window",
               "Command to fire up your favorite browser", Option::Type::String);
   Option::add("calc:prompt", "expr> ", "Expression prompt during calc-mode",
@@ -115,6 +119,9 @@ void registerAllOptions() {
   Option::add("calc:maxHistory", "50",
               "History size for storing all calc-mode commands",
               Option::Type::Integer);
+  Option::add("calc:decimal", "NO",
+              "Use fixed-point decimals for non-integers in calc-mode",
+              Option::Type::Boolean);
   Option::add("cmBar:height", "1", "Cmd-bar height", Option::Type::Integer);
   Option::add("cmBar:multiheight", "8", "Cmd-bar height during interaction",
               Option::Type::Integer);
@@ -134,6 +141,11 @@ void registerAllOptions() {
               Option::Type::Boolean);
   Option::add("logLevel", "-1", "Spew verbosity. Higher value means more spews",
               Option::Type::Integer);
+  Option::add("logMaxSizeKB", "10240",
+              "Size of the log file beyond which it is rotated. 0 disables it",
+              Option::Type::Integer);
+  Option::add("logNumBackups", "2", "Number of rotated log files to retain",
+              Option::Type::Integer);
   Option::add("maxHistory", "25", "History size for storing all files visited",
               Option::Type::Integer);
   Option::add("orgNotesDir", "<homeFolder>/org",
@@ -141,11 +153,26 @@ void registerAllOptions() {
   Option::add("pageScrollJump", "0.9",
               "How much of a jump to make during page scrolls",
               Option::Type::Real);
+  Option::add("profile:enable", "YES",
+              "Collect latency samples of the instrumented hot paths",
+              Option::Type::Boolean);
+  Option::add("profile:refreshMs", "1000",
+              "Refresh interval (in ms) of the *profile* buffer",
+              Option::Type::Integer);
+  Option::add("profileStartup", "NO",
+              "Quit after the first frame and print the startup timeline",
+              Option::Type::Boolean);
   Option::add("quitAfterLoad", "NO",
               "Quit after parsing cmdline args and loading input files",
               Option::Type::Boolean);
   Option::add("songsDir", "<homeFolder>/songs", "Path to dir containing songs",
               Option::Type::String);
+  Option::add("ssh:cmd", "ssh",
+              "Command to connect to remote hosts. Host and the command to be"
+              " run there are appended to it", Option::Type::String);
+  Option::add("ssh:timeoutMs", "30000",
+              "Max time (in ms) to wait for a remote host to respond, before"
+              " deeming its connection dead", Option::Type::Integer);
   Option::add("startProg", "cygstart", "Program used to open special files",
               Option::Type::String);
   Option::add("tabSpaces", "2", "Number of spaces per tab",
@@ -158,6 +185,12 @@ void registerAllOptions() {
   Option::add("watch:defaultSleepMs", "1000",
               "Default sleep duration (in ms) between reruns in watch-mode",
               Option::Type::Integer);
+  Option::add("watch:highlightChanges", "NO",
+              "Highlight the lines changed in the latest update in watch-mode",
+              Option::Type::Boolean);
+  Option::add("watch:maxConcurrentJobs", "4",
+              "Max number of watch commands that can be running at a time",
+              Option::Type::Integer);
   Option::add("windowSplitter", "|", "Character used as window splitter",
               Option::Type::Char);
 }
@@ -194,6 +227,8 @@ bool parseArgs(int argc, char** argv, std::vector<FileInfo>& files) {
              "  -rc <rcFile>     Configure the editor using this rc file.\n"
              "  -listopts        List all options supported and exit.\n"
              "  -o <name> <val>  Set the option as found in the 'Option'.\n"
+             "  -profile-startup Quit after the first frame and print the\n"
+             "                   time taken by each of the startup phases.\n"
              "  -v               Print version info and exit.\n"
              "  <files>          Files to be opened\n");
       return false;
@@ -213,6 +248,9 @@ bool parseArgs(int argc, char** argv, std::vector<FileInfo>& files) {
     } else if(!strcmp(argv[i], "-listopts")) {
       Option::printOpts();
       return false;
+    } else if(!strcmp(argv[i], "-profile-startup") ||
+              !strcmp(argv[i], "--profile-startup")) {
+      Option::set("profileStartup", "YES");
     } else if(!strcmp(argv[i], "-o")) {
       ++i;
       ASSERT(i < argc, "'-o' option expects 2 arguments!");
@@ -1,5 +1,6 @@
 #include "nfa.h"
 #include <core/utils.h>
+#include <core/profiler.h>
 
 namespace teditor {
 namespace parser {
@@ -62,6 +63,11 @@ NFA::NFA(const std::string& reg) : regex(reg) {
 }
 
 size_t NFA::find(const std::string& str, size_t start, size_t end) {
+  PROBE(NfaFind);
+  return match(str, start, end);
+}
+
+size_t NFA::match(const std::string& str, size_t start, size_t end) {
   if (end == 0) end = str.size();
   reset();
   for (; start < end; ++start) {
@@ -75,10 +81,11 @@ size_t NFA::find(const std::string& str, size_t start, size_t end) {
 
 size_t NFA::findAny(const std::string& str, size_t& matchStartPos, size_t start,
                     size_t end) {
+  PROBE(NfaFind);
   if (end == 0) end = str.size();
   size_t endPos = matchStartPos = NFA::NoMatch;
   for (; start < end; ++start) {
-    endPos = find(str, start, end);
+    endPos = match(str, start, end);
     if (endPos != NFA::NoMatch) {
       matchStartPos = start;
       break;
@@ -131,6 +131,8 @@ private:
   DoubleBuffer<Actives> acs;
 
   void stepThroughSplitStates();
+  /** 'find' without the profiling probe, as 'findAny' calls it in a loop */
+  size_t match(const std::string& str, size_t start, size_t end);
   void checkForSplitState(State* st, const Point& pos, Actives& ac);
 
   // used only while compiling the regex's
@@ -36,8 +36,7 @@ BufferScanner::BufferScanner(Buffer& b): buf(b), currPos({0, 0}), end({0, 0}) {
 char BufferScanner::next(Point& pt) {
   ASSERT(!isEof(), "next: called after hitting EOF!");
   pt = currPos = buf.getPoint();
-  auto& str = buf.at(pt.y).get();
-  auto c = pt.x >= buf.lengthOf(pt.y) ? '\n' : str[pt.x];
+  auto c = pt.x >= buf.lengthOf(pt.y) ? '\n' : buf.at(pt.y).at(pt.x);
   buf.right();
   return c;
 }
@@ -46,8 +45,7 @@ std::string BufferScanner::at(const Point& begin, const Point& end) {
   auto out = buf.regionAsStr(begin, end);
   // Buffer::regionAsStr does not include 'end'!
   if (end.y < buf.length()) {
-    auto& str = buf.at(end.y).get();
-    auto c = end.x >= buf.lengthOf(end.y) ? '\n' : str[end.x];
+    auto c = end.x >= buf.lengthOf(end.y) ? '\n' : buf.at(end.y).at(end.x);
     out += c;
   }
   return out;
@@ -0,0 +1,196 @@
+#include "profiler.h"
+#include "utils.h"
+#include "logger.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+
+
+namespace teditor {
+
+const int Profiler::SubBuckets;
+const int Profiler::NumBuckets;
+std::atomic<bool> Profiler::enabled(true);
+
+static const char* ProbeNames[] = {
+  "Editor::draw",
+  "Editor::render",
+  "Editor::runCmd",
+  "Terminal::flush",
+  "Buffer::load",
+  "Buffer::save",
+  "NFA::find",
+};
+
+/**
+ * samples of a probe in a thread. Only the owning thread writes into these,
+ * so no read-modify-write atomics are needed. They are atomics only to keep
+ * the concurrent reads from 'summary' well-defined.
+ */
+struct ProbeData {
+  std::atomic<uint64_t> count, totalNs, maxNs;
+  std::atomic<uint64_t> hist[Profiler::NumBuckets];
+
+  ProbeData() { clear(); }
+
+  void clear() {
+    count = totalNs = maxNs = 0;
+    for(auto& h : hist) h = 0;
+  }
+};
+
+struct ThreadProbes {
+  ProbeData probes[Probe_Count];
+};
+
+static void incr(std::atomic<uint64_t>& a, uint64_t val) {
+  a.store(a.load(std::memory_order_relaxed) + val, std::memory_order_relaxed);
+}
+
+/** owns the samples of all threads, even after they have exited */
+struct ProbeRegistry {
+  std::mutex mtx;
+  std::vector<std::unique_ptr<ThreadProbes>> threads;
+};
+
+static ProbeRegistry& registry() {
+  static ProbeRegistry reg;
+  return reg;
+}
+
+static ThreadProbes& threadProbes() {
+  static thread_local ThreadProbes* tp = nullptr;
+  if(tp != nullptr) return *tp;
+  auto& reg = registry();
+  std::unique_lock<std::mutex> lk(reg.mtx);
+  reg.threads.push_back(std::unique_ptr<ThreadProbes>(new ThreadProbes));
+  tp = reg.threads.back().get();
+  return *tp;
+}
+
+const char* Profiler::name(ProbeId id) {
+  static_assert(sizeof(ProbeNames) / sizeof(ProbeNames[0]) == Probe_Count,
+                "ProbeNames is out of sync with ProbeId!");
+  return ProbeNames[id];
+}
+
+int Profiler::bucketOf(uint64_t ns) {
+  if(ns < (uint64_t)SubBuckets) return (int)ns;
+  int msb = 63 - __builtin_clzll(ns);
+  int sub = int(ns >> (msb - 2)) & (SubBuckets - 1);
+  return SubBuckets * (msb - 1) + sub;
+}
+
+uint64_t Profiler::bucketStart(int b) {
+  if(b < SubBuckets) return (uint64_t)b;
+  int msb = b / SubBuckets + 1, sub = b % SubBuckets;
+  return uint64_t(SubBuckets + sub) << (msb - 2);
+}
+
+void Profiler::record(ProbeId id, uint64_t ns) {
+  auto& pd = threadProbes().probes[id];
+  incr(pd.count, 1);
+  incr(pd.totalNs, ns);
+  if(ns > pd.maxNs.load(std::memory_order_relaxed))
+    pd.maxNs.store(ns, std::memory_order_relaxed);
+  incr(pd.hist[bucketOf(ns)], 1);
+}
+
+/** midpoint of the bucket where the given percentile lies */
+static double percentileUs(const std::vector<uint64_t>& hist, uint64_t count,
+                           double pct, uint64_t maxNs) {
+  auto target = uint64_t(pct * count + 0.999999);
+  if(target == 0) target = 1;
+  uint64_t sum = 0;
+  for(int b = 0; b < Profiler::NumBuckets; ++b) {
+    sum += hist[b];
+    if(sum < target) continue;
+    auto lo = Profiler::bucketStart(b);
+    auto hi = b + 1 < Profiler::NumBuckets ? Profiler::bucketStart(b + 1) : lo;
+    auto mid = std::min((lo + hi) / 2, maxNs);
+    return mid / 1000.0;
+  }
+  return maxNs / 1000.0;
+}
+
+std::vector<ProbeSummary> Profiler::summary() {
+  std::vector<ProbeSummary> ret;
+  auto& reg = registry();
+  std::unique_lock<std::mutex> lk(reg.mtx);
+  for(int id = 0; id < Probe_Count; ++id) {
+    uint64_t count = 0, totalNs = 0, maxNs = 0;
+    std::vector<uint64_t> hist(NumBuckets, 0);
+    for(const auto& tp : reg.threads) {
+      const auto& pd = tp->probes[id];
+      count += pd.count.load(std::memory_order_relaxed);
+      totalNs += pd.totalNs.load(std::memory_order_relaxed);
+      maxNs = std::max(maxNs, pd.maxNs.load(std::memory_order_relaxed));
+      for(int b = 0; b < NumBuckets; ++b)
+        hist[b] += pd.hist[b].load(std::memory_order_relaxed);
+    }
+    ProbeSummary ps;
+    ps.name = name(ProbeId(id));
+    ps.count = count;
+    ps.totalMs = totalNs / 1e6;
+    ps.meanUs = count > 0 ? totalNs / 1e3 / count : 0.0;
+    ps.maxUs = maxNs / 1e3;
+    ps.p50Us = count > 0 ? percentileUs(hist, count, 0.50, maxNs) : 0.0;
+    ps.p90Us = count > 0 ? percentileUs(hist, count, 0.90, maxNs) : 0.0;
+    ps.p99Us = count > 0 ? percentileUs(hist, count, 0.99, maxNs) : 0.0;
+    ret.push_back(ps);
+  }
+  return ret;
+}
+
+void Profiler::reset() {
+  auto& reg = registry();
+  std::unique_lock<std::mutex> lk(reg.mtx);
+  for(auto& tp : reg.threads)
+    for(auto& pd : tp->probes) pd.clear();
+}
+
+
+std::chrono::steady_clock::time_point StartupTimeline::start =
+  std::chrono::steady_clock::now();
+std::chrono::steady_clock::time_point StartupTimeline::last =
+  StartupTimeline::start;
+std::vector<StartupPhase> StartupTimeline::list;
+bool StartupTimeline::done = false;
+
+void StartupTimeline::begin() {
+  start = last = std::chrono::steady_clock::now();
+  list.clear();
+  done = false;
+}
+
+void StartupTimeline::mark(const std::string& phase) {
+  if(done) return;
+  auto now = std::chrono::steady_clock::now();
+  auto ms = std::chrono::duration<double, std::milli>(now - last).count();
+  list.push_back({phase, ms});
+  last = now;
+}
+
+void StartupTimeline::finish(const std::string& phase) {
+  if(done) return;
+  mark(phase);
+  done = true;
+  std::string str;
+  for(const auto& p : list) str += format(" %s=%.2fms", p.name.c_str(), p.ms);
+  INFO("Startup: total=%.2fms%s\n", totalMs(), str.c_str());
+}
+
+std::vector<std::string> StartupTimeline::report() {
+  std::vector<std::string> ret;
+  ret.push_back(format("Startup (%.2f ms till the %s)", totalMs(),
+                       done ? "first frame" : "last mark"));
+  for(const auto& p : list)
+    ret.push_back(format("  %-14s %11.2f", p.name.c_str(), p.ms));
+  return ret;
+}
+
+double StartupTimeline::totalMs() {
+  return std::chrono::duration<double, std::milli>(last - start).count();
+}
+
+}; // end namespace teditor
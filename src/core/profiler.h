@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace teditor {
+
+/**
+ * @brief Compile-time id's of all the probes. When adding a new one, also add
+ * its name in profiler.cpp
+ */
+enum ProbeId {
+  Probe_EditorDraw = 0,
+  Probe_EditorRender,
+  Probe_EditorRunCmd,
+  Probe_TerminalFlush,
+  Probe_BufferLoad,
+  Probe_BufferSave,
+  Probe_NfaFind,
+  Probe_Count
+};
+
+/** aggregated view of all the samples of a probe across all threads */
+struct ProbeSummary {
+  std::string name;
+  uint64_t count;
+  double totalMs;
+  /** latencies */
+  double meanUs, p50Us, p90Us, p99Us, maxUs;
+};
+
+/**
+ * @brief Collects latencies of all the probes. Samples are accumulated in
+ * thread-local storage (count, total, max and a log-linear histogram with 4
+ * sub-buckets per power of 2), so recording never contends with other threads.
+ */
+class Profiler {
+public:
+  /** number of sub-buckets per power of 2 in the histogram */
+  static const int SubBuckets = 4;
+  static const int NumBuckets = 252;
+
+  static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+  static void setEnabled(bool e) { enabled = e; }
+  static const char* name(ProbeId id);
+
+  /** records a sample (in ns) for the given probe on the current thread */
+  static void record(ProbeId id, uint64_t ns);
+
+  /** aggregates the samples of all probes across all the threads */
+  static std::vector<ProbeSummary> summary();
+
+  /** clears all the samples collected so far */
+  static void reset();
+
+  /** histogram bucket of the given sample */
+  static int bucketOf(uint64_t ns);
+  /** smallest sample that falls in the given bucket */
+  static uint64_t bucketStart(int b);
+
+private:
+  static std::atomic<bool> enabled;
+};
+
+
+/** time taken by one of the phases of the editor startup */
+struct StartupPhase {
+  std::string name;
+  double ms;
+};
+
+/**
+ * @brief Timeline of the editor startup, all the way till its first frame is
+ * on the screen. Each mark closes the phase which began at the previous one.
+ * Only the main thread is expected to use this.
+ */
+class StartupTimeline {
+public:
+  /** starts the timeline afresh */
+  static void begin();
+  /** marks the end of the named phase. Ignored after 'finish' */
+  static void mark(const std::string& phase);
+  /** marks the last phase and logs the whole timeline */
+  static void finish(const std::string& phase);
+  static bool finished() { return done; }
+  static const std::vector<StartupPhase>& phases() { return list; }
+  /** time between 'begin' and the last mark */
+  static double totalMs();
+  /** human readable report of all the phases */
+  static std::vector<std::string> report();
+
+private:
+  static std::chrono::steady_clock::time_point start, last;
+  static std::vector<StartupPhase> list;
+  static bool done;
+};
+
+
+/** RAII probe measuring the time spent in its scope */
+class ScopedProbe {
+public:
+  ScopedProbe(ProbeId i): id(i), on(Profiler::isEnabled()) {
+    if(on) start = std::chrono::steady_clock::now();
+  }
+
+  ~ScopedProbe() {
+    if(!on) return;
+    auto diff = std::chrono::steady_clock::now() - start;
+    Profiler::record(id, uint64_t(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(diff).count()));
+  }
+
+private:
+  ProbeId id;
+  bool on;
+  std::chrono::steady_clock::time_point start;
+};
+
+#define PROBE_CONCAT_(a, b) a##b
+#define PROBE_CONCAT(a, b) PROBE_CONCAT_(a, b)
+/** measures the rest of the current scope under the probe 'Probe_<id>' */
+#define PROBE(id) ScopedProbe PROBE_CONCAT(_probe_, __LINE__)(Probe_##id)
+
+}; // end namespace teditor
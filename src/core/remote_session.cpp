@@ -0,0 +1,247 @@
+#include "remote_session.h"
+#include "option.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <mutex>
+
+
+namespace teditor {
+
+// The helper sticks to POSIX sh and tools, as the remote host could be anything.
+// Replies are framed by the size of their data, hence the temp file. Payloads
+// are read in blocks, with the last one cut short, so that the next request is
+// never consumed. 'list' mimics `stat --format "  %A  %8s  %n"` via `ls -la`
+const char* RemoteSession::HelperScript =
+  "t=$(mktemp) || exit 1\n"
+  "trap \"rm -f $t\" EXIT\n"
+  "rd() {\n"
+  "  : > $t; m=0\n"
+  "  while [ $m -lt $1 ]; do\n"
+  "    b=$(($1 - m)); [ $b -gt 65536 ] && b=65536\n"
+  "    dd bs=$b count=1 >> $t 2> /dev/null\n"
+  "    k=$(wc -c < $t); [ $k -eq $m ] && return 1; m=$k\n"
+  "  done\n"
+  "}\n"
+  "while read -r op n p; do\n"
+  "  s=0\n"
+  "  case $op in\n"
+  "  load) cat -- \"$p\" > $t 2> /dev/null || s=1 ;;\n"
+  "  save) rd $n || exit 1\n"
+  "        cat $t > \"$p\" 2> /dev/null || s=1; : > $t ;;\n"
+  "  stat) if [ -d \"$p\" ]; then echo d; elif [ -e \"$p\" ]; then echo f;\n"
+  "        else echo -; fi > $t ;;\n"
+  "  list) if (cd -- \"$p\") 2> /dev/null; then\n"
+  "          (cd -- \"$p\" && LC_ALL=C ls -la) < /dev/null 2> /dev/null |\n"
+  "          while read -r a x y z sz m d tm f; do\n"
+  "            case $a in\n"
+  "            total) continue ;;\n"
+  "            [bc]*) sz=$sz$m; f=${f#* } ;;\n"
+  "            l*) f=${f% -> *} ;;\n"
+  "            esac\n"
+  "            printf \"  %.10s  %8s  %s\\n\" \"$a\" \"$sz\" \"$f\"\n"
+  "          done > $t\n"
+  "        else s=1; : > $t; fi ;;\n"
+  "  mkdir) mkdir -p -- \"$p\" > $t 2>&1 || s=1 ;;\n"
+  "  run) rd $n || exit 1; c=$(cat $t)\n"
+  "       (cd -- \"$p\" && eval \"$c\") < /dev/null > $t 2>&1; s=$? ;;\n"
+  "  *) s=127; : > $t ;;\n"
+  "  esac\n"
+  "  printf \"%d %d\\n\" $s $(wc -c < $t)\n"
+  "  cat $t\n"
+  "done\n";
+
+const int RemoteSession::DefaultTimeoutMs = 30000;
+
+RemoteSession::RemoteSession(const Strings& argv, int timeoutMs_):
+  args(argv), timeoutMs(timeoutMs_), fd(-1), pid(-1), inBuf() {
+}
+
+RemoteSession::~RemoteSession() { stop(); }
+
+static bool isReadOnly(const std::string& op) {
+  return op == "load" || op == "stat" || op == "list";
+}
+
+std::vector<RemoteReply> RemoteSession::request(
+  const std::vector<RemoteRequest>& reqs) {
+  for(const auto& r : reqs)
+    ASSERT(r.path.find('\n') == std::string::npos,
+           "RemoteSession: newlines in paths are not supported! [%s]",
+           r.path.c_str());
+  std::vector<RemoteReply> replies;
+  if(!alive()) start();
+  size_t numSent = 0;
+  bool responded = exchange(reqs, replies, numSent);
+  // connection had died in the meanwhile. The unanswered requests are retried
+  // on a fresh one, only if none of them could have already taken effect
+  bool retry = responded && replies.size() < reqs.size();
+  for(size_t i = replies.size(); retry && i < numSent; ++i)
+    retry = isReadOnly(reqs[i].op);
+  if(retry) {
+    stop();
+    start();
+    responded = exchange(reqs, replies, numSent);
+  }
+  bool ok = replies.size() == reqs.size();
+  if(!ok) stop();
+  ASSERT(ok, "RemoteSession: '%s' failed after %d of %d replies!%s",
+         args[0].c_str(), (int)replies.size(), (int)reqs.size(),
+         responded ? "" : " (timed out)");
+  return replies;
+}
+
+RemoteReply RemoteSession::request(const RemoteRequest& req) {
+  return request(std::vector<RemoteRequest>{req})[0];
+}
+
+void RemoteSession::start() {
+  // only async-signal-safe calls are allowed in the child, as some other
+  // thread could be holding a lock (eg: of malloc) while forking
+  std::vector<char*> argv;
+  for(const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+  argv.push_back(nullptr);
+  int sv[2];
+  int ret = socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv);
+  ASSERT(ret == 0, "RemoteSession: socketpair failed! errno=%d", errno);
+  pid = fork();
+  if(pid < 0) {
+    close(sv[0]);
+    close(sv[1]);
+    ASSERT(false, "RemoteSession: fork failed for '%s'!", args[0].c_str());
+  } else if(pid == 0) {
+    // child, talks to us over its stdin/stdout
+    dup2(sv[1], STDIN_FILENO);
+    dup2(sv[1], STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    if(devNull >= 0) dup2(devNull, STDERR_FILENO);
+    execvp(argv[0], argv.data());
+    _exit(127);
+  }
+  close(sv[1]);
+  fd = sv[0];
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  inBuf.clear();
+}
+
+void RemoteSession::stop() {
+  if(fd >= 0) close(fd);
+  fd = -1;
+  if(pid <= 0) return;
+  // the helper exits on its own once its stdin is closed
+  int status;
+  bool exited = false;
+  for(int i = 0; i < 20 && !exited; ++i) {
+    exited = waitpid(pid, &status, WNOHANG) == pid;
+    if(!exited) usleep(5000);
+  }
+  if(!exited) {
+    kill(pid, SIGTERM);
+    waitpid(pid, &status, 0);
+  }
+  pid = -1;
+}
+
+bool RemoteSession::exchange(const std::vector<RemoteRequest>& reqs,
+                             std::vector<RemoteReply>& replies,
+                             size_t& numSent) {
+  // only the requests not yet replied to are (re)sent
+  size_t first = replies.size(), num = reqs.size();
+  std::string out;
+  std::vector<size_t> offsets;
+  for(size_t i = first; i < num; ++i) {
+    const auto& r = reqs[i];
+    offsets.push_back(out.size());
+    out += r.op + ' ' + std::to_string(r.payload.size()) + ' ' + r.path + '\n';
+    out += r.payload;
+  }
+  // writing and reading go together, lest the helper blocks on a full pipe
+  size_t written = 0;
+  bool responded = true;
+  char buf[8192];
+  while(replies.size() < num) {
+    short events = POLLIN | (written < out.size() ? POLLOUT : 0);
+    struct pollfd p = {fd, events, 0};
+    int ret = poll(&p, 1, timeoutMs);
+    if(ret < 0) {
+      if(errno == EINTR) continue;
+      break;
+    }
+    if(ret == 0) {
+      responded = false;
+      break;
+    }
+    if(p.revents & POLLOUT) {
+      auto n = send(fd, out.data() + written, out.size() - written,
+                    MSG_NOSIGNAL);
+      if(n < 0 && errno != EAGAIN && errno != EINTR) break;
+      if(n > 0) written += n;
+    }
+    if(p.revents & (POLLIN | POLLHUP | POLLERR)) {
+      auto n = read(fd, buf, sizeof(buf));
+      if(n < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+      if(n <= 0) break;
+      inBuf.append(buf, n);
+      while(replies.size() < num && parseReply(replies)) {}
+    }
+  }
+  // requests even partly written might have reached the helper
+  numSent = first;
+  for(auto off : offsets)
+    if(off < written) ++numSent;
+  return responded;
+}
+
+bool RemoteSession::parseReply(std::vector<RemoteReply>& replies) {
+  auto nl = inBuf.find('\n');
+  if(nl == std::string::npos) return false;
+  int status;
+  size_t len;
+  bool ok = sscanf(inBuf.c_str(), "%d %zu", &status, &len) == 2;
+  if(!ok) stop();
+  ASSERT(ok, "RemoteSession: bad reply header '%s'!",
+         inBuf.substr(0, nl).c_str());
+  if(inBuf.size() < nl + 1 + len) return false;
+  replies.push_back({status, inBuf.substr(nl + 1, len)});
+  inBuf.erase(0, nl + 1 + len);
+  return true;
+}
+
+// guards the sessions map
+static std::mutex& sessionsMutex() {
+  static std::mutex mtx;
+  return mtx;
+}
+
+RemoteSession& RemoteSession::get(const std::string& host) {
+  std::lock_guard<std::mutex> lk(sessionsMutex());
+  auto& all = sessions();
+  auto itr = all.find(host);
+  if(itr != all.end()) return *itr->second;
+  Strings argv;
+  for(const auto& a : split(Option::get("ssh:cmd").getStr(), ' '))
+    if(!a.empty()) argv.push_back(a);
+  argv.push_back(host);
+  argv.push_back(std::string("sh -c '") + HelperScript + "'");
+  auto* rs = new RemoteSession(argv, Option::get("ssh:timeoutMs").getInt());
+  all[host].reset(rs);
+  return *rs;
+}
+
+void RemoteSession::closeAll() {
+  std::lock_guard<std::mutex> lk(sessionsMutex());
+  sessions().clear();
+}
+
+std::unordered_map<std::string, std::unique_ptr<RemoteSession>>&
+RemoteSession::sessions() {
+  static std::unordered_map<std::string, std::unique_ptr<RemoteSession>> all;
+  return all;
+}
+
+} // end namespace teditor
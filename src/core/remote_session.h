@@ -0,0 +1,101 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+#include "utils.h"
+
+
+namespace teditor {
+
+/** a single operation to be carried out on the remote host */
+struct RemoteRequest {
+  /** one of load, save, stat, list, mkdir or run */
+  std::string op;
+  /** file or dir to operate upon. For 'run' it is the working dir */
+  std::string path;
+  /** contents of the file for 'save' and the command for 'run' */
+  std::string payload;
+};
+
+struct RemoteReply {
+  /** exit status of the command for 'run', non-zero on failure otherwise */
+  int status;
+  /**
+   * file contents for 'load', one of 'd', 'f' or '-' (for missing) followed
+   * by a newline for 'stat', the 'ls -l' like listing for 'list' and the
+   * combined stdout/stderr for 'run'
+   */
+  std::string data;
+};
+
+
+/**
+ * @brief A persistent connection to a remote host, over which all remote file
+ * operations are carried out. This avoids paying for a full ssh handshake on
+ * every load, save or listing. The connection runs a small shell script on
+ * the host (see `HelperScript`), which reads requests framed as
+ * `<op> <payload-len> <path>\n<payload>` on its stdin and answers each of
+ * them, in order, as `<status> <data-len>\n<data>` on its stdout. Thus,
+ * multiple requests can be pipelined without waiting for their replies.
+ * A connection which has died is re-established once before giving up, but
+ * only if the requests yet to be answered are safe to be sent again. One which
+ * makes no progress for a while is deemed dead too.
+ */
+class RemoteSession {
+public:
+  /**
+   * @brief ctor
+   * @param argv command (with its args) which runs the helper script and
+   *             talks to it over its stdin/stdout. It is started lazily
+   * @param timeoutMs_ max time (in ms) to wait for the helper to make progress
+   */
+  RemoteSession(const Strings& argv, int timeoutMs_ = DefaultTimeoutMs);
+  ~RemoteSession();
+
+  /** sends all the requests in one go and then collects all their replies */
+  std::vector<RemoteReply> request(const std::vector<RemoteRequest>& reqs);
+  RemoteReply request(const RemoteRequest& req);
+  bool alive() const { return pid > 0; }
+  /** pid of the process running the helper, -1 if not running */
+  pid_t helperPid() const { return pid; }
+
+  /**
+   * @brief the session with the given host, connecting to it if needed. The
+   * connection is made with the command in the 'ssh:cmd' option.
+   */
+  static RemoteSession& get(const std::string& host);
+  /** closes the connections to all the hosts */
+  static void closeAll();
+
+  /** the helper run on the remote host. It contains no single quotes */
+  static const char* HelperScript;
+  static const int DefaultTimeoutMs;
+
+private:
+  Strings args;
+  int timeoutMs;
+  int fd;
+  pid_t pid;
+  /** bytes read from the helper, but not yet consumed */
+  std::string inBuf;
+
+  void start();
+  void stop();
+  /**
+   * @brief sends the requests which have no replies yet and reads their
+   * replies, until all of them are in or the connection dies
+   * @param numSent number of requests which might have reached the helper
+   * @return false if the helper did not make progress in time
+   */
+  bool exchange(const std::vector<RemoteRequest>& reqs,
+                std::vector<RemoteReply>& replies, size_t& numSent);
+  bool parseReply(std::vector<RemoteReply>& replies);
+
+  static std::unordered_map<std::string, std::unique_ptr<RemoteSession>>&
+    sessions();
+};  // class RemoteSession
+
+} // end namespace teditor
@@ -3,6 +3,7 @@
 #include <sys/stat.h>
 #include <stdint.h>
 #include "logger.h"
+#include "profiler.h"
 #include <unistd.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
@@ -11,6 +12,10 @@
 #include <signal.h>
 #include "file_utils.h"
 #include "infocmp.h"
+#include "option.h"
+#include "utf8.h"
+#include <algorithm>
+#include <map>
 
 
 namespace teditor {
@@ -32,6 +37,8 @@ const char* func2terminfo(Func f) {
   case Func_ExitKeypad: return "rmkx";
   case Func_EnterMouse: return "TBD";
   case Func_ExitMouse: return "TBD";
+  case Func_EnterPaste: return "TBD";
+  case Func_ExitPaste: return "TBD";
   default:
     ASSERT(false, "func2terminfo: bad func passed '%d'!", f);
   };
@@ -44,13 +51,19 @@ void sigwinch_handler(int xxx) {
   const int zzz = 1;
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-result"
-  (void)write(Terminal::getInstance().getWinchFd(1), &zzz, sizeof(int));
+  auto& term = static_cast<TtyTerminal&>(Terminal::getInstance());
+  (void)write(term.getWinchFd(1), &zzz, sizeof(int));
 #pragma GCC diagnostic pop
 }
 
 const std::string Terminal::EnterMouseSeq = "\x1b[?1000h\x1b[?1002h\x1b[?1015h\x1b[?1006h";
 const std::string Terminal::ExitMouseSeq = "\x1b[?1006l\x1b[?1015l\x1b[?1002l\x1b[?1000l";
+const std::string Terminal::EnterPasteSeq = "\x1b[?2004h";
+const std::string Terminal::PasteStart = "\x1b[200~";
+const std::string Terminal::PasteEnd = "\x1b[201~";
+const std::string Terminal::ExitPasteSeq = "\x1b[?2004l";
 const int Terminal::BuffSize = 32 * 1024;
+const int Terminal::InputBuffSize = 64 * 1024;
 const int Terminal::UndefinedSequence = -10;
 Terminal* Terminal::inst = nullptr;
 
@@ -68,7 +81,55 @@ void Terminal::puts(const char* data, size_t len) {
   outbuff.append(data, len);
 }
 
-void Terminal::flush() {
+InputRing::InputRing(size_t capacity): buff(), mask(0), head(0), tail(0) {
+  size_t cap = 1;
+  while(cap < capacity) cap <<= 1;
+  buff.resize(cap);
+  mask = cap - 1;
+}
+
+char* InputRing::writable(size_t& len) {
+  size_t pos = tail & mask;
+  len = std::min(buff.size() - size(), buff.size() - pos);
+  return buff.data() + pos;
+}
+
+std::string InputRing::str(size_t n) const {
+  n = std::min(n, size());
+  std::string ret;
+  ret.reserve(n);
+  size_t pos = head & mask, first = std::min(n, buff.size() - pos);
+  ret.append(buff.data() + pos, first);
+  ret.append(buff.data(), n - first);
+  return ret;
+}
+
+size_t InputRing::push(const char* data, size_t len) {
+  size_t done = 0;
+  while(done < len) {
+    size_t avail;
+    char* ptr = writable(avail);
+    if(avail == 0) break;
+    avail = std::min(avail, len - done);
+    memcpy(ptr, data + done, avail);
+    commit(avail);
+    done += avail;
+  }
+  return done;
+}
+
+
+Terminal::Terminal():
+  type(), mk(), loc(), text(), funcs(), outbuff(), tsize(),
+  inbuf(InputBuffSize), oldSeq(), buffResize(false), inPaste(false),
+  pasted() {
+  outbuff.reserve(BuffSize);
+}
+
+Terminal::~Terminal() {}
+
+void TtyTerminal::flush() {
+  PROBE(TerminalFlush);
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-result"
   (void)write(inout, outbuff.c_str(), outbuff.length());
@@ -77,7 +138,7 @@ void Terminal::flush() {
   outbuff.clear();
 }
 
-void Terminal::updateTermSize() {
+void TtyTerminal::updateTermSize() {
   struct winsize sz;
   memset(&sz, 0, sizeof(sz));
   ioctl(inout, TIOCGWINSZ, &sz);
@@ -85,18 +146,17 @@ void Terminal::updateTermSize() {
   tsize.y = sz.ws_row;
 }
 
-Terminal::Terminal(const std::string& tty):
-  type(), mk(), loc(), funcs(), termName(env("TERM")), outbuff(), ttyFile(tty),
-  inout(-1), tios(), origTios(), seq(), oldSeq(), buffResize(false),
-  winchFds() {
+TtyTerminal::TtyTerminal(const std::string& tty):
+  Terminal(), termName(env("TERM")), ttyFile(tty), inout(-1), tios(),
+  origTios(), winchFds() {
   // terminfo setup
-  InfoCmp infocmp;
-  for (int i = 0; i < Func_FuncsNum - 2; ++i) {
+  InfoCmp infocmp(termName, Option::get("homeFolder").getStr() + "/terminfo");
+  for (int i = 0; i < Func_EnterMouse; ++i) {
     funcs.push_back(infocmp.getStrCap(func2terminfo(Func(i))));
   }
-  funcs.push_back(EnterMouseSeq);
-  funcs.push_back(ExitMouseSeq);
-  INFO("Terminal: term=%s ttyFile=%s\n", termName.c_str(), ttyFile.c_str());
+  addNonTerminfoFuncs();
+  INFO("Terminal: term=%s ttyFile=%s terminfo-source=%d\n", termName.c_str(),
+       ttyFile.c_str(), infocmp.source);
   // termios setup
   inout = open(ttyFile.c_str(), O_RDWR);
   ASSERT(inout >= 0, "Terminal: Failed to open tty '%s'!", ttyFile.c_str());
@@ -104,22 +164,23 @@ Terminal::Terminal(const std::string& tty):
   ASSERT(f >= 0, "Terminal: failed to fcntl in the tty descriptor (ret=%d)!", f);
   ASSERT(isatty(inout), "Terminal: descriptor opened from '%s' not a tty!",
          ttyFile.c_str());
-  outbuff.reserve(BuffSize);
   setupTios();
   puts(Func_EnterKeypad);
   puts(Func_EnterCA);
   puts(Func_HideCursor); // we'll manually handle the cursor draws
+  puts(Func_EnterPaste);
   // event handler setup
   ASSERT(pipe(winchFds) >= 0, "Failed to setup 'pipe'!");
   reset();
   setSignalHandler();
 }
 
-Terminal::~Terminal() {
+TtyTerminal::~TtyTerminal() {
   puts(Func_Sgr0);
   puts(Func_ExitCA);
   puts(Func_ExitKeypad);
   puts(Func_ExitMouse);
+  puts(Func_ExitPaste);
   puts(Func_ShowCursor);
   flush();
   tcsetattr(inout, TCSAFLUSH, &origTios);
@@ -128,7 +189,14 @@ Terminal::~Terminal() {
   close(winchFds[1]);
 }
 
-void Terminal::setSignalHandler() {
+void Terminal::addNonTerminfoFuncs() {
+  funcs.push_back(EnterMouseSeq);
+  funcs.push_back(ExitMouseSeq);
+  funcs.push_back(EnterPasteSeq);
+  funcs.push_back(ExitPasteSeq);
+}
+
+void TtyTerminal::setSignalHandler() {
   struct sigaction sa;
   memset(&sa, 0, sizeof(sa));
   sa.sa_handler = sigwinch_handler;
@@ -144,7 +212,7 @@ void Terminal::setSignalHandler() {
   signal(SIGPIPE, SIG_IGN);
 }
 
-void Terminal::setupTios() {
+void TtyTerminal::setupTios() {
   tcgetattr(inout, &origTios);
   memcpy(&tios, &origTios, sizeof(tios));
   tios.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP
@@ -158,7 +226,7 @@ void Terminal::setupTios() {
   tcsetattr(inout, TCSAFLUSH, &tios);
 }
 
-Terminal::ColorSupport Terminal::colorSupported() const {
+TtyTerminal::ColorSupport TtyTerminal::colorSupported() const {
   std::string colorterm = env("COLORTERM");
   if((colorterm.find("truecolor") != std::string::npos) ||
      (colorterm.find("24bit") != std::string::npos)) {
@@ -180,93 +248,249 @@ struct KeyCombo {
 
 #include "xterm_strokes.h"
 
-struct AllCombos {
-  AllCombos() { for(auto& c : KeyCombo::Combos) allKeys[c.escSeq] = c.mk; }
-  static std::unordered_map<std::string, MetaKey> allKeys;
-  static const AllCombos test;
+/**
+ * Escape sequences (minus the leading Esc) of all the known keys, as a trie
+ * stored in flat arrays. Children of a node are contiguous and sorted.
+ */
+class EscTrie {
+public:
+  enum Kind {
+    Kind_None,
+    Kind_Key,
+    Kind_PasteStart,
+  };
+
+  struct Node {
+    MetaKey mk;
+    Kind kind;
+    int first, num;
+  };
+
+  static const EscTrie& get() {
+    static const EscTrie trie;
+    return trie;
+  }
+
+  const Node& root() const { return nodes[0]; }
+  /** returns the child of the node for the given byte, nullptr if none */
+  const Node* child(const Node& n, char c) const {
+    for(int i = n.first; i < n.first + n.num; ++i)
+      if(labels[i] == c) return &nodes[i];
+    return nullptr;
+  }
+
+private:
+  std::vector<Node> nodes;
+  /** the byte leading to each node from its parent */
+  std::vector<char> labels;
+
+  struct TmpNode {
+    MetaKey mk;
+    Kind kind;
+    std::map<char, int> children;
+  };
+
+  EscTrie(): nodes(), labels() {
+    std::vector<TmpNode> tmp(1, {MetaKey(), Kind_None, {}});
+    auto add = [&tmp](const std::string& s, const MetaKey& mk, Kind kind) {
+      int curr = 0;
+      for(auto c : s) {
+        auto itr = tmp[curr].children.find(c);
+        if(itr == tmp[curr].children.end()) {
+          tmp[curr].children[c] = (int)tmp.size();
+          curr = (int)tmp.size();
+          tmp.push_back({MetaKey(), Kind_None, {}});
+        } else {
+          curr = itr->second;
+        }
+      }
+      // later definitions of a sequence win, just like before
+      tmp[curr].mk = mk;
+      tmp[curr].kind = kind;
+    };
+    for(const auto& c : KeyCombo::Combos) add(c.escSeq, c.mk, Kind_Key);
+    add(Terminal::PasteStart.substr(1), MetaKey(), Kind_PasteStart);
+    // flatten in breadth-first order
+    std::vector<int> order(1, 0);
+    nodes.push_back({MetaKey(), Kind_None, 0, 0});
+    labels.push_back(0);
+    for(size_t i = 0; i < order.size(); ++i) {
+      const auto& t = tmp[order[i]];
+      auto& n = nodes[i];
+      n.mk = t.mk;
+      n.kind = t.kind;
+      n.first = (int)nodes.size();
+      n.num = (int)t.children.size();
+      for(const auto& ch : t.children) {
+        order.push_back(ch.second);
+        nodes.push_back({MetaKey(), Kind_None, 0, 0});
+        labels.push_back(ch.first);
+      }
+    }
+  }
 };
 
-std::unordered_map<std::string, MetaKey> AllCombos::allKeys;
-const AllCombos AllCombos::test;
+MetaKey char2key(key_t ch) {
+  MetaKey mk(ch);
+  // Ctrl A-Z and 0-7, except Enter
+  if(ch < Key_Space && ch != Key_Enter && ch != Key_Tab)
+    mk.updateMeta(Meta_Ctrl);
+  return mk;
+}
+
+std::string key2seq(const std::string& key) {
+  static std::unordered_map<std::string, std::string> seqs;
+  if(seqs.empty()) {
+    std::string esc(1, (char)Key_Esc);
+    // the first of the alternatives for a key wins
+    for(const auto& c : KeyCombo::Combos)
+      seqs.insert({c.mk.toStr(), esc + c.escSeq});
+    seqs["esc"] = esc;
+    for(key_t ch = 0; ch <= Key_Backspace2; ++ch) {
+      if(ch != Key_Esc)
+        seqs.insert({char2key(ch).toStr(), std::string(1, (char)ch)});
+      if(Key_Space <= ch && ch <= Key_Tilde)
+        seqs.insert({MetaKey(Meta_Alt, ch).toStr(), esc + (char)ch});
+    }
+  }
+  auto itr = seqs.find(key);
+  ASSERT(itr != seqs.end(), "key2seq: unknown key '%s'!", key.c_str());
+  return itr->second;
+}
 
 void Terminal::reset() {
   type = Event_None;
   loc = {0, 0};
   mk.reset();
   mk.setMeta(Meta_None);
+  text.clear();
 }
 
-int Terminal::decodeChar(key_t ch) {
-  ULTRA_DEBUG("decodeChar: ch=%u\n", ch);
-  mk.setKey(ch);
-  // Ctrl A-Z and 0-7, except Enter
-  if(ch < Key_Space && ch != Key_Enter && ch != Key_Tab)
-    mk.updateMeta(Meta_Ctrl);
-  return 1;
+int Terminal::undefined(size_t len) {
+  oldSeq = inbuf.str(len);
+  inbuf.consume(len);
+  DEBUG("Terminal: unknown seq=%s\n", oldSeq.c_str());
+  return UndefinedSequence;
 }
 
 int Terminal::decodeEscSeq() {
-  int len = (int)seq.length();
-  ULTRA_DEBUG("decodeEscSeq: len=%d seq=%s\n", len, seq.c_str());
-  if(len == 0) {
+  ULTRA_DEBUG("decodeEscSeq: len=%lu\n", inbuf.size());
+  if(inbuf.size() == 1) {
+    inbuf.consume(1);
     mk.setKey(Key_Esc);
-    return 1;
+    return type;
   }
+  const auto& trie = EscTrie::get();
+  char c = inbuf[1];
   // Alt-<key>
-  if(len == 1 && (char)Key_Space <= seq[0] && seq[0] <= (char)Key_Tilde) {
-    mk = MetaKey(Meta_Alt, (key_t)seq[0]);
-    seq.erase(0, 1);
-    return 1;
+  if((char)Key_Space <= c && c <= (char)Key_Tilde &&
+     (inbuf.size() == 2 || trie.child(trie.root(), c) == nullptr)) {
+    mk = MetaKey(Meta_Alt, (key_t)c);
+    inbuf.consume(2);
+    return type;
   }
-  // check for shortest string matching the list of keys
-  for(int i=1;i<=len;++i) {
-    std::string str(seq, 0, i);
-    const auto itr = AllCombos::allKeys.find(str);
-    if(itr != AllCombos::allKeys.end()) {
-      mk = itr->second;
-      seq.erase(0, i);
-      return i;
+  // walk down the trie till the shortest matching sequence
+  const auto* node = &trie.root();
+  for(size_t i = 1; ; ++i) {
+    if(i >= inbuf.size() && !fetchMore()) return undefined(i);
+    node = trie.child(*node, inbuf[i]);
+    if(node == nullptr) return undefined(i + 1);
+    if(node->kind == EscTrie::Kind_Key) {
+      mk = node->mk;
+      inbuf.consume(i + 1);
+      return type;
+    }
+    if(node->kind == EscTrie::Kind_PasteStart) {
+      inbuf.consume(i + 1);
+      inPaste = true;
+      return readPaste();
     }
   }
-  oldSeq = seq;
-  seq.clear();
-  DEBUG("decodeEscSeq: unknown seq=%s\n", oldSeq.c_str());
-  return UndefinedSequence;
 }
 
-int Terminal::readAndExtract() {
-  ULTRA_DEBUG("Terminal::readAndExtract: before read seq=%s\n", seq.c_str());
-  if (seq.empty()) {
-    int rs = 1;
-    do {
-      char c;
-      rs = read(inout, &c, 1);
-      if(rs > 0)
-        seq += c;
-    } while(rs > 0);
+int Terminal::decodeUtf8() {
+  size_t len = Utf8::charLen(inbuf[0]);
+  // stray continuation bytes
+  if(len == 1) return undefined(1);
+  while(inbuf.size() < len)
+    if(!fetchMore()) return undefined(inbuf.size());
+  type = Event_Text;
+  text = inbuf.str(len);
+  inbuf.consume(len);
+  return type;
+}
+
+int Terminal::readPaste() {
+  const size_t endLen = PasteEnd.size();
+  // move everything till the end marker into the pasted text
+  size_t i = 0, n = inbuf.size();
+  for(; i < n; ++i) {
+    if(inbuf[i] != PasteEnd[0]) continue;
+    size_t j = 1;
+    while(j < endLen && i + j < n && inbuf[i + j] == PasteEnd[j]) ++j;
+    if(j == endLen) break;
+    // a partial end marker at the end of the input
+    if(i + j == n) break;
   }
-  ULTRA_DEBUG("Terminal::readAndExtract: after read seq=%s\n", seq.c_str());
+  pasted += inbuf.str(i);
+  inbuf.consume(i);
+  if(inbuf.size() < endLen) return 0;  // wait for the rest of the paste
+  inbuf.consume(endLen);
+  inPaste = false;
+  type = Event_Text;
+  // terminals send carriage returns for newlines
+  text.clear();
+  text.reserve(pasted.size());
+  for(size_t k = 0; k < pasted.size(); ++k) {
+    if(pasted[k] != '\r') text += pasted[k];
+    else if(k + 1 >= pasted.size() || pasted[k + 1] != '\n') text += '\n';
+  }
+  pasted.clear();
+  return type;
+}
+
+int Terminal::readKey() {
+  if(inPaste) return readPaste();
+  if(inbuf.empty()) return 0;
   ///@todo: support for mouse events
   type = Event_Key;
   mk.setMeta(Meta_None);
-  char c = seq[0];
-  seq.erase(0, 1);
+  char c = inbuf[0];
+  ULTRA_DEBUG("Terminal::readKey: c=%d len=%lu\n", (int)c, inbuf.size());
   if(c == (char)Key_Esc) return decodeEscSeq();
-  if(c <= (char)Key_Backspace2) return decodeChar(c);
-  ASSERT(false, "Terminal::readAndExtract: UTF8 sequence found '%u'!",
-         (uint32_t)c);
+  if((unsigned char)c <= Key_Backspace2) {
+    mk = char2key((unsigned char)c);
+    inbuf.consume(1);
+    return type;
+  }
+  return decodeUtf8();
 }
 
-int Terminal::readKey() {
-  auto n = readAndExtract();
-  ULTRA_DEBUG("Terminal::readKey: inout keyval=%d\n", n);
-  if(n == UndefinedSequence) return n;
-  if(n < 0) return -1;
-  if(n > 0) return type;
-  return 0;
+bool TtyTerminal::readInput() {
+  bool any = false;
+  while(true) {
+    size_t len;
+    char* ptr = inbuf.writable(len);
+    if(len == 0) break;
+    auto rs = read(inout, ptr, len);
+    if(rs <= 0) break;
+    inbuf.commit((size_t)rs);
+    any = true;
+  }
+  return any;
 }
 
-int Terminal::waitAndFill(struct timeval* timeout) {
+bool TtyTerminal::fetchMore() {
+  // rest of a sequence usually follows immediately, if at all
+  fd_set events;
+  FD_ZERO(&events);
+  FD_SET(inout, &events);
+  struct timeval tv = {0, 20000};
+  if(select(inout + 1, &events, 0, 0, &tv) <= 0) return false;
+  return readInput();
+}
+
+int TtyTerminal::waitAndFill(struct timeval* timeout) {
   fd_set events;
   reset();
   while(1) {
@@ -274,7 +498,7 @@ int Terminal::waitAndFill(struct timeval* timeout) {
     FD_SET(inout, &events);
     FD_SET(winchFds[0], &events);
     int maxfd  = std::max(winchFds[0], inout);
-    if (!seq.empty()) return readKey();
+    if (!inbuf.empty() && !inPaste) return readKey();
     ULTRA_DEBUG("Terminal::waitAndFill: waiting on select...\n");
     int result = select(maxfd+1, &events, 0, 0, timeout);
     ULTRA_DEBUG("Terminal::waitAndFill: result=%d\n", result);
@@ -295,7 +519,13 @@ int Terminal::waitAndFill(struct timeval* timeout) {
       disableResize();
     }
     // key/mouse events
-    if(FD_ISSET(inout, &events)) return readKey();
+    if(FD_ISSET(inout, &events)) {
+      readInput();
+      int ret = readKey();
+      // still in the middle of a paste
+      if(ret == 0 && inPaste) continue;
+      return ret;
+    }
   }
 }
 
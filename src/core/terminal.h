@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "utils.h"
 #include <string.h>
 #include <termios.h>
@@ -25,6 +26,8 @@ enum Func {
   Func_ExitKeypad,
   Func_EnterMouse,
   Func_ExitMouse,
+  Func_EnterPaste,
+  Func_ExitPaste,
   Func_FuncsNum,
 };
 
@@ -32,13 +35,59 @@ enum EventType {
   Event_Key = 1,
   Event_Resize,
   Event_Mouse,
+  /** UTF-8 text, either a non-ASCII char or a bracketed paste */
+  Event_Text,
   Event_None = 0
 };
 
 const char* func2terminfo(Func f);
 
 
-///@todo: implement decodeUtf8 if needed
+/**
+ * @brief Converts the name of a key (as used in the keybindings, eg: "C-X",
+ * "M-f", "enter", "up", "a") into the byte sequence a terminal sends for it
+ */
+std::string key2seq(const std::string& key);
+
+
+/**
+ * @brief Fixed size ring of input bytes. Bytes are read from the terminal
+ * directly into its free space, in as large chunks as possible.
+ */
+class InputRing {
+public:
+  InputRing(size_t capacity);
+
+  size_t size() const { return tail - head; }
+  bool empty() const { return head == tail; }
+  bool full() const { return size() == buff.size(); }
+  /** i-th byte from the front, which must be less than `size()` */
+  char operator[](size_t i) const { return buff[(head + i) & mask]; }
+  /** removes 'n' bytes from the front */
+  void consume(size_t n) { head += std::min(n, size()); }
+  /** contiguous free space at the back, to be filled by the caller */
+  char* writable(size_t& len);
+  /** marks 'n' bytes of the above space as filled */
+  void commit(size_t n) { tail += n; }
+  /** copies 'n' bytes from the front into a string */
+  std::string str(size_t n) const;
+  /** appends the given bytes and returns the number of bytes appended */
+  size_t push(const char* data, size_t len);
+
+private:
+  std::vector<char> buff;
+  size_t mask;
+  /** monotonically increasing read/write positions */
+  size_t head, tail;
+};
+
+
+/**
+ * @brief The interface to the terminal. Output is accumulated in a buffer and
+ * sent out on every `flush`. Input bytes are decoded into key events by this
+ * class, while fetching them is left to the implementations. There can only be
+ * one terminal at any time, which is accessed via `getInstance`.
+ */
 ///@todo: add support for mouse in future
 class Terminal {
 public:
@@ -48,8 +97,11 @@ public:
   MetaKey mk;
   /** for mouse events */
   Pos2d<uint16_t> loc;
+  /** for text events */
+  std::string text;
+
+  virtual ~Terminal();
 
-  int getWinchFd(int idx) const { return winchFds[idx]; }
   int width() const { return tsize.x; }
   int height() const { return tsize.y; }
 
@@ -67,9 +119,9 @@ public:
   void puts(const std::string& data) { puts(data.c_str(), data.length()); }
   void puts(Func f) { puts(func(f)); }
   /** flush the contents of the buffer to the pty */
-  void flush();
+  virtual void flush() = 0;
   /** update the terminal size */
-  void updateTermSize();
+  virtual void updateTermSize() = 0;
   /** @} */
 
   /**
@@ -78,8 +130,12 @@ public:
    */
   /** reset the input pipeline */
   void reset();
-  /** wait for an event and extract it */
-  int waitAndFill(struct timeval* timeout);
+  /**
+   * @brief wait for an event and extract it
+   * @return the event type, 0 on timeout, `UndefinedSequence` for an unknown
+   *         key sequence and a negative value when no more input is available
+   */
+  virtual int waitAndFill(struct timeval* timeout) = 0;
   /** get the previous key sequence */
   const std::string& getOldSeq() const { return oldSeq; }
   /** whether to resize the buffer */
@@ -93,34 +149,86 @@ public:
 
   /** flag to raise an undefined escape sequence scenario */
   static const int UndefinedSequence;
+  /** markers around a bracketed paste */
+  static const std::string PasteStart;
+  static const std::string PasteEnd;
 
-private:
+protected:
   /** functions */
   Strings funcs;
-  /** pty name */
-  std::string termName;
   /** buffer used to communicate commands to the pty */
   std::string outbuff;
-  /** tty file to be used for communication */
-  std::string ttyFile;
-  /** file descriptor for the ttyFile */
-  int inout;
-  /** termios struct to update attrs */
-  struct termios tios, origTios;
   /** terminal size */
   Pos2di tsize;
-  /** key sequences */
-  std::string seq, oldSeq;
+  /** pending input bytes */
+  InputRing inbuf;
+  /** the previous undecodable input */
+  std::string oldSeq;
   /** whether to resize the buffer */
   bool buffResize;
-  /** window change listeners */
-  int winchFds[2];
+  /** whether in the middle of a bracketed paste */
+  bool inPaste;
 
-  /** the singleton object */
-  static Terminal* inst;
   static const std::string EnterMouseSeq;
   static const std::string ExitMouseSeq;
+  static const std::string EnterPasteSeq;
+  static const std::string ExitPasteSeq;
   static const int BuffSize;
+  static const int InputBuffSize;
+
+  Terminal();
+  const char* func(int id) const { return funcs[id].c_str(); }
+  /** appends the funcs which are not part of terminfo */
+  void addNonTerminfoFuncs();
+  /**
+   * @brief decodes the next event out of the pending input
+   * @return the event type, 0 if there's no complete event yet, or
+   *         `UndefinedSequence`
+   */
+  int readKey();
+  /**
+   * @brief tries to get more input, when the pending input ends in the middle
+   * of a key sequence
+   * @return true if new input was added
+   */
+  virtual bool fetchMore() { return false; }
+
+private:
+  /** the singleton object */
+  static Terminal* inst;
+  /** bracketed paste received so far */
+  std::string pasted;
+
+  int decodeEscSeq();
+  int decodeUtf8();
+  int readPaste();
+  int undefined(size_t len);
+
+  template <typename A, typename B> friend class SingletonHandler;
+};
+
+
+/** The terminal backed by a real tty */
+class TtyTerminal: public Terminal {
+public:
+  ~TtyTerminal();
+
+  int getWinchFd(int idx) const { return winchFds[idx]; }
+  void flush() override;
+  void updateTermSize() override;
+  int waitAndFill(struct timeval* timeout) override;
+
+private:
+  /** pty name */
+  std::string termName;
+  /** tty file to be used for communication */
+  std::string ttyFile;
+  /** file descriptor for the ttyFile */
+  int inout;
+  /** termios struct to update attrs */
+  struct termios tios, origTios;
+  /** window change listeners */
+  int winchFds[2];
 
   enum ColorSupport {
     CS_None = 0,
@@ -128,16 +236,13 @@ private:
     CS_True
   };
 
-  Terminal(const std::string& tty);
-  ~Terminal();
+  TtyTerminal(const std::string& tty);
   void setSignalHandler();
   void setupTios();
   ColorSupport colorSupported() const;
-  const char* func(int id) const { return funcs[id].c_str(); }
-  int readAndExtract();
-  int decodeChar(key_t ch);
-  int decodeEscSeq();
-  int readKey();
+  /** reads all of the available input, returns false if there was none */
+  bool readInput();
+  bool fetchMore() override;
 
   template <typename A, typename B> friend class SingletonHandler;
 };
@@ -21,7 +21,10 @@ const std::string& timeFormat() {
 
 struct tm toStructTm(const TimePoint& pt) {
   auto asTime = std::chrono::system_clock::to_time_t(pt);
-  return *std::localtime(&asTime);
+  // localtime_r, as the todo occurrences are expanded on multiple threads
+  struct tm ret;
+  localtime_r(&asTime, &ret);
+  return ret;
 }
 
 TimePoint toTimePoint(struct tm& tm_) {
@@ -100,12 +103,15 @@ void addMonth(TimePoint& pt) {
     t.tm_mon = 0;
     ++t.tm_year;
   }
+  // let mktime figure out the DST of the new date
+  t.tm_isdst = -1;
   pt = toTimePoint(t);
 }
 
 void addYear(TimePoint& pt) {
   auto t = toStructTm(pt);
   ++t.tm_year;
+  t.tm_isdst = -1;
   pt = toTimePoint(t);
 }
 
@@ -152,9 +158,43 @@ TimePoint addYear(const TimePoint& pt) {
 }
 
 void weekFor(TimePoint& start, TimePoint& end, const TimePoint& pt) {
-  auto dw = dayOfWeek(pt);
-  start = addDay(pt, -dw);
-  end = addDay(static_cast<const TimePoint&>(start), 6);
+  // aligned to the midnight, so that all the time points in a week agree
+  auto t = toStructTm(pt);
+  t.tm_mday -= t.tm_wday;
+  t.tm_hour = t.tm_min = t.tm_sec = 0;
+  t.tm_isdst = -1;
+  auto t1 = t;
+  start = toTimePoint(t);
+  t1.tm_mday += 6;
+  t1.tm_isdst = -1;
+  end = toTimePoint(t1);
+}
+
+/** period of the given number of months, aligned to the beginning of year */
+void periodFor(TimePoint& start, TimePoint& end, const TimePoint& pt,
+               int months) {
+  auto t = toStructTm(pt);
+  t.tm_mon = t.tm_mon / months * months;
+  t.tm_mday = 1;
+  t.tm_hour = t.tm_min = t.tm_sec = 0;
+  t.tm_isdst = -1;
+  auto t1 = t;
+  start = toTimePoint(t);
+  t1.tm_mon += months;
+  t1.tm_isdst = -1;
+  end = toTimePoint(t1) - std::chrono::seconds(1);
+}
+
+void monthFor(TimePoint& start, TimePoint& end, const TimePoint& pt) {
+  periodFor(start, end, pt, 1);
+}
+
+void quarterFor(TimePoint& start, TimePoint& end, const TimePoint& pt) {
+  periodFor(start, end, pt, 3);
+}
+
+void yearFor(TimePoint& start, TimePoint& end, const TimePoint& pt) {
+  periodFor(start, end, pt, 12);
 }
 
 }  // namespace teditor
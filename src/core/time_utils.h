@@ -36,5 +36,14 @@ TimePoint addMonth(const TimePoint& pt);
 TimePoint addYear(const TimePoint& pt);
 
 void weekFor(TimePoint& start, TimePoint& end, const TimePoint& pt);
+/**
+ * @defgroup Periods first and last second of the month/quarter/year containing
+ * the given time point
+ * @{
+ */
+void monthFor(TimePoint& start, TimePoint& end, const TimePoint& pt);
+void quarterFor(TimePoint& start, TimePoint& end, const TimePoint& pt);
+void yearFor(TimePoint& start, TimePoint& end, const TimePoint& pt);
+/** @} */
 
 }  // namespace teditor
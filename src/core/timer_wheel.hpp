@@ -0,0 +1,138 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace teditor {
+
+/**
+ * @brief Hierarchical timer wheel. Time is measured in integral ticks. Each
+ *        level has `Slots` buckets and every bucket of a level spans as many
+ *        ticks as the whole of its previous level. Insertion is O(1) and
+ *        advancing the time by one tick is amortized O(1), as timers far in
+ *        the future get cascaded down to the lower levels only as they come
+ *        closer to their expiry.
+ * @tparam T the payload to be stored with every timer
+ */
+template <typename T>
+class TimerWheel {
+public:
+  static const int Bits = 6;
+  static const int Slots = 1 << Bits;
+  static const int Levels = 4;
+
+  /**
+   * @brief ctor
+   * @param now the starting tick
+   */
+  TimerWheel(uint64_t now = 0) : curr(now), count(0), wheel(), overflow() {
+    wheel.resize(Levels * Slots);
+  }
+
+  uint64_t now() const { return curr; }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  /**
+   * @brief adds a new timer. Expiries which are not in the future will fire at
+   *        the next tick
+   */
+  void add(uint64_t expiry, const T& val) {
+    if (expiry <= curr) expiry = curr + 1;
+    insert({expiry, val});
+    ++count;
+  }
+
+  /**
+   * @brief advances the current time and collects the expired timers
+   * @param now the tick to advance to
+   * @param expired the payloads of expired timers are appended here, in the
+   *                order of their expiry
+   */
+  void advance(uint64_t now, std::vector<T>& expired) {
+    if (count == 0) {
+      if (now > curr) curr = now;
+      return;
+    }
+    while (curr < now) {
+      ++curr;
+      cascade();
+      auto& bucket = wheel[curr & Mask];
+      for (const auto& e : bucket) expired.push_back(e.val);
+      count -= bucket.size();
+      bucket.clear();
+    }
+  }
+
+  /**
+   * @brief number of ticks that can be safely skipped without missing any
+   *        expiry. This is only a lower bound, as the higher levels are not
+   *        looked into.
+   */
+  uint64_t ticksToNext() const {
+    for (uint64_t d = 1; d < Slots; ++d) {
+      if (!wheel[(curr + d) & Mask].empty()) return d;
+      // a cascade might bring timers down to the lower level here
+      if (((curr + d) & Mask) == 0) return d;
+    }
+    return Slots;
+  }
+
+private:
+  static const uint64_t Mask = Slots - 1;
+
+  struct Entry {
+    uint64_t expiry;
+    T val;
+  };  // struct Entry
+
+  uint64_t curr;
+  size_t count;
+  /** all the levels, with each being 'Slots' buckets wide */
+  std::vector<std::vector<Entry>> wheel;
+  /** timers beyond the range of the top level */
+  std::vector<Entry> overflow;
+
+  /**
+   * a timer goes into the lowest level above which its expiry and the current
+   * time agree. This guarantees that it never lands in the current bucket of
+   * that level, which has already been cascaded
+   */
+  void insert(const Entry& e) {
+    for (int l = 0; l < Levels; ++l) {
+      int shift = Bits * (l + 1);
+      if ((e.expiry >> shift) == (curr >> shift)) {
+        auto slot = (e.expiry >> (Bits * l)) & Mask;
+        wheel[l * Slots + slot].push_back(e);
+        return;
+      }
+    }
+    overflow.push_back(e);
+  }
+
+  /** brings the timers of the higher levels down, whenever a level wraps */
+  void cascade() {
+    if ((curr & Mask) != 0) return;
+    for (int l = 1; l < Levels; ++l) {
+      auto slot = (curr >> (Bits * l)) & Mask;
+      redistribute(wheel[l * Slots + slot]);
+      if (slot != 0) return;
+    }
+    redistribute(overflow);
+  }
+
+  void redistribute(std::vector<Entry>& bucket) {
+    if (bucket.empty()) return;
+    std::vector<Entry> tmp;
+    tmp.swap(bucket);
+    for (const auto& e : tmp) insert(e);
+  }
+};  // class TimerWheel
+
+template <typename T> const int TimerWheel<T>::Bits;
+template <typename T> const int TimerWheel<T>::Slots;
+template <typename T> const int TimerWheel<T>::Levels;
+template <typename T> const uint64_t TimerWheel<T>::Mask;
+
+}  // namespace teditor
@@ -1,4 +1,5 @@
 #include "utf8.h"
+#include <wchar.h>
 
 namespace teditor {
 namespace Utf8 {
@@ -64,5 +65,10 @@ int unicode2char(char* out, uint32_t c) {
   return len;
 }
 
+int width(uint32_t c) {
+  int w = wcwidth((wchar_t)c);
+  return w < 1 ? 1 : w;
+}
+
 } // end namespace Utf8
 } // end namespace teditor
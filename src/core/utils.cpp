@@ -13,6 +13,7 @@
 #include <iostream>
 #include <cctype>
 #include "file_utils.h"
+#include "remote_session.h"
 #include <chrono>
 #include <ctime>
 #include <thread>
@@ -98,9 +99,15 @@ bool isUnderGit(const std::string& dir) {
 
 std::string gitBranchName(const std::string& dir) {
   if(!isUnderGit(dir)) return "";
-  std::string cmdStr = "cd " + dir + " && git rev-parse --abbrev-ref HEAD";
+  std::string cmdStr = " && git rev-parse --abbrev-ref HEAD";
+  CmdStatus cmd;
   // Note: this line consumes non-trivial amount of time!
-  auto cmd = check_output(cmdStr);
+  if(isRemote(dir)) {
+    Remote r(dir);
+    cmd = check_output("cd " + r.file + cmdStr, r.host);
+  } else {
+    cmd = check_output("cd " + dir + cmdStr);
+  }
   if(cmd.status != 0) return "";
   auto ret = cmd.output;
   if(ret.back() == '\n') ret = ret.substr(0, ret.size()-1);
@@ -161,8 +168,11 @@ CmdStatus check_output(const std::string& cmd) {
 }
 
 CmdStatus check_output(const std::string& cmd, const std::string& host) {
-  std::string sshCmd = "ssh " + host + " " + cmd;
-  return check_output(sshCmd);
+  auto out = RemoteSession::get(host).request({"run", ".", cmd});
+  CmdStatus ret;
+  ret.output = out.data;
+  ret.status = out.status;
+  return ret;
 }
 
 
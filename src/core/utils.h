@@ -79,7 +79,10 @@ struct CmdStatus {
 };
 
 CmdStatus check_output(const std::string& cmd);
-/** run the given command on the remote host and return its output */
+/**
+ * run the given command on the remote host (over its RemoteSession) and
+ * return its output. Its stderr is merged into the output
+ */
 CmdStatus check_output(const std::string& cmd, const std::string& host);
 
 /** @brief Hexify the input url */
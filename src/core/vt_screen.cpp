@@ -0,0 +1,229 @@
+#include "vt_screen.h"
+#include "utf8.h"
+#include "utils.h"
+
+
+namespace teditor {
+
+VtScreen::VtScreen(int w, int h):
+  screen(w, h), cu(0, 0), top(0), bot(h - 1), fg(), bg(), showCursor(true), titleStr(),
+  state(St_Ground), params(), utf8() {
+  erase(0, 0, w, h);
+}
+
+void VtScreen::resize(int w, int h) {
+  screen.resize(w, h);
+  top = 0;
+  bot = h - 1;
+  erase(0, 0, w, h);
+  clampCursor();
+}
+
+std::string VtScreen::row(int y) const {
+  std::string ret;
+  char buf[8];
+  for(int x = 0; x < (int)screen.w();) {
+    const auto& c = screen.at(x, y);
+    int len = Utf8::unicode2char(buf, c.ch);
+    ret.append(buf, len);
+    x += std::max(c.width(), 1);
+  }
+  auto pos = ret.find_last_not_of(' ');
+  ret.erase(pos == std::string::npos ? 0 : pos + 1);
+  return ret;
+}
+
+void VtScreen::feed(const char* data, size_t len) {
+  for(size_t i = 0; i < len; ++i) {
+    char c = data[i];
+    switch(state) {
+    case St_Ground:
+      if(!utf8.empty() || (c & 0x80)) {
+        utf8 += c;
+        if(utf8.size() < Utf8::charLen(utf8[0])) break;
+        Chr ch;
+        Utf8::char2unicode(&ch, utf8.c_str());
+        utf8.clear();
+        putChar(ch);
+      } else if(c == '\033') {
+        state = St_Esc;
+      } else if(c == '\r') {
+        cu.x = 0;
+      } else if(c == '\n') {
+        if(cu.y + 1 < (int)screen.h()) ++cu.y;
+      } else if(c == '\b') {
+        if(cu.x > 0) --cu.x;
+      } else if((unsigned char)c >= ' ') {
+        putChar((Chr)c);
+      }
+      break;
+    case St_Esc:
+      params.clear();
+      if(c == '[') state = St_Csi;
+      else if(c == ']') state = St_Osc;
+      else if(c == '(' || c == ')') state = St_Charset;
+      else state = St_Ground;  // eg: keypad modes
+      break;
+    case St_Csi:
+      if(('0' <= c && c <= '9') || c == ';' || c == '?') {
+        params += c;
+      } else {
+        csi(c);
+        state = St_Ground;
+      }
+      break;
+    case St_Osc:
+      if(c == '\007') oscDone();
+      else if(c == '\033') state = St_OscEsc;
+      else params += c;
+      break;
+    case St_OscEsc:  // string terminator
+      oscDone();
+      break;
+    case St_Charset:
+      state = St_Ground;
+      break;
+    };
+  }
+}
+
+void VtScreen::oscDone() {
+  state = St_Ground;
+  // only the window title is of interest
+  if(params.compare(0, 2, "0;") == 0 || params.compare(0, 2, "2;") == 0)
+    titleStr = params.substr(2);
+}
+
+void VtScreen::putChar(Chr c) {
+  int w = (int)screen.w(), h = (int)screen.h();
+  if(w == 0 || h == 0) return;
+  if(cu.x >= w) {
+    cu.x = 0;
+    if(cu.y + 1 < h) ++cu.y;
+  }
+  Cell ce = {c, fg, bg};
+  int wid = std::max(ce.width(), 1);
+  screen.at(cu.x, cu.y).copy(ce);
+  // the remaining columns of a wide char are covered by it
+  for(int i = 1; i < wid && cu.x + i < w; ++i)
+    screen.at(cu.x + i, cu.y).set(' ', fg, bg);
+  cu.x += wid;
+}
+
+void VtScreen::csi(char final) {
+  bool priv = !params.empty() && params[0] == '?';
+  std::vector<int> args;
+  for(const auto& p : split(priv ? params.substr(1) : params, ';'))
+    args.push_back(p.empty() ? 0 : str2num(p));
+  auto arg = [&args](size_t i, int def) {
+    return i < args.size() && args[i] > 0 ? args[i] : def;
+  };
+  int w = (int)screen.w(), h = (int)screen.h();
+  if(priv) {
+    // only the cursor visibility is of interest among the private modes
+    for(auto a : args)
+      if(a == 25 && (final == 'h' || final == 'l')) showCursor = final == 'h';
+    return;
+  }
+  switch(final) {
+  case 'H':
+  case 'f':
+    cu.y = arg(0, 1) - 1;
+    cu.x = arg(1, 1) - 1;
+    break;
+  case 'A': cu.y -= arg(0, 1); break;
+  case 'B': cu.y += arg(0, 1); break;
+  case 'C': cu.x += arg(0, 1); break;
+  case 'D': cu.x -= arg(0, 1); break;
+  case 'G': cu.x = arg(0, 1) - 1; break;
+  case 'd': cu.y = arg(0, 1) - 1; break;
+  case 'J':
+    if(arg(0, 0) == 0) {
+      erase(cu.x, cu.y, w, cu.y + 1);
+      erase(0, cu.y + 1, w, h);
+    } else if(arg(0, 0) == 1) {
+      erase(0, 0, w, cu.y);
+      erase(0, cu.y, cu.x + 1, cu.y + 1);
+    } else {
+      erase(0, 0, w, h);
+    }
+    break;
+  case 'K':
+    if(arg(0, 0) == 0) erase(cu.x, cu.y, w, cu.y + 1);
+    else if(arg(0, 0) == 1) erase(0, cu.y, cu.x + 1, cu.y + 1);
+    else erase(0, cu.y, w, cu.y + 1);
+    break;
+  case 'm':
+    if(args.empty()) args.push_back(0);
+    sgr(args);
+    break;
+  case 'r':
+    top = arg(0, 1) - 1;
+    bot = std::min(arg(1, h), h) - 1;
+    if(top >= bot) {
+      top = 0;
+      bot = h - 1;
+    }
+    cu.x = cu.y = 0;
+    break;
+  case 'S': scroll(arg(0, 1)); break;
+  case 'T': scroll(-arg(0, 1)); break;
+  default:
+    break;
+  };
+  clampCursor();
+}
+
+void VtScreen::sgr(const std::vector<int>& args) {
+  for(size_t i = 0; i < args.size(); ++i) {
+    int a = args[i];
+    if(a == 0) {
+      fg = AttrColor();
+      bg = AttrColor();
+    } else if(a == 1) {
+      fg.setBold();
+    } else if(a == 3) {
+      fg.setItalic();
+    } else if(a == 4) {
+      fg.setUnderline();
+    } else if(30 <= a && a <= 37) {
+      fg.set(color_t(a - 30), fg.ac & ~AttrColor::Mask);
+    } else if(40 <= a && a <= 47) {
+      bg.set(color_t(a - 40), bg.ac & ~AttrColor::Mask);
+    } else if((a == 38 || a == 48) && i + 2 < args.size() && args[i + 1] == 5) {
+      auto& col = a == 38 ? fg : bg;
+      col.set(color_t(args[i + 2]), col.ac & ~AttrColor::Mask);
+      i += 2;
+    } else if(a == 39) {
+      fg.set(0, fg.ac & ~AttrColor::Mask);
+    } else if(a == 49) {
+      bg.set(0, bg.ac & ~AttrColor::Mask);
+    }
+  }
+}
+
+void VtScreen::erase(int x0, int y0, int x1, int y1) {
+  x1 = std::min(x1, (int)screen.w());
+  y1 = std::min(y1, (int)screen.h());
+  for(int y = std::max(y0, 0); y < y1; ++y)
+    for(int x = std::max(x0, 0); x < x1; ++x)
+      screen.at(x, y).set(' ', fg, bg);
+}
+
+void VtScreen::scroll(int n) {
+  int m = std::min(n > 0 ? n : -n, bot - top + 1);
+  if(m == bot - top + 1) {
+    erase(0, top, (int)screen.w(), bot + 1);
+    return;
+  }
+  screen.scroll(top, bot, n > 0 ? m : -m);
+  if(n > 0) erase(0, bot - m + 1, (int)screen.w(), bot + 1);
+  else erase(0, top, (int)screen.w(), top + m);
+}
+
+void VtScreen::clampCursor() {
+  cu.x = std::max(0, std::min(cu.x, (int)screen.w() - 1));
+  cu.y = std::max(0, std::min(cu.y, (int)screen.h() - 1));
+}
+
+}; // end namespace teditor
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "cell_buffer.h"
+#include "pos2d.h"
+#include <string>
+#include <vector>
+
+
+namespace teditor {
+
+/**
+ * @brief A virtual screen which interprets the escape sequences written out to
+ * the terminal, the way an xterm would. Only the sequences emitted by the
+ * editor (and the terminfo capabilities it uses) are understood, rest of them
+ * are silently ignored. Decoding state is preserved across calls to `feed`, so
+ * the stream can be split at arbitrary places.
+ */
+class VtScreen {
+public:
+  VtScreen(int w, int h);
+
+  /** resizes and clears the screen */
+  void resize(int w, int h);
+  /** interprets the given stream of bytes */
+  void feed(const char* data, size_t len);
+  void feed(const std::string& data) { feed(data.c_str(), data.size()); }
+
+  const CellBuffer& cells() const { return screen; }
+  const Cell& at(int x, int y) const { return screen.at(x, y); }
+  /** contents of the given row as UTF-8, with trailing whitespace removed */
+  std::string row(int y) const;
+  const Pos2di& cursor() const { return cu; }
+  bool cursorVisible() const { return showCursor; }
+  const std::string& title() const { return titleStr; }
+
+private:
+  enum State {
+    St_Ground,
+    St_Esc,
+    St_Csi,
+    St_Osc,
+    St_OscEsc,
+    St_Charset,
+  };
+
+  CellBuffer screen;
+  Pos2di cu;
+  /** scroll region, as set by DECSTBM */
+  int top, bot;
+  AttrColor fg, bg;
+  bool showCursor;
+  std::string titleStr;
+  State state;
+  /** pending parameters of the current escape sequence */
+  std::string params;
+  /** pending bytes of an incomplete UTF-8 char */
+  std::string utf8;
+
+  void putChar(Chr c);
+  void oscDone();
+  void csi(char final);
+  void sgr(const std::vector<int>& args);
+  void erase(int x0, int y0, int x1, int y1);
+  void scroll(int n);
+  void clampCursor();
+};
+
+}; // end namespace teditor
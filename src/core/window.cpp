@@ -96,8 +96,8 @@ void Windows::draw(Editor& ed, bool cmdMsgBarActive) {
     DEBUG("draw: cmdMsgBar.drawPoint\n");
     int i = 0;
     for(auto itr : wins) {
-      const auto& bg = itr->getBuff().getColor("cursorbg");
-      const auto& ibg = itr->getBuff().getColor("inactivecursorbg");
+      const auto& bg = itr->getBuff().getColor(Slot_cursorbg);
+      const auto& ibg = itr->getBuff().getColor(Slot_inactivecursorbg);
       itr->drawPoint(ed, i == 0? bg : ibg);
       ++i;
     }
@@ -107,8 +107,8 @@ void Windows::draw(Editor& ed, bool cmdMsgBarActive) {
     for(auto itr : wins) {
       DEBUG("draw: currWin=%d i=%d\n", currWin, i);
       if(i != 0) {
-        const auto& bg = itr->getBuff().getColor("cursorbg");
-        const auto& ibg = itr->getBuff().getColor("inactivecursorbg");
+        const auto& bg = itr->getBuff().getColor(Slot_cursorbg);
+        const auto& ibg = itr->getBuff().getColor(Slot_inactivecursorbg);
         itr->drawPoint(ed, i == currWin? bg : ibg);
       }
       ++i;
@@ -117,8 +117,8 @@ void Windows::draw(Editor& ed, bool cmdMsgBarActive) {
   DEBUG("draw: drawing borders\n");
   // Note: This should still work with multiple windows, since these colors
   // are supposed to be universally defined for all modes
-  const auto& fg = getWindow().getBuff().getColor("winframefg");
-  const auto& bg = getWindow().getBuff().getColor("winframebg");
+  const auto& fg = getWindow().getBuff().getColor(Slot_winframefg);
+  const auto& bg = getWindow().getBuff().getColor(Slot_winframebg);
   for(auto& b : borders) {
     for(int i=b.sy;i<b.ey;++i)
       ed.sendChar(b.x, i, bg, fg, Option::get("windowSplitter").getChar());
@@ -86,6 +86,39 @@ namespace ops {
  * @note Available since v1.0.0
  *
  *
+ * @section sort-lines sort-lines
+ * Sorts the lines in the currently active region in ascending lexicographic
+ * order. The region covers all the lines between the start of the region and
+ * the cursor, both inclusive. This operation can be undo'd.
+ *
+ * @note Available since v1.9.0
+ *
+ *
+ * @section sort-lines-numeric sort-lines-numeric
+ * Same as @ref sort-lines, but compares the numbers found at the beginning of
+ * each line. Lines not starting with a number are treated as zero.
+ *
+ * @note Available since v1.9.0
+ *
+ *
+ * @section sort-lines-reverse sort-lines-reverse
+ * Same as @ref sort-lines, but sorts in the descending order.
+ *
+ * @note Available since v1.9.0
+ *
+ *
+ * @section sort-lines-unique sort-lines-unique
+ * Same as @ref sort-lines, but only keeps the first of the identical lines.
+ *
+ * @note Available since v1.9.0
+ *
+ *
+ * @section sort-lines-icase sort-lines-icase
+ * Same as @ref sort-lines, but ignores the case while comparing lines.
+ *
+ * @note Available since v1.9.0
+ *
+ *
  * @section shell-to-buffer shell-to-buffer
  * Prompts the user for a command, executes it inside a shel and inserts the
  * contents from its `stdout` at the current cursor location.
@@ -218,6 +251,14 @@ namespace ops {
  *        Buffer! It will also erase the undo-redo stack too.
  *
  * @note Available since v1.0.0
+ *
+ *
+ * @section buffer-memory buffer-memory
+ * Shows the memory footprint of the contents of the current Buffer. This
+ * includes the line objects themselves, as well as the slabs used for storing
+ * the longer lines.
+ *
+ * @note Available since v1.9.0
  */
 
 DEF_CMD(CommandUndo, "command-undo", "buffer_ops", DEF_OP() {
@@ -235,6 +276,12 @@ DEF_CMD(InsertChar, ".insert-char", "buffer_ops", DEF_OP() {
     buf.insert(c);
   });
 
+DEF_CMD(InsertText, ".insert-text", "buffer_ops", DEF_OP() {
+    auto& buf = ed.getBuff();
+    if(buf.isRegionActive()) ed.runCmd(".backspace-char");
+    buf.insert(ed.getText());
+  });
+
 DEF_CMD(BackspaceChar, ".backspace-char", "buffer_ops",
         DEF_OP() { ed.getBuff().remove(); });
 
@@ -247,34 +294,31 @@ DEF_CMD(KillLine, "kill-line", "buffer_ops", DEF_OP() {
     CMBAR_MSG(ed, "Line killed\n");
   });
 
-// CMD_UNDO4(SortLines, "sort-lines", Positions after, Positions regs,
-//           Strings del, Positions before) {
-//     if(type == CMD_FRESH && !buf.isRegionActive()) {
-//         canIundo = false;
-//         return;
-//     }
-//     auto& buf = ed.getBuff();
-//     switch(type) {
-//     case CMD_UNDO:
-//         buf.removeRegion(regs, after);
-//         buf.restoreCursors(regs);
-//         buf.insert(del);
-//         break;
-//     case CMD_REDO:
-//         buf.restoreCursors(regs);
-//         buf.startRegion();
-//         buf.restoreCursors(before);
-//         buf.sortRegions();
-//         break;
-//     default:
-//         regs = buf.getRegionLocs();
-//         del = buf.regionAsStr();
-//         before = buf.saveCursors();
-//         buf.sortRegions();
-//         after = buf.saveCursors();
-//     };
-//     buf.stopRegion();
-// }
+void sortLines(Editor& ed, int flags) {
+  auto& buf = ed.getBuff();
+  if(!buf.isRegionActive()) {
+    CMBAR_MSG(ed, "No region to sort!\n");
+    return;
+  }
+  buf.sortRegion(flags);
+  buf.stopRegion();
+  CMBAR_MSG(ed, "Sort done\n");
+}
+
+DEF_CMD(SortLines, "sort-lines", "buffer_ops",
+        DEF_OP() { sortLines(ed, Sort_Default); });
+
+DEF_CMD(SortLinesNumeric, "sort-lines-numeric", "buffer_ops",
+        DEF_OP() { sortLines(ed, Sort_Numeric); });
+
+DEF_CMD(SortLinesReverse, "sort-lines-reverse", "buffer_ops",
+        DEF_OP() { sortLines(ed, Sort_Reverse); });
+
+DEF_CMD(SortLinesUnique, "sort-lines-unique", "buffer_ops",
+        DEF_OP() { sortLines(ed, Sort_Unique); });
+
+DEF_CMD(SortLinesICase, "sort-lines-icase", "buffer_ops",
+        DEF_OP() { sortLines(ed, Sort_ICase); });
 
 void keepRemoveLines(Editor& ed, bool keep) {
   auto& buf = ed.getBuff();
@@ -403,6 +447,13 @@ DEF_CMD(Reload, "reload-buffer", "buffer_ops", DEF_OP() {
       buf.reload();
   });
 
+DEF_CMD(BufferMemory, "buffer-memory", "buffer_ops", DEF_OP() {
+    auto ms = ed.getBuff().memStats();
+    CMBAR_MSG(ed, "Lines: %zu (%zu B), Slabs: %zu (%zu B, %zu B used), "
+              "Large: %zu B\n", ms.numLines, ms.lineBytes, ms.arena.numSlabs,
+              ms.arena.slabBytes, ms.arena.usedBytes, ms.arena.largeBytes);
+  });
+
 } // end namespace ops
 } // end namespace buffer
 } // end namespace teditor
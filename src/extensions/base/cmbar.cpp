@@ -12,21 +12,19 @@ class CmBarMode: public Mode {
 public:
   CmBarMode():
     Mode("cmbar",
-         "abcdefghijklmnopqrstuvwxyzABCDEGGHIJKLMNOPQRSTUVWXYZ0123456789_-"),
-    kcMap(), cMap() {
-    populateKeyMap<CmBarMode::Keys>(kcMap);
-    kcMap.resetTraversal();
-    populateColorMap<CmBarMode::Colors>(cMap);
+         "abcdefghijklmnopqrstuvwxyzABCDEGGHIJKLMNOPQRSTUVWXYZ0123456789_-") {
+    if(!buildingTables()) return;
+    populateKeyMap<CmBarMode::Keys>(getKeyCmdMap());
+    populateColorMap<CmBarMode::Colors>(getColorMap());
   }
 
   int indent(Buffer& buf, int line) { return 0; }
 
-  KeyCmdMap& getKeyCmdMap() { return kcMap; }
-  ColorMap& getColorMap() { return cMap; }
   void getColorFor(AttrColor& fg, AttrColor& bg, int lineNum, int pos,
                    const Buffer& b, bool isHighlighted) {
-    fg = cMap.get(isHighlighted ? "highlightfg" : "defaultfg");
-    bg = cMap.get(isHighlighted ? "highlightbg" : "defaultbg");
+    const auto& cMap = getColorMap();
+    fg = cMap.get(isHighlighted ? Slot_highlightfg : Slot_defaultfg);
+    bg = cMap.get(isHighlighted ? Slot_highlightbg : Slot_defaultbg);
   }
 
   static Mode* create() { return new CmBarMode; }
@@ -34,9 +32,6 @@ public:
   static bool modeCheck(const std::string& file) { return false; }
 
 private:
-  KeyCmdMap kcMap;
-  ColorMap cMap;
-
   struct Keys { static std::vector<KeyCmdPair> All; };
   struct Colors { static std::vector<NameColorPair> All; };
 };
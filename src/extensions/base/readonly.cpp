@@ -11,16 +11,17 @@ bool ReadOnlyMode::modeCheck(const std::string& file) {
 }
 
 ReadOnlyMode::ReadOnlyMode(const std::string& n, const std::string& w):
-  Mode(n, w), kcMap(), cMap() {
+  Mode(n, w) {
+  if(!buildingTables()) return;
   populateKeyMap<ReadOnlyMode::Keys>(getKeyCmdMap());
-  getKeyCmdMap().resetTraversal();
   populateColorMap<ReadOnlyMode::Colors>(getColorMap());
 }
 
 void ReadOnlyMode::getColorFor(AttrColor& fg, AttrColor& bg, int lineNum,
                                int pos, const Buffer& b, bool isHighlighted) {
-  fg = cMap.get(isHighlighted ? "highlightfg" : "defaultfg");
-  bg = cMap.get(isHighlighted ? "highlightbg" : "defaultbg");
+  const auto& cMap = getColorMap();
+  fg = cMap.get(isHighlighted ? Slot_highlightfg : Slot_defaultfg);
+  bg = cMap.get(isHighlighted ? Slot_highlightbg : Slot_defaultbg);
 }
 
 REGISTER_MODE(ReadOnlyMode, "ro");
@@ -14,8 +14,6 @@ public:
                const std::string& w="abcdefghijklmnopqrstuvwxyzABCDEGGHIJKLMNO"
                                     "PQRSTUVWXYZ0123456789_");
   int indent(Buffer& buf, int line) { return 0; }
-  KeyCmdMap& getKeyCmdMap() { return kcMap; }
-  ColorMap& getColorMap() { return cMap; }
   void getColorFor(AttrColor& fg, AttrColor& bg, int lineNum, int pos,
                    const Buffer& b, bool isHighlighted);
 
@@ -24,9 +22,6 @@ public:
   static bool modeCheck(const std::string& file);
 
 private:
-  KeyCmdMap kcMap;
-  ColorMap cMap;
-
   struct Keys { static std::vector<KeyCmdPair> All; };
   struct Colors { static std::vector<NameColorPair> All; };
 };
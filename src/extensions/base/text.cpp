@@ -9,8 +9,10 @@ REGISTER_MODE(TextMode, "text");
 
 TextMode::TextMode(const std::string& n, const std::string& w):
   readonly::ReadOnlyMode(n, w) {
-  populateKeyMap<TextMode::Keys>(getKeyCmdMap());
-  populateColorMap<TextMode::Colors>(getColorMap());
+  if(buildingTables()) {
+    populateKeyMap<TextMode::Keys>(getKeyCmdMap());
+    populateColorMap<TextMode::Colors>(getColorMap());
+  }
 }
 
 int TextMode::indent(Buffer& buf, int line) {
@@ -0,0 +1,656 @@
+#include "bignum.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <stdlib.h>
+
+namespace teditor {
+namespace calc {
+
+typedef BigInt::Limbs Limbs;
+
+/** max number of bits allowed in the result of an exponentiation */
+static const int64_t MaxPowBits = 1 << 22;
+
+namespace {
+
+void trimMag(Limbs& a) {
+  while (!a.empty() && a.back() == 0) a.pop_back();
+}
+
+int cmpMag(const Limbs& a, const Limbs& b) {
+  if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+  for (int i = (int)a.size() - 1; i >= 0; --i)
+    if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+  return 0;
+}
+
+Limbs addMag(const uint32_t* a, int na, const uint32_t* b, int nb) {
+  if (na < nb) {
+    std::swap(a, b);
+    std::swap(na, nb);
+  }
+  Limbs r(na + 1);
+  uint64_t carry = 0;
+  for (int i = 0; i < na; ++i) {
+    uint64_t s = uint64_t(a[i]) + (i < nb ? b[i] : 0) + carry;
+    r[i] = uint32_t(s);
+    carry = s >> 32;
+  }
+  r[na] = uint32_t(carry);
+  trimMag(r);
+  return r;
+}
+
+/** a -= b, where a >= b */
+void subMag(Limbs& a, const uint32_t* b, int nb) {
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if ((int)i >= nb && borrow == 0) break;
+    uint64_t d = uint64_t(a[i]) - ((int)i < nb ? b[i] : 0) - borrow;
+    a[i] = uint32_t(d);
+    borrow = d >> 63;
+  }
+  trimMag(a);
+}
+
+/** r += x << (32 * shift) */
+void addShifted(Limbs& r, const Limbs& x, int shift) {
+  if (r.size() < x.size() + shift + 1) r.resize(x.size() + shift + 1, 0);
+  uint64_t carry = 0;
+  size_t i = 0;
+  for (; i < x.size(); ++i) {
+    uint64_t s = uint64_t(r[i + shift]) + x[i] + carry;
+    r[i + shift] = uint32_t(s);
+    carry = s >> 32;
+  }
+  for (i += shift; carry != 0 && i < r.size(); ++i) {
+    uint64_t s = uint64_t(r[i]) + carry;
+    r[i] = uint32_t(s);
+    carry = s >> 32;
+  }
+}
+
+Limbs schoolbook(const uint32_t* a, int na, const uint32_t* b, int nb) {
+  Limbs r(na + nb, 0);
+  for (int i = 0; i < na; ++i) {
+    uint64_t ai = a[i], carry = 0;
+    if (ai == 0) continue;
+    for (int j = 0; j < nb; ++j) {
+      uint64_t t = ai * b[j] + r[i + j] + carry;
+      r[i + j] = uint32_t(t);
+      carry = t >> 32;
+    }
+    r[i + nb] = uint32_t(carry);
+  }
+  trimMag(r);
+  return r;
+}
+
+Limbs mulMag(const uint32_t* a, int na, const uint32_t* b, int nb) {
+  while (na > 0 && a[na - 1] == 0) --na;
+  while (nb > 0 && b[nb - 1] == 0) --nb;
+  if (na == 0 || nb == 0) return Limbs();
+  if (na < nb) {
+    std::swap(a, b);
+    std::swap(na, nb);
+  }
+  if (nb < BigInt::KaratsubaThreshold) return schoolbook(a, na, b, nb);
+  int m = na / 2;
+  // too unbalanced to split 'b' too, so only split 'a'
+  if (nb <= m) {
+    auto r = mulMag(a, m, b, nb);
+    addShifted(r, mulMag(a + m, na - m, b, nb), m);
+    trimMag(r);
+    return r;
+  }
+  // (a1.B + a0)(b1.B + b0) = z2.B^2 + z1.B + z0
+  // where, z1 = (a1 + a0)(b1 + b0) - z2 - z0
+  auto z0 = mulMag(a, m, b, m);
+  auto z2 = mulMag(a + m, na - m, b + m, nb - m);
+  auto sa = addMag(a, m, a + m, na - m);
+  auto sb = addMag(b, m, b + m, nb - m);
+  auto z1 = mulMag(sa.data(), (int)sa.size(), sb.data(), (int)sb.size());
+  subMag(z1, z0.data(), (int)z0.size());
+  subMag(z1, z2.data(), (int)z2.size());
+  Limbs r(z0);
+  addShifted(r, z1, m);
+  addShifted(r, z2, 2 * m);
+  trimMag(r);
+  return r;
+}
+
+/** u = q.v + r. Knuth's algorithm D (TAOCP vol 2, 4.3.1) */
+void divmodMag(const Limbs& u, const Limbs& v, Limbs& q, Limbs& r) {
+  if (cmpMag(u, v) < 0) {
+    q.clear();
+    r = u;
+    return;
+  }
+  int n = (int)v.size(), m = (int)u.size();
+  if (n == 1) {
+    uint64_t rem = 0, d = v[0];
+    q.assign(m, 0);
+    for (int i = m - 1; i >= 0; --i) {
+      uint64_t cur = (rem << 32) | u[i];
+      q[i] = uint32_t(cur / d);
+      rem = cur % d;
+    }
+    trimMag(q);
+    r.clear();
+    if (rem != 0) r.push_back(uint32_t(rem));
+    return;
+  }
+  // normalize so that the top bit of the divisor is set
+  int s = __builtin_clz(v[n - 1]);
+  Limbs vn(n), un(m + 1);
+  for (int i = n - 1; i > 0; --i)
+    vn[i] = (v[i] << s) | (s ? uint32_t(uint64_t(v[i - 1]) >> (32 - s)) : 0);
+  vn[0] = v[0] << s;
+  un[m] = s ? uint32_t(uint64_t(u[m - 1]) >> (32 - s)) : 0;
+  for (int i = m - 1; i > 0; --i)
+    un[i] = (u[i] << s) | (s ? uint32_t(uint64_t(u[i - 1]) >> (32 - s)) : 0);
+  un[0] = u[0] << s;
+  const uint64_t B = 1ULL << 32;
+  q.assign(m - n + 1, 0);
+  for (int j = m - n; j >= 0; --j) {
+    uint64_t num = (uint64_t(un[j + n]) << 32) | un[j + n - 1];
+    uint64_t qhat = num / vn[n - 1], rhat = num % vn[n - 1];
+    while (qhat >= B || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+      --qhat;
+      rhat += vn[n - 1];
+      if (rhat >= B) break;
+    }
+    // multiply and subtract
+    int64_t k = 0, t;
+    for (int i = 0; i < n; ++i) {
+      uint64_t p = qhat * vn[i];
+      t = int64_t(un[i + j]) - k - int64_t(p & 0xFFFFFFFFULL);
+      un[i + j] = uint32_t(t);
+      k = int64_t(p >> 32) - (t >> 32);
+    }
+    t = int64_t(un[j + n]) - k;
+    un[j + n] = uint32_t(t);
+    q[j] = uint32_t(qhat);
+    // subtracted too much, add back
+    if (t < 0) {
+      --q[j];
+      uint64_t c = 0;
+      for (int i = 0; i < n; ++i) {
+        uint64_t sum = uint64_t(un[i + j]) + vn[i] + c;
+        un[i + j] = uint32_t(sum);
+        c = sum >> 32;
+      }
+      un[j + n] = uint32_t(uint64_t(un[j + n]) + c);
+    }
+  }
+  r.assign(n, 0);
+  for (int i = 0; i < n; ++i)
+    r[i] = (un[i] >> s) | (s ? uint32_t(uint64_t(un[i + 1]) << (32 - s)) : 0);
+  trimMag(q);
+  trimMag(r);
+}
+
+/** a = a * mul + add */
+void mulAddSmall(Limbs& a, uint32_t mul, uint32_t add) {
+  uint64_t carry = add;
+  for (auto& l : a) {
+    uint64_t t = uint64_t(l) * mul + carry;
+    l = uint32_t(t);
+    carry = t >> 32;
+  }
+  if (carry != 0) a.push_back(uint32_t(carry));
+}
+
+/** a /= d and returns the remainder */
+uint32_t divSmall(Limbs& a, uint32_t d) {
+  uint64_t rem = 0;
+  for (int i = (int)a.size() - 1; i >= 0; --i) {
+    uint64_t cur = (rem << 32) | a[i];
+    a[i] = uint32_t(cur / d);
+    rem = cur % d;
+  }
+  trimMag(a);
+  return uint32_t(rem);
+}
+
+}  // anonymous namespace
+
+
+const int BigInt::KaratsubaThreshold;
+
+BigInt::BigInt(int64_t v): neg(v < 0), limbs() {
+  uint64_t mag = neg ? 0 - uint64_t(v) : uint64_t(v);
+  limbs.push_back(uint32_t(mag));
+  limbs.push_back(uint32_t(mag >> 32));
+  trim();
+}
+
+BigInt::BigInt(const std::string& str): neg(false), limbs() {
+  size_t pos = 0;
+  if (!str.empty() && (str[0] == '-' || str[0] == '+')) {
+    neg = str[0] == '-';
+    ++pos;
+  }
+  ASSERT(pos < str.size(), "Incorrect number passed '%s'!", str.c_str());
+  for (; pos < str.size(); ) {
+    uint32_t chunk = 0, mul = 1;
+    for (int i = 0; i < 9 && pos < str.size(); ++i, ++pos) {
+      char c = str[pos];
+      ASSERT('0' <= c && c <= '9', "Incorrect number passed '%s'!",
+             str.c_str());
+      chunk = chunk * 10 + uint32_t(c - '0');
+      mul *= 10;
+    }
+    mulAddSmall(limbs, mul, chunk);
+  }
+  trim();
+}
+
+void BigInt::trim() {
+  trimMag(limbs);
+  if (limbs.empty()) neg = false;
+}
+
+bool BigInt::fitsInt64() const {
+  if (size() > 2) return false;
+  uint64_t mag = 0;
+  for (int i = size() - 1; i >= 0; --i) mag = (mag << 32) | limbs[i];
+  return neg ? mag <= (1ULL << 63) : mag < (1ULL << 63);
+}
+
+int64_t BigInt::toInt64() const {
+  uint64_t mag = 0;
+  for (int i = size() - 1; i >= 0; --i) mag = (mag << 32) | limbs[i];
+  return neg ? int64_t(0 - mag) : int64_t(mag);
+}
+
+double BigInt::toDouble() const {
+  double d = 0.0;
+  for (int i = size() - 1; i >= 0; --i) d = d * 4294967296.0 + limbs[i];
+  return neg ? -d : d;
+}
+
+int64_t BigInt::numBits() const {
+  if (isZero()) return 0;
+  return int64_t(size() - 1) * 32 + 32 - __builtin_clz(limbs.back());
+}
+
+std::string BigInt::toString() const {
+  if (isZero()) return "0";
+  std::vector<uint32_t> chunks;
+  Limbs tmp(limbs);
+  while (!tmp.empty()) chunks.push_back(divSmall(tmp, 1000000000U));
+  std::string ret(neg ? "-" : "");
+  ret += std::to_string(chunks.back());
+  for (int i = (int)chunks.size() - 2; i >= 0; --i)
+    ret += format("%09u", chunks[i]);
+  return ret;
+}
+
+int BigInt::compare(const BigInt& b) const {
+  if (neg != b.neg) return neg ? -1 : 1;
+  int c = cmpMag(limbs, b.limbs);
+  return neg ? -c : c;
+}
+
+BigInt BigInt::operator-() const {
+  BigInt ret(*this);
+  if (!ret.isZero()) ret.neg = !ret.neg;
+  return ret;
+}
+
+void BigInt::addSigned(const BigInt& b, bool bNeg) {
+  if (neg == bNeg) {
+    limbs = addMag(limbs.data(), size(), b.limbs.data(), b.size());
+  } else if (cmpMag(limbs, b.limbs) >= 0) {
+    subMag(limbs, b.limbs.data(), b.size());
+  } else {
+    Limbs tmp(b.limbs);
+    subMag(tmp, limbs.data(), size());
+    limbs.swap(tmp);
+    neg = bNeg;
+  }
+  trim();
+}
+
+const BigInt& BigInt::operator+=(const BigInt& b) {
+  addSigned(b, b.neg);
+  return *this;
+}
+
+const BigInt& BigInt::operator-=(const BigInt& b) {
+  addSigned(b, !b.neg && !b.isZero());
+  return *this;
+}
+
+const BigInt& BigInt::operator*=(const BigInt& b) {
+  limbs = mulMag(limbs.data(), size(), b.limbs.data(), b.size());
+  neg = neg != b.neg;
+  trim();
+  return *this;
+}
+
+BigInt BigInt::mulSchoolbook(const BigInt& a, const BigInt& b) {
+  BigInt ret;
+  if (a.isZero() || b.isZero()) return ret;
+  ret.limbs = schoolbook(a.limbs.data(), a.size(), b.limbs.data(), b.size());
+  ret.neg = a.neg != b.neg;
+  ret.trim();
+  return ret;
+}
+
+void BigInt::divmod(const BigInt& a, const BigInt& b, BigInt& q, BigInt& r) {
+  ASSERT(!b.isZero(), "calc: integer division by zero!");
+  BigInt tq, tr;
+  divmodMag(a.limbs, b.limbs, tq.limbs, tr.limbs);
+  tq.neg = a.neg != b.neg;
+  tr.neg = a.neg;
+  tq.trim();
+  tr.trim();
+  q = std::move(tq);
+  r = std::move(tr);
+}
+
+BigInt BigInt::pow(uint64_t e) const {
+  ASSERT(numBits() * double(e) <= MaxPowBits, "calc: result is too large!");
+  BigInt ret(int64_t(1)), base(*this);
+  while (e > 0) {
+    if (e & 1) ret *= base;
+    e >>= 1;
+    if (e > 0) base *= base;
+  }
+  return ret;
+}
+
+const BigInt& BigInt::pow10(int e) {
+  // deque, so that the references returned earlier remain valid
+  static std::deque<BigInt> cache(1, BigInt(int64_t(1)));
+  ASSERT(e >= 0, "BigInt::pow10: negative exponent %d!", e);
+  while ((int)cache.size() <= e) {
+    BigInt next(cache.back());
+    mulAddSmall(next.limbs, 10, 0);
+    cache.push_back(std::move(next));
+  }
+  return cache[e];
+}
+
+BigInt operator+(const BigInt& a, const BigInt& b) {
+  BigInt ret(a);
+  ret += b;
+  return ret;
+}
+
+BigInt operator-(const BigInt& a, const BigInt& b) {
+  BigInt ret(a);
+  ret -= b;
+  return ret;
+}
+
+BigInt operator*(const BigInt& a, const BigInt& b) {
+  BigInt ret(a);
+  ret *= b;
+  return ret;
+}
+
+BigInt operator/(const BigInt& a, const BigInt& b) {
+  BigInt q, r;
+  BigInt::divmod(a, b, q, r);
+  return q;
+}
+
+BigInt operator%(const BigInt& a, const BigInt& b) {
+  BigInt q, r;
+  BigInt::divmod(a, b, q, r);
+  return r;
+}
+
+
+const int BigNum::Scale;
+
+/** a / b, rounded half away from zero */
+static BigInt divRound(const BigInt& a, const BigInt& b) {
+  BigInt q, r;
+  BigInt::divmod(a, b, q, r);
+  if (r.isZero()) return q;
+  auto twice = r + r;
+  if ((twice.isNeg() ? -twice : twice).compare(b.isNeg() ? -b : b) >= 0)
+    q += BigInt(int64_t(a.isNeg() != b.isNeg() ? -1 : 1));
+  return q;
+}
+
+/** digits * 10^exp in fixed-point */
+static BigInt toFixed(const BigInt& digits, int exp) {
+  exp += BigNum::Scale;
+  if (exp >= 0) return digits * BigInt::pow10(exp);
+  return divRound(digits, BigInt::pow10(-exp));
+}
+
+static BigNum makeDecimal(const BigInt& m) {
+  BigNum ret(m);
+  ret.type = BigNum::Decimal;
+  return ret;
+}
+
+BigNum::BigNum(const Num64& n): type(n.isInt ? Int : Float), m(), f(0.0) {
+  if (n.isInt) m = BigInt(n.i);
+  else f = n.f;
+}
+
+BigNum::BigNum(const std::string& str, bool decimal): type(Int), m(), f(0.0) {
+  auto ePos = str.find_first_of("eE");
+  auto mant = str.substr(0, ePos);
+  auto dot = mant.find('.');
+  if (ePos == std::string::npos && dot == std::string::npos) {
+    m = BigInt(str);
+    return;
+  }
+  if (!decimal) {
+    type = Float;
+    f = Num64(str).f;
+    return;
+  }
+  int exp = 0;
+  if (ePos != std::string::npos) {
+    auto e = BigInt(str.substr(ePos + 1));
+    ASSERT(e.fitsInt64() && std::abs(e.toInt64()) < 100000,
+           "Incorrect number passed '%s'!", str.c_str());
+    exp = int(e.toInt64());
+  }
+  if (dot != std::string::npos) {
+    exp -= int(mant.size() - dot - 1);
+    mant.erase(dot, 1);
+    // eg: '.5' or '-.5'
+    if (mant.empty() || mant == "-" || mant == "+") mant += "0";
+  }
+  type = Decimal;
+  m = toFixed(BigInt(mant), exp);
+}
+
+Num64 BigNum::toNum64() const {
+  if (type == Int && m.fitsInt64()) return Num64(m.toInt64());
+  return Num64(toDouble());
+}
+
+double BigNum::toDouble() const {
+  if (type == Float) return f;
+  if (type == Int) return m.toDouble();
+  return strtod(toString().c_str(), nullptr);
+}
+
+std::string BigNum::toString() const {
+  if (type == Int) return m.toString();
+  if (type == Float) return format("%.12g", f);
+  auto digits = (m.isNeg() ? -m : m).toString();
+  if ((int)digits.size() <= Scale)
+    digits = std::string(Scale + 1 - digits.size(), '0') + digits;
+  auto intPart = digits.substr(0, digits.size() - Scale);
+  auto frac = digits.substr(digits.size() - Scale);
+  auto last = frac.find_last_not_of('0');
+  std::string ret(m.isNeg() ? "-" : "");
+  ret += intPart;
+  if (last != std::string::npos) ret += "." + frac.substr(0, last + 1);
+  return ret;
+}
+
+BigNum BigNum::toInt() const {
+  if (type == Int) return *this;
+  if (type == Float) {
+    ASSERT(std::isfinite(f), "calc: cannot convert '%g' to int!", f);
+    return BigNum(BigNum(format("%.0f", std::trunc(f))).m);
+  }
+  return BigNum(m / BigInt::pow10(Scale));
+}
+
+BigNum BigNum::toFloat() const {
+  if (type == Float) return *this;
+  return BigNum(toDouble());
+}
+
+BigNum BigNum::toDecimal() const {
+  if (type == Decimal) return *this;
+  if (type == Int) return makeDecimal(m * BigInt::pow10(Scale));
+  ASSERT(std::isfinite(f), "calc: cannot convert '%g' to decimal!", f);
+  return BigNum(format("%.17g", f), true).toDecimal();
+}
+
+int BigNum::compare(const BigNum& b) const {
+  if (type == Float || b.type == Float) {
+    double x = toDouble(), y = b.toDouble();
+    return x < y ? -1 : x > y ? 1 : 0;
+  }
+  if (type == b.type) return m.compare(b.m);
+  return toDecimal().m.compare(b.toDecimal().m);
+}
+
+BigNum& BigNum::operator-() {
+  if (type == Float) f = -f;
+  else m = -m;
+  return *this;
+}
+
+// brings both the operands to the same type before operating on them
+#define BIG_OP(b, intOp, decOp, fltOp) do {         \
+    if (type == Float || b.type == Float) {         \
+      f = toDouble() fltOp b.toDouble();            \
+      type = Float;                                 \
+      m = BigInt();                                 \
+    } else if (type == Int && b.type == Int) {      \
+      intOp;                                        \
+    } else {                                        \
+      const auto& bd = b.type == Decimal ? b : b.toDecimal();   \
+      if (type == Int) *this = toDecimal();         \
+      decOp;                                        \
+    }                                               \
+  } while (0);                                      \
+  return *this
+
+const BigNum& BigNum::operator+=(const BigNum& b) {
+  BIG_OP(b, m += b.m, m += bd.m, +);
+}
+
+const BigNum& BigNum::operator-=(const BigNum& b) {
+  BIG_OP(b, m -= b.m, m -= bd.m, -);
+}
+
+const BigNum& BigNum::operator*=(const BigNum& b) {
+  BIG_OP(b, m *= b.m, m = divRound(m * bd.m, BigInt::pow10(Scale)), *);
+}
+
+const BigNum& BigNum::operator/=(const BigNum& b) {
+  BIG_OP(b, m = m / b.m,
+         ASSERT(!bd.m.isZero(), "calc: division by zero!");
+         m = divRound(m * BigInt::pow10(Scale), bd.m), /);
+}
+
+#undef BIG_OP
+
+BigNum operator+(const BigNum& a, const BigNum& b) {
+  BigNum ret(a);
+  ret += b;
+  return ret;
+}
+
+BigNum operator-(const BigNum& a, const BigNum& b) {
+  BigNum ret(a);
+  ret -= b;
+  return ret;
+}
+
+BigNum operator*(const BigNum& a, const BigNum& b) {
+  BigNum ret(a);
+  ret *= b;
+  return ret;
+}
+
+BigNum operator/(const BigNum& a, const BigNum& b) {
+  BigNum ret(a);
+  ret /= b;
+  return ret;
+}
+
+BigNum pow(const BigNum& a, const BigNum& b) {
+  if (a.type == BigNum::Float || b.type != BigNum::Int)
+    return BigNum(std::pow(a.toDouble(), b.toDouble()));
+  bool negExp = b.m.isNeg();
+  auto e = negExp ? -b.m : b.m;
+  ASSERT(e.fitsInt64(), "calc: result is too large!");
+  auto ue = uint64_t(e.toInt64());
+  BigNum ret;
+  if (a.type == BigNum::Int) {
+    ret = BigNum(a.m.pow(ue));
+  } else {
+    // keep rounding at every step, as the scale is fixed
+    ret = BigNum(int64_t(1)).toDecimal();
+    BigNum base(a);
+    while (ue > 0) {
+      if (ue & 1) ret *= base;
+      ue >>= 1;
+      if (ue > 0) base *= base;
+    }
+  }
+  if (!negExp) return ret;
+  return BigNum(int64_t(1)).toDecimal() / ret;
+}
+
+BigNum sq(const BigNum& a) { return a * a; }
+
+BigNum cube(const BigNum& a) { return a * a * a; }
+
+BigNum abs(const BigNum& a) {
+  BigNum ret(a);
+  if (a < BigNum(int64_t(0))) -ret;
+  return ret;
+}
+
+/** 'dir' is -1 for floor, 1 for ceil and 0 for round */
+static BigNum roundTo(const BigNum& a, int dir) {
+  if (a.type == BigNum::Int) return a;
+  if (a.type == BigNum::Float) {
+    return BigNum(dir < 0 ? std::floor(a.f) :
+                  dir > 0 ? std::ceil(a.f) : std::round(a.f));
+  }
+  const auto& unit = BigInt::pow10(BigNum::Scale);
+  BigInt q, r;
+  if (dir == 0) {
+    q = divRound(a.m, unit);
+  } else {
+    BigInt::divmod(a.m, unit, q, r);
+    if (dir < 0 && r.isNeg()) q -= BigInt(int64_t(1));
+    if (dir > 0 && !r.isNeg() && !r.isZero()) q += BigInt(int64_t(1));
+  }
+  return makeDecimal(q * unit);
+}
+
+BigNum floor(const BigNum& a) { return roundTo(a, -1); }
+
+BigNum ceil(const BigNum& a) { return roundTo(a, 1); }
+
+BigNum round(const BigNum& a) { return roundTo(a, 0); }
+
+BigNum toInt(const BigNum& a) { return a.toInt(); }
+
+BigNum toFloat(const BigNum& a) { return a.toFloat(); }
+
+}  // namespace calc
+}  // namespace teditor
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "number.h"
+
+namespace teditor {
+namespace calc {
+
+/**
+ * @brief Arbitrary precision signed integer. Magnitude is stored as 32b limbs
+ * in little-endian order, with no leading zero limbs (zero has no limbs).
+ */
+class BigInt {
+public:
+  BigInt(): neg(false), limbs() {}
+  BigInt(int64_t v);
+  /** parses a decimal integer with an optional sign */
+  BigInt(const std::string& str);
+
+  bool isZero() const { return limbs.empty(); }
+  bool isNeg() const { return neg; }
+  /** whether the value fits in an int64_t */
+  bool fitsInt64() const;
+  int64_t toInt64() const;
+  double toDouble() const;
+  std::string toString() const;
+  /** number of 32b limbs used */
+  int size() const { return (int)limbs.size(); }
+
+  /** -1, 0 or 1 depending on whether this is less, equal or greater than b */
+  int compare(const BigInt& b) const;
+
+  BigInt operator-() const;
+  const BigInt& operator+=(const BigInt& b);
+  const BigInt& operator-=(const BigInt& b);
+  const BigInt& operator*=(const BigInt& b);
+
+  /** truncating division, same as for C++ integers */
+  static void divmod(const BigInt& a, const BigInt& b, BigInt& q, BigInt& r);
+  /** this raised to the power of e */
+  BigInt pow(uint64_t e) const;
+  /** 10 raised to the power of e */
+  static const BigInt& pow10(int e);
+  /** number of significant bits in the magnitude */
+  int64_t numBits() const;
+
+  /** number of limbs above which Karatsuba is used for multiplication */
+  static const int KaratsubaThreshold = 32;
+
+  typedef std::vector<uint32_t> Limbs;
+
+  /** multiplication with schoolbook method only (mainly for testing) */
+  static BigInt mulSchoolbook(const BigInt& a, const BigInt& b);
+
+private:
+  bool neg;
+  Limbs limbs;
+
+  void trim();
+  void addSigned(const BigInt& b, bool bNeg);
+};  // class BigInt
+
+BigInt operator+(const BigInt& a, const BigInt& b);
+BigInt operator-(const BigInt& a, const BigInt& b);
+BigInt operator*(const BigInt& a, const BigInt& b);
+BigInt operator/(const BigInt& a, const BigInt& b);
+BigInt operator%(const BigInt& a, const BigInt& b);
+inline bool operator==(const BigInt& a, const BigInt& b) {
+  return a.compare(b) == 0;
+}
+inline bool operator!=(const BigInt& a, const BigInt& b) {
+  return a.compare(b) != 0;
+}
+inline bool operator<(const BigInt& a, const BigInt& b) {
+  return a.compare(b) < 0;
+}
+
+
+/**
+ * @brief Arbitrary precision counterpart of `Num64`, which the calculator
+ * switches to when the latter overflows (or when asked to work in decimals).
+ * Integers are stored exactly and floats are stored as doubles, just like in
+ * `Num64`. Decimals are stored in fixed-point with `Scale` digits after the
+ * decimal point, which means that sums of values like 0.01 don't suffer from
+ * the binary floating point rounding errors.
+ *
+ * Type of the result of an operation is the "widest" of its operands, with
+ * Int < Decimal < Float.
+ */
+struct BigNum {
+  enum Type {
+    Int = 0,
+    /** value is 'm / 10^Scale' */
+    Decimal,
+    Float,
+  };  // enum Type
+
+  Type type;
+  BigInt m;
+  double f;
+
+  /** number of decimal digits kept after the decimal point */
+  static const int Scale = 20;
+
+  BigNum(): type(Int), m(), f(0.0) {}
+  BigNum(const BigInt& i): type(Int), m(i), f(0.0) {}
+  BigNum(int64_t i): type(Int), m(i), f(0.0) {}
+  BigNum(double v): type(Float), m(), f(v) {}
+  BigNum(const Num64& n);
+  /**
+   * @brief parses the number. Integers are always parsed exactly and the rest
+   * (including the 'e' notation) are parsed as Decimal or Float depending on
+   * the 'decimal' flag.
+   */
+  BigNum(const std::string& str, bool decimal=false);
+
+  bool isInt() const { return type == Int; }
+  /** whether this can be represented by a `Num64` without any loss */
+  bool isSmall() const {
+    return type == Float || (type == Int && m.fitsInt64());
+  }
+  /** converts to a `Num64`, possibly with a loss of precision */
+  Num64 toNum64() const;
+  double toDouble() const;
+  std::string toString() const;
+
+  BigNum toInt() const;
+  BigNum toFloat() const;
+  /** converts Int and Float values to Decimal */
+  BigNum toDecimal() const;
+
+  int compare(const BigNum& b) const;
+
+  BigNum& operator-();
+  const BigNum& operator+=(const BigNum& b);
+  const BigNum& operator-=(const BigNum& b);
+  const BigNum& operator*=(const BigNum& b);
+  const BigNum& operator/=(const BigNum& b);
+};  // struct BigNum
+
+BigNum operator+(const BigNum& a, const BigNum& b);
+BigNum operator-(const BigNum& a, const BigNum& b);
+BigNum operator*(const BigNum& a, const BigNum& b);
+BigNum operator/(const BigNum& a, const BigNum& b);
+inline bool operator==(const BigNum& a, const BigNum& b) {
+  return a.compare(b) == 0;
+}
+inline bool operator!=(const BigNum& a, const BigNum& b) {
+  return a.compare(b) != 0;
+}
+inline bool operator<(const BigNum& a, const BigNum& b) {
+  return a.compare(b) < 0;
+}
+inline bool operator>(const BigNum& a, const BigNum& b) {
+  return a.compare(b) > 0;
+}
+
+/**
+ * @defgroup BigNumFuncs Functions on BigNum which can be computed exactly
+ * @{
+ */
+BigNum pow(const BigNum& a, const BigNum& b);
+BigNum sq(const BigNum& a);
+BigNum cube(const BigNum& a);
+BigNum abs(const BigNum& a);
+BigNum floor(const BigNum& a);
+BigNum ceil(const BigNum& a);
+BigNum round(const BigNum& a);
+BigNum toInt(const BigNum& a);
+BigNum toFloat(const BigNum& a);
+/** @} */
+
+}  // namespace calc
+}  // namespace teditor
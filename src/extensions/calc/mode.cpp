@@ -27,8 +27,10 @@ void addCmd(const std::string& c) {
 class CalcMode: public text::TextMode {
 public:
   CalcMode(): text::TextMode("calc") {
-    populateKeyMap<CalcMode::Keys>(getKeyCmdMap());
-    populateColorMap<CalcMode::Colors>(getColorMap());
+    if (buildingTables()) {
+      populateKeyMap<CalcMode::Keys>(getKeyCmdMap());
+      populateColorMap<CalcMode::Colors>(getColorMap());
+    }
   }
 
   ~CalcMode() { cmds().store(); }
@@ -104,7 +106,7 @@ std::vector<KeyCmdPair> CalcMode::Keys::All = {
   {"[", ""},
   {"\\", ""},
   {"]", ""},
-  {"^", ""},
+  {"^", ".calc::insert-char"},
   {"_", ".calc::insert-char"},
   {"`", ""},
   {"a", ".calc::insert-char"},
@@ -1,12 +1,12 @@
 #include "core/utils.h"
-#include "number.h"
+#include "bignum.h"
 #include <unordered_map>
 #include <string>
 
 namespace teditor {
 namespace calc {
 
-typedef std::unordered_map<std::string, Num64> VarMap;
+typedef std::unordered_map<std::string, BigNum> VarMap;
 
 VarMap& vars();
 History& cmds();
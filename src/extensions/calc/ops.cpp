@@ -39,9 +39,18 @@ namespace ops {
  *
  * @section calc_enter calc::enter
  * Evaluate the current expression and print the result below it.
+ * Expressions of the form `<expr> for <var> in <start>..<end> [by <step>]` are
+ * evaluated for all values of `var` in the given range and the count, min, max
+ * and sum of the results are printed instead. Eg: `sq(x) for x in 0..1e6`.
  * 
  * @note Available since v1.7.0
  *
+ * Integer results which overflow 64b are computed with arbitrary precision
+ * automatically. When the option `calc:decimal` is set, non-integers are
+ * computed in fixed-point decimal instead of double precision floats.
+ *
+ * @note Sequences and arbitrary precision are supported since v1.9.0
+ *
  *
  * @section calc_backspace-char calc::backspace-char
  * Removes the char to the left of the cursor, from the current line.
@@ -120,6 +129,31 @@ void insertChar(Buffer& buf, char c, Editor& ed) {
 }
 
 
+void evaluate(Buffer& buf, const std::string& expr) {
+  bool decimal = Option::get("calc:decimal").getBool();
+  Parser parser(decimal);
+  std::string e, var;
+  BigNum start, end, step;
+  try {
+    if (Parser::isSequence(expr, e, var, start, end, step, decimal)) {
+      auto res = parser.evaluateSequence(e, var, start, end, step, vars());
+      buf.insert(format("\nCount: %lld\nMin: %s (%s=%s)\nMax: %s (%s=%s)\n"
+                        "Sum: %s\n", (long long)res.count,
+                        num2str(res.min).c_str(), var.c_str(),
+                        num2str(res.argMin).c_str(),
+                        num2str(res.max).c_str(), var.c_str(),
+                        num2str(res.argMax).c_str(),
+                        num2str(res.sum).c_str()));
+    } else {
+      auto res = parser.evaluate(expr, vars());
+      buf.insert(format("\nResult: %s\n", num2str(res).c_str()));
+    }
+  } catch (const std::exception& ex) {
+    buf.insert(format("\nError: %s\n", ex.what()));
+  }
+}
+
+
 DEF_CMD(Calc, "calc", "calc_ops", DEF_OP() {
     auto& buf = getCalcBuff(ed);
     printHeader(buf);
@@ -142,7 +176,6 @@ DEF_CMD(InsertChar, ".calc::insert-char", "calc_ops",
 
 DEF_CMD(Evaluate, "calc::enter", "calc_ops", DEF_OP() {
     auto& buf = ed.getBuff();
-    Parser parser;
     const auto& pt = buf.getPoint();
     const auto& line = buf.at(pt.y).get();
     const auto& p = prompt();
@@ -153,9 +186,7 @@ DEF_CMD(Evaluate, "calc::enter", "calc_ops", DEF_OP() {
     auto expr = line.substr(p.size());
     if (expr.empty()) return;
     addCmd(expr);
-    parser.evaluate(expr, vars());
-    //@todo: fix this
-    buf.insert(format("\nResult: %s\n", expr.c_str()));
+    evaluate(buf, expr);
     printHeader(buf);  // insert the next prompt
   });
 
@@ -2,6 +2,9 @@
 //  https://eli.thegreenplace.net/2012/08/02/parsing-expressions-by-precedence-climbing
 
 #include "parser.h"
+#include <algorithm>
+#include <cmath>
+#include "core/lrucache.hpp"
 #include "core/parser/regexs.h"
 #include "core/parser/scanner.h"
 #include "core/parser/lexer.h"
@@ -50,66 +53,556 @@ parser::Lexer& getLexer() {
   return lexer;
 }
 
-bool Parser::lexingDone(const parser::Token& tok) {
-  return tok.type == parser::Token::End || tok.type == parser::Token::Unknown;
+
+/** max number of compiled programs to be cached */
+static const size_t MaxCachedPrograms = 128;
+/** number of values evaluated together in the sequence mode */
+static const int SeqBatch = 256;
+/**
+ * upper limits on the length of a sequence, so that it gets evaluated in
+ * interactive times. Evaluations on BigNum are way slower, hence a lower limit
+ */
+static const int64_t MaxSeqLength = 10000000;
+static const int64_t MaxBigSeqLength = 1000000;
+
+/**
+ * @defgroup Checked Operations on Num64 which throw `Overflow` when the ints
+ * don't fit in 64b. Their overloads on BigNum never overflow.
+ * @{
+ */
+inline void add(Num64& a, const Num64& b) {
+  if (a.isInt && b.isInt) {
+    if (__builtin_add_overflow(a.i, b.i, &a.i)) throw Overflow();
+  } else {
+    a += b;
+  }
+}
+
+inline void sub(Num64& a, const Num64& b) {
+  if (a.isInt && b.isInt) {
+    if (__builtin_sub_overflow(a.i, b.i, &a.i)) throw Overflow();
+  } else {
+    a -= b;
+  }
+}
+
+inline void mul(Num64& a, const Num64& b) {
+  if (a.isInt && b.isInt) {
+    if (__builtin_mul_overflow(a.i, b.i, &a.i)) throw Overflow();
+  } else {
+    a *= b;
+  }
+}
+
+inline void div(Num64& a, const Num64& b) {
+  if (a.isInt && b.isInt) {
+    ASSERT(b.i != 0, "calc: integer division by zero!");
+    if (b.i == -1 && a.i == INT64_MIN) throw Overflow();
+  }
+  a /= b;
+}
+
+inline void neg(Num64& a) {
+  if (a.isInt && a.i == INT64_MIN) throw Overflow();
+  -a;
+}
+
+/** ints raised to non-negative ints are computed exactly */
+inline void power(Num64& a, const Num64& b) {
+  if (!a.isInt || !b.isInt || b.i < 0) {
+    a = pow(a, b);
+    return;
+  }
+  Num64 ret(int64_t(1)), base(a);
+  for (auto e = b.i; e > 0; e >>= 1) {
+    if (e & 1) mul(ret, base);
+    if (e > 1) mul(base, base);
+  }
+  a = ret;
+}
+
+inline Num64 sqChecked(const Num64& a) {
+  Num64 ret(a);
+  mul(ret, a);
+  return ret;
+}
+
+inline Num64 cubeChecked(const Num64& a) {
+  Num64 ret(sqChecked(a));
+  mul(ret, a);
+  return ret;
 }
 
-void Parser::evaluate(const std::string& expr, VarMap& vars) {
+inline void add(BigNum& a, const BigNum& b) { a += b; }
+inline void sub(BigNum& a, const BigNum& b) { a -= b; }
+inline void mul(BigNum& a, const BigNum& b) { a *= b; }
+inline void div(BigNum& a, const BigNum& b) { a /= b; }
+inline void neg(BigNum& a) { -a; }
+inline void power(BigNum& a, const BigNum& b) { a = pow(a, b); }
+/** @} */
+
+/** sum += v, but spills the sum into 'big' instead of overflowing */
+inline void accumulate(Num64& sum, BigNum& big, const Num64& v) {
+  int64_t res;
+  if (sum.isInt && v.isInt && __builtin_add_overflow(sum.i, v.i, &res)) {
+    big += BigNum(sum);
+    sum = v;
+  } else {
+    sum += v;
+  }
+}
+
+inline void accumulate(BigNum& sum, BigNum& big, const BigNum& v) { sum += v; }
+
+inline Num64 call(const Function* f, const Num64& a) { return f->small(a); }
+inline BigNum call(const Function* f, const BigNum& a) { return f->big(a); }
+
+inline void assign(Num64& out, const BigNum& in) { out = in.toNum64(); }
+inline void assign(BigNum& out, const BigNum& in) { out = in; }
+
+// functions which are computed in double precision on both the paths
+#define FP_FUNC(name)                                                   \
+  {#name "(", {&name<int64_t, double>,                                  \
+               [](const BigNum& a) { return BigNum(std::name(a.toDouble())); }}}
+const std::unordered_map<std::string, Function>& unaryFuncs() {
+  static std::unordered_map<std::string, Function> funcs{
+    {"sq(", {&sqChecked, &sq}},
+    {"cube(", {&cubeChecked, &cube}},
+    {"abs(", {&abs<int64_t, double>, &abs}},
+    FP_FUNC(sin), FP_FUNC(cos), FP_FUNC(tan), FP_FUNC(asin), FP_FUNC(acos),
+    FP_FUNC(atan), FP_FUNC(sinh), FP_FUNC(cosh), FP_FUNC(tanh),
+    FP_FUNC(asinh), FP_FUNC(acosh), FP_FUNC(atanh), FP_FUNC(sqrt),
+    FP_FUNC(cbrt), FP_FUNC(log), FP_FUNC(log10), FP_FUNC(exp),
+    {"floor(", {&floor<int64_t, double>, &floor}},
+    {"ceil(", {&ceil<int64_t, double>, &ceil}},
+    {"round(", {&round<int64_t, double>, &round}},
+    {"int(", {&toInt<int64_t, double>, &toInt}},
+    {"float(", {&toFloat<int64_t, double>, &toFloat}},
+  };
+  return funcs;
+}
+#undef FP_FUNC
+
+std::string num2str(const Num64& n) {
+  if (n.isInt) return std::to_string(n.i);
+  return format("%.12g", n.f);
+}
+
+std::string num2str(const BigNum& n) { return n.toString(); }
+
+/** lexed token along with its string */
+struct Lexeme {
+  uint32_t type;
+  std::string str;
+};  // struct Lexeme
+
+/** compiles a list of lexemes into a program via precedence climbing */
+class Compiler {
+public:
+  Compiler(const std::vector<Lexeme>& l, Program& p):
+    lex(l), pos(0), prog(p), depth(0), slots() {
+    prog.maxDepth = 0;
+    prog.hasFraction = false;
+  }
+
+  void compile() {
+    while (true) {
+      statement();
+      if (pos >= lex.size()) break;
+      ASSERT(lex[pos].type == SemiColon, "calc: unexpected '%s'!",
+             lex[pos].str.c_str());
+      ++pos;
+      if (pos >= lex.size()) break;  // trailing ';'
+      emit(Program::Pop, 0, -1);
+    }
+  }
+
+private:
+  const std::vector<Lexeme>& lex;
+  size_t pos;
+  Program& prog;
+  int depth;
+  std::unordered_map<std::string, int> slots;
+
+  bool has(uint32_t type, size_t offset = 0) const {
+    return pos + offset < lex.size() && lex[pos + offset].type == type;
+  }
+
+  void emit(Program::OpCode op, int arg, int delta) {
+    prog.code.push_back(Program::Instr{op, arg});
+    depth += delta;
+    prog.maxDepth = std::max(prog.maxDepth, depth);
+  }
+
+  int slot(const std::string& name) {
+    auto itr = slots.find(name);
+    if (itr != slots.end()) return itr->second;
+    int id = (int)prog.vars.size();
+    prog.vars.push_back(name);
+    prog.assigned.push_back(false);
+    slots[name] = id;
+    return id;
+  }
+
+  void statement() {
+    if (has(Var) && has(Equals, 1)) {
+      int s = slot(lex[pos].str);
+      pos += 2;
+      expr(0);
+      prog.assigned[s] = true;
+      emit(Program::Store, s, 0);
+    } else {
+      expr(0);
+    }
+  }
+
+  static int precedence(uint32_t type) {
+    if (type == Plus || type == Minus) return 1;
+    if (type == Mul || type == Div) return 2;
+    if (type == Exp) return 3;
+    return -1;
+  }
+
+  void expr(int minPrec) {
+    atom();
+    while (pos < lex.size()) {
+      auto type = lex[pos].type;
+      int prec = precedence(type);
+      if (prec < minPrec || prec < 0) break;
+      ++pos;
+      // '^' is right associative
+      expr(type == Exp ? prec : prec + 1);
+      auto op = type == Plus ? Program::Add : type == Minus ? Program::Sub :
+        type == Mul ? Program::Mul : type == Div ? Program::Div : Program::Pow;
+      emit(op, 0, -1);
+    }
+  }
+
+  void atom() {
+    ASSERT(pos < lex.size(), "calc: incomplete expression!");
+    const auto& l = lex[pos++];
+    if (l.type == IVal || l.type == FVal) {
+      prog.consts.push_back(Num64(l.str));
+      prog.literals.push_back(l.str);
+      if (!prog.consts.back().isInt) prog.hasFraction = true;
+      emit(Program::Const, (int)prog.consts.size() - 1, 1);
+    } else if (l.type == Var) {
+      emit(Program::Load, slot(l.str), 1);
+    } else if (l.type == BrktOpen) {
+      expr(0);
+      ASSERT(has(BrktClose), "calc: missing ')'!");
+      ++pos;
+    } else if (l.type == Func) {
+      auto& funcs = unaryFuncs();
+      auto itr = funcs.find(l.str);
+      ASSERT(itr != funcs.end(), "calc: unknown function '%s'!",
+             l.str.c_str());
+      expr(0);
+      ASSERT(has(BrktClose), "calc: missing ')' for '%s'!", l.str.c_str());
+      ++pos;
+      prog.funcs.push_back(&itr->second);
+      emit(Program::Call, (int)prog.funcs.size() - 1, 0);
+    } else if (l.type == Minus) {
+      // unary minus binds tighter than everything but '^'
+      expr(precedence(Exp));
+      emit(Program::Neg, 0, 0);
+    } else if (l.type == Plus) {
+      expr(precedence(Exp));
+    } else {
+      ASSERT(false, "calc: unexpected '%s'!", l.str.c_str());
+    }
+  }
+};  // class Compiler
+
+std::vector<Lexeme> tokenize(const std::string& expr) {
   parser::StringScanner sc(expr);
-  NumStack stack;
-  evaluateExpr(&sc, vars, stack);
-}
-
-void Parser::evaluateExpr(parser::Scanner *sc, VarMap& vars, NumStack& stack) {
-  auto& lex = getLexer();
-  auto tok = lex.next(sc, Space);
-  if (lexingDone(tok)) return;
-  //if (isNumber(tok.type))
-  ///@todo:
-}
-
-Num64 Parser::computeBinaryOp(const Num64& a, const Num64& b, uint32_t id) {
-  if (id == Plus) return a + b;
-  if (id == Minus) return a - b;
-  if (id == Mul) return a * b;
-  if (id == Div) return a / b;
-  if (id == Exp) return pow(a, b);
-  return Num64();
-}
-
-Num64 Parser::computeUnaryFunc(const Num64& a, const std::string& func) {
-  if ("sq(" == func)    return sq(a);
-  if ("cube(" == func)  return cube(a);
-  if ("abs(" == func)   return abs(a);
-  if ("sin(" == func)   return sin(a);
-  if ("cos(" == func)   return cos(a);
-  if ("tan(" == func)   return tan(a);
-  if ("asin(" == func)  return asin(a);
-  if ("acos(" == func)  return acos(a);
-  if ("atan(" == func)  return atan(a);
-  if ("sinh(" == func)  return sinh(a);
-  if ("cosh(" == func)  return cosh(a);
-  if ("tanh(" == func)  return tanh(a);
-  if ("asinh(" == func) return asinh(a);
-  if ("acosh(" == func) return acosh(a);
-  if ("atanh(" == func) return atanh(a);
-  if ("sqrt(" == func)  return sqrt(a);
-  if ("cbrt(" == func)  return cbrt(a);
-  if ("log(" == func)   return log(a);
-  if ("log10(" == func) return log10(a);
-  if ("exp(" == func)   return exp(a);
-  if ("floor(" == func) return floor(a);
-  if ("ceil(" == func)  return ceil(a);
-  if ("round(" == func) return round(a);
-  if ("int(" == func)   return toInt(a);
-  if ("float(" == func) return toFloat(a);
-  return Num64();
-}
-
-bool Parser::isUnaryFunc(uint32_t id) { return id == Func; }
-
-bool Parser::isBinaryOp(uint32_t id) {
-  return Plus <= id && id <= Exp;
+  auto& lexer = getLexer();
+  std::vector<Lexeme> ret;
+  while (true) {
+    auto tok = lexer.next(&sc, Space);
+    if (tok.type == parser::Token::End) break;
+    ASSERT(tok.type != parser::Token::Unknown, "calc: bad expression '%s'!",
+           expr.c_str());
+    auto str = sc.at(tok.start, tok.end);
+    // the lexer greedily eats the sign into the number. Separate it out so that
+    // the compiler can treat it as a unary/binary operator. Eg: '3-2', '-2^2'
+    if ((tok.type == IVal || tok.type == FVal) &&
+        (str[0] == '+' || str[0] == '-')) {
+      ret.push_back(Lexeme{str[0] == '+' ? Plus : Minus, str.substr(0, 1)});
+      str = str.substr(1);
+    }
+    ret.push_back(Lexeme{tok.type, str});
+  }
+  return ret;
+}
+
+std::shared_ptr<const Program> Parser::compile(const std::string& expr) {
+  static LRUCache<std::string, std::shared_ptr<const Program>>
+    cache(MaxCachedPrograms);
+  if (cache.exists(expr)) return cache.get(expr);
+  auto lex = tokenize(expr);
+  ASSERT(!lex.empty(), "calc: empty expression!");
+  std::shared_ptr<Program> prog(new Program);
+  Compiler(lex, *prog).compile();
+  cache.put(expr, prog);
+  return prog;
+}
+
+/**
+ * runs the program over 'n' values at a time. The stack is laid out as
+ * 'maxDepth' rows of 'n' values each, with the result ending up in row 0.
+ * Values of the variable in slot 'seqSlot' are taken from 'seq' instead.
+ */
+template <typename T>
+void execute(const Program& prog, const T* consts, const std::vector<T*>& slots,
+             int seqSlot, const T* seq, int n, T* stack) {
+  int sp = 0;
+  for (const auto& in : prog.code) {
+    // 'a' and 'b' are the top 2 rows and 'next' is the first free one
+    T *next = stack + sp * n, *b = next - n, *a = b - n;
+    switch (in.op) {
+    case Program::Const:
+      std::fill(next, next + n, consts[in.arg]);
+      ++sp;
+      break;
+    case Program::Load:
+      if (in.arg == seqSlot) std::copy(seq, seq + n, next);
+      else std::fill(next, next + n, *slots[in.arg]);
+      ++sp;
+      break;
+    case Program::Store:
+      *slots[in.arg] = b[n - 1];
+      break;
+    case Program::Pop:
+      --sp;
+      break;
+    case Program::Add:
+      for (int i = 0; i < n; ++i) add(a[i], b[i]);
+      --sp;
+      break;
+    case Program::Sub:
+      for (int i = 0; i < n; ++i) sub(a[i], b[i]);
+      --sp;
+      break;
+    case Program::Mul:
+      for (int i = 0; i < n; ++i) mul(a[i], b[i]);
+      --sp;
+      break;
+    case Program::Div:
+      for (int i = 0; i < n; ++i) div(a[i], b[i]);
+      --sp;
+      break;
+    case Program::Pow:
+      for (int i = 0; i < n; ++i) power(a[i], b[i]);
+      --sp;
+      break;
+    case Program::Neg:
+      for (int i = 0; i < n; ++i) neg(b[i]);
+      break;
+    case Program::Call: {
+      auto f = prog.funcs[in.arg];
+      for (int i = 0; i < n; ++i) b[i] = call(f, b[i]);
+      break;
+    }
+    };
+  }
+}
+
+/** constants of the program in the given type */
+inline const Num64* constants(const Program& prog, bool decimal,
+                              std::vector<Num64>& out) {
+  return prog.consts.data();
+}
+
+inline const BigNum* constants(const Program& prog, bool decimal,
+                               std::vector<BigNum>& out) {
+  for (const auto& l : prog.literals) out.push_back(BigNum(l, decimal));
+  return out.data();
+}
+
+/** values of the variables and constants of a program in the given type */
+template <typename T>
+struct Bindings {
+  std::vector<T> storage, values;
+  std::vector<T*> slots;
+  const T* consts;
+
+  Bindings(const Program& prog, const VarMap& vars, bool decimal):
+    storage(), values(prog.vars.size()), slots(), consts(nullptr) {
+    for (size_t i = 0; i < prog.vars.size(); ++i) {
+      auto itr = vars.find(prog.vars[i]);
+      if (itr != vars.end()) assign(values[i], itr->second);
+      slots.push_back(&values[i]);
+    }
+    consts = constants(prog, decimal, storage);
+  }
+};  // struct Bindings
+
+/** whether the program can be evaluated on Num64 */
+bool isSmall(const Program& prog, const VarMap& vars, bool decimal) {
+  if (decimal && prog.hasFraction) return false;
+  for (const auto& name : prog.vars) {
+    auto itr = vars.find(name);
+    if (itr != vars.end() && !itr->second.isSmall()) return false;
+  }
+  return true;
+}
+
+template <typename T>
+BigNum evaluateAs(const Program& prog, VarMap& vars, bool decimal) {
+  Bindings<T> b(prog, vars, decimal);
+  std::vector<T> stack(std::max(prog.maxDepth, 1));
+  execute(prog, b.consts, b.slots, -1, (const T*)nullptr, 1,
+          stack.data());
+  // update the variables only after a successful evaluation
+  for (size_t i = 0; i < prog.vars.size(); ++i)
+    if (prog.assigned[i]) vars[prog.vars[i]] = BigNum(b.values[i]);
+  return BigNum(stack[0]);
+}
+
+BigNum Parser::evaluate(const std::string& expr, VarMap& vars) {
+  auto prog = compile(expr);
+  for (size_t i = 0; i < prog->vars.size(); ++i) {
+    const auto& name = prog->vars[i];
+    ASSERT(prog->assigned[i] || vars.find(name) != vars.end(),
+           "calc: unknown variable '%s'!", name.c_str());
+  }
+  if (isSmall(*prog, vars, decimal)) {
+    try {
+      return evaluateAs<Num64>(*prog, vars, decimal);
+    } catch (const Overflow&) {}
+  }
+  return evaluateAs<BigNum>(*prog, vars, decimal);
+}
+
+template <typename T>
+SeqResult sequenceAs(const Program& prog, int seqSlot, const VarMap& vars,
+                     bool decimal, const BigNum& start, const BigNum& step,
+                     int64_t count) {
+  Bindings<T> b(prog, vars, decimal);
+  T first, incr;
+  assign(first, start);
+  assign(incr, step);
+  std::vector<T> seq(SeqBatch), stack(std::max(prog.maxDepth, 1) * SeqBatch);
+  T min, max, sum, argMin, argMax;
+  BigNum spilled;
+  for (int64_t done = 0; done < count; done += SeqBatch) {
+    int n = (int)std::min<int64_t>(SeqBatch, count - done);
+    for (int i = 0; i < n; ++i) {
+      seq[i] = T(int64_t(done + i));
+      mul(seq[i], incr);
+      add(seq[i], first);
+    }
+    execute(prog, b.consts, b.slots, seqSlot, (const T*)seq.data(), n,
+            stack.data());
+    for (int i = 0; i < n; ++i) {
+      const auto& v = stack[i];
+      if (done + i == 0) {
+        min = max = sum = v;
+        argMin = argMax = seq[i];
+        continue;
+      }
+      accumulate(sum, spilled, v);
+      if (v < min) {
+        min = v;
+        argMin = seq[i];
+      }
+      if (v > max) {
+        max = v;
+        argMax = seq[i];
+      }
+    }
+  }
+  SeqResult ret;
+  ret.count = count;
+  ret.min = BigNum(min);
+  ret.max = BigNum(max);
+  ret.sum = spilled + BigNum(sum);
+  ret.argMin = BigNum(argMin);
+  ret.argMax = BigNum(argMax);
+  return ret;
+}
+
+/**
+ * number of whole steps needed to go from start to end (negative if the step
+ * goes the other way). Exact for Int and Decimal values. With floats, values
+ * like 0.3 / 0.1 end up just short of an integer and are hence rounded.
+ */
+double numSteps(const BigNum& diff, const BigNum& step) {
+  if (diff.type == BigNum::Float || step.type == BigNum::Float) {
+    auto len = diff.toDouble() / step.toDouble();
+    auto r = std::round(len);
+    if (std::abs(len - r) <= 1e-9 * std::max(1.0, std::abs(r))) return r;
+    return std::floor(len);
+  }
+  BigInt q, r;
+  auto a = diff.toDecimal().m, b = step.toDecimal().m;
+  BigInt::divmod(a, b, q, r);
+  // divmod truncates, whereas whole steps need a floor
+  if (!r.isZero() && a.isNeg() != b.isNeg()) q -= BigInt(int64_t(1));
+  return q.toDouble();
+}
+
+SeqResult Parser::evaluateSequence(const std::string& expr,
+                                   const std::string& var, const BigNum& start,
+                                   const BigNum& end, const BigNum& step,
+                                   const VarMap& vars) {
+  auto prog = compile(expr);
+  int seqSlot = -1;
+  for (size_t i = 0; i < prog->vars.size(); ++i) {
+    const auto& name = prog->vars[i];
+    ASSERT(!prog->assigned[i],
+           "calc: assignments are not allowed in sequences!");
+    if (name == var) seqSlot = (int)i;
+    else ASSERT(vars.find(name) != vars.end(), "calc: unknown variable '%s'!",
+                name.c_str());
+  }
+  ASSERT(step != BigNum(int64_t(0)), "calc: sequence step cannot be 0!");
+  auto len = numSteps(end - start, step);
+  ASSERT(len >= 0, "calc: empty sequence!");
+  ASSERT(len < MaxSeqLength, "calc: sequence is too long! [max=%ld]",
+         MaxSeqLength);
+  auto count = int64_t(len) + 1;
+  if (isSmall(*prog, vars, decimal) && start.isSmall() && step.isSmall()) {
+    try {
+      return sequenceAs<Num64>(*prog, seqSlot, vars, decimal, start, step,
+                               count);
+    } catch (const Overflow&) {}
+  }
+  ASSERT(count <= MaxBigSeqLength,
+         "calc: sequence is too long for big numbers! [max=%ld]",
+         MaxBigSeqLength);
+  return sequenceAs<BigNum>(*prog, seqSlot, vars, decimal, start, step, count);
+}
+
+bool Parser::isSequence(const std::string& line, std::string& expr,
+                        std::string& var, BigNum& start, BigNum& end,
+                        BigNum& step, bool decimal) {
+  auto forPos = line.rfind(" for ");
+  if (forPos == std::string::npos) return false;
+  auto rest = line.substr(forPos + 5);
+  auto inPos = rest.find(" in ");
+  auto dots = rest.find("..");
+  if (inPos == std::string::npos || dots == std::string::npos) return false;
+  auto trim = [](const std::string& s) {
+    auto b = s.find_first_not_of(" \t");
+    if (b == std::string::npos) return std::string();
+    auto e = s.find_last_not_of(" \t");
+    return s.substr(b, e - b + 1);
+  };
+  expr = line.substr(0, forPos);
+  var = trim(rest.substr(0, inPos));
+  start = BigNum(trim(rest.substr(inPos + 4, dots - inPos - 4)), decimal);
+  auto endStr = rest.substr(dots + 2);
+  auto byPos = endStr.find(" by ");
+  if (byPos == std::string::npos) {
+    step = BigNum(int64_t(1));
+  } else {
+    step = BigNum(trim(endStr.substr(byPos + 4)), decimal);
+    endStr = endStr.substr(0, byPos);
+  }
+  end = BigNum(trim(endStr), decimal);
+  return true;
 }
 
 }  // namespace calc
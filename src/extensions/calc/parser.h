@@ -4,29 +4,126 @@
 #include "core/parser/lexer.h"
 #include <unordered_map>
 #include "number.h"
+#include "bignum.h"
 #include <string>
-#include <stack>
 #include <vector>
 #include <memory>
 
 namespace teditor {
 namespace calc {
 
-typedef std::unordered_map<std::string, Num64> VarMap;
-typedef std::stack<Num64> NumStack;
+typedef std::unordered_map<std::string, BigNum> VarMap;
 
-/** expression parser and evaluator */
+/** unary function that can be called from the expressions */
+struct Function {
+  /** implementation on Num64, which throws `Overflow` on int overflows */
+  Num64 (*small)(const Num64&);
+  /** implementation on BigNum */
+  BigNum (*big)(const BigNum&);
+};  // struct Function
+
+/** thrown by the Num64 evaluation path on int overflows */
+struct Overflow {};
+
+/**
+ * @brief An expression compiled into a compact postfix bytecode. Variables are
+ * referred to by their slots, which are bound to the actual values only at the
+ * time of evaluation. Statements (separated by ';') are evaluated in order and
+ * the value of the last one is the result of the program.
+ */
+struct Program {
+  enum OpCode {
+    /** push consts[arg] */
+    Const = 0,
+    /** push value of the variable in slot arg */
+    Load,
+    /** store the top of the stack into the variable in slot arg */
+    Store,
+    /** discard the top of the stack */
+    Pop,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Pow,
+    Neg,
+    /** replace the top of the stack with funcs[arg] applied on it */
+    Call,
+  };  // enum OpCode
+
+  struct Instr {
+    OpCode op;
+    int arg;
+  };  // struct Instr
+
+  std::vector<Instr> code;
+  std::vector<Num64> consts;
+  /** text of the above constants, for an exact parsing into BigNum */
+  std::vector<std::string> literals;
+  /** whether any of the constants is not an integer */
+  bool hasFraction;
+  /** names of the variables referred, indexed by their slots */
+  std::vector<std::string> vars;
+  /** whether each of the above variables is assigned to in this program */
+  std::vector<bool> assigned;
+  std::vector<const Function*> funcs;
+  /** max depth of the stack needed for evaluation */
+  int maxDepth;
+};  // struct Program
+
+/** summary of evaluating an expression over a sequence of values */
+struct SeqResult {
+  int64_t count;
+  BigNum min, max, sum;
+  /** values of the sequence variable where min and max were found */
+  BigNum argMin, argMax;
+};  // struct SeqResult
+
+/**
+ * @brief expression parser and evaluator. Evaluation happens on `Num64` and
+ * automatically switches to `BigNum` in case of int overflows. In decimal mode,
+ * non-integer constants are treated as fixed-point decimals, which means that
+ * such expressions are always evaluated on `BigNum`.
+ */
 struct Parser {
-  void evaluate(const std::string& expr, VarMap& vars);
-
- private:
-  bool lexingDone(const parser::Token& tok);
-  Num64 computeBinaryOp(const Num64& a, const Num64& b, uint32_t op);
-  Num64 computeUnaryFunc(const Num64& a, const std::string& func);
-  bool isBinaryOp(uint32_t id);
-  bool isUnaryFunc(uint32_t id);
-  void evaluateExpr(parser::Scanner *sc, VarMap& vars, NumStack& stack);
+  Parser(bool dec = false): decimal(dec) {}
+
+  /**
+   * @brief evaluates the expression
+   * @param expr the expression (or multiple of them separated by ';')
+   * @param vars the variables, which will also be updated with assignments
+   * @return value of the last expression
+   */
+  BigNum evaluate(const std::string& expr, VarMap& vars);
+
+  /**
+   * @brief evaluates the expression for every value of the given variable in
+   * the range [start, end], in increments of step. This happens over arrays of
+   * values at a time, without touching `vars` for the sequence variable.
+   * @note assignments are not allowed in such expressions
+   */
+  SeqResult evaluateSequence(const std::string& expr, const std::string& var,
+                             const BigNum& start, const BigNum& end,
+                             const BigNum& step, const VarMap& vars);
+
+  /**
+   * @brief checks if the line is of the form `expr for x in start..end` (with
+   * an optional ` by step` at the end) and if so, splits it into its parts
+   */
+  static bool isSequence(const std::string& line, std::string& expr,
+                         std::string& var, BigNum& start, BigNum& end,
+                         BigNum& step, bool decimal=false);
+
+  /** compiles the expression, returning the cached program if available */
+  static std::shared_ptr<const Program> compile(const std::string& expr);
+
+private:
+  bool decimal;
 };  // struct Parser
 
+/** string representation of the number */
+std::string num2str(const Num64& n);
+std::string num2str(const BigNum& n);
+
 }  // namespace calc
 }  // namespace teditor
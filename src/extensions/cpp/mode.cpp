@@ -9,8 +9,10 @@ namespace cpp {
 class CppMode: public text::TextMode {
 public:
   CppMode(): text::TextMode("c++"), nspace("namespace.*{") {
-    populateKeyMap<CppMode::Keys>(getKeyCmdMap());
-    populateColorMap<CppMode::Colors>(getColorMap());
+    if(buildingTables()) {
+      populateKeyMap<CppMode::Keys>(getKeyCmdMap());
+      populateColorMap<CppMode::Colors>(getColorMap());
+    }
   }
 
   int indent(Buffer& buf, int line) {
@@ -9,23 +9,25 @@ namespace dir {
 class DirMode: public readonly::ReadOnlyMode {
 public:
   DirMode(): readonly::ReadOnlyMode("dir") {
-    populateKeyMap<DirMode::Keys>(getKeyCmdMap());
-    populateColorMap<DirMode::Colors>(getColorMap());
+    if (buildingTables()) {
+      populateKeyMap<DirMode::Keys>(getKeyCmdMap());
+      populateColorMap<DirMode::Colors>(getColorMap());
+    }
   }
 
   void getColorFor(AttrColor& fg, AttrColor& bg, int lineNum, int pos,
                    const Buffer& b, bool isHighlighted) {
     auto& cm = getColorMap();
     if (isHighlighted) {
-      fg = cm.get("highlightfg");
-      bg = cm.get("highlightbg");
+      fg = cm.get(Slot_highlightfg);
+      bg = cm.get(Slot_highlightbg);
     } else if (lineNum == 0) {
-      fg = cm.get("defaultfg");
-      bg = cm.get("defaultbg");
+      fg = cm.get(Slot_defaultfg);
+      bg = cm.get(Slot_defaultbg);
     } else {
       const auto& str = b.at(lineNum).get();
-      fg = cm.get(str[2] == 'd' ? "dirfg" : "defaultfg");
-      bg = cm.get("defaultbg");
+      fg = cm.get(str[2] == 'd' ? Slot_dirfg : Slot_defaultfg);
+      bg = cm.get(Slot_defaultbg);
     }
   }
 
@@ -8,23 +8,25 @@ namespace grep {
 class GrepMode: public readonly::ReadOnlyMode {
 public:
   GrepMode(): readonly::ReadOnlyMode("grep") {
-    populateKeyMap<GrepMode::Keys>(getKeyCmdMap());
-    populateColorMap<GrepMode::Colors>(getColorMap());
+    if (buildingTables()) {
+      populateKeyMap<GrepMode::Keys>(getKeyCmdMap());
+      populateColorMap<GrepMode::Colors>(getColorMap());
+    }
   }
 
   void getColorFor(AttrColor& fg, AttrColor& bg, int lineNum, int pos,
                    const Buffer& b, bool isHighlighted) {
     auto& cmap = getColorMap();
-    fg = cmap.get(isHighlighted ? "highlightfg" :
-                  lineNum == 0 ? "titlefg" : "defaultfg");
-    bg = cmap.get(isHighlighted ? "highlightbg" : "defaultbg");
+    fg = cmap.get(isHighlighted ? Slot_highlightfg :
+                  lineNum == 0 ? Slot_titlefg : Slot_defaultfg);
+    bg = cmap.get(isHighlighted ? Slot_highlightbg : Slot_defaultbg);
     const auto& line = b.at(lineNum).get();
     if (lineNum < 4 || pos >= (int)line.size()) return;
     auto loc = line.find_first_of(':');
     if (loc == std::string::npos) return;
     loc = line.find_first_of(':', loc + 1);
     if (loc == std::string::npos) return;
-    if (pos < (int)loc) fg = cmap.get("filefg");
+    if (pos < (int)loc) fg = cmap.get(Slot_filefg);
   }
 
   static Mode* create() { return new GrepMode; }
@@ -32,8 +32,10 @@ REGISTER_MODE(LedgerMode, "ledger");
 class LedgerShowMode: public readonly::ReadOnlyMode {
  public:
   LedgerShowMode(): readonly::ReadOnlyMode("ledger-show") {
-    populateKeyMap<LedgerShowMode::Keys>(getKeyCmdMap());
-    populateColorMap<LedgerShowMode::Colors>(getColorMap());
+    if (buildingTables()) {
+      populateKeyMap<LedgerShowMode::Keys>(getKeyCmdMap());
+      populateColorMap<LedgerShowMode::Colors>(getColorMap());
+    }
   }
 
   static Mode* create() { return new LedgerShowMode; }
@@ -46,6 +48,8 @@ class LedgerShowMode: public readonly::ReadOnlyMode {
 
 std::vector<KeyCmdPair> LedgerShowMode::Keys::All = {
   {"a", "ledger::all"},
+  {"m", "ledger::monthly"},
+  {"r", "ledger::range"},
   {"t", "ledger::top"}
 };
 
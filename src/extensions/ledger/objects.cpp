@@ -0,0 +1,60 @@
+#include "objects.h"
+
+namespace teditor {
+namespace ledger {
+
+void Accounts::push_back(const Account& a) {
+  accts.push_back(a);
+  index(size() - 1);
+}
+
+void Accounts::index(int id) {
+  const auto& a = accts[id];
+  // emplace does not overwrite the existing entries
+  ids.emplace(a.name(), id);
+  for(const auto& al : a.aliases()) ids.emplace(al, id);
+}
+
+void Accounts::reindex() {
+  ids.clear();
+  for(int i = 0; i < size(); ++i) index(i);
+}
+
+
+AccountTree::AccountTree(const Accounts& accts,
+                         const std::vector<int64_t>& bals):
+  nodes(), roots(), ids() {
+  for(int i = 0; i < accts.size(); ++i) {
+    const auto& name = accts[i].name();
+    int curr = -1;
+    size_t pos = 0;
+    while(true) {
+      auto next = name.find(':', pos);
+      curr = getNode(name.substr(0, next), curr);
+      if(next == std::string::npos) break;
+      pos = next + 1;
+    }
+    nodes[curr].account = i;
+    if(i < (int)bals.size()) nodes[curr].bal += bals[i];
+  }
+  // children are always created after their parents, so a single reverse pass
+  // is enough to roll-up the balances
+  for(int i = size() - 1; i >= 0; --i) {
+    int p = nodes[i].parent;
+    if(p >= 0) nodes[p].bal += nodes[i].bal;
+  }
+}
+
+int AccountTree::getNode(const std::string& path, int parent) {
+  auto itr = ids.find(path);
+  if(itr != ids.end()) return itr->second;
+  int id = size();
+  nodes.push_back(Node{path, parent, -1, 0, std::vector<int>()});
+  ids[path] = id;
+  if(parent >= 0) nodes[parent].children.push_back(id);
+  else roots.push_back(id);
+  return id;
+}
+
+} // end namespace ledger
+} // end namespace teditor
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <utility>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <stdio.h>
 #include <stdint.h>
@@ -34,7 +36,12 @@ public:
   bool isAnAlias(const std::string& a) const {
     return alias.find(a) != alias.end();
   }
+  /**
+   * @note aliases inserted this way after the account has been added into
+   * `Accounts` will not be used for its lookups
+   */
   void insertAlias(const std::string& a) { alias.insert(a); }
+  const Aliases& aliases() const { return alias; }
 
   Account& operator+=(double val) {
     bal += (int64_t)(val * 100.0);
@@ -48,18 +55,112 @@ private:
   int64_t bal;
 };
 
-/** all accounts in the current ledger */
-class Accounts: public std::vector<Account> {
+/**
+ * @brief All accounts in the current ledger. Accounts are interned, ie: each of
+ * them is identified by its position in this list and a hash table maps their
+ * names as well as aliases to these ids.
+ */
+class Accounts {
 public:
-  Account& find(const std::string& a) {
-    for(size_t i=0;i<size();++i) {
-      auto& itr = at(i);
-      if(itr.name() == a) return itr;
-      if(itr.isAnAlias(a)) return itr;
-    }
+  typedef std::vector<Account>::iterator iterator;
+  typedef std::vector<Account>::const_iterator const_iterator;
+
+  Accounts(): accts(), ids() {}
+
+  /** id of the account with the given name or alias, -1 if there's none */
+  int lookup(const std::string& a) const {
+    auto itr = ids.find(a);
+    return itr == ids.end() ? -1 : itr->second;
+  }
+
+  /** id of the account with the given name or alias, creating it if needed */
+  int id(const std::string& a) {
+    auto itr = ids.find(a);
+    if(itr != ids.end()) return itr->second;
     push_back(Account(a));
-    return back();
+    return size() - 1;
+  }
+
+  Account& find(const std::string& a) { return accts[id(a)]; }
+
+  /**
+   * @brief appends a new account. If its name or any of its aliases is already
+   * taken, lookups on them will continue to return the older account.
+   */
+  void push_back(const Account& a);
+
+  /** sorts the accounts (and re-assigns their ids!) */
+  template <typename Cmp>
+  void sort(Cmp cmp) {
+    std::sort(accts.begin(), accts.end(), cmp);
+    reindex();
+  }
+
+  int size() const { return (int)accts.size(); }
+  bool empty() const { return accts.empty(); }
+  void clear() { accts.clear(); ids.clear(); }
+  Account& operator[](int i) { return accts[i]; }
+  const Account& operator[](int i) const { return accts[i]; }
+  Account& back() { return accts.back(); }
+  iterator begin() { return accts.begin(); }
+  iterator end() { return accts.end(); }
+  const_iterator begin() const { return accts.begin(); }
+  const_iterator end() const { return accts.end(); }
+
+private:
+  std::vector<Account> accts;
+  std::unordered_map<std::string, int> ids;
+
+  void index(int id);
+  void reindex();
+};
+
+
+/**
+ * @brief Prefix tree of the account names, split at ':', used for hierarchical
+ * roll-ups of the balances. Eg: 'Expenses' node contains the sum of balances
+ * of 'Expenses:Auto' and 'Expenses:Food:Groceries' and so on.
+ */
+class AccountTree {
+public:
+  /** a node in the tree, representing one prefix of the account names */
+  struct Node {
+    /** the full prefix */
+    std::string path;
+    /** parent node, -1 for the top-level ones */
+    int parent;
+    /** id of the account with this name, -1 if it is only a prefix */
+    int account;
+    /** total balance of all accounts under this prefix */
+    int64_t bal;
+    /** child nodes, in the order of their creation */
+    std::vector<int> children;
+  };
+
+  /**
+   * @brief builds the tree and computes the balances
+   * @param accts all the accounts
+   * @param bals balance of each account, indexed by its id
+   */
+  AccountTree(const Accounts& accts, const std::vector<int64_t>& bals);
+
+  /** node of the given prefix, -1 if there's none */
+  int lookup(const std::string& path) const {
+    auto itr = ids.find(path);
+    return itr == ids.end() ? -1 : itr->second;
   }
+
+  const Node& node(int id) const { return nodes[id]; }
+  int size() const { return (int)nodes.size(); }
+  /** the top-level nodes, in the order of their creation */
+  const std::vector<int>& tops() const { return roots; }
+
+private:
+  std::vector<Node> nodes;
+  std::vector<int> roots;
+  std::unordered_map<std::string, int> ids;
+
+  int getNode(const std::string& path, int parent);
 };
 
 /** account related info in a transaction */
@@ -89,6 +190,9 @@ public:
     for(const auto& a : accts) acc.find(a.first) += a.second;
   }
 
+  /** all the postings of this transaction */
+  const AccountsInfo& postings() const { return accts; }
+
   const std::string& name() const { return nam; }
   const TimePoint& date() const { return dat; }
 
@@ -3,7 +3,11 @@
 #include "core/option.h"
 #include "parser.h"
 #include "core/time_utils.h"
+#include <algorithm>
+#include <map>
+#include <memory>
 #include <sstream>
+#include <unordered_map>
 
 namespace teditor {
 namespace ledger {
@@ -18,6 +22,9 @@ namespace ops {
  *
  * @section ledger-top
  * Shows all top-level account transaction summary inside a `*ledger` Buffer.
+ * The ledger is kept in memory across invocations and only the transactions
+ * edited since the previous report are re-parsed. When invoked from the
+ * `*ledger` Buffer itself, the ledger file of the previous report is used.
  *
  * @note Available since v1.3.0
  *
@@ -26,6 +33,21 @@ namespace ops {
  * Shows all account transaction summary inside a `*ledger` Buffer.
  *
  * @note Available since v1.3.0
+ *
+ *
+ * @section ledger-monthly
+ * Shows the net change of every top-level account in each month, along with
+ * its running balance at the end of that month, inside a `*ledger` Buffer.
+ *
+ * @note Available since v1.9.0
+ *
+ *
+ * @section ledger-range
+ * Prompts for a date range (as `yyyy-mm-dd yyyy-mm-dd`, both inclusive) and
+ * shows the net change of all accounts over that range, along with their
+ * balances at the end of it, inside a `*ledger` Buffer.
+ *
+ * @note Available since v1.9.0
  */
 
 Buffer& getLedgerShowBuff(Editor& ed) {
@@ -36,6 +58,30 @@ Buffer& getLedgerShowBuff(Editor& ed) {
   return buf;
 }
 
+/**
+ * in-memory ledger of the current buffer. If the current buffer is not backed
+ * by a file (eg: the `*ledger` Buffer), the file of the previous call is used
+ */
+Parser& getLedger(Editor& ed) {
+  static std::unordered_map<std::string, std::unique_ptr<Parser>> ledgers;
+  static std::string lastFile;
+  const auto& buf = ed.getBuff();
+  auto file = buf.getFileName();
+  if (file.empty()) file = lastFile;
+  ASSERT(!file.empty(), "ledger: current buffer is not a ledger file!");
+  auto& p = ledgers[file];
+  if (!p) p.reset(new Parser);
+  if (file == buf.getFileName()) {
+    p->update(buf);
+  } else {
+    Buffer tmp;
+    tmp.load(file, 0);
+    p->update(tmp);
+  }
+  lastFile = file;
+  return *p;
+}
+
 void printHeader(Buffer& buf, const TimePoint& min, const TimePoint& max) {
   std::stringstream ss;
   buf.clear();
@@ -47,8 +93,7 @@ void printHeader(Buffer& buf, const TimePoint& min, const TimePoint& max) {
   buf.insert(ss.str());
 }
 
-void showTopAccounts(Buffer& buf, const std::string& file) {
-  Parser p(file);
+void showTopAccounts(Buffer& buf, const Parser& p) {
   TimePoint min, max;
   p.minmaxDates(min, max);
   printHeader(buf, min, max);
@@ -66,14 +111,13 @@ void showTopAccounts(Buffer& buf, const std::string& file) {
 }
 
 DEF_CMD(LedgerTop, "ledger::top", "ledger_ops", DEF_OP() {
-    const auto& file = ed.getBuff().getFileName();
+    const auto& p = getLedger(ed);
     auto& buf = getLedgerShowBuff(ed);
-    showTopAccounts(buf, file);
+    showTopAccounts(buf, p);
     ed.switchToBuff("*ledger");
   });
 
-void showAllAccounts(Buffer& buf, const std::string& file) {
-  Parser p(file);
+void showAllAccounts(Buffer& buf, const Parser& p) {
   TimePoint min, max;
   p.minmaxDates(min, max);
   printHeader(buf, min, max);
@@ -92,9 +136,113 @@ void showAllAccounts(Buffer& buf, const std::string& file) {
 }
 
 DEF_CMD(Ledger, "ledger::all", "ledger_ops", DEF_OP() {
-    const auto& file = ed.getBuff().getFileName();
+    const auto& p = getLedger(ed);
+    auto& buf = getLedgerShowBuff(ed);
+    showAllAccounts(buf, p);
+    ed.switchToBuff("*ledger");
+  });
+
+/**
+ * index of the top-level account of every account, with the names of all
+ * top-level accounts (sorted) being returned in `tops`
+ */
+std::vector<int> topLevelOf(const Accounts& accts, Strings& tops) {
+  std::map<std::string, int> ids;
+  std::vector<std::string> names;
+  for (const auto& a : accts) {
+    names.push_back(a.name().substr(0, a.name().find(':')));
+    ids[names.back()] = 0;
+  }
+  tops.clear();
+  for (auto& itr : ids) {
+    itr.second = (int)tops.size();
+    tops.push_back(itr.first);
+  }
+  std::vector<int> ret;
+  ret.reserve(names.size());
+  for (const auto& n : names) ret.push_back(ids[n]);
+  return ret;
+}
+
+void showMonthly(Buffer& buf, const Parser& p) {
+  TimePoint min, max;
+  p.minmaxDates(min, max);
+  printHeader(buf, min, max);
+  buf.insert("### Monthly balances ###\n");
+  buf.insert(format("%12s  %12s  %-16s\n", "change", "balance", "account"));
+  const auto& st = p.store();
+  if (st.empty()) return;
+  Strings tops;
+  auto topOf = topLevelOf(p.accounts(), tops);
+  std::vector<int64_t> bals, change, running(tops.size(), 0);
+  auto start = timeFromStr(format("%d-%02d-01", year(min), month(min)));
+  for (int row = 0; row < st.size();) {
+    auto end = start;
+    addMonth(end);
+    auto r = st.range(start, end);
+    bals.assign(p.accounts().size(), 0);
+    st.sum(r.first, r.second, bals);
+    change.assign(tops.size(), 0);
+    for (size_t i = 0; i < bals.size(); ++i) change[topOf[i]] += bals[i];
+    auto month = timeToDateStr(start).substr(0, 7);
+    buf.insert(format("\n### %s ###\n", month.c_str()));
+    for (size_t i = 0; i < tops.size(); ++i) {
+      running[i] += change[i];
+      auto chStr = format("%.2lf", change[i] / 100.0);
+      auto balStr = format("%.2lf", running[i] / 100.0);
+      buf.insert(format("%12s  %12s  %-16s\n", chStr.c_str(), balStr.c_str(),
+                        tops[i].c_str()));
+    }
+    row = r.second;
+    start = end;
+  }
+}
+
+DEF_CMD(LedgerMonthly, "ledger::monthly", "ledger_ops", DEF_OP() {
+    const auto& p = getLedger(ed);
+    auto& buf = getLedgerShowBuff(ed);
+    showMonthly(buf, p);
+    ed.switchToBuff("*ledger");
+  });
+
+void showRange(Buffer& buf, const Parser& p, const TimePoint& from,
+               const TimePoint& to) {
+  printHeader(buf, from, to);
+  buf.insert("### Accounts in the range ###\n");
+  buf.insert(format("%12s  %12s  %-16s\n", "change", "balance", "account"));
+  const auto& st = p.store();
+  auto r = st.range(from, addDay(to, 1));
+  std::vector<int64_t> change(p.accounts().size(), 0), upto(change);
+  st.sum(r.first, r.second, change);
+  st.sum(0, r.second, upto);
+  auto changes = p.allAccounts(change), bals = p.allAccounts(upto);
+  double total = 0.0;
+  for (int i = 0; i < changes.size(); ++i) {
+    const auto& name = changes[i].name();
+    if(name[0] != ' ' || name[1] != ' ') total += changes[i].balance();
+    auto chStr = format("%.2lf", changes[i].balance());
+    auto balStr = format("%.2lf", bals[i].balance());
+    buf.insert(format("%12s  %12s  %-16s\n", chStr.c_str(), balStr.c_str(),
+                      name.c_str()));
+  }
+  buf.insert("------------------------------\n");
+  auto valStr = format("%.2lf", total);
+  buf.insert(format("%12s  %12s  %-16s\n", valStr.c_str(), "", "total"));
+  buf.insert(format("\n### %d transactions ###\n", r.second - r.first));
+}
+
+DEF_CMD(LedgerRange, "ledger::range", "ledger_ops", DEF_OP() {
+    const auto& p = getLedger(ed);
+    auto range = ed.prompt("Date range (yyyy-mm-dd yyyy-mm-dd): ");
+    if (range.empty()) return;
+    auto dates = split(range, ' ');
+    dates.erase(std::remove(dates.begin(), dates.end(), ""), dates.end());
+    if (dates.size() != 2) {
+      CMBAR_MSG(ed, "ledger::range: needs exactly 2 dates!\n");
+      return;
+    }
     auto& buf = getLedgerShowBuff(ed);
-    showAllAccounts(buf, file);
+    showRange(buf, p, timeFromStr(dates[0]), timeFromStr(dates[1]));
     ed.switchToBuff("*ledger");
   });
 
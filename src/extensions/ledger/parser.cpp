@@ -39,15 +39,10 @@ parser::Lexer& getLexer() {
   return lexer;
 }
 
-Parser::Parser(const std::string& f): file(f), trans(), accts() {
-  parse(file);
-}
-
-void Parser::parse(const std::string& f) {
-  auto tmp = isAbs(f) ? f : rel2abs(getpwd(), f);
-  Buffer buff;
-  buff.load(tmp, 0);
-  parser::BufferScanner scanner(buff);
+/** parses the text, appending the transactions and account definitions found */
+void parseText(const std::string& text, Transactions& trans,
+               std::vector<Account>& defs) {
+  parser::StringScanner scanner(text);
   auto& lexer = getLexer();
   std::unordered_set<uint32_t> ignores{Space, Newline, Comment};
   parser::Token token;
@@ -96,7 +91,7 @@ void Parser::parse(const std::string& f) {
                accName.c_str());
         accAls.insert(getString());
       } while (token.type == AccountAlias);
-      accts.push_back(Account(accName, accDesc, accAls));
+      defs.push_back(Account(accName, accDesc, accAls));
     } else if (token.type == Date) {  // transaction info
       auto dateStr = getString();
       // description
@@ -122,65 +117,219 @@ void Parser::parse(const std::string& f) {
       next();
     }
   }  // while
-  for(auto& t : trans) t.updateAccounts(accts);
 }
 
-void Parser::reload() {
+const uint64_t FnvBasis = 14695981039346656037ULL;
+
+/** FNV-1a hash of the given bytes, continuing from the hash 'h' */
+uint64_t hashOf(const char* s, size_t len, uint64_t h) {
+  for(size_t i = 0; i < len; ++i) {
+    h ^= (uint8_t)s[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+/** contents of the lines [start, end) of the buffer */
+std::string linesOf(const Buffer& buf, int start, int end) {
+  std::string ret;
+  for(int i = start; i < end; ++i) {
+    const auto& line = buf.at(i);
+    ret.append(line.c_str(), line.length());
+    ret += '\n';
+  }
+  return ret;
+}
+
+Parser::Parser(const std::string& f): file(f), trans(), accts(), bals(),
+                                      refs(), nDefined(0), chunks(), fprint(0),
+                                      nParsed(0), st() {
+  parse(file);
+}
+
+Parser::Parser(): file(), trans(), accts(), bals(), refs(), nDefined(0),
+                  chunks(), fprint(0), nParsed(0), st() {
+}
+
+void Parser::parse(const std::string& f) {
+  auto tmp = isAbs(f) ? f : rel2abs(getpwd(), f);
+  Buffer buff;
+  buff.load(tmp, 0);
+  clear();
+  update(buff);
+}
+
+void Parser::reload() { parse(file); }
+
+void Parser::clear() {
   trans.clear();
   accts.clear();
-  parse(file);
+  bals.clear();
+  refs.clear();
+  nDefined = 0;
+  chunks.clear();
+  fprint = 0;
+  st.reset();
+}
+
+bool Parser::update(const Buffer& buf) {
+  std::vector<Chunk> newChunks;
+  for(int i = 0; i < buf.length(); ++i) {
+    const auto& line = buf.at(i);
+    char c = line.empty() ? ' ' : line.at(0);
+    if(newChunks.empty() || (c != ' ' && c != '\t' && c != '#'))
+      newChunks.push_back(Chunk{i, i, FnvBasis, 0, 0});
+    auto& ch = newChunks.back();
+    ch.end = i + 1;
+    ch.hash = hashOf(line.c_str(), line.length(), ch.hash);
+    ch.hash = hashOf("\n", 1, ch.hash);
+  }
+  uint64_t fp = FnvBasis;
+  for(const auto& ch : newChunks)
+    fp = hashOf((const char*)&ch.hash, sizeof(ch.hash), fp);
+  nParsed = 0;
+  if(fp == fprint && newChunks.size() == chunks.size()) return false;
+  if(chunks.empty()) {
+    rebuild(buf, newChunks);
+    fprint = fp;
+    return true;
+  }
+  // only the chunks between the common prefix and suffix need to be re-parsed
+  int oldN = (int)chunks.size(), newN = (int)newChunks.size();
+  int pre = 0, suf = 0;
+  while(pre < oldN && pre < newN && chunks[pre].hash == newChunks[pre].hash) {
+    newChunks[pre].nTrans = chunks[pre].nTrans;
+    newChunks[pre].nAccts = chunks[pre].nAccts;
+    ++pre;
+  }
+  while(suf < oldN - pre && suf < newN - pre &&
+        chunks[oldN - 1 - suf].hash == newChunks[newN - 1 - suf].hash) {
+    newChunks[newN - 1 - suf].nTrans = chunks[oldN - 1 - suf].nTrans;
+    newChunks[newN - 1 - suf].nAccts = chunks[oldN - 1 - suf].nAccts;
+    ++suf;
+  }
+  // account definitions affect the resolution of every posting
+  bool full = false;
+  for(int i = pre; i < oldN - suf; ++i) full = full || chunks[i].nAccts > 0;
+  Transactions added;
+  std::vector<Account> defs;
+  for(int i = pre; i < newN - suf && !full; ++i) {
+    auto& ch = newChunks[i];
+    auto nT = added.size();
+    parseText(linesOf(buf, ch.start, ch.end), added, defs);
+    ch.nTrans = int(added.size() - nT);
+    ch.nAccts = (int)defs.size();
+    full = !defs.empty();
+    ++nParsed;
+  }
+  if(full) {
+    rebuild(buf, newChunks);
+    fprint = fp;
+    return true;
+  }
+  int tStart = 0, tOld = 0;
+  for(int i = 0; i < pre; ++i) tStart += chunks[i].nTrans;
+  for(int i = pre; i < oldN - suf; ++i) tOld += chunks[i].nTrans;
+  for(int i = tStart; i < tStart + tOld; ++i) apply(trans[i], -1);
+  for(const auto& t : added) apply(t, 1);
+  // accounts which are no longer referred to would not exist in a fresh parse
+  bool orphans = false;
+  for(int i = nDefined; i < (int)refs.size(); ++i)
+    orphans = orphans || refs[i] == 0;
+  if(orphans) {
+    rebuild(buf, newChunks);
+    fprint = fp;
+    return true;
+  }
+  trans.erase(trans.begin() + tStart, trans.begin() + tStart + tOld);
+  trans.insert(trans.begin() + tStart, added.begin(), added.end());
+  chunks.swap(newChunks);
+  st.reset();
+  fprint = fp;
+  return true;
 }
 
-Accounts Parser::topAccounts(bool sort) const {
+void Parser::rebuild(const Buffer& buf, std::vector<Chunk>& newChunks) {
+  clear();
+  std::vector<Account> defs;
+  for(auto& ch : newChunks) {
+    auto nT = trans.size(), nA = defs.size();
+    parseText(linesOf(buf, ch.start, ch.end), trans, defs);
+    ch.nTrans = int(trans.size() - nT);
+    ch.nAccts = int(defs.size() - nA);
+  }
+  nParsed = (int)newChunks.size();
+  for(const auto& a : defs) accts.push_back(a);
+  // accounts being referred before their definitions will be resolved only
+  // after the whole ledger has been parsed
+  nDefined = accts.size();
+  bals.assign(nDefined, 0);
+  refs.assign(nDefined, 0);
+  for(const auto& t : trans) apply(t, 1);
+  chunks.swap(newChunks);
+}
+
+void Parser::apply(const Transaction& t, int sign) {
+  for(const auto& p : t.postings()) {
+    int id = accts.id(p.first);
+    if(id >= (int)bals.size()) {
+      bals.resize(id + 1, 0);
+      refs.resize(id + 1, 0);
+    }
+    bals[id] += sign * p.second;
+    accts[id] += sign * p.second;
+    refs[id] += sign;
+  }
+}
+
+const TransactionStore& Parser::store() const {
+  if(!st) st.reset(new TransactionStore(trans, accts));
+  return *st;
+}
+
+Accounts Parser::topAccounts(const std::vector<int64_t>& b, bool sort) const {
+  AccountTree tree(accts, b);
   Accounts topAccts;
-  for(const auto& a : accts) {
-    auto tokens = split(a.name(), ':');
-    topAccts.find(tokens[0]) += a.rawBalance();
+  for(auto id : tree.tops()) {
+    const auto& n = tree.node(id);
+    topAccts.push_back(Account(n.path));
+    topAccts.back() += n.bal;
   }
   if (sort) {
-    std::sort(topAccts.begin(), topAccts.end(),
-              [](const Account& a, const Account& b) {
-                return a.name().compare(b.name()) <= 0;
-              });
+    topAccts.sort([](const Account& a, const Account& b) {
+        return a.name() < b.name();
+      });
   }
   return topAccts;
 }
 
-Accounts Parser::allAccounts(bool sort) const {
-  std::map<std::string, Accounts> tmp;
-  Accounts all;
-  for(int i=0;i<(int)accts.size();++i) {
-    const auto& a = accts[i];
-    auto tokens = split(a.name(), ':');
-    if(tmp.find(tokens[0]) == tmp.end()) tmp[tokens[0]] = Accounts();
-    auto& currAccts = tmp[tokens[0]];
-    currAccts.find(tokens[0]) += a.rawBalance();
-    auto joined = "  " + join(tokens, ':', 1);
-    currAccts.find(joined) += a.rawBalance();
+Accounts Parser::allAccounts(const std::vector<int64_t>& b, bool sort) const {
+  AccountTree tree(accts, b);
+  // all accounts under each top-level account, relative to its name
+  std::map<std::string, std::vector<std::pair<std::string, int64_t>>> tmp;
+  for(int i = 0; i < accts.size(); ++i) {
+    const auto& name = accts[i].name();
+    auto pos = name.find(':');
+    auto top = name.substr(0, pos);
+    auto rest = pos == std::string::npos ? "" : name.substr(pos + 1);
+    tmp[top].push_back({"  " + rest, i < (int)b.size() ? b[i] : 0});
   }
+  Accounts all;
   for(auto& itr : tmp) {
-    if (sort) {
-      std::sort(itr.second.begin(), itr.second.end(),
-                [](const Account& a, const Account& b) {
-                  const auto& an = a.name();
-                  const auto& bn = b.name();
-                  if (an[0] == ' ' && bn[0] != ' ') return false;
-                  if (an[0] != ' ' && bn[0] == ' ') return true;
-                  return an.compare(bn) <= 0;
-                });
+    all.push_back(Account(itr.first));
+    all.back() += tree.node(tree.lookup(itr.first)).bal;
+    auto& subs = itr.second;
+    if (sort) std::sort(subs.begin(), subs.end());
+    for(const auto& s : subs) {
+      all.push_back(Account(s.first));
+      all.back() += s.second;
     }
-    for(const auto& a : itr.second) all.find(a.name()) += a.rawBalance();
   }
   return all;
 }
 
 void Parser::minmaxDates(TimePoint& min, TimePoint& max) const {
-  bool first = true;
-  for(const auto& t : trans) {
-    if(first || t.date() < min) min = t.date();
-    if(first || max < t.date()) max = t.date();
-    first = false;
-  }
+  store().minmaxDates(min, max);
 }
 
 } // end namespace ledger
@@ -1,19 +1,53 @@
 #pragma once
 
+#include <memory>
 #include "objects.h"
+#include "store.h"
 #include "core/time_utils.h"
+#include "core/buffer.h"
 
 namespace teditor {
 namespace ledger {
 
-/** Poor man's ledger parser! */
+/**
+ * @brief Poor man's ledger parser!
+ *
+ * The ledger text is split into chunks, each being a non-indented line (an
+ * account definition, a transaction or something unknown) along with all the
+ * indented, empty or comment lines following it. Line range and a hash of the
+ * contents of every chunk are remembered, so that when the ledger is updated
+ * from a buffer, only the chunks which have changed since the last update are
+ * re-parsed and the balances are adjusted by their delta.
+ */
 class Parser {
 public:
+  /** parses the given ledger file from the disk */
   Parser(const std::string& f);
+  /** an empty ledger, to be populated later via `update` */
+  Parser();
 
+  /** re-parses the whole file from the disk */
   void reload();
+
+  /**
+   * @brief Brings the ledger in sync with the contents of the given buffer
+   * @param buf the buffer containing the ledger text
+   * @return true if anything had changed since the last update
+   * @note If any account definitions are touched or an account ends up with no
+   * postings, the whole ledger is rebuilt instead
+   */
+  bool update(const Buffer& buf);
+
+  /** hash of the ledger text as of the last update */
+  uint64_t fingerprint() const { return fprint; }
+  /** number of chunks that were parsed during the last update */
+  int lastParsed() const { return nParsed; }
   const Transactions& transactions() const { return trans; }
   const Accounts& accounts() const { return accts; }
+  /** balances of all accounts, indexed by their ids */
+  const std::vector<int64_t>& balances() const { return bals; }
+  /** date sorted store of the transactions, built lazily after each change */
+  const TransactionStore& store() const;
 
   /**
    * @brief Computes balances of only the top-level accounts.
@@ -23,24 +57,56 @@ public:
    * @param sort whether to sort the output before returning
    * @return the accounts
    */
-  Accounts topAccounts(bool sort = true) const;
+  Accounts topAccounts(bool sort = true) const {
+    return topAccounts(bals, sort);
+  }
+  /** same as above, but with the given balances (indexed by account ids) */
+  Accounts topAccounts(const std::vector<int64_t>& b, bool sort = true) const;
 
   /**
    * @brief Computes balances of the top-level accounts as well as all accounts
    * @param sort whether to sort the output before returning
    * @return all the accounts
    */
-  Accounts allAccounts(bool sort = true) const;
+  Accounts allAccounts(bool sort = true) const {
+    return allAccounts(bals, sort);
+  }
+  /** same as above, but with the given balances (indexed by account ids) */
+  Accounts allAccounts(const std::vector<int64_t>& b, bool sort = true) const;
 
   /** earliest and latest transaction dates */
   void minmaxDates(TimePoint& min, TimePoint& max) const;
 
 private:
+  /** a chunk of the ledger text, parsed independently of the others */
+  struct Chunk {
+    /** line range [start, end) of this chunk */
+    int start, end;
+    /** hash of its contents */
+    uint64_t hash;
+    /** number of transactions and account definitions found in it */
+    int nTrans, nAccts;
+  };
+
   std::string file;
   Transactions trans;
   Accounts accts;
+  std::vector<int64_t> bals;
+  /** number of postings referring to each account */
+  std::vector<int> refs;
+  /** accounts with ids less than this are the defined ones */
+  int nDefined;
+  std::vector<Chunk> chunks;
+  uint64_t fprint;
+  int nParsed;
+  mutable std::unique_ptr<TransactionStore> st;
 
   void parse(const std::string& f);
+  void clear();
+  /** rebuilds the whole ledger from the given chunks */
+  void rebuild(const Buffer& buf, std::vector<Chunk>& newChunks);
+  /** adds (sign = 1) or removes (sign = -1) postings of the transaction */
+  void apply(const Transaction& t, int sign);
 };
 
 } // end namespace ledger
@@ -0,0 +1,71 @@
+#include "store.h"
+#include <algorithm>
+#include "core/utils.h"
+
+namespace teditor {
+namespace ledger {
+
+TransactionStore::TransactionStore(const Transactions& trans,
+                                   const Accounts& accts):
+  dates(), payees(), payeeNames(), payeeIds(), starts(), accounts(),
+  amounts() {
+  int n = (int)trans.size();
+  // stable, so that transactions on the same day remain in the ledger order
+  std::vector<int> order(n);
+  for(int i = 0; i < n; ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&trans](int a, int b) {
+      return trans[a].date() < trans[b].date();
+    });
+  size_t nPostings = 0;
+  for(const auto& t : trans) nPostings += t.postings().size();
+  dates.reserve(n);
+  payees.reserve(n);
+  starts.reserve(n + 1);
+  accounts.reserve(nPostings);
+  amounts.reserve(nPostings);
+  for(auto i : order) {
+    const auto& t = trans[i];
+    dates.push_back(t.date());
+    auto itr = payeeIds.find(t.name());
+    if(itr == payeeIds.end()) {
+      itr = payeeIds.emplace(t.name(), numPayees()).first;
+      payeeNames.push_back(t.name());
+    }
+    payees.push_back(itr->second);
+    starts.push_back((int)accounts.size());
+    for(const auto& p : t.postings()) {
+      int id = accts.lookup(p.first);
+      ASSERT(id >= 0, "TransactionStore: unknown account '%s'!",
+             p.first.c_str());
+      accounts.push_back(id);
+      amounts.push_back(p.second);
+    }
+  }
+  starts.push_back((int)accounts.size());
+}
+
+std::pair<int, int> TransactionStore::range(const TimePoint& from,
+                                            const TimePoint& to) const {
+  auto start = std::lower_bound(dates.begin(), dates.end(), from);
+  auto end = std::lower_bound(start, dates.end(), to);
+  return {int(start - dates.begin()), int(end - dates.begin())};
+}
+
+void TransactionStore::sum(int start, int end,
+                           std::vector<int64_t>& bals) const {
+  if(start >= end) return;
+  for(int p = starts[start]; p < starts[end]; ++p) {
+    int id = accounts[p];
+    if(id >= (int)bals.size()) bals.resize(id + 1, 0);
+    bals[id] += amounts[p];
+  }
+}
+
+void TransactionStore::minmaxDates(TimePoint& min, TimePoint& max) const {
+  if(empty()) return;
+  min = dates.front();
+  max = dates.back();
+}
+
+} // end namespace ledger
+} // end namespace teditor
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+#include "objects.h"
+#include "core/time_utils.h"
+
+namespace teditor {
+namespace ledger {
+
+/**
+ * @brief Columnar, read-only store of all the transactions in a ledger, sorted
+ * by their dates. Each transaction is identified by its row in this store.
+ * Payees are interned and the postings of all transactions are kept in flat
+ * arrays, with the accounts referred to by their ids in `Accounts`.
+ */
+class TransactionStore {
+public:
+  /**
+   * @brief ctor
+   * @param trans the transactions (need not be sorted)
+   * @param accts accounts of the ledger. Every posting must refer to one
+   */
+  TransactionStore(const Transactions& trans, const Accounts& accts);
+
+  int size() const { return (int)dates.size(); }
+  bool empty() const { return dates.empty(); }
+
+  const TimePoint& date(int row) const { return dates[row]; }
+  int payee(int row) const { return payees[row]; }
+  const std::string& payeeName(int id) const { return payeeNames[id]; }
+  int numPayees() const { return (int)payeeNames.size(); }
+
+  /** postings of a row are in the range [postingStart(row), postingEnd(row)) */
+  int postingStart(int row) const { return starts[row]; }
+  int postingEnd(int row) const { return starts[row + 1]; }
+  int postingAccount(int p) const { return accounts[p]; }
+  int64_t postingAmount(int p) const { return amounts[p]; }
+
+  /** range of rows [start, end) whose dates are in the range [from, to) */
+  std::pair<int, int> range(const TimePoint& from, const TimePoint& to) const;
+
+  /**
+   * @brief accumulates the net change of each account over the rows
+   * [start, end) into `bals`, indexed by account ids and grown as needed
+   */
+  void sum(int start, int end, std::vector<int64_t>& bals) const;
+
+  /** earliest and latest transaction dates. Untouched if the store is empty */
+  void minmaxDates(TimePoint& min, TimePoint& max) const;
+
+private:
+  std::vector<TimePoint> dates;
+  std::vector<int> payees;
+  std::vector<std::string> payeeNames;
+  std::unordered_map<std::string, int> payeeIds;
+  /** offsets of the postings of each row, with one extra at the end */
+  std::vector<int> starts;
+  std::vector<int> accounts;
+  std::vector<int64_t> amounts;
+};
+
+} // end namespace ledger
+} // end namespace teditor
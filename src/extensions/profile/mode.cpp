@@ -0,0 +1,79 @@
+#include "mode.h"
+#include "core/option.h"
+#include "core/profiler.h"
+
+namespace teditor {
+namespace profile {
+
+// number of lines before the table of probes
+static const int HeaderLines = 4;
+
+ProfileMode::ProfileMode():
+  readonly::ReadOnlyMode("profile"),
+  refreshMs(Option::get("profile:refreshMs").getInt()), lastRefresh() {
+  if (buildingTables()) {
+    populateKeyMap<ProfileMode::Keys>(getKeyCmdMap());
+    populateColorMap<ProfileMode::Colors>(getColorMap());
+  }
+}
+
+Strings ProfileMode::cmdNames() const {
+  return allCmdNames([](const std::string& name) {
+    return (name[0] != '.' && name.find("profile::") == 0) ||
+      (name == "profile");
+  });
+}
+
+void ProfileMode::beforeDraw(Buffer& buf) {
+  auto now = std::chrono::steady_clock::now();
+  if (now - lastRefresh < std::chrono::milliseconds(refreshMs)) return;
+  refresh(buf);
+}
+
+void ProfileMode::refresh(Buffer& buf) {
+  buf.replaceLines(0, buf.length(), report(refreshMs));
+  lastRefresh = std::chrono::steady_clock::now();
+}
+
+Strings ProfileMode::report(int refreshMs) {
+  Strings ret;
+  ret.push_back(format("Profile (refreshed every %d ms, probes %s)", refreshMs,
+                       Profiler::isEnabled() ? "enabled" : "disabled"));
+  ret.push_back("");
+  ret.push_back(format("%-16s %10s %11s %9s %9s %9s %9s %10s", "Probe",
+                       "Count", "Total(ms)", "Mean(us)", "p50(us)", "p90(us)",
+                       "p99(us)", "Max(us)"));
+  ret.push_back(std::string(ret.back().size(), '-'));
+  for (const auto& ps : Profiler::summary()) {
+    ret.push_back(format("%-16s %10lu %11.2f %9.1f %9.1f %9.1f %9.1f %10.1f",
+                         ps.name.c_str(), ps.count, ps.totalMs, ps.meanUs,
+                         ps.p50Us, ps.p90Us, ps.p99Us, ps.maxUs));
+  }
+  if (StartupTimeline::phases().empty()) return ret;
+  ret.push_back("");
+  for (const auto& line : StartupTimeline::report()) ret.push_back(line);
+  return ret;
+}
+
+void ProfileMode::getColorFor(AttrColor& fg, AttrColor& bg, int lineNum,
+                              int pos, const Buffer& b, bool isHighlighted) {
+  ReadOnlyMode::getColorFor(fg, bg, lineNum, pos, b, isHighlighted);
+  if (isHighlighted || lineNum >= HeaderLines - 1) return;
+  fg = getColorMap().get(Slot_titlefg);
+}
+
+REGISTER_MODE(ProfileMode, "profile");
+
+
+std::vector<KeyCmdPair> ProfileMode::Keys::All = {
+  {"g", "profile::refresh"},
+  {"r", "profile::reset"},
+  {"t", "profile::toggle"},
+};
+
+std::vector<NameColorPair> ProfileMode::Colors::All = {
+  {"titlefg", "Bold:Red"},
+};
+
+}  // end namespace profile
+}  // end namespace teditor
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../base/readonly.h"
+#include "core/buffer.h"
+#include <chrono>
+
+namespace teditor {
+namespace profile {
+
+/** profile mode, showing the latencies of all the probes live */
+class ProfileMode: public readonly::ReadOnlyMode {
+ public:
+  ProfileMode();
+
+  Strings cmdNames() const;
+
+  static Mode* create() { return new ProfileMode; }
+  static bool modeCheck(const std::string& file) { return file == "*profile*"; }
+
+  void getColorFor(AttrColor& fg, AttrColor& bg, int lineNum, int pos,
+                   const Buffer& b, bool isHighlighted);
+
+  /** refreshes the contents, if they are older than the refresh interval */
+  void beforeDraw(Buffer& buf);
+
+  /** refreshes the contents of the buffer right away */
+  void refresh(Buffer& buf);
+
+  /** the table of all the probes' stats, as it is shown in the buffer */
+  static Strings report(int refreshMs);
+
+ private:
+  struct Keys { static std::vector<KeyCmdPair> All; };
+  struct Colors { static std::vector<NameColorPair> All; };
+
+  int refreshMs;
+  std::chrono::steady_clock::time_point lastRefresh;
+};  // class ProfileMode
+
+}  // namespace profile
+}  // namespace teditor
@@ -0,0 +1,81 @@
+#include "core/editor.h"
+#include "core/command.h"
+#include "core/profiler.h"
+#include "mode.h"
+
+namespace teditor {
+namespace profile {
+namespace ops {
+
+/**
+ * @page profile_ops profile-mode
+ * All operations supported under `profile-mode`.
+ *
+ * @tableofcontents
+ *
+ * @section profile profile
+ * Opens the `*profile*` Buffer, which shows the latency statistics (count,
+ * total time, mean, 50th/90th/99th percentiles and max) of all the probes
+ * placed in the hot paths of the editor, like drawing, rendering, command
+ * dispatch, file load/save and regex matching. Its contents are refreshed
+ * every `profile:refreshMs` while it is being displayed. Whether these probes
+ * collect samples or not is controlled by the Option `profile:enable`.
+ *
+ * @note Available since v1.9.0.
+ *
+ *
+ * @section profile_refresh profile::refresh
+ * Refreshes the contents of the `*profile*` Buffer right away.
+ *
+ * @note Available since v1.9.0.
+ *
+ *
+ * @section profile_reset profile::reset
+ * Clears all the samples collected so far.
+ *
+ * @note Available since v1.9.0.
+ *
+ *
+ * @section profile_toggle profile::toggle
+ * Enables/disables the collection of samples by the probes.
+ *
+ * @note Available since v1.9.0.
+ */
+
+Buffer& getProfileBuff(Editor& ed) {
+  bool newOne;
+  auto& buf = ed.getBuff("*profile*", true, newOne);
+  if (newOne)
+    buf.setMode(Mode::createMode(Mode::inferMode(buf.bufferName(), false)));
+  return buf;
+}
+
+void refresh(Editor& ed) {
+  auto& buf = getProfileBuff(ed);
+  buf.getMode<ProfileMode>("profile")->refresh(buf);
+}
+
+DEF_CMD(Profile, "profile", "profile_ops", DEF_OP() {
+    refresh(ed);
+    ed.switchToBuff("*profile*");
+  });
+
+DEF_CMD(ProfileRefresh, "profile::refresh", "profile_ops",
+        DEF_OP() { refresh(ed); });
+
+DEF_CMD(ProfileReset, "profile::reset", "profile_ops", DEF_OP() {
+    Profiler::reset();
+    refresh(ed);
+    CMBAR_MSG(ed, "Profile samples cleared\n");
+  });
+
+DEF_CMD(ProfileToggle, "profile::toggle", "profile_ops", DEF_OP() {
+    Profiler::setEnabled(!Profiler::isEnabled());
+    refresh(ed);
+    CMBAR_MSG(ed, "Profiling %s\n",
+              Profiler::isEnabled() ? "enabled" : "disabled");
+  });
+
+}  // end namespace ops
+}  // end namespace profile
+}  // end namespace teditor
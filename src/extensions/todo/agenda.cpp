@@ -0,0 +1,83 @@
+#include "agenda.h"
+#include <functional>
+#include <sstream>
+#include <sys/stat.h>
+#include "core/file_utils.h"
+#include "core/utils.h"
+
+namespace teditor {
+namespace todo {
+
+const int Agenda::MaxViews;
+
+Agenda::Agenda(const std::string& f):
+  file(isAbs(f) ? f : rel2abs(getpwd(), f)), mtime(-1), size(-1), hash(0), p(),
+  views() {
+  refresh();
+}
+
+bool Agenda::refresh() {
+  struct stat st;
+  ASSERT(stat(file.c_str(), &st) == 0, "'stat' failed on '%s'!",
+         file.c_str());
+  int64_t mt = int64_t(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+  if (p && mt == mtime && int64_t(st.st_size) == size) return false;
+  // a mere touch of the file should not throw away the cached views
+  auto h = std::hash<std::string>()(slurp(file));
+  bool changed = !p || h != hash;
+  if (changed) {
+    // stamps are updated only after a successful parse, to retry next time
+    if (p) p->reload();
+    else p.reset(new Parser(file));
+    views.clear();
+  }
+  mtime = mt;
+  size = int64_t(st.st_size);
+  hash = h;
+  return changed;
+}
+
+const std::string& Agenda::range(const TimePoint& start,
+                                 const TimePoint& end) {
+  refresh();
+  auto key = timeToStr(start) + ".." + timeToStr(end);
+  auto itr = views.find(key);
+  if (itr != views.end()) return itr->second;
+  auto title = "# TODO's for " + timeToDateStr(start) + " to " +
+    timeToDateStr(end);
+  return render(key, title, p->index().findMatchesIn(start, end));
+}
+
+const std::string& Agenda::next(const TimePoint& from, int count) {
+  refresh();
+  auto key = timeToStr(from) + "+" + std::to_string(count);
+  auto itr = views.find(key);
+  if (itr != views.end()) return itr->second;
+  auto title = "# Next " + std::to_string(count) + " TODO's from " +
+    timeToDateStr(from);
+  return render(key, title, p->index().nextOccurences(from, count));
+}
+
+const std::string& Agenda::render(const std::string& key,
+                                  const std::string& title,
+                                  const CalendarMatches& matches) {
+  std::stringstream ss;
+  ss << title
+     << "\n###############################################################\n\n";
+  const auto& items = p->items();
+  if (matches.empty()) {
+    ss << "NONE\n";
+  } else {
+    for (const auto& m : matches) {
+      ss << timeToDateStr(m.pt) << " ---> " << items[m.idx].description
+         << "\n";
+    }
+  }
+  if ((int)views.size() >= MaxViews) views.clear();
+  auto& ret = views[key];
+  ret = ss.str();
+  return ret;
+}
+
+} // end namespace todo
+} // end namespace teditor
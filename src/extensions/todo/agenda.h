@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+#include "parser.h"
+
+namespace teditor {
+namespace todo {
+
+/**
+ * @brief Agenda views of a todo file. The file is parsed only when its mtime
+ * or contents change and the views computed since then are cached.
+ */
+class Agenda {
+public:
+  Agenda(const std::string& f);
+
+  /** re-parses the file if it has changed. Returns true if it was re-parsed */
+  bool refresh();
+
+  /** agenda of all the todo's in the range [start, end] */
+  const std::string& range(const TimePoint& start, const TimePoint& end);
+
+  /** agenda of the next 'count' todo's at or after the given time point */
+  const std::string& next(const TimePoint& from, int count);
+
+  const std::string& fileName() const { return file; }
+  const Parser& parser() const { return *p; }
+  /** number of views currently cached */
+  int numCached() const { return (int)views.size(); }
+
+  /** max number of views cached, beyond which the cache is started afresh */
+  static const int MaxViews = 64;
+
+private:
+  std::string file;
+  /** modification time (in ns) and size of the file, as of the last refresh */
+  int64_t mtime, size;
+  /** hash of the contents of the file, as of the last refresh */
+  size_t hash;
+  std::unique_ptr<Parser> p;
+  std::unordered_map<std::string, std::string> views;
+
+  const std::string& render(const std::string& key, const std::string& title,
+                            const CalendarMatches& matches);
+};
+
+} // end namespace todo
+} // end namespace teditor
@@ -27,8 +27,10 @@ REGISTER_MODE(TodoMode, "todo");
 class TodoShowMode: public readonly::ReadOnlyMode {
  public:
   TodoShowMode(): readonly::ReadOnlyMode("todo-show") {
-    populateKeyMap<TodoShowMode::Keys>(getKeyCmdMap());
-    populateColorMap<TodoShowMode::Colors>(getColorMap());
+    if (buildingTables()) {
+      populateKeyMap<TodoShowMode::Keys>(getKeyCmdMap());
+      populateColorMap<TodoShowMode::Colors>(getColorMap());
+    }
   }
 
   static Mode* create() { return new TodoShowMode; }
@@ -39,7 +41,13 @@ class TodoShowMode: public readonly::ReadOnlyMode {
   struct Colors { static std::vector<NameColorPair> All; };
 };  // class TodoShowMode
 
-std::vector<KeyCmdPair> TodoShowMode::Keys::All = {};
+std::vector<KeyCmdPair> TodoShowMode::Keys::All = {
+  {"m", "todo-show-this-month"},
+  {"n", "todo-show-next"},
+  {"Q", "todo-show-this-quarter"},
+  {"w", "todo-show-this-week"},
+  {"y", "todo-show-this-year"},
+};
 
 std::vector<NameColorPair> TodoShowMode::Colors::All = {};
 
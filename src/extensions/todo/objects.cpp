@@ -4,10 +4,15 @@
 #include "core/time_utils.h"
 #include <iostream>
 #include <algorithm>
+#include <queue>
+#include <thread>
 
 namespace teditor {
 namespace todo {
 
+/** occurrences are expanded in parallel only beyond these many items/thread */
+static const size_t MinItemsPerThread = 256;
+
 RepeatType strToRepeatType(const std::string& str) {
   const auto* cstr = str.c_str();
   if (!strcmp(cstr, "none") || str.empty()) return Repeat_None;
@@ -45,12 +50,62 @@ TimePoint CalendarItem::getNextOccurence(const TimePoint& pt) const {
   ASSERT(false, "Incorrect RepeatType passed '%d'!", repeat);
 }
 
+TimePoint CalendarItem::getFirstOccurenceFrom(const TimePoint& pt) const {
+  ASSERT(hasStart, "CalendarItem does not have a start point!");
+  if (repeat == Repeat_None || pt <= start) return start;
+  if (repeat == Repeat_Daily || repeat == Repeat_Weekly) {
+    // these repeat at fixed intervals
+    int64_t period = repeat == Repeat_Daily ? 24 * 60 * 60 : 7 * 24 * 60 * 60;
+    auto diff = std::chrono::duration_cast<std::chrono::seconds>(pt - start);
+    int64_t times = (diff.count() + period - 1) / period;
+    return start + std::chrono::seconds(times * period);
+  }
+  auto s = toStructTm(start);
+  // stepping one month at a time from days beyond 28 (or one year at a time
+  // from Feb 29) keeps drifting the day of the month, which can't be computed
+  // in closed form. These are rare and have only 12 occurrences a year at most
+  bool drifts = repeat == Repeat_Monthly ? s.tm_mday > 28 :
+    s.tm_mon == 1 && s.tm_mday == 29;
+  auto ret = start;
+  if (!drifts) {
+    auto q = toStructTm(pt);
+    // start from the occurrence just before the month/year of 'pt'
+    int times = repeat == Repeat_Monthly ?
+      (q.tm_year - s.tm_year) * 12 + q.tm_mon - s.tm_mon - 1 :
+      q.tm_year - s.tm_year - 1;
+    if (times > 0) {
+      if (repeat == Repeat_Monthly) s.tm_mon += times;
+      else s.tm_year += times;
+      s.tm_isdst = -1;
+      ret = toTimePoint(s);
+    }
+  }
+  while (ret < pt) ret = getNextOccurence(ret);
+  return ret;
+}
+
 bool compareMatches(const MatchItem& a, const MatchItem& b) {
   if (a.pt < b.pt) return true;
   if (a.pt > b.pt) return false;
   return a.idx < b.idx;
 }
 
+/** appends all occurrences of the item in [start, end] to the matches */
+void addMatches(const CalendarItem& item, int idx, const TimePoint& start,
+                const TimePoint& end, CalendarMatches& ret) {
+  if (!item.hasStart) return;
+  auto pt = item.getFirstOccurenceFrom(start);
+  while (pt <= end) {
+    if (item.hasEnd && pt > item.end) break;
+    if (pt >= start) {
+      MatchItem mi{idx, pt};
+      ret.push_back(mi);
+    }
+    if (item.repeat == Repeat_None) break;
+    pt = item.getNextOccurence(pt);
+  }
+}
+
 CalendarMatches findMatchesIn(const CalendarItems& items,
                               const TimePoint& start, const TimePoint& end) {
   ASSERT(start <= end, "findMatchesIn: start time is greater than end!");
@@ -58,21 +113,145 @@ CalendarMatches findMatchesIn(const CalendarItems& items,
   int idx = -1;
   for (const auto& item : items) {
     ++idx;
-    if (!item.hasStart) continue;
-    auto pt = item.start;
-    while (pt <= end) {
-      if (item.hasEnd && pt > item.end) break;
-      if (pt >= start) {
-        MatchItem mi{idx, pt};
-        ret.push_back(mi);
-      }
-      if (item.repeat == Repeat_None) break;
-      pt = item.getNextOccurence(pt);
-    }
+    addMatches(item, idx, start, end, ret);
   }
   std::sort(ret.begin(), ret.end(), compareMatches);
   return ret;
 }
 
+
+void CalendarIndex::build(const CalendarItems& its) {
+  items = &its;
+  ids.clear();
+  for (int i = 0; i < (int)its.size(); ++i)
+    if (its[i].hasStart) ids.push_back(i);
+  std::stable_sort(ids.begin(), ids.end(), [&its](int a, int b) {
+      return its[a].start < its[b].start;
+    });
+  starts.clear();
+  ends.clear();
+  for (auto id : ids) {
+    const auto& item = its[id];
+    starts.push_back(item.start);
+    if (item.repeat == Repeat_None) ends.push_back(item.start);
+    else if (item.hasEnd) ends.push_back(item.end);
+    else ends.push_back(TimePoint::max());
+  }
+  maxEnds.resize(ids.size());
+  buildMax(0, (int)ids.size());
+}
+
+TimePoint CalendarIndex::buildMax(int lo, int hi) {
+  if (lo >= hi) return TimePoint::min();
+  int mid = lo + (hi - lo) / 2;
+  auto ret = std::max(ends[mid], std::max(buildMax(lo, mid),
+                                          buildMax(mid + 1, hi)));
+  maxEnds[mid] = ret;
+  return ret;
+}
+
+void CalendarIndex::query(int lo, int hi, const TimePoint& start,
+                          const TimePoint& end, std::vector<int>& out) const {
+  if (lo >= hi) return;
+  int mid = lo + (hi - lo) / 2;
+  // nothing in this subtree lives till 'start'
+  if (maxEnds[mid] < start) return;
+  query(lo, mid, start, end, out);
+  // everything to the right starts only after 'end'
+  if (starts[mid] > end) return;
+  if (ends[mid] >= start) out.push_back(ids[mid]);
+  query(mid + 1, hi, start, end, out);
+}
+
+std::vector<int> CalendarIndex::overlaps(const TimePoint& start,
+                                         const TimePoint& end) const {
+  std::vector<int> ret;
+  query(0, (int)ids.size(), start, end, ret);
+  return ret;
+}
+
+CalendarMatches mergeMatches(const std::vector<CalendarMatches>& lists) {
+  // (list, position) of the next match to be picked from each list
+  typedef std::pair<size_t, size_t> Cursor;
+  auto greater = [&lists](const Cursor& a, const Cursor& b) {
+    return compareMatches(lists[b.first][b.second], lists[a.first][a.second]);
+  };
+  std::priority_queue<Cursor, std::vector<Cursor>, decltype(greater)>
+    heap(greater);
+  size_t total = 0;
+  for (size_t i = 0; i < lists.size(); ++i) {
+    if (!lists[i].empty()) heap.push(Cursor(i, 0));
+    total += lists[i].size();
+  }
+  CalendarMatches ret;
+  ret.reserve(total);
+  while (!heap.empty()) {
+    auto c = heap.top();
+    heap.pop();
+    ret.push_back(lists[c.first][c.second]);
+    if (++c.second < lists[c.first].size()) heap.push(c);
+  }
+  return ret;
+}
+
+CalendarMatches CalendarIndex::findMatchesIn(const TimePoint& start,
+                                             const TimePoint& end,
+                                             unsigned maxThreads) const {
+  ASSERT(start <= end, "findMatchesIn: start time is greater than end!");
+  CalendarMatches ret;
+  if (items == nullptr) return ret;
+  auto idxs = overlaps(start, end);
+  if (maxThreads == 0) maxThreads = numThreads();
+  size_t nThreads = std::min((size_t)std::max(maxThreads, 1U),
+                             idxs.size() / MinItemsPerThread);
+  if (nThreads <= 1) {
+    for (auto idx : idxs) addMatches((*items)[idx], idx, start, end, ret);
+    std::sort(ret.begin(), ret.end(), compareMatches);
+    return ret;
+  }
+  // items are dealt out round-robin, to balance the long-lived ones (which are
+  // clustered at the beginning) across the shards
+  std::vector<CalendarMatches> shards(nThreads);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < nThreads; ++i) {
+    workers.emplace_back([this, i, nThreads, &idxs, &shards, &start, &end]() {
+        auto& shard = shards[i];
+        for (size_t j = i; j < idxs.size(); j += nThreads)
+          addMatches((*items)[idxs[j]], idxs[j], start, end, shard);
+        std::sort(shard.begin(), shard.end(), compareMatches);
+      });
+  }
+  for (auto& w : workers) w.join();
+  return mergeMatches(shards);
+}
+
+CalendarMatches CalendarIndex::nextOccurences(const TimePoint& from,
+                                              int count) const {
+  CalendarMatches ret;
+  if (items == nullptr || count <= 0) return ret;
+  // each item is a sorted stream of occurrences, which are k-way merged
+  auto greater = [](const MatchItem& a, const MatchItem& b) {
+    return compareMatches(b, a);
+  };
+  std::priority_queue<MatchItem, std::vector<MatchItem>, decltype(greater)>
+    heap(greater);
+  auto push = [this, &heap](int idx, const TimePoint& pt) {
+    const auto& item = (*items)[idx];
+    if (!item.hasEnd || pt <= item.end) heap.push(MatchItem{idx, pt});
+  };
+  for (auto idx : overlaps(from, TimePoint::max())) {
+    auto pt = (*items)[idx].getFirstOccurenceFrom(from);
+    if (pt >= from) push(idx, pt);
+  }
+  while (!heap.empty() && (int)ret.size() < count) {
+    auto m = heap.top();
+    heap.pop();
+    ret.push_back(m);
+    const auto& item = (*items)[m.idx];
+    if (item.repeat != Repeat_None) push(m.idx, item.getNextOccurence(m.pt));
+  }
+  return ret;
+}
+
 }  // namespace todo
 }  // namespace teditor
@@ -31,6 +31,12 @@ struct CalendarItem {
                const std::string& d);
   void clear();
   TimePoint getNextOccurence(const TimePoint& pt) const;
+  /**
+   * @brief Computes the earliest occurrence of this item at or after the given
+   * time point directly, without stepping through all the ones before it.
+   * Non-repeating items always return their start. Any end date is ignored.
+   */
+  TimePoint getFirstOccurenceFrom(const TimePoint& pt) const;
 };  // struct CalendarItem
 
 struct MatchItem {
@@ -44,5 +50,62 @@ typedef std::vector<MatchItem> CalendarMatches;
 CalendarMatches findMatchesIn(const CalendarItems& items,
                               const TimePoint& start, const TimePoint& end);
 
+/** merges the individually sorted lists of matches into one sorted list */
+CalendarMatches mergeMatches(const std::vector<CalendarMatches>& lists);
+
+/**
+ * @brief Static interval index over a list of calendar items, to quickly find
+ * the ones which are active in a given time range. The index refers to the
+ * items passed to it, so it must not outlive them.
+ */
+class CalendarIndex {
+public:
+  CalendarIndex(): items(nullptr), ids(), starts(), ends(), maxEnds() {}
+  CalendarIndex(const CalendarItems& its): items(nullptr), ids(), starts(),
+                                          ends(), maxEnds() {
+    build(its);
+  }
+
+  /** (re)builds the index over the given items */
+  void build(const CalendarItems& its);
+
+  /**
+   * @brief indices of the items whose lifetime overlaps with [start, end],
+   * in the increasing order of their start
+   */
+  std::vector<int> overlaps(const TimePoint& start, const TimePoint& end) const;
+
+  /**
+   * @brief same as the `findMatchesIn` function, but only looks at the
+   * overlapping items. With lots of them, their occurrences are expanded in
+   * parallel, across multiple threads, and the results are k-way merged.
+   * @param maxThreads max threads to be used (0 for all available)
+   */
+  CalendarMatches findMatchesIn(const TimePoint& start, const TimePoint& end,
+                                unsigned maxThreads = 0) const;
+
+  /**
+   * @brief first 'count' occurrences at or after the given time point, sorted
+   * the same way as the `findMatchesIn` function
+   */
+  CalendarMatches nextOccurences(const TimePoint& from, int count) const;
+
+private:
+  const CalendarItems* items;
+  /** item indices, sorted by their start */
+  std::vector<int> ids;
+  /** start and end of the lifetime of the above items */
+  std::vector<TimePoint> starts, ends;
+  /**
+   * max of `ends` in each subtree of the implicit binary tree formed by
+   * recursively splitting the above arrays at their middle
+   */
+  std::vector<TimePoint> maxEnds;
+
+  TimePoint buildMax(int lo, int hi);
+  void query(int lo, int hi, const TimePoint& start, const TimePoint& end,
+             std::vector<int>& out) const;
+};  // class CalendarIndex
+
 }  // namespace todo
 }  // namespace teditor
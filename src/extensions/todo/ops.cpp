@@ -1,9 +1,9 @@
 #include "core/editor.h"
 #include "core/command.h"
 #include "core/option.h"
-#include <sstream>
+#include <memory>
 #include "core/time_utils.h"
-#include "parser.h"
+#include "agenda.h"
 #include "objects.h"
 
 namespace teditor {
@@ -29,6 +29,34 @@ namespace ops {
  * Sunday.
  *
  * @note Available since v1.8.0.
+ *
+ *
+ * @section todo-show-this-month
+ * Show all todo's to be done in the current month.
+ *
+ * @note Available since v1.9.0.
+ *
+ *
+ * @section todo-show-this-quarter
+ * Show all todo's to be done in the current quarter of the year.
+ *
+ * @note Available since v1.9.0.
+ *
+ *
+ * @section todo-show-this-year
+ * Show all todo's to be done in the current year.
+ *
+ * @note Available since v1.9.0.
+ *
+ *
+ * @section todo-show-next
+ * Prompts for a count and shows those many upcoming todo's, starting from
+ * today.
+ *
+ * @note Available since v1.9.0.
+ *
+ *
+ * All of the above views are cached until the todo file is modified.
  */
 
 Buffer& getTodoShowBuff(Editor& ed) {
@@ -44,24 +72,27 @@ DEF_CMD(TodoOpen, "todo-open", "ledger_ops", DEF_OP() {
     ed.load(todoFile, 0);
   });
 
-void showTodosFor(Buffer& buf, const TimePoint& start, const TimePoint& end) {
+/** agenda of the current todo file, which is kept across the calls */
+Agenda& getAgenda() {
+  static std::unique_ptr<Agenda> agenda;
   auto todoFile = Option::get("todo:file").getStr();
-  Parser p(todoFile);
+  auto file = isAbs(todoFile) ? todoFile : rel2abs(getpwd(), todoFile);
+  if (!agenda || agenda->fileName() != file) agenda.reset(new Agenda(file));
+  return *agenda;
+}
+
+void showTodosFor(Buffer& buf, const TimePoint& start, const TimePoint& end) {
+  const auto& text = getAgenda().range(start, end);
   buf.clear();
-  std::stringstream ss;
-  ss << "# TODO's for " << timeToDateStr(start) << " to " << timeToDateStr(end)
-     << "\n###############################################################\n\n";
-  const auto& items = p.items();
-  auto matches = findMatchesIn(items, start, end);
-  if (matches.empty()) {
-    ss << "NONE\n";
-  } else {
-    for (const auto& m : matches) {
-      ss << timeToDateStr(m.pt) << " ---> " << items[m.idx].description
-         << "\n";
-    }
-  }
-  buf.insert(ss.str());
+  buf.insert(text);
+}
+
+/** beginning of the current day */
+TimePoint today() {
+  auto t = toStructTm(std::chrono::system_clock::now());
+  t.tm_hour = t.tm_min = t.tm_sec = 0;
+  t.tm_isdst = -1;
+  return toTimePoint(t);
 }
 
 DEF_CMD(TodoShowThisWeek, "todo-show-this-week", "ledger_ops", DEF_OP() {
@@ -73,6 +104,45 @@ DEF_CMD(TodoShowThisWeek, "todo-show-this-week", "ledger_ops", DEF_OP() {
     ed.switchToBuff("*todo");
   });
 
+DEF_CMD(TodoShowThisMonth, "todo-show-this-month", "ledger_ops", DEF_OP() {
+    auto& buf = getTodoShowBuff(ed);
+    TimePoint s;
+    TimePoint e;
+    monthFor(s, e, std::chrono::system_clock::now());
+    showTodosFor(buf, s, e);
+    ed.switchToBuff("*todo");
+  });
+
+DEF_CMD(TodoShowThisQuarter, "todo-show-this-quarter", "ledger_ops",
+        DEF_OP() {
+    auto& buf = getTodoShowBuff(ed);
+    TimePoint s;
+    TimePoint e;
+    quarterFor(s, e, std::chrono::system_clock::now());
+    showTodosFor(buf, s, e);
+    ed.switchToBuff("*todo");
+  });
+
+DEF_CMD(TodoShowThisYear, "todo-show-this-year", "ledger_ops", DEF_OP() {
+    auto& buf = getTodoShowBuff(ed);
+    TimePoint s;
+    TimePoint e;
+    yearFor(s, e, std::chrono::system_clock::now());
+    showTodosFor(buf, s, e);
+    ed.switchToBuff("*todo");
+  });
+
+DEF_CMD(TodoShowNext, "todo-show-next", "ledger_ops", DEF_OP() {
+    auto countStr = ed.prompt("Number of todo's: ", nullptr, nullptr, "10");
+    if (countStr.empty()) return;
+    auto count = str2num(countStr);
+    const auto& text = getAgenda().next(today(), count);
+    auto& buf = getTodoShowBuff(ed);
+    buf.clear();
+    buf.insert(text);
+    ed.switchToBuff("*todo");
+  });
+
 } // end namespace ops
 } // end namespace todo
 } // end namespace teditor
@@ -100,6 +100,7 @@ void Parser::parse(const std::string& f) {
   }
   if (curr.hasStart) items_.push_back(curr);
   curr.clear();
+  index_.build(items_);
 }
 
 } // end namespace todo
@@ -13,11 +13,14 @@ public:
   void reload() { parse(file); }
 
   const CalendarItems& items() const { return items_; }
+  /** interval index over the above items */
+  const CalendarIndex& index() const { return index_; }
 
 private:
   std::string file;
   CalendarItem curr;
   CalendarItems items_;
+  CalendarIndex index_;
 
   void parse(const std::string& f);
 };
@@ -1,7 +1,8 @@
 #include "mode.h"
 #include "core/option.h"
 #include "core/time_utils.h"
-#include <chrono>
+#include "core/line_diff.h"
+#include "scheduler.h"
 
 namespace teditor {
 namespace watch {
@@ -9,9 +10,14 @@ namespace watch {
 WatchMode::WatchMode():
   readonly::ReadOnlyMode("watch"), buf(nullptr), watchCmd(),
   defaultSleepMilliSec(Option::get("watch:defaultSleepMs").getInt()),
-  sleepMilliSec(defaultSleepMilliSec), alreadyRunning(false), runner() {
-  populateKeyMap<WatchMode::Keys>(getKeyCmdMap());
-  populateColorMap<WatchMode::Colors>(getColorMap());
+  sleepMilliSec(defaultSleepMilliSec), jobId(-1),
+  prevLines(), prevOutput(), prevError(), ranOnce(false), pending(),
+  hasPending(false), pendingMtx(), changed(),
+  highlight(Option::get("watch:highlightChanges").getBool()) {
+  if (buildingTables()) {
+    populateKeyMap<WatchMode::Keys>(getKeyCmdMap());
+    populateColorMap<WatchMode::Colors>(getColorMap());
+  }
 }
 
 Strings WatchMode::cmdNames() const {
@@ -21,45 +27,114 @@ Strings WatchMode::cmdNames() const {
 }
 
 void WatchMode::start() {
-  if (watchCmd.empty() || alreadyRunning) return;
-  alreadyRunning = true;
-  auto lambda = [&]() {
-    while (this->alreadyRunning) {
-      this->writeOutput();
-      std::this_thread::sleep_for(std::chrono::milliseconds(sleepMilliSec));
-    }
-  };
-  runner.reset(new std::thread(lambda));
+  if (watchCmd.empty() || isRunning()) return;
+  jobId = Scheduler::instance().add(buf->bufferName(), watchCmd, sleepMilliSec,
+                                    [this]() { return runCmd(); });
 }
 
 void WatchMode::start(Buffer* b, const std::string& cmd, int sleepLenMs) {
   if (cmd.empty()) return;
-  if (alreadyRunning) stop();
+  stop();
   buf = b;
   watchCmd = cmd;
+  reset();
   sleepMilliSec = sleepLenMs <= 0 ? defaultSleepMilliSec : sleepLenMs;
   start();
 }
 
 void WatchMode::stop() {
-  if (!alreadyRunning) return;
-  alreadyRunning = false;
-  runner->join();
+  if (!isRunning()) return;
+  Scheduler::instance().remove(jobId);
+  jobId = -1;
 }
 
-void WatchMode::writeOutput() {
+void WatchMode::reset() {
+  prevLines.clear();
+  prevOutput.clear();
+  prevError.clear();
+  ranOnce = false;
+  changed.clear();
+  std::lock_guard<std::mutex> lk(pendingMtx);
+  pending.clear();
+  hasPending = false;
+}
+
+// number of lines in the header, which are never highlighted
+static const int HeaderLines = 4;
+
+/** splits at newlines, while also keeping the trailing empty line */
+static Strings toLines(const std::string& str) {
+  Strings ret;
+  size_t pos = 0;
+  while (true) {
+    auto next = str.find('\n', pos);
+    if (next == std::string::npos) break;
+    ret.push_back(str.substr(pos, next - pos));
+    pos = next + 1;
+  }
+  ret.push_back(str.substr(pos));
+  return ret;
+}
+
+bool WatchMode::runCmd() {
   auto res = check_output(watchCmd);
+  bool ok = res.status == 0;
+  // nothing to do (not even a redraw) if the output hasn't changed
+  if (ranOnce && res.output == prevOutput && res.error == prevError)
+    return ok;
+  ranOnce = true;
+  prevOutput = res.output;
+  prevError = res.error;
   auto curr = currentTimeToStr();
-  buf->clear();
   auto str = format("Cmd     : %s\nRefresh : %d ms\nTime    : %s\n\n",
                     watchCmd.c_str(), sleepMilliSec, curr.c_str());
-  buf->insert(str);
-  buf->insert("## Output\n");
-  buf->insert(res.output);
-  buf->insert("\n");
-  buf->insert("## Error\n");
-  buf->insert(res.error);
-  buf->insert("\n");
+  str += "## Output\n" + res.output + "\n## Error\n" + res.error + "\n";
+  // an update not yet drawn is simply superseded by this one
+  std::lock_guard<std::mutex> lk(pendingMtx);
+  pending = toLines(str);
+  hasPending = true;
+  return ok;
+}
+
+void WatchMode::beforeDraw(Buffer& b) {
+  Strings lines;
+  {
+    std::lock_guard<std::mutex> lk(pendingMtx);
+    if (!hasPending) return;
+    lines.swap(pending);
+    hasPending = false;
+  }
+  writeOutput(b, lines);
+}
+
+void WatchMode::writeOutput(Buffer& b, Strings& lines) {
+  changed.assign(lines.size(), false);
+  // buffer out of sync with what was written last time, rewrite it fully
+  if (prevLines.empty() || b.length() != (int)prevLines.size()) {
+    b.replaceLines(0, b.length(), lines);
+    prevLines.swap(lines);
+    return;
+  }
+  // apply the hunks from the bottom, so that the earlier ones stay valid
+  auto hunks = diffLines(prevLines, lines);
+  for (auto itr = hunks.rbegin(); itr != hunks.rend(); ++itr) {
+    auto first = lines.begin() + itr->newStart;
+    b.replaceLines(itr->oldStart, itr->oldLen,
+                   Strings(first, first + itr->newLen));
+    for (int i = itr->newStart; i < itr->newStart + itr->newLen; ++i)
+      changed[i] = i >= HeaderLines;
+  }
+  prevLines.swap(lines);
+}
+
+void WatchMode::getColorFor(AttrColor& fg, AttrColor& bg, int lineNum,
+                            int pos, const Buffer& b, bool isHighlighted) {
+  ReadOnlyMode::getColorFor(fg, bg, lineNum, pos, b, isHighlighted);
+  if (isHighlighted || !highlight || lineNum >= (int)changed.size() ||
+      !changed[lineNum]) return;
+  auto& cmap = getColorMap();
+  fg = cmap.get(Slot_changedfg);
+  bg = cmap.get(Slot_changedbg);
 }
 
 REGISTER_MODE(WatchMode, "watch");
@@ -68,9 +143,13 @@ REGISTER_MODE(WatchMode, "watch");
 std::vector<KeyCmdPair> WatchMode::Keys::All = {
   {"s", "watch::stop"},
   {"r", "watch::restart"},
+  {"d", "watch::toggle-highlight"},
 };
 
-std::vector<NameColorPair> WatchMode::Colors::All = {};
+std::vector<NameColorPair> WatchMode::Colors::All = {
+  {"changedfg", "Black"},
+  {"changedbg", "Yellow"},
+};
 
 }  // end namespace watch
 }  // end namespace teditor
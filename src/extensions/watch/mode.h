@@ -2,9 +2,7 @@
 
 #include "../base/readonly.h"
 #include "core/buffer.h"
-#include <atomic>
-#include <memory>
-#include <thread>
+#include <mutex>
 
 namespace teditor {
 namespace watch {
@@ -18,7 +16,10 @@ class WatchMode: public readonly::ReadOnlyMode {
   Strings cmdNames() const;
 
   static Mode* create() { return new WatchMode; }
-  static bool modeCheck(const std::string& file) { return file == "*watch"; }
+  /** every watch job gets its own buffer: *watch, *watch_1, *watch_2, ... */
+  static bool modeCheck(const std::string& file) {
+    return file == "*watch" || file.find("*watch_") == 0;
+  }
 
   void start(Buffer* buf, const std::string& cmd,
              int sleepLenMs = 0);
@@ -26,6 +27,22 @@ class WatchMode: public readonly::ReadOnlyMode {
   void restart() { stop(); start(); }
 
   int sleepTimeMs() const { return sleepMilliSec; }
+  bool isRunning() const { return jobId >= 0; }
+  const std::string& command() const { return watchCmd; }
+
+  void getColorFor(AttrColor& fg, AttrColor& bg, int lineNum, int pos,
+                   const Buffer& b, bool isHighlighted);
+  /** applies the latest output of the command onto the buffer */
+  void beforeDraw(Buffer& b);
+  /** whether there's an output yet to be applied onto the buffer */
+  bool hasUpdate() {
+    std::lock_guard<std::mutex> lk(pendingMtx);
+    return hasPending;
+  }
+
+  /** toggles highlighting of the lines changed in the latest update */
+  void toggleHighlight() { highlight = !highlight; }
+  bool highlightChanges() const { return highlight; }
 
  private:
   struct Keys { static std::vector<KeyCmdPair> All; };
@@ -35,11 +52,29 @@ class WatchMode: public readonly::ReadOnlyMode {
   std::string watchCmd;
   int defaultSleepMilliSec;
   int sleepMilliSec;
-  std::atomic<bool> alreadyRunning;
-  std::shared_ptr<std::thread> runner;
+  /** id of this job in the Scheduler, -1 if not running */
+  int jobId;
+  /** buffer contents written in the latest update */
+  Strings prevLines;
+  /** outputs of the command in its latest run (only touched by the job) */
+  std::string prevOutput, prevError;
+  bool ranOnce;
+  /**
+   * contents produced by the job, yet to be written into the buffer. The job
+   * runs on a scheduler worker, whereas the buffer is only ever edited from
+   * the main thread in `beforeDraw`
+   */
+  Strings pending;
+  bool hasPending;
+  std::mutex pendingMtx;
+  /** whether each line of the buffer changed in the latest update */
+  std::vector<bool> changed;
+  bool highlight;
 
   void start();
-  void writeOutput();
+  bool runCmd();
+  void writeOutput(Buffer& b, Strings& lines);
+  void reset();
 };  // class WatchMode
 
 }  // namespace watch
@@ -2,6 +2,7 @@
 #include "core/command.h"
 #include "mode.h"
 #include "core/utils.h"
+#include "scheduler.h"
 
 namespace teditor {
 namespace watch {
@@ -17,19 +18,33 @@ namespace ops {
  * Prompts for a command and start a watch on it. Sleep time between successive
  * invocations of this shell command is controlled by the Option
  * `watch:defaultSleepMs`. The `stdout` and `stderr` of the command will be
- * printed in the current Buffer.
+ * printed in the watch Buffer. When invoked from inside a watch Buffer, the
+ * command being watched there gets replaced. Otherwise, a new watch Buffer is
+ * created, so that multiple commands can be watched at the same time. At most
+ * `watch:maxConcurrentJobs` commands run at any given time and a command is
+ * never run again until its previous invocation has completed. Only the lines
+ * which changed since the previous invocation are updated, so the current
+ * scroll position is retained. If the output didn't change at all, nothing is
+ * updated (including the `Time` field in the header).
  *
  * @note Available since v1.8.0.
  *
  *
  * @section watch-sleep
  * Prompts for a command and then a sleep time (in ms) and starts a watch on it.
- * The `stdout` and `stderr` of the command will be printed in the current
- * Buffer.
+ * The `stdout` and `stderr` of the command will be printed in a watch Buffer,
+ * which is chosen the same way as in `watch`.
  *
  * @note Available since v1.8.0.
  *
  *
+ * @section watch-jobs watch-jobs
+ * Lists all the currently running watch commands along with their runtime
+ * statistics, in the `*watch-jobs` Buffer.
+ *
+ * @note Available since v1.9.0.
+ *
+ *
  * @section watch_stop watch::stop
  * Stops the currently running watch command.
  *
@@ -40,25 +55,67 @@ namespace ops {
  * Restarts the previously stopped watch command.
  *
  * @note Available since v1.8.0
+ *
+ *
+ * @section watch_toggle-highlight watch::toggle-highlight
+ * Toggles the highlighting of lines which changed in the latest update (similar
+ * to `watch -d`). Its default is controlled by the Option
+ * `watch:highlightChanges`.
+ *
+ * @note Available since v1.9.0.
  */
 
+/** the current buffer if it is a watch buffer, else a new one */
 Buffer& getWatchBuff(Editor& ed) {
-  bool newOne;
-  auto& buf = ed.getBuff("*watch", true, newOne);
-  if (newOne) {
-    buf.setMode(Mode::createMode(Mode::inferMode(buf.bufferName(), false)));
+  auto& curr = ed.getBuff();
+  if (curr.modeName() == "watch") return curr;
+  std::string name("*watch");
+  for (int idx = 1; ; ++idx) {
+    bool newOne;
+    auto& buf = ed.getBuff(name, true, newOne);
+    if (newOne) {
+      buf.setMode(Mode::createMode(Mode::inferMode(buf.bufferName(), false)));
+      return buf;
+    }
+    name = "*watch_" + num2str(idx);
+  }
+}
+
+void startWatch(Editor& ed, const std::string& cmd, int sleepMs) {
+  auto& buf = getWatchBuff(ed);
+  ed.switchToBuff(buf.bufferName());
+  auto* mode = buf.getMode<watch::WatchMode>("watch");
+  mode->start(&buf, cmd, sleepMs);
+}
+
+void listJobs(Editor& ed) {
+  auto jobs = Scheduler::instance().jobs();
+  std::string str = format("Watch jobs: %d (max concurrency: %d)\n\n",
+                           (int)jobs.size(),
+                           Scheduler::instance().maxConcurrency());
+  str += format("%-12s %8s %6s %5s %9s %9s %9s %9s  %s\n", "Buffer",
+                "Period", "Runs", "Fail", "Last(ms)", "Avg(ms)", "Max(ms)",
+                "Delay(ms)", "Command");
+  for (const auto& j : jobs) {
+    const auto& st = j.stats;
+    str += format("%-12s %8d %6d %5d %9.1f %9.1f %9.1f %9.1f  %s%s\n",
+                  j.name.c_str(), j.periodMs, st.runs, st.failures, st.lastMs,
+                  st.avgMs(), st.maxMs, st.maxDelayMs, j.cmd.c_str(),
+                  j.running ? " [running]" : "");
   }
-  return buf;
+  bool newOne;
+  auto& buf = ed.getBuff("*watch-jobs", true, newOne);
+  buf.clear();
+  buf.insert(str);
+  buf.begin();
+  ed.switchToBuff("*watch-jobs");
 }
 
 DEF_CMD(Watch, "watch", "ledger_ops", DEF_OP() {
     auto cmd = ed.prompt("Command to watch: ");
     if (cmd.empty()) return;
     CMBAR_MSG(ed, "Starting watch on '%s'...\n", cmd.c_str());
-    auto& buf = getWatchBuff(ed);
-    ed.switchToBuff("*watch");
-    auto* mode = buf.getMode<watch::WatchMode>("watch");
-    mode->start(&buf, cmd);
+    startWatch(ed, cmd, 0);
   });
 
 DEF_CMD(WatchSleep, "watch-sleep", "ledger_ops", DEF_OP() {
@@ -68,30 +125,33 @@ DEF_CMD(WatchSleep, "watch-sleep", "ledger_ops", DEF_OP() {
     if (sleep.empty()) return;
     CMBAR_MSG(ed, "Starting watch on '%s' with sleep-time=%s ms...\n",
               cmd.c_str(), sleep.c_str());
-    auto& buf = getWatchBuff(ed);
-    ed.switchToBuff("*watch");
-    auto* mode = buf.getMode<watch::WatchMode>("watch");
-    mode->start(&buf, cmd, str2num(sleep));
+    startWatch(ed, cmd, str2num(sleep));
   });
 
+DEF_CMD(WatchJobs, "watch-jobs", "ledger_ops", DEF_OP() { listJobs(ed); });
+
 DEF_CMD(WatchStop, "watch::stop", "ledger_ops", DEF_OP() {
     CMBAR_MSG(ed, "Waiting for previously running command to complete...\n");
-    auto& buf = getWatchBuff(ed);
-    ed.switchToBuff("*watch");
-    auto* mode = buf.getMode<watch::WatchMode>("watch");
+    auto* mode = ed.getBuff().getMode<watch::WatchMode>("watch");
     mode->stop();
     CMBAR_MSG(ed, "Watch command stopped successfully\n");
   });
 
 DEF_CMD(WatchRestart, "watch::restart", "ledger_ops", DEF_OP() {
     CMBAR_MSG(ed, "Restarting the watch command...\n");
-    auto& buf = getWatchBuff(ed);
-    ed.switchToBuff("*watch");
-    auto* mode = buf.getMode<watch::WatchMode>("watch");
+    auto* mode = ed.getBuff().getMode<watch::WatchMode>("watch");
     mode->restart();
     CMBAR_MSG(ed, "Watch command restarted successfully\n");
   });
 
+DEF_CMD(WatchToggleHighlight, "watch::toggle-highlight", "ledger_ops",
+        DEF_OP() {
+    auto* mode = ed.getBuff().getMode<watch::WatchMode>("watch");
+    mode->toggleHighlight();
+    CMBAR_MSG(ed, "Highlighting of changes %s\n",
+              mode->highlightChanges() ? "enabled" : "disabled");
+  });
+
 } // end namespace ops
 } // end namespace watch
 } // end namespace teditor
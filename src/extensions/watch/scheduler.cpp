@@ -0,0 +1,172 @@
+#include "scheduler.h"
+#include "core/option.h"
+#include "core/utils.h"
+#include <algorithm>
+
+namespace teditor {
+namespace watch {
+
+const int Scheduler::TickMs = 10;
+
+Scheduler& Scheduler::instance() {
+  static Scheduler sched(Option::get("watch:maxConcurrentJobs").getInt());
+  return sched;
+}
+
+Scheduler::Scheduler(int maxConcurrent):
+  maxWorkers(std::max(maxConcurrent, 1)), nextId(0), quit(false),
+  epoch(Clock::now()), wheel(), jobMap(), ready(), mtx(), timerCv(),
+  workerCv(), doneCv(), timer(), workers() {
+}
+
+Scheduler::~Scheduler() {
+  {
+    std::unique_lock<std::mutex> lk(mtx);
+    quit = true;
+  }
+  timerCv.notify_all();
+  workerCv.notify_all();
+  if (timer.joinable()) timer.join();
+  for (auto& w : workers) w.join();
+}
+
+int Scheduler::add(const std::string& name, const std::string& cmd,
+                   int periodMs, Callback cb) {
+  ASSERT(periodMs > 0, "Scheduler::add: period must be positive! [%d]",
+         periodMs);
+  std::unique_lock<std::mutex> lk(mtx);
+  if (!timer.joinable()) startThreads();
+  int id = nextId++;
+  auto& job = jobMap[id];
+  job.name = name;
+  job.cmd = cmd;
+  job.periodMs = periodMs;
+  job.cb = cb;
+  job.due = Clock::now();
+  job.running = job.removed = false;
+  ready.push_back(id);
+  workerCv.notify_one();
+  return id;
+}
+
+bool Scheduler::remove(int id) {
+  std::unique_lock<std::mutex> lk(mtx);
+  auto itr = jobMap.find(id);
+  if (itr == jobMap.end()) return false;
+  // stale entries in the timer wheel or the ready queue are just ignored later
+  if (!itr->second.running) {
+    jobMap.erase(itr);
+    return true;
+  }
+  itr->second.removed = true;
+  doneCv.wait(lk, [&]() { return jobMap.find(id) == jobMap.end(); });
+  return true;
+}
+
+bool Scheduler::stats(int id, JobStats& st) const {
+  std::unique_lock<std::mutex> lk(mtx);
+  auto itr = jobMap.find(id);
+  if (itr == jobMap.end()) return false;
+  st = itr->second.stats;
+  return true;
+}
+
+std::vector<JobInfo> Scheduler::jobs() const {
+  std::vector<JobInfo> ret;
+  std::unique_lock<std::mutex> lk(mtx);
+  for (const auto& itr : jobMap) {
+    const auto& j = itr.second;
+    if (j.removed) continue;
+    ret.push_back({itr.first, j.name, j.cmd, j.periodMs, j.running, j.stats});
+  }
+  std::sort(ret.begin(), ret.end(),
+            [](const JobInfo& a, const JobInfo& b) { return a.id < b.id; });
+  return ret;
+}
+
+size_t Scheduler::numJobs() const {
+  std::unique_lock<std::mutex> lk(mtx);
+  return jobMap.size();
+}
+
+void Scheduler::startThreads() {
+  timer = std::thread([this]() { timerLoop(); });
+  for (int i = 0; i < maxWorkers; ++i)
+    workers.push_back(std::thread([this]() { workerLoop(); }));
+}
+
+uint64_t Scheduler::toTick(const Clock::time_point& t, bool roundUp) const {
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(t - epoch);
+  int64_t tickUs = TickMs * 1000, val = std::max<int64_t>(us.count(), 0);
+  return uint64_t((val + (roundUp ? tickUs - 1 : 0)) / tickUs);
+}
+
+void Scheduler::advance() {
+  std::vector<int> expired;
+  wheel.advance(toTick(Clock::now(), false), expired);
+  bool any = false;
+  for (auto id : expired) {
+    if (jobMap.find(id) == jobMap.end()) continue;
+    ready.push_back(id);
+    any = true;
+  }
+  if (any) workerCv.notify_all();
+}
+
+void Scheduler::timerLoop() {
+  std::unique_lock<std::mutex> lk(mtx);
+  while (!quit) {
+    advance();
+    if (wheel.empty()) {
+      timerCv.wait(lk);
+    } else {
+      auto next = wheel.now() + wheel.ticksToNext();
+      timerCv.wait_until(lk,
+                         epoch + std::chrono::milliseconds(next * TickMs));
+    }
+  }
+}
+
+void Scheduler::workerLoop() {
+  std::unique_lock<std::mutex> lk(mtx);
+  while (true) {
+    workerCv.wait(lk, [this]() { return quit || !ready.empty(); });
+    if (quit) return;
+    int id = ready.front();
+    ready.pop_front();
+    auto itr = jobMap.find(id);
+    if (itr == jobMap.end()) continue;
+    // node references of the map survive rehashing, unlike its iterators. And
+    // 'remove' waits for the running jobs to finish. So this is safe to use
+    auto& job = itr->second;
+    job.running = true;
+    auto start = Clock::now();
+    lk.unlock();
+    bool ok = job.cb();
+    auto end = Clock::now();
+    lk.lock();
+    job.running = false;
+    auto& st = job.stats;
+    ++st.runs;
+    if (!ok) ++st.failures;
+    st.lastMs = std::chrono::duration<double, std::milli>(end - start).count();
+    st.totalMs += st.lastMs;
+    st.maxMs = std::max(st.maxMs, st.lastMs);
+    auto delay = std::chrono::duration<double, std::milli>(start - job.due);
+    st.totalDelayMs += std::max(delay.count(), 0.0);
+    st.maxDelayMs = std::max(st.maxDelayMs, delay.count());
+    if (job.removed) {
+      jobMap.erase(id);
+      doneCv.notify_all();
+      continue;
+    }
+    job.due = end + std::chrono::milliseconds(job.periodMs);
+    // the wheel might be lagging behind, if it had been idle for a while
+    advance();
+    wheel.add(toTick(job.due, true), id);
+    timerCv.notify_one();
+  }
+}
+
+}  // namespace watch
+}  // namespace teditor
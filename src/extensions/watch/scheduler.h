@@ -0,0 +1,128 @@
+#pragma once
+
+#include "core/timer_wheel.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace teditor {
+namespace watch {
+
+/** runtime statistics of a scheduled job */
+struct JobStats {
+  int runs, failures;
+  /** runtimes of the job */
+  double lastMs, totalMs, maxMs;
+  /** delay between the job being due and it actually starting */
+  double totalDelayMs, maxDelayMs;
+
+  JobStats(): runs(0), failures(0), lastMs(0.0), totalMs(0.0), maxMs(0.0),
+              totalDelayMs(0.0), maxDelayMs(0.0) {}
+  double avgMs() const { return runs > 0 ? totalMs / runs : 0.0; }
+  double avgDelayMs() const { return runs > 0 ? totalDelayMs / runs : 0.0; }
+};  // struct JobStats
+
+/** snapshot of a job, as seen by the outside world */
+struct JobInfo {
+  int id;
+  std::string name, cmd;
+  int periodMs;
+  bool running;
+  JobStats stats;
+};  // struct JobInfo
+
+
+/**
+ * @brief Runs periodic jobs. A single thread keeps track of when each of the
+ * jobs is due using a hierarchical timer wheel and hands over the due ones to
+ * a bounded set of worker threads. A job is rescheduled only after its current
+ * run completes, so the runs of a job never overlap. The period is thus the
+ * sleep time between the end of a run and the start of the next one.
+ */
+class Scheduler {
+ public:
+  /** a job returns false if its run failed */
+  typedef std::function<bool()> Callback;
+  /** resolution of the timer wheel */
+  static const int TickMs;
+
+  /** the one shared by all the watch buffers */
+  static Scheduler& instance();
+
+  /**
+   * @brief ctor. No threads are started until the first job is added
+   * @param maxConcurrent max number of jobs that can be running at any time
+   */
+  Scheduler(int maxConcurrent);
+  ~Scheduler();
+
+  /**
+   * @brief adds a new job and schedules its first run immediately
+   * @param name name of the job
+   * @param cmd description of what the job runs
+   * @param periodMs sleep time between successive runs
+   * @param cb the job itself
+   * @return id of the job
+   */
+  int add(const std::string& name, const std::string& cmd, int periodMs,
+          Callback cb);
+
+  /**
+   * @brief removes the job. If it is currently running, this waits for the run
+   * to complete, thereby guaranteeing that its callback is never invoked after
+   * this returns
+   * @return false if no such job existed
+   */
+  bool remove(int id);
+
+  /** stats of the job, returns false if no such job exists */
+  bool stats(int id, JobStats& st) const;
+
+  /** info about all the jobs, in the increasing order of their id's */
+  std::vector<JobInfo> jobs() const;
+
+  size_t numJobs() const;
+  int maxConcurrency() const { return maxWorkers; }
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Job {
+    std::string name, cmd;
+    int periodMs;
+    Callback cb;
+    Clock::time_point due;
+    bool running, removed;
+    JobStats stats;
+  };  // struct Job
+
+  int maxWorkers;
+  int nextId;
+  bool quit;
+  Clock::time_point epoch;
+  TimerWheel<int> wheel;
+  std::unordered_map<int, Job> jobMap;
+  /** jobs which are due, but are waiting for a free worker */
+  std::deque<int> ready;
+  mutable std::mutex mtx;
+  /** to wake up the timer thread, workers and 'remove' respectively */
+  std::condition_variable timerCv, workerCv, doneCv;
+  std::thread timer;
+  std::vector<std::thread> workers;
+
+  void startThreads();
+  /** moves the timer wheel to the current time and queues up the due jobs */
+  void advance();
+  void timerLoop();
+  void workerLoop();
+  uint64_t toTick(const Clock::time_point& t, bool roundUp) const;
+};  // class Scheduler
+
+}  // namespace watch
+}  // namespace teditor
@@ -1,6 +1,9 @@
 #include "testutils.h"
 #include "core/buffer.h"
+#include "core/timer.h"
 #include "catch.hpp"
+#include <fstream>
+#include <unistd.h>
 
 
 namespace teditor {
@@ -87,6 +90,78 @@ TEST_CASE("Buffer::Clear") {
   REQUIRE(1 == ml.length());
 }
 
+TEST_CASE("Buffer::ReplaceLines") {
+  Buffer ml;
+  setupBuff(ml, {0, 0}, {30, 10}, "samples/multiline.txt");
+  REQUIRE(4 == ml.length());
+  ml.gotoLine(3, {30, 10});
+  SECTION("same length") {
+    ml.replaceLines(1, 1, {"hello"});
+    REQUIRE(4 == ml.length());
+    REQUIRE("hello" == ml.at(1).get());
+    REQUIRE(3 == ml.getPoint().y);
+  }
+  SECTION("grow") {
+    ml.replaceLines(1, 1, {"a", "b", "c"});
+    REQUIRE(6 == ml.length());
+    REQUIRE("a" == ml.at(1).get());
+    REQUIRE("c" == ml.at(3).get());
+    REQUIRE(5 == ml.getPoint().y);
+  }
+  SECTION("shrink") {
+    ml.replaceLines(0, 2, {});
+    REQUIRE(2 == ml.length());
+    REQUIRE(1 == ml.getPoint().y);
+    ml.replaceLines(0, 2, {});
+    REQUIRE(1 == ml.length());
+    REQUIRE(0 == ml.getPoint().y);
+    REQUIRE(0 == ml.getPoint().x);
+  }
+}
+
+TEST_CASE("Buffer::MemStats") {
+  Buffer ml;
+  setupBuff(ml, {0, 0}, {30, 10}, "samples/sample.cxx");
+  auto ms = ml.memStats();
+  REQUIRE(size_t(ml.length()) == ms.numLines);
+  REQUIRE(ms.numLines * sizeof(Line) <= ms.lineBytes);
+  size_t heap = 0;
+  for(int i = 0; i < ml.length(); ++i) heap += ml.at(i).heapBytes();
+  REQUIRE(heap == ms.arena.usedBytes + ms.arena.largeBytes);
+  REQUIRE(ms.arena.usedBytes <= ms.arena.slabBytes);
+  ml.clear();
+  ms = ml.memStats();
+  REQUIRE(1 == ms.numLines);
+  REQUIRE(0 == ms.arena.numSlabs);
+  REQUIRE(0 == ms.arena.usedBytes);
+}
+
+// Not run by default. Use: teditor-tests "[bench]"
+TEST_CASE("Buffer::LoadBench", "[.][bench]") {
+  const int NumLines = 1000000;
+  auto src = slurpToArr("samples/long.cpp");
+  std::string file("/tmp/teditor-long-bench.cpp");
+  {
+    std::ofstream fp(file.c_str());
+    for(int i = 0; i < NumLines; ++i) fp << src[i % src.size()] << "\n";
+  }
+  Buffer ml;
+  tic("load");
+  ml.load(file);
+  toc("load");
+  REQUIRE(NumLines + 1 == ml.length());
+  auto ms = ml.memStats();
+  tic("clear");
+  ml.clear();
+  toc("clear");
+  printf("load: %lf s, clear: %lf s\n", getTimer("load").elapsed(),
+         getTimer("clear").elapsed());
+  printf("lines: %zu objects: %zu B slabs: %zu (%zu B) used: %zu B "
+         "large: %zu B\n", ms.numLines, ms.lineBytes, ms.arena.numSlabs,
+         ms.arena.slabBytes, ms.arena.usedBytes, ms.arena.largeBytes);
+  unlink(file.c_str());
+}
+
 TEST_CASE("Buffer::CharAt") {
   Buffer ml;
   setupBuff(ml, {0, 0}, {30, 10}, "samples/multiline.txt");
@@ -109,6 +184,40 @@ TEST_CASE("Buffer::Buffer2screen") {
   REQUIRE(Point(4, 5) == ml.buffer2screen({9, 2}, start, dim));
 }
 
+TEST_CASE("Buffer::MultiByteCursor") {
+  Buffer ml;
+  // "h\u00e9llo" (e-acute is 2 bytes long)
+  ml.insert("h\xc3\xa9llo\nabcdef");
+  ml.begin();
+  ml.right();
+  REQUIRE(Point(1, 0) == ml.getPoint());
+  ml.right();
+  REQUIRE(Point(3, 0) == ml.getPoint());
+  // vertical movements retain the display column
+  ml.down();
+  REQUIRE(Point(2, 1) == ml.getPoint());
+  ml.up();
+  REQUIRE(Point(3, 0) == ml.getPoint());
+  ml.left();
+  REQUIRE(Point(1, 0) == ml.getPoint());
+  Point start = {0, 0}, dim = {3, 10};
+  REQUIRE(Point(1, 0) == ml.buffer2screen({1, 0}, start, dim));
+  REQUIRE(Point(0, 1) == ml.buffer2screen({4, 0}, start, dim));
+  REQUIRE(Point(1, 2) == ml.buffer2screen({1, 1}, start, dim));
+  REQUIRE(Point(4, 0) == ml.screen2buffer({0, 1}, start, dim));
+  // whole char is removed and brought back
+  ml.right();
+  ml.remove();
+  REQUIRE("hllo" == ml.at(0).get());
+  REQUIRE(Point(1, 0) == ml.getPoint());
+  ml.undo();
+  REQUIRE("h\xc3\xa9llo" == ml.at(0).get());
+  ml.begin();
+  ml.right();
+  ml.remove(true);
+  REQUIRE("hllo" == ml.at(0).get());
+}
+
 TEST_CASE("Window::Screen2buffer") {
   Buffer ml;
   Point start = {0, 0};
@@ -178,6 +287,21 @@ TEST_CASE("Buffer::RemoveRegion") {
   REQUIRE(21 == ml.length());
   REQUIRE("#ifndef _GNU_SOURCE" == ml.at(0).get());
   REQUIRE("" == ml.at(3).get());
+
+  // start and end in the middle of lines
+  start = {2, 0};
+  end = {3, 2};
+  del = ml.removeRegion(start, end);
+  REQUIRE("fndef _GNU_SOURCE\n#define _GNU_SOURCE // for wcstring, strcasestr\n#en"
+          == del);
+  REQUIRE(19 == ml.length());
+  REQUIRE("#idif" == ml.at(0).get());
+  REQUIRE("" == ml.at(1).get());
+  ml.setPoint(start);
+  ml.insert(del);
+  REQUIRE(21 == ml.length());
+  REQUIRE("#ifndef _GNU_SOURCE" == ml.at(0).get());
+  REQUIRE("#endif" == ml.at(2).get());
 }
 
 TEST_CASE("Buffer::LengthOf") {
@@ -269,6 +393,58 @@ TEST_CASE("Buffer::SortRegions") {
   REQUIRE("" == ml.at(3).get());
 }
 
+TEST_CASE("Buffer::SortRegionsUndoRedo") {
+  Buffer ml;
+  setupBuff(ml, {0, 0}, {30, 10}, "samples/sample.cxx");
+  REQUIRE(21 == ml.length());
+  Strings orig;
+  for(int i = 0; i < ml.length(); ++i) orig.push_back(ml.at(i).get());
+  ml.startRegion();
+  ml.nextPara();
+  ml.left();
+  auto before = ml.getPoint();
+  ml.sortRegion();
+  ml.stopRegion();
+  REQUIRE(ml.isModified());
+  REQUIRE("#define _GNU_SOURCE // for wcstring, strcasestr" == ml.at(0).get());
+  REQUIRE("#endif" == ml.at(1).get());
+  REQUIRE("#ifndef _GNU_SOURCE" == ml.at(2).get());
+  auto after = ml.getPoint();
+  REQUIRE(ml.undo());
+  REQUIRE(21 == ml.length());
+  for(int i = 0; i < ml.length(); ++i) REQUIRE(orig[i] == ml.at(i).get());
+  REQUIRE(before == ml.getPoint());
+  REQUIRE(ml.redo());
+  REQUIRE("#define _GNU_SOURCE // for wcstring, strcasestr" == ml.at(0).get());
+  REQUIRE("#endif" == ml.at(1).get());
+  REQUIRE("#ifndef _GNU_SOURCE" == ml.at(2).get());
+  REQUIRE(after == ml.getPoint());
+}
+
+TEST_CASE("Buffer::SortRegionsUnique") {
+  Buffer ml;
+  ml.insert("b\na\nb\nc\na");
+  REQUIRE(5 == ml.length());
+  ml.begin();
+  ml.startRegion();
+  ml.end();
+  ml.sortRegion(Sort_Unique | Sort_Reverse);
+  ml.stopRegion();
+  REQUIRE(3 == ml.length());
+  REQUIRE("c" == ml.at(0).get());
+  REQUIRE("b" == ml.at(1).get());
+  REQUIRE("a" == ml.at(2).get());
+  REQUIRE(Point(1, 2) == ml.getPoint());
+  REQUIRE(ml.undo());
+  REQUIRE(5 == ml.length());
+  Strings exp = {"b", "a", "b", "c", "a"};
+  for(int i = 0; i < ml.length(); ++i) REQUIRE(exp[i] == ml.at(i).get());
+  REQUIRE(ml.redo());
+  REQUIRE(3 == ml.length());
+  REQUIRE("c" == ml.at(0).get());
+  REQUIRE("a" == ml.at(2).get());
+}
+
 TEST_CASE("Buffer::KeepLinesNoMatches") {
   Buffer ml;
   setupBuff(ml, {0, 0}, {30, 10}, "samples/sample.cxx");
@@ -297,6 +473,8 @@ TEST_CASE("Buffer::KeepLinesSomeMatches") {
   ml.keepRemoveLines(nfa, true);
   REQUIRE(12 == ml.length());
   REQUIRE(ml.isModified());
+  Strings kept;
+  for(int i = 0; i < ml.length(); ++i) kept.push_back(ml.at(i).get());
   // undo
   ml.undo();
   REQUIRE(21 == ml.length());
@@ -305,6 +483,7 @@ TEST_CASE("Buffer::KeepLinesSomeMatches") {
   // redo
   ml.redo();
   REQUIRE(12 == ml.length());
+  for(int i = 0; i < ml.length(); ++i) REQUIRE(kept[i] == ml.at(i).get());
 }
 
 TEST_CASE("Buffer::KeepLinesAllMatches") {
@@ -559,10 +738,9 @@ TEST_CASE("Buffer::Cut") {
     auto regs = ml.getRegion();
     auto del = ml.removeRegion(regs, after);
     REQUIRE("\nTesting123\n" == del);
-    ///@todo: issue with trailing newline now!!
-    REQUIRE(3 == ml.length());
-    REQUIRE("* Hello" == ml.at(0).get());
-    REQUIRE("for multi-line buffer!" == ml.at(1).get());
+    REQUIRE(2 == ml.length());
+    REQUIRE("* Hellofor multi-line buffer!" == ml.at(0).get());
+    REQUIRE("" == ml.at(1).get());
   }
 }
 
@@ -786,6 +964,41 @@ TEST_CASE("Buffer::SingleCursorEdits") {
     REQUIRE(ml.isModified());
   }
 
+  SECTION("insert multi-line string") {
+    ml.right(); ml.right();
+    ml.insert("AA\nBB\n\nCC");
+    REQUIRE(7 == ml.length());
+    REQUIRE("* AA" == ml.at(0).get());
+    REQUIRE("BB" == ml.at(1).get());
+    REQUIRE("" == ml.at(2).get());
+    REQUIRE("CCHello" == ml.at(3).get());
+    REQUIRE("Testing123" == ml.at(4).get());
+    REQUIRE(Point(2, 3) == ml.getPoint());
+    REQUIRE(ml.undo());
+    REQUIRE(4 == ml.length());
+    REQUIRE("* Hello" == ml.at(0).get());
+    REQUIRE("Testing123" == ml.at(1).get());
+    REQUIRE(Point(2, 0) == ml.getPoint());
+    REQUIRE(ml.redo());
+    REQUIRE(7 == ml.length());
+    REQUIRE("CCHello" == ml.at(3).get());
+    REQUIRE(Point(2, 3) == ml.getPoint());
+    REQUIRE(ml.isModified());
+  }
+
+  SECTION("insert string ending with newline") {
+    ml.insert("AA\nBB\n");
+    REQUIRE(6 == ml.length());
+    REQUIRE("AA" == ml.at(0).get());
+    REQUIRE("BB" == ml.at(1).get());
+    REQUIRE("* Hello" == ml.at(2).get());
+    REQUIRE(Point(0, 2) == ml.getPoint());
+    REQUIRE(ml.undo());
+    REQUIRE(4 == ml.length());
+    REQUIRE("* Hello" == ml.at(0).get());
+    REQUIRE(Point(0, 0) == ml.getPoint());
+  }
+
   SECTION("remove from front") {
     ml.remove();
     REQUIRE("* Hello" == ml.at(0).get());
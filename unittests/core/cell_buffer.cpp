@@ -30,4 +30,59 @@ TEST_CASE("CellBuffer::CellBuffer") {
     REQUIRE(6U == cb.h());
 }
 
+TEST_CASE("CellBuffer::Rows") {
+    AttrColor fg=0, bg=1;
+    CellBuffer a(4, 3), b(4, 3);
+    a.clear(fg, bg);
+    b.clear(fg, bg);
+    REQUIRE(a.rowHash(0) == a.rowHash(2));
+    REQUIRE(a.sameRow(1, b, 1));
+    b.at(2, 1).set('x', fg, bg);
+    REQUIRE_FALSE(a.sameRow(1, b, 1));
+    REQUIRE(a.rowHash(1) != b.rowHash(1));
+    a.copyRow(1, b);
+    REQUIRE(a.sameRow(1, b, 1));
+    REQUIRE(a.rowHash(1) == b.rowHash(1));
+    // clearing puts back the cells, even of the rows with fresh hashes
+    b.clear(fg, bg);
+    REQUIRE(' ' == b.at(2, 1).ch);
+    REQUIRE(b.rowHash(1) == b.rowHash(0));
+    b.clear(bg, fg);
+    REQUIRE(bg == b.at(0, 0).fg);
+    REQUIRE(b.rowHash(0) != a.rowHash(0));
+}
+
+TEST_CASE("CellBuffer::Scroll") {
+    AttrColor fg=0, bg=1;
+    CellBuffer front(3, 6), back(3, 6);
+    front.clear(fg, bg);
+    back.clear(fg, bg);
+    for(int y = 0; y < 6; ++y)
+      for(int x = 0; x < 3; ++x) front.at(x, y).set('a' + y, fg, bg);
+    // contents move up by 2, except for the last row
+    for(int y = 0; y < 3; ++y)
+      for(int x = 0; x < 3; ++x) back.at(x, y).set('c' + y, fg, bg);
+    back.at(0, 5).set('z', fg, bg);
+    int top = -1, bot = -1;
+    REQUIRE(2 == findScroll(front, back, top, bot));
+    REQUIRE(0 == top);
+    REQUIRE(4 == bot);
+    front.scroll(top, bot, 2);
+    for(int y = 0; y < 3; ++y) REQUIRE(front.sameRow(y, back, y));
+    REQUIRE_FALSE(front.sameRow(3, back, 3));
+    REQUIRE_FALSE(front.sameRow(4, back, 4));
+    REQUIRE('f' == front.at(0, 5).ch);
+    int count = syncCells(front, back, [](int, int, const Cell&, int) {});
+    REQUIRE(3 * 2 + 3 == count);
+    REQUIRE(0 == syncCells(front, back, [](int, int, const Cell&, int) {}));
+    REQUIRE(0 == findScroll(front, back, top, bot));
+    // and now down by 1
+    back.scroll(0, 5, -1);
+    back.at(0, 0).set('q', fg, bg);
+    for(int x = 1; x < 3; ++x) back.at(x, 0).set(' ', fg, bg);
+    REQUIRE(-1 == findScroll(front, back, top, bot));
+    REQUIRE(0 == top);
+    REQUIRE(5 == bot);
+}
+
 } // end namespace teditor
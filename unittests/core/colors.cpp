@@ -39,4 +39,23 @@ TEST_CASE("Colors::ColorHelper") {
   REQUIRE("Red" == ColorHelper::tostr(Color_Red));
 }
 
+TEST_CASE("Colors::ColorMap") {
+  REQUIRE(Slot_defaultfg == colorSlot("defaultfg"));
+  REQUIRE(Slot_filefg == colorSlot("filefg"));
+  REQUIRE(Slot_Count == colorSlot("unknownfg"));
+  ColorMap cm;
+  REQUIRE_THROWS(cm.get(Slot_defaultfg));
+  cm.add({"defaultfg", "Bold:Red"});
+  cm.add({"highlightfg", "defaultfg"});
+  cm.add({"myfg", "Blue"});
+  REQUIRE(cm.get("defaultfg") == cm.get(Slot_defaultfg));
+  REQUIRE(Color_Red == cm.get(Slot_defaultfg).color());
+  REQUIRE(cm.get(Slot_highlightfg).isBold());
+  REQUIRE(Color_Blue == cm.get("myfg").color());
+  REQUIRE_THROWS(cm.get(Slot_defaultbg));
+  cm.clear();
+  REQUIRE_THROWS(cm.get(Slot_defaultfg));
+  REQUIRE_THROWS(cm.get("defaultfg"));
+}
+
 } // end namespace teditor
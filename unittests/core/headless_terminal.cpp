@@ -0,0 +1,201 @@
+#include "core/headless_terminal.h"
+#include "core/editor.h"
+#include "core/file_utils.h"
+#include "core/option.h"
+#include "catch.hpp"
+#include <locale.h>
+#include <unistd.h>
+
+namespace teditor {
+
+TEST_CASE("Terminal::key2seq") {
+  REQUIRE("a" == key2seq("a"));
+  REQUIRE("\x18" == key2seq("C-X"));
+  REQUIRE("\r" == key2seq("enter"));
+  REQUIRE("\033x" == key2seq("M-x"));
+  REQUIRE("\033" == key2seq("esc"));
+  REQUIRE("\033OA" == key2seq("up"));
+  REQUIRE_THROWS_AS(key2seq("C-foo"), std::runtime_error);
+}
+
+TEST_CASE("InputRing") {
+  InputRing ring(5);
+  REQUIRE(ring.empty());
+  // capacity is rounded up to a power of 2
+  REQUIRE(8U == ring.push("abcdefghij", 10));
+  REQUIRE(0U == ring.push("x", 1));
+  REQUIRE(ring.full());
+  REQUIRE("abcdefgh" == ring.str(100));
+  ring.consume(6);
+  REQUIRE(2U == ring.size());
+  REQUIRE(4U == ring.push("1234", 4));
+  size_t len;
+  ring.writable(len);
+  REQUIRE(2U == len);
+  REQUIRE("gh1234" == ring.str(6));
+  REQUIRE('1' == ring[2]);
+  ring.consume(100);
+  REQUIRE(ring.empty());
+}
+
+TEST_CASE("Terminal::Decode") {
+  SingletonHandler<HeadlessTerminal, Pos2di> sh({20, 5});
+  auto& term = static_cast<HeadlessTerminal&>(Terminal::getInstance());
+  // multiple keys arriving together
+  term.addKeySeq("\033[A\033[Bq\033x\033");
+  REQUIRE(Event_Key == term.waitAndFill(nullptr));
+  REQUIRE("up" == term.mk.toStr());
+  REQUIRE(Event_Key == term.waitAndFill(nullptr));
+  REQUIRE("down" == term.mk.toStr());
+  REQUIRE(Event_Key == term.waitAndFill(nullptr));
+  REQUIRE("q" == term.mk.toStr());
+  REQUIRE(Event_Key == term.waitAndFill(nullptr));
+  REQUIRE("M-x" == term.mk.toStr());
+  REQUIRE(Event_Key == term.waitAndFill(nullptr));
+  REQUIRE("esc" == term.mk.toStr());
+  // only the undefined part gets dropped
+  term.addKeySeq("\033[Qa");
+  REQUIRE(Terminal::UndefinedSequence == term.waitAndFill(nullptr));
+  REQUIRE("\033[Q" == term.getOldSeq());
+  REQUIRE(Event_Key == term.waitAndFill(nullptr));
+  REQUIRE("a" == term.mk.toStr());
+  // UTF-8
+  term.addKeySeq("\xc3\xa9\xe2\x82\xac");
+  REQUIRE(Event_Text == term.waitAndFill(nullptr));
+  REQUIRE("\xc3\xa9" == term.text);
+  REQUIRE(Event_Text == term.waitAndFill(nullptr));
+  REQUIRE("\xe2\x82\xac" == term.text);
+  // bracketed paste
+  term.addKeySeq(Terminal::PasteStart + "ab\033[A\rcd\r\n" +
+                 Terminal::PasteEnd + "z");
+  REQUIRE(Event_Text == term.waitAndFill(nullptr));
+  REQUIRE("ab\033[A\ncd\n" == term.text);
+  REQUIRE(Event_Key == term.waitAndFill(nullptr));
+  REQUIRE("z" == term.mk.toStr());
+  REQUIRE(term.waitAndFill(nullptr) < 0);
+}
+
+TEST_CASE("HeadlessTerminal::Keys") {
+  SingletonHandler<HeadlessTerminal, Pos2di> sh({20, 5});
+  auto& term = static_cast<HeadlessTerminal&>(Terminal::getInstance());
+  REQUIRE(20 == term.width());
+  REQUIRE(5 == term.height());
+  term.addScript("# comment\n\n"
+                 "keys C-X up\n"
+                 "type ab\n"
+                 "resize 30 6\n");
+  REQUIRE(5U == term.pending());
+  REQUIRE(Event_Key == term.waitAndFill(nullptr));
+  REQUIRE("C-X" == term.mk.toStr());
+  REQUIRE(Event_Key == term.waitAndFill(nullptr));
+  REQUIRE("up" == term.mk.toStr());
+  REQUIRE(Event_Key == term.waitAndFill(nullptr));
+  REQUIRE("a" == term.mk.toStr());
+  REQUIRE(Event_Key == term.waitAndFill(nullptr));
+  REQUIRE("b" == term.mk.toStr());
+  REQUIRE(Event_Resize == term.waitAndFill(nullptr));
+  REQUIRE(term.bufferResize());
+  REQUIRE(30 == term.width());
+  REQUIRE(6U == term.screen().cells().h());
+  REQUIRE(term.waitAndFill(nullptr) < 0);
+  REQUIRE_THROWS_AS(term.addScript("foo bar"), std::runtime_error);
+}
+
+TEST_CASE("HeadlessTerminal::Editor") {
+  std::vector<FileInfo> files;
+  parseArgs(0, nullptr, files);
+  auto hist = tempFileName();
+  Option::set("histFile", hist);
+  SingletonHandler<HeadlessTerminal, Pos2di> sh({40, 10});
+  auto& term = static_cast<HeadlessTerminal&>(Terminal::getInstance());
+  term.addScript("type hello world\n"
+                 "keys enter\n"
+                 "type bye\n"
+                 "paste  xyz\\n123\n"
+                 "resize 50 12\n");
+  {
+    Editor ed(files);
+    ed.run();
+    const auto& buf = ed.getBuff();
+    REQUIRE(3 == buf.length());
+    REQUIRE("hello world" == buf.at(0).get());
+    REQUIRE("bye xyz" == buf.at(1).get());
+    REQUIRE("123" == buf.at(2).get());
+  }
+  const auto& vt = term.screen();
+  REQUIRE(50U == vt.cells().w());
+  REQUIRE(vt.row(0).find("hello world") != std::string::npos);
+  REQUIRE(vt.row(1).find("bye") != std::string::npos);
+  int keyFrames = 0;
+  size_t bytes = 0;
+  for(const auto& f : term.frames()) {
+    bytes += f.bytes;
+    if(f.latencyUs >= 0.0) ++keyFrames;
+  }
+  REQUIRE(bytes > 0);
+  // one frame for every key and paste
+  REQUIRE(16 == keyFrames);
+  unlink(hist.c_str());
+}
+
+TEST_CASE("HeadlessTerminal::CmdMsgBar") {
+  auto* old = setlocale(LC_CTYPE, nullptr);
+  std::string oldLocale(old == nullptr ? "C" : old);
+  if(setlocale(LC_CTYPE, "C.UTF-8") == nullptr) return;
+  std::vector<FileInfo> files;
+  parseArgs(0, nullptr, files);
+  auto hist = tempFileName();
+  Option::set("histFile", hist);
+  SingletonHandler<HeadlessTerminal, Pos2di> sh({80, 10});
+  auto& term = static_cast<HeadlessTerminal&>(Terminal::getInstance());
+  {
+    Editor ed(files);
+    ed.run();
+    // "h\u00e9 \u4e2d!" (2-byte and wide chars) with a char after them
+    ed.getCmBar().insert("h\xc3\xa9 \xe4\xb8\xad!x");
+    ed.refresh();
+  }
+  const auto& vt = term.screen();
+  REQUIRE("h\xc3\xa9 \xe4\xb8\xad!x" == vt.row(9));
+  REQUIRE('x' == (char)vt.cells().at(6, 9).ch);
+  unlink(hist.c_str());
+  setlocale(LC_CTYPE, oldLocale.c_str());
+}
+
+TEST_CASE("HeadlessTerminal::Scroll") {
+  auto file = tempFileName();
+  FILE* fp = fopen(file.c_str(), "w");
+  REQUIRE(fp != nullptr);
+  for(int i = 0; i < 100; ++i)
+    fprintf(fp, "line %d %s\n", i, std::string(i % 23, 'a' + i % 26).c_str());
+  fclose(fp);
+  std::vector<FileInfo> files;
+  parseArgs(0, nullptr, files);
+  files.push_back({file, 0});
+  auto hist = tempFileName();
+  Option::set("histFile", hist);
+  SingletonHandler<HeadlessTerminal, Pos2di> sh({40, 10});
+  auto& term = static_cast<HeadlessTerminal&>(Terminal::getInstance());
+  std::string script;
+  for(int i = 0; i < 12; ++i) script += "keys down\n";
+  script += "keys pagedown\nkeys up\nkeys up\n";
+  term.addScript(script);
+  {
+    Editor ed(files);
+    ed.run();
+  }
+  // the screen, as left behind by all the scrolls, is what the buffer has
+  const auto& vt = term.screen();
+  int first;
+  REQUIRE(1 == sscanf(vt.row(0).c_str(), "line %d", &first));
+  for(int y = 1; y < 8; ++y) {
+    int i = first + y;
+    auto line = format("line %d %s", i,
+                       std::string(i % 23, 'a' + i % 26).c_str());
+    REQUIRE(line.substr(0, line.find_last_not_of(' ') + 1) == vt.row(y));
+  }
+  unlink(file.c_str());
+  unlink(hist.c_str());
+}
+
+} // end namespace teditor
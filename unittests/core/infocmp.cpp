@@ -1,14 +1,147 @@
 #include "core/infocmp.h"
+#include "core/file_utils.h"
 #include "core/terminal.h"
 #include "catch.hpp"
+#include <cstdio>
+#include <stdlib.h>
+#include <utime.h>
 
 namespace teditor {
 
 TEST_CASE("InfoCmp") {
   InfoCmp ic;
-  for (int i = 0; i < Func_FuncsNum - 2; ++i) {
+  for (int i = 0; i < Func_EnterMouse; ++i) {
     REQUIRE_NOTHROW(ic.getStrCap(func2terminfo(Func(i))));
   }
 }
 
+static void putNum(std::string& out, int val, int size) {
+  for (int i = 0; i < size; ++i) out += char((val >> (8 * i)) & 0xff);
+}
+
+static void pad(std::string& out) {
+  if (out.size() % 2) out += '\0';
+}
+
+/** a hand-made compiled terminfo entry, as described in term(5) */
+static std::string compiledEntry(bool is32Bit, bool withExt) {
+  int ns = is32Bit ? 4 : 2;
+  std::string names("tedtest|teditor test terminal");
+  names += '\0';
+  std::string table("\007\0\r\0\033[H\033[2J\0", 12);
+  std::string out;
+  putNum(out, is32Bit ? 01036 : 0432, 2);
+  putNum(out, (int)names.size(), 2);
+  putNum(out, 2, 2);  // bw, am
+  putNum(out, 3, 2);  // cols, it, lines
+  putNum(out, 6, 2);  // cbt, bel, cr, csr, tbc, clear
+  putNum(out, (int)table.size(), 2);
+  out += names;
+  out += '\0';
+  out += '\1';
+  pad(out);
+  putNum(out, 80, ns);
+  putNum(out, -1, ns);
+  putNum(out, 24, ns);
+  for (int off : {-1, 0, 2, -1, -2, 4}) putNum(out, off, 2);
+  out += table;
+  if (!withExt) return out;
+  pad(out);
+  std::string values("\033[?1006h", 9);
+  std::string extNames("AX\0U8\0XM\0", 9);
+  putNum(out, 1, 2);
+  putNum(out, 1, 2);
+  putNum(out, 1, 2);
+  putNum(out, 4, 2);
+  putNum(out, int(values.size() + extNames.size()), 2);
+  out += '\1';
+  pad(out);
+  putNum(out, 1, ns);
+  putNum(out, 0, 2);
+  for (int off : {0, 3, 6}) putNum(out, off, 2);
+  out += values;
+  out += extNames;
+  return out;
+}
+
+static void writeFile(const std::string& file, const std::string& data) {
+  FILE* fp = fopen(file.c_str(), "wb");
+  REQUIRE(fp != nullptr);
+  fwrite(data.data(), 1, data.size(), fp);
+  fclose(fp);
+}
+
+TEST_CASE("InfoCmp::ParseCompiled") {
+  auto file = tempFileName();
+  for (bool is32Bit : {false, true}) {
+    for (bool withExt : {false, true}) {
+      writeFile(file, compiledEntry(is32Bit, withExt));
+      InfoCmp ic("");
+      REQUIRE(ic.parseCompiled(file));
+      REQUIRE("tedtest|teditor test terminal" == ic.header);
+      REQUIRE(80U == ic.numCaps.at("cols"));
+      REQUIRE(24U == ic.numCaps.at("lines"));
+      REQUIRE(ic.numCaps.find("it") == ic.numCaps.end());
+      REQUIRE("\007" == ic.getStrCap("bel"));
+      REQUIRE("\r" == ic.getStrCap("cr"));
+      REQUIRE("\033[H\033[2J" == ic.getStrCap("clear"));
+      REQUIRE_THROWS(ic.getStrCap("cbt"));
+      REQUIRE_THROWS(ic.getStrCap("tbc"));
+      if (!withExt) {
+        REQUIRE(Strings{"am"} == ic.boolCaps);
+        continue;
+      }
+      REQUIRE(Strings({"am", "AX"}) == ic.boolCaps);
+      REQUIRE(1U == ic.numCaps.at("U8"));
+      REQUIRE("\033[?1006h" == ic.getStrCap("XM"));
+    }
+  }
+  writeFile(file, "not a terminfo entry");
+  InfoCmp ic("");
+  REQUIRE_FALSE(ic.parseCompiled(file));
+  REQUIRE_FALSE(ic.parseCompiled(file + ".nonexistent"));
+  remove(file.c_str());
+}
+
+TEST_CASE("InfoCmp::Cache") {
+  auto root = tempFileName();
+  auto cacheDir = root + "/cache";
+  makeDir(root);
+  makeDir(root + "/t");
+  auto file = root + "/t/tedtest";
+  writeFile(file, compiledEntry(false, true));
+  auto old = env("TERMINFO");
+  setenv("TERMINFO", root.c_str(), 1);
+  REQUIRE(file == InfoCmp::findCompiled("tedtest"));
+  REQUIRE("" == InfoCmp::findCompiled("../t/tedtest"));
+  {
+    InfoCmp ic("tedtest", cacheDir);
+    REQUIRE(InfoCmp::Src_Compiled == ic.source);
+    REQUIRE(isFile(cacheDir + "/tedtest"));
+  }
+  {
+    InfoCmp ic("tedtest", cacheDir);
+    REQUIRE(InfoCmp::Src_Cache == ic.source);
+    REQUIRE("tedtest|teditor test terminal" == ic.header);
+    REQUIRE(Strings({"am", "AX"}) == ic.boolCaps);
+    REQUIRE(80U == ic.numCaps.at("cols"));
+    REQUIRE("\033[H\033[2J" == ic.getStrCap("clear"));
+    REQUIRE("\033[?1006h" == ic.getStrCap("XM"));
+  }
+  // a newer compiled entry invalidates the cache
+  struct utimbuf times{1000, 1000};
+  REQUIRE(0 == utime(file.c_str(), &times));
+  {
+    InfoCmp ic("tedtest", cacheDir);
+    REQUIRE(InfoCmp::Src_Compiled == ic.source);
+  }
+  {
+    InfoCmp ic("tedtest", cacheDir);
+    REQUIRE(InfoCmp::Src_Cache == ic.source);
+  }
+  if (old.empty()) unsetenv("TERMINFO");
+  else setenv("TERMINFO", old.c_str(), 1);
+  check_output("rm -rf " + root);
+}
+
 }  // namespace teditor
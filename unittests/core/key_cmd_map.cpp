@@ -9,28 +9,107 @@ TEST_CASE("KeyCmdMap::Usage") {
   kcm.add("C-a C-b", "cmd2");
   kcm.add("C-b C-x", "cmd3");
   kcm.add("C-q", "cmd4");
-  REQUIRE(TS_NULL == kcm.traverse("C-z"));
-  REQUIRE(TS_NON_LEAF == kcm.traverse("C-b"));
-  REQUIRE(TS_NULL == kcm.traverse("M-s"));
-  REQUIRE(TS_NON_LEAF == kcm.traverse("C-b"));
-  REQUIRE(TS_LEAF == kcm.traverse("C-x"));
-  REQUIRE("cmd3" == kcm.getCmd());
+  kcm.compile();
+  int st = KeyCmdMap::Root;
+  REQUIRE(TS_NULL == kcm.traverse(st, "C-z"));
+  REQUIRE(KeyCmdMap::Root == st);
+  REQUIRE(TS_NON_LEAF == kcm.traverse(st, "C-b"));
+  REQUIRE(TS_NULL == kcm.traverse(st, "M-s"));
+  REQUIRE(KeyCmdMap::Root == st);
+  REQUIRE(TS_NON_LEAF == kcm.traverse(st, "C-b"));
+  REQUIRE(TS_LEAF == kcm.traverse(st, "C-x"));
+  REQUIRE("cmd3" == kcm.getCmd(st));
 
   kcm.add("C-b C-x", "cmd5");
-  kcm.resetTraversal();
-  REQUIRE(TS_NON_LEAF == kcm.traverse("C-b"));
-  REQUIRE(TS_LEAF == kcm.traverse("C-x"));
-  REQUIRE("cmd5" == kcm.getCmd());
+  REQUIRE_THROWS(kcm.traverse(st, "C-b"));
+  kcm.compile();
+  st = KeyCmdMap::Root;
+  REQUIRE(TS_NON_LEAF == kcm.traverse(st, "C-b"));
+  REQUIRE(TS_LEAF == kcm.traverse(st, "C-x"));
+  REQUIRE("cmd5" == kcm.getCmd(st));
 
   kcm.add({"C-z C-y", "cmd6"});
-  kcm.resetTraversal();
-  REQUIRE(TS_NON_LEAF == kcm.traverse("C-z"));
-  REQUIRE(TS_LEAF == kcm.traverse("C-y"));
-  REQUIRE("cmd6" == kcm.getCmd());
+  kcm.compile();
+  st = KeyCmdMap::Root;
+  REQUIRE(TS_NON_LEAF == kcm.traverse(st, "C-z"));
+  REQUIRE(TS_LEAF == kcm.traverse(st, "C-y"));
+  REQUIRE("cmd6" == kcm.getCmd(st));
 
   kcm.eraseKey("C-z C-y");
-  kcm.resetTraversal();
-  REQUIRE(TS_NULL == kcm.traverse("C-z"));
+  kcm.compile();
+  st = KeyCmdMap::Root;
+  REQUIRE(TS_NULL == kcm.traverse(st, "C-z"));
+}
+
+TEST_CASE("KeyCmdMap::MetaKeys") {
+  KeyCmdMap kcm;
+  kcm.add("C-X C-S", "cmd1");
+  kcm.add("C-X C-C", "cmd2");
+  kcm.add("backspace", "cmd3");
+  kcm.add(" ", "cmd4");
+  kcm.add("C-backspace", "cmd5");
+  kcm.compile();
+  int st = KeyCmdMap::Root;
+  REQUIRE(TS_NON_LEAF == kcm.traverse(st, MetaKey(Meta_Ctrl, Key_CtrlX)));
+  REQUIRE(TS_LEAF == kcm.traverse(st, MetaKey(Meta_Ctrl, Key_CtrlS)));
+  REQUIRE("cmd1" == kcm.getCmd(st));
+  // unknown commands never resolve to a function
+  REQUIRE(nullptr == kcm.getFunc(st));
+  st = KeyCmdMap::Root;
+  REQUIRE(TS_NON_LEAF == kcm.traverse(st, MetaKey(Meta_Ctrl, Key_X)));
+  REQUIRE(TS_LEAF == kcm.traverse(st, "C-C"));
+  REQUIRE("cmd2" == kcm.getCmd(st));
+  st = KeyCmdMap::Root;
+  REQUIRE(TS_LEAF == kcm.traverse(st, MetaKey(Key_Backspace2)));
+  REQUIRE("cmd3" == kcm.getCmd(st));
+  st = KeyCmdMap::Root;
+  REQUIRE(TS_LEAF == kcm.traverse(st, MetaKey(Key_Space)));
+  REQUIRE("cmd4" == kcm.getCmd(st));
+  st = KeyCmdMap::Root;
+  REQUIRE(TS_LEAF == kcm.traverse(st, MetaKey(Meta_Ctrl, Key_CtrlH)));
+  REQUIRE("cmd5" == kcm.getCmd(st));
+  st = KeyCmdMap::Root;
+  REQUIRE(TS_NULL == kcm.traverse(st, MetaKey(Key_x)));
+  REQUIRE("" == kcm.getCmd(st));
+  REQUIRE(kcm.hasCmd("cmd3"));
+  kcm.add("backspace", "cmd6");
+  REQUIRE_FALSE(kcm.hasCmd("cmd3"));
+  REQUIRE(kcm.hasCmd("cmd6"));
+  REQUIRE_THROWS(kcm.add("C-X", "cmd7"));
+  REQUIRE_THROWS(kcm.add("C-backspace C-X", "cmd7"));
+  REQUIRE_THROWS(kcm.add("C-x C-foo", "cmd7"));
+}
+
+TEST_CASE("KeyCmdMap::Funcs") {
+  KeyCmdMap kcm;
+  kcm.add("C-Q", "quit");
+  kcm.compile();
+  int st = KeyCmdMap::Root;
+  REQUIRE(TS_LEAF == kcm.traverse(st, MetaKey(Meta_Ctrl, Key_CtrlQ)));
+  REQUIRE(getCmd("quit").first == kcm.getFunc(st));
+  kcm.clear();
+  REQUIRE(nullptr == kcm.getFunc(st));
+  kcm.compile();
+  st = KeyCmdMap::Root;
+  REQUIRE(TS_NULL == kcm.traverse(st, MetaKey(Meta_Ctrl, Key_CtrlQ)));
+  REQUIRE(nullptr == kcm.getFunc(st));
+}
+
+TEST_CASE("KeyCmdMap::SharedTraversals") {
+  KeyCmdMap kcm;
+  kcm.add("C-x C-s", "cmd1");
+  kcm.add("C-x C-c", "cmd2");
+  kcm.compile();
+  const auto& shared = kcm;
+  // eg: two buffers of the same mode, each midway through a key sequence
+  int st1 = KeyCmdMap::Root, st2 = KeyCmdMap::Root;
+  REQUIRE(TS_NON_LEAF == shared.traverse(st1, "C-x"));
+  REQUIRE(TS_NULL == shared.traverse(st2, "C-s"));
+  REQUIRE(TS_NON_LEAF == shared.traverse(st2, "C-x"));
+  REQUIRE(TS_LEAF == shared.traverse(st2, "C-c"));
+  REQUIRE(TS_LEAF == shared.traverse(st1, "C-s"));
+  REQUIRE("cmd1" == shared.getCmd(st1));
+  REQUIRE("cmd2" == shared.getCmd(st2));
 }
 
 } // end namespace teditor
@@ -54,4 +54,42 @@ TEST_CASE("Keys::MetaKey") {
     REQUIRE("F1" == mk4.toStr());
 }
 
+TEST_CASE("Keys::ParseAndIntern") {
+    MetaKey mk;
+    REQUIRE(MetaKey::parse("C-M-x", mk));
+    REQUIRE((Meta_Ctrl | Meta_Alt | Key_x) == mk.getFull());
+    REQUIRE(MetaKey::parse("C--", mk));
+    REQUIRE((Meta_Ctrl | Key_Minus) == mk.getFull());
+    REQUIRE(MetaKey::parse(" ", mk));
+    REQUIRE(Key_Space == mk.getFull());
+    REQUIRE(MetaKey::parse("F12", mk));
+    REQUIRE(Key_F12 == mk.getFull());
+    REQUIRE_FALSE(MetaKey::parse("F13", mk));
+    REQUIRE_FALSE(MetaKey::parse("C-", mk));
+    REQUIRE_FALSE(MetaKey::parse("foo", mk));
+    REQUIRE_FALSE(MetaKey::parse("", mk));
+    // aliases get interned to the same id
+    REQUIRE(MetaKey(Meta_Ctrl, Key_CtrlH).intern() ==
+            MetaKey(Meta_Ctrl, Key_Backspace2).intern());
+    REQUIRE(MetaKey(Meta_Ctrl, Key_CtrlA).intern() ==
+            MetaKey(Meta_Ctrl, Key_A).intern());
+    REQUIRE(MetaKey(Meta_Ctrl, Key_a).intern() !=
+            MetaKey(Meta_Ctrl, Key_A).intern());
+    // parse is the inverse of toStr, modulo the aliases
+    std::vector<key_t> keys;
+    for(key_t k = 0; k <= Key_Backspace2; ++k) keys.push_back(k);
+    for(key_t k = Key_ArrowUp; k <= Key_F1; ++k) keys.push_back(k);
+    for(key_t m : {Meta_None, Meta_Ctrl, Meta_Alt, Meta_Ctrl | Meta_Shift}) {
+      for(auto k : keys) {
+        MetaKey orig(m, k);
+        auto str = orig.toStr();
+        if(str.empty() || str.back() == '-') continue;
+        INFO("key=" << str);
+        REQUIRE(MetaKey::parse(str, mk));
+        REQUIRE(str == mk.toStr());
+        REQUIRE(orig.intern() == mk.intern());
+      }
+    }
+}
+
 } // end namespace teditor
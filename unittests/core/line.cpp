@@ -2,6 +2,7 @@
 #include "core/line.h"
 #include "core/buffer.h"
 #include "catch.hpp"
+#include <clocale>
 
 
 namespace teditor {
@@ -82,6 +83,169 @@ TEST_CASE("Line::prepend") {
     REQUIRE(4 == line.length());
 }
 
+TEST_CASE("Line::LongLines") {
+    LineArena arena;
+    Line line(&arena);
+    std::string str(Line::InlineCap - 1, 'a');
+    line.append(str);
+    REQUIRE(0 == line.heapBytes());
+    REQUIRE(0 == arena.stats().usedBytes);
+    line.append('b');
+    REQUIRE(str + "b" == line.get());
+    REQUIRE(LineArena::MinBlock == line.heapBytes());
+    REQUIRE(LineArena::MinBlock == arena.stats().usedBytes);
+    line.insert("cc", 1);
+    REQUIRE("acc" + str.substr(1) + "b" == line.get());
+    REQUIRE("cc" == line.erase(1, 2));
+    REQUIRE(str + "b" == line.get());
+    auto other = line.split(10);
+    REQUIRE(str.substr(0, 10) == line.get());
+    REQUIRE(str.substr(10) + "b" == other.get());
+    line.join(other);
+    REQUIRE(str + "b" == line.get());
+    // copies and moves
+    Line copy(line);
+    REQUIRE(line.get() == copy.get());
+    REQUIRE(2 * LineArena::MinBlock == arena.stats().usedBytes);
+    Line moved(std::move(copy));
+    REQUIRE(line.get() == moved.get());
+    REQUIRE(copy.empty());
+    REQUIRE(2 * LineArena::MinBlock == arena.stats().usedBytes);
+    moved = line;
+    REQUIRE(line.get() == moved.get());
+    line.clear();
+    REQUIRE(line.empty());
+    REQUIRE("" == line.get());
+}
+
+TEST_CASE("Line::LongLinesNoArena") {
+    Line line;
+    std::string str(100, 'x');
+    line.append(str);
+    REQUIRE(str == line.get());
+    REQUIRE(101 <= line.heapBytes());
+    line.prepend("yy");
+    REQUIRE("yy" + str == line.get());
+    Line other;
+    other = line;
+    REQUIRE("yy" + str == other.get());
+}
+
+TEST_CASE("Line::Columns") {
+    Line line;
+    SECTION("ascii") {
+        line.append("Hello");
+        REQUIRE(5 == line.numCols());
+        REQUIRE(3 == line.byte2col(3));
+        REQUIRE(3 == line.col2byte(3));
+        REQUIRE(5 == line.col2byte(10));
+        REQUIRE(4 == line.nextChar(3));
+        REQUIRE(2 == line.prevChar(3));
+        int x, row;
+        line.screenPos(4, 3, x, row);
+        REQUIRE(1 == x);
+        REQUIRE(1 == row);
+        REQUIRE(4 == line.screenIdx(1, 1, 3));
+        REQUIRE(2 == line.numLinesNeeded(3));
+    }
+    SECTION("multi-byte") {
+        // "h\u00e9llo" (e-acute is 2 bytes long)
+        line.append("h\xc3\xa9llo");
+        REQUIRE(6 == line.length());
+        REQUIRE(5 == line.numCols());
+        REQUIRE(1 == line.byte2col(1));
+        REQUIRE(1 == line.byte2col(2));
+        REQUIRE(2 == line.byte2col(3));
+        REQUIRE(5 == line.byte2col(6));
+        REQUIRE(3 == line.col2byte(2));
+        REQUIRE(1 == line.col2byte(1));
+        REQUIRE(3 == line.nextChar(1));
+        REQUIRE(1 == line.prevChar(3));
+        REQUIRE(2 == line.numLinesNeeded(3));
+        int x, row;
+        line.screenPos(4, 3, x, row);
+        REQUIRE(0 == x);
+        REQUIRE(1 == row);
+        REQUIRE(4 == line.screenIdx(0, 1, 3));
+        // index is recomputed after edits
+        line.erase(1, 2);
+        REQUIRE(4 == line.numCols());
+        REQUIRE(2 == line.col2byte(2));
+        line.insert("\xc3\xa9", 0);
+        REQUIRE(5 == line.numCols());
+        REQUIRE(2 == line.nextChar(0));
+    }
+    SECTION("malformed") {
+        // truncated 3-byte sequence is treated as individual bytes
+        line.append("a\xe4\xb8");
+        REQUIRE(3 == line.numCols());
+        REQUIRE(2 == line.nextChar(1));
+    }
+}
+
+TEST_CASE("Line::WideColumns") {
+    auto* old = setlocale(LC_CTYPE, nullptr);
+    std::string oldLocale(old == nullptr ? "C" : old);
+    if(setlocale(LC_CTYPE, "C.UTF-8") == nullptr) return;
+    Line line;
+    // "a\u4e2d\u6587b" (the CJK chars are 3 bytes and 2 columns each)
+    line.append("a\xe4\xb8\xad\xe6\x96\x87" "b");
+    REQUIRE(8 == line.length());
+    REQUIRE(6 == line.numCols());
+    REQUIRE(1 == line.byte2col(1));
+    REQUIRE(3 == line.byte2col(4));
+    REQUIRE(5 == line.byte2col(7));
+    REQUIRE(1 == line.col2byte(2));
+    REQUIRE(4 == line.col2byte(4));
+    // wide char not fitting at the end of a row moves to the next one
+    int x, row;
+    line.screenPos(4, 4, x, row);
+    REQUIRE(0 == x);
+    REQUIRE(1 == row);
+    line.screenPos(7, 4, x, row);
+    REQUIRE(2 == x);
+    REQUIRE(1 == row);
+    REQUIRE(2 == line.numLinesNeeded(4));
+    REQUIRE(4 == line.screenIdx(1, 1, 4));
+    REQUIRE(7 == line.screenIdx(2, 1, 4));
+    REQUIRE(2 == line.numLinesNeeded(5));
+    line.screenPos(7, 5, x, row);
+    REQUIRE(0 == x);
+    REQUIRE(1 == row);
+    setlocale(LC_CTYPE, oldLocale.c_str());
+}
+
+TEST_CASE("Line::ColumnRuns") {
+    auto* old = setlocale(LC_CTYPE, nullptr);
+    std::string oldLocale(old == nullptr ? "C" : old);
+    if(setlocale(LC_CTYPE, "C.UTF-8") == nullptr) return;
+    Line line;
+    // "\u00e9\u00e9ab\u4e2d\u4e2d" (runs of 2-byte and of 3-byte wide chars)
+    line.append("\xc3\xa9\xc3\xa9" "ab" "\xe4\xb8\xad\xe4\xb8\xad");
+    REQUIRE(12 == line.length());
+    REQUIRE(8 == line.numCols());
+    REQUIRE(1 == line.byte2col(2));
+    REQUIRE(1 == line.byte2col(3));
+    REQUIRE(2 == line.byte2col(4));
+    REQUIRE(6 == line.byte2col(9));
+    REQUIRE(6 == line.byte2col(10));
+    REQUIRE(8 == line.byte2col(12));
+    REQUIRE(2 == line.col2byte(1));
+    REQUIRE(5 == line.col2byte(3));
+    REQUIRE(6 == line.col2byte(5));
+    REQUIRE(9 == line.col2byte(6));
+    REQUIRE(9 == line.col2byte(7));
+    REQUIRE(2 == line.nextChar(0));
+    REQUIRE(4 == line.nextChar(2));
+    REQUIRE(9 == line.nextChar(6));
+    REQUIRE(12 == line.nextChar(9));
+    REQUIRE(2 == line.prevChar(4));
+    REQUIRE(5 == line.prevChar(6));
+    REQUIRE(6 == line.prevChar(9));
+    REQUIRE(9 == line.prevChar(12));
+    setlocale(LC_CTYPE, oldLocale.c_str());
+}
+
 TEST_CASE("Line::FindFirstNotOf") {
     Buffer ml;
     setupBuff(ml, {0, 0}, {30, 10}, "samples/multiline.txt");
@@ -0,0 +1,58 @@
+#include "core/line_arena.h"
+#include "catch.hpp"
+
+
+namespace teditor {
+
+TEST_CASE("LineArena::Alloc") {
+  LineArena arena;
+  int size = 40;
+  auto* a = arena.alloc(size);
+  REQUIRE(LineArena::MinBlock == size);
+  REQUIRE(1 == arena.stats().numSlabs);
+  REQUIRE(LineArena::SlabSize == arena.stats().slabBytes);
+  REQUIRE(LineArena::MinBlock == arena.stats().usedBytes);
+  size = 100;
+  auto* b = arena.alloc(size);
+  REQUIRE(128 == size);
+  REQUIRE(a + LineArena::MinBlock == b);
+  REQUIRE(LineArena::MinBlock + 128 == arena.stats().usedBytes);
+  // freed blocks get recycled
+  arena.free(b, 128);
+  REQUIRE(LineArena::MinBlock == arena.stats().usedBytes);
+  size = 65;
+  REQUIRE(b == arena.alloc(size));
+  REQUIRE(128 == size);
+  REQUIRE(1 == arena.stats().numSlabs);
+}
+
+TEST_CASE("LineArena::Large") {
+  LineArena arena;
+  int size = LineArena::MaxBlock + 1;
+  auto* a = arena.alloc(size);
+  REQUIRE(LineArena::MaxBlock + 1 == size);
+  REQUIRE(0 == arena.stats().numSlabs);
+  REQUIRE(size_t(size) == arena.stats().largeBytes);
+  arena.free(a, size);
+  REQUIRE(0 == arena.stats().largeBytes);
+}
+
+TEST_CASE("LineArena::Release") {
+  LineArena arena;
+  int count = 2 * LineArena::SlabSize / LineArena::MaxBlock;
+  for(int i = 0; i < count; ++i) {
+    int size = LineArena::MaxBlock;
+    arena.alloc(size);
+  }
+  REQUIRE(2 == arena.stats().numSlabs);
+  arena.beginRelease();
+  arena.release();
+  REQUIRE(0 == arena.stats().numSlabs);
+  REQUIRE(0 == arena.stats().slabBytes);
+  REQUIRE(0 == arena.stats().usedBytes);
+  int size = 10;
+  arena.alloc(size);
+  REQUIRE(1 == arena.stats().numSlabs);
+}
+
+} // end namespace teditor
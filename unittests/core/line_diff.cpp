@@ -0,0 +1,90 @@
+#include "testutils.h"
+#include "core/line_diff.h"
+#include "catch.hpp"
+#include <random>
+
+
+namespace teditor {
+
+/** applies the hunks on the old lines, the same way watch-mode does */
+Strings applyHunks(const Strings& oldLines, const Strings& newLines,
+                   const DiffHunks& hunks) {
+  Strings ret(oldLines);
+  for(auto itr = hunks.rbegin(); itr != hunks.rend(); ++itr) {
+    ret.erase(ret.begin() + itr->oldStart,
+              ret.begin() + itr->oldStart + itr->oldLen);
+    ret.insert(ret.begin() + itr->oldStart,
+               newLines.begin() + itr->newStart,
+               newLines.begin() + itr->newStart + itr->newLen);
+  }
+  return ret;
+}
+
+int numEdits(const DiffHunks& hunks) {
+  int ret = 0;
+  for(const auto& h : hunks) ret += h.oldLen + h.newLen;
+  return ret;
+}
+
+TEST_CASE("LineDiff::Basic") {
+  Strings a{"a", "b", "c", "d"};
+  SECTION("same") {
+    REQUIRE(diffLines(a, a).empty());
+  }
+  SECTION("empty") {
+    auto hunks = diffLines(Strings(), a);
+    REQUIRE(hunks.size() == 1);
+    REQUIRE(hunks[0] == DiffHunk{0, 0, 0, 4});
+    hunks = diffLines(a, Strings());
+    REQUIRE(hunks.size() == 1);
+    REQUIRE(hunks[0] == DiffHunk{0, 4, 0, 0});
+  }
+  SECTION("change") {
+    Strings b{"a", "x", "c", "d"};
+    auto hunks = diffLines(a, b);
+    REQUIRE(hunks.size() == 1);
+    REQUIRE(hunks[0] == DiffHunk{1, 1, 1, 1});
+  }
+  SECTION("insert and delete") {
+    Strings b{"b", "c", "x", "y", "d", "e"};
+    auto hunks = diffLines(a, b);
+    REQUIRE(hunks.size() == 3);
+    REQUIRE(hunks[0] == DiffHunk{0, 1, 0, 0});
+    REQUIRE(hunks[1] == DiffHunk{3, 0, 2, 2});
+    REQUIRE(hunks[2] == DiffHunk{4, 0, 5, 1});
+    REQUIRE(applyHunks(a, b, hunks) == b);
+  }
+  SECTION("minimal") {
+    Strings x{"a", "b", "c", "a", "b", "b", "a"};
+    Strings y{"c", "b", "a", "b", "a", "c"};
+    auto hunks = diffLines(x, y);
+    // the classic example from Myers' paper has an edit distance of 5
+    REQUIRE(numEdits(hunks) == 5);
+    REQUIRE(applyHunks(x, y, hunks) == y);
+  }
+  SECTION("max edits") {
+    Strings b{"w", "x", "y", "z"};
+    auto hunks = diffLines(a, b, 2);
+    REQUIRE(hunks.size() == 1);
+    REQUIRE(hunks[0] == DiffHunk{0, 4, 0, 4});
+  }
+}
+
+TEST_CASE("LineDiff::Random") {
+  std::mt19937 rng(123);
+  for(int iter = 0; iter < 100; ++iter) {
+    Strings a, b;
+    int n = rng() % 50, m = rng() % 50;
+    for(int i = 0; i < n; ++i) a.push_back(std::to_string(rng() % 5));
+    for(int i = 0; i < m; ++i) b.push_back(std::to_string(rng() % 5));
+    auto hunks = diffLines(a, b);
+    REQUIRE(applyHunks(a, b, hunks) == b);
+    // successive hunks are always separated by atleast one common line
+    for(size_t i = 1; i < hunks.size(); ++i) {
+      REQUIRE(hunks[i - 1].oldStart + hunks[i - 1].oldLen < hunks[i].oldStart);
+      REQUIRE(hunks[i - 1].newStart + hunks[i - 1].newLen < hunks[i].newStart);
+    }
+  }
+}
+
+} // end namespace teditor
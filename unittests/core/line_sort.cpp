@@ -0,0 +1,111 @@
+#include "core/line_sort.h"
+#include "core/timer.h"
+#include "core/utils.h"
+#include "catch.hpp"
+#include <algorithm>
+#include <stdlib.h>
+
+
+namespace teditor {
+
+std::vector<Line> makeLines(const Strings& strs) {
+  std::vector<Line> lines;
+  for(const auto& s : strs) {
+    lines.push_back(Line());
+    lines.back().append(s);
+  }
+  return lines;
+}
+
+Strings applyPerm(const std::vector<Line>& lines, const std::vector<int>& perm,
+                  int numKept) {
+  Strings out;
+  for(int i = 0; i < numKept; ++i) out.push_back(lines[perm[i]].get());
+  return out;
+}
+
+TEST_CASE("LineSort::Default") {
+  auto lines = makeLines({"banana", "apple", "", "apple pie", "Cherry",
+                          "apple"});
+  int numKept;
+  auto perm = sortPermutation(lines, 0, (int)lines.size(), Sort_Default,
+                              numKept);
+  REQUIRE(6 == numKept);
+  Strings exp = {"", "Cherry", "apple", "apple", "apple pie", "banana"};
+  REQUIRE(exp == applyPerm(lines, perm, numKept));
+  // stable: the first 'apple' comes first
+  REQUIRE(1 == perm[2]);
+  REQUIRE(5 == perm[3]);
+}
+
+TEST_CASE("LineSort::SubRange") {
+  auto lines = makeLines({"z", "c", "b", "a", "0"});
+  int numKept;
+  auto perm = sortPermutation(lines, 1, 4, Sort_Default, numKept);
+  REQUIRE(3 == numKept);
+  REQUIRE(std::vector<int>({2, 1, 0}) == perm);
+}
+
+TEST_CASE("LineSort::Reverse") {
+  auto lines = makeLines({"b", "a", "c"});
+  int numKept;
+  auto perm = sortPermutation(lines, 0, 3, Sort_Reverse, numKept);
+  REQUIRE(Strings({"c", "b", "a"}) == applyPerm(lines, perm, numKept));
+}
+
+TEST_CASE("LineSort::ICase") {
+  auto lines = makeLines({"banana", "Apple", "cherry", "apple"});
+  int numKept;
+  auto perm = sortPermutation(lines, 0, 4, Sort_ICase, numKept);
+  REQUIRE(Strings({"Apple", "apple", "banana", "cherry"}) ==
+          applyPerm(lines, perm, numKept));
+  perm = sortPermutation(lines, 0, 4, Sort_ICase | Sort_Unique, numKept);
+  REQUIRE(3 == numKept);
+  REQUIRE(Strings({"Apple", "banana", "cherry"}) ==
+          applyPerm(lines, perm, numKept));
+  REQUIRE(3 == perm[3]);
+}
+
+TEST_CASE("LineSort::Numeric") {
+  auto lines = makeLines({"10 ten", "  2 two", "-1 minus", "abc", "2.5"});
+  int numKept;
+  auto perm = sortPermutation(lines, 0, 5, Sort_Numeric, numKept);
+  REQUIRE(Strings({"-1 minus", "abc", "  2 two", "2.5", "10 ten"}) ==
+          applyPerm(lines, perm, numKept));
+  perm = sortPermutation(lines, 0, 5, Sort_Numeric | Sort_Reverse, numKept);
+  REQUIRE(Strings({"10 ten", "2.5", "  2 two", "abc", "-1 minus"}) ==
+          applyPerm(lines, perm, numKept));
+}
+
+TEST_CASE("LineSort::Unique") {
+  auto lines = makeLines({"b", "a", "b", "c", "a", "a"});
+  int numKept;
+  auto perm = sortPermutation(lines, 0, 6, Sort_Unique, numKept);
+  REQUIRE(3 == numKept);
+  REQUIRE(Strings({"a", "b", "c"}) == applyPerm(lines, perm, numKept));
+  // duplicates are stored at the end
+  REQUIRE(std::vector<int>({1, 0, 3, 4, 5, 2}) == perm);
+}
+
+TEST_CASE("LineSort::Large") {
+  Strings strs;
+  srand(42);
+  for(int i = 0; i < 100000; ++i) strs.push_back(num2str(rand() % 50000));
+  auto lines = makeLines(strs);
+  int numKept;
+  tic("sortPermutation");
+  auto perm = sortPermutation(lines, 0, (int)lines.size(), Sort_Default,
+                              numKept);
+  toc("sortPermutation");
+  // takes a few ms. Seconds means the key cache is being copied around
+  REQUIRE(getTimer("sortPermutation").elapsed() < 1.0);
+  auto exp = strs;
+  std::stable_sort(exp.begin(), exp.end());
+  REQUIRE(exp == applyPerm(lines, perm, numKept));
+  perm = sortPermutation(lines, 0, (int)lines.size(), Sort_Numeric, numKept);
+  auto sorted = applyPerm(lines, perm, numKept);
+  for(size_t i = 1; i < sorted.size(); ++i)
+    REQUIRE(str2num(sorted[i - 1]) <= str2num(sorted[i]));
+}
+
+} // end namespace teditor
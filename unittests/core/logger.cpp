@@ -0,0 +1,137 @@
+#include "testutils.h"
+#include "core/logger.h"
+#include "core/file_utils.h"
+#include "core/timer.h"
+#include "catch.hpp"
+#include <fstream>
+#include <unistd.h>
+
+
+namespace teditor {
+
+int countLines(const std::string& file) {
+  std::ifstream fp(file);
+  std::string line;
+  int count = 0;
+  while(std::getline(fp, line)) ++count;
+  return count;
+}
+
+TEST_CASE("Logger::Basic") {
+  std::string file("logger-test.log");
+  {
+    SingletonHandler<Logger, std::string> shl(file);
+    REQUIRE_FALSE(Logger::isEnabled(0));
+    Logger::setLevel(100);
+    REQUIRE(Logger::isEnabled(10));
+    REQUIRE_FALSE(Logger::isEnabled(1000));
+    ERROR("hello %d\n", 42);
+    // filtered out at runtime
+    LOG(1000, "should not be there\n");
+    const int N = 4, M = 500;
+    std::vector<std::thread> threads;
+    for(int t = 0; t < N; ++t) {
+      threads.push_back(std::thread([t]() {
+            for(int i = 0; i < M; ++i) LOG(100, "thread=%d i=%d\n", t, i);
+          }));
+    }
+    for(auto& t : threads) t.join();
+    Logger::flush();
+    REQUIRE(1 + N * M == countLines(file));
+    std::ifstream fp(file);
+    std::string line;
+    std::getline(fp, line);
+    // header and the message are a single record
+    REQUIRE(line.find("unittests/core/logger.cpp:") == 0);
+    REQUIRE(line.find("Lev=10 DLev=100 hello 42") != std::string::npos);
+  }
+  REQUIRE_FALSE(Logger::isEnabled(0));
+  unlink(file.c_str());
+}
+
+TEST_CASE("Logger::SyncErrors") {
+  std::string file("logger-sync.log");
+  {
+    SingletonHandler<Logger, std::string> shl(file);
+    Logger::setLevel(100);
+    LOG(100, "buffered\n");
+    ERROR("error\n");
+    // no flush needed, errors get written out before returning
+    REQUIRE(2 == countLines(file));
+    FATAL("fatal\n");
+    REQUIRE(3 == countLines(file));
+  }
+  unlink(file.c_str());
+}
+
+TEST_CASE("Logger::Wakeup") {
+  std::string file("logger-wakeup.log");
+  {
+    SingletonHandler<Logger, std::string> shl(file);
+    Logger::setLevel(100);
+    // the writer sleeps in between, but has to wake up for each of these
+    for(int i = 1; i <= 3; ++i) {
+      LOG(100, "record %d\n", i);
+      for(int j = 0; j < 200 && countLines(file) < i; ++j) usleep(10000);
+      REQUIRE(i == countLines(file));
+    }
+  }
+  unlink(file.c_str());
+}
+
+TEST_CASE("Logger::Rotation") {
+  std::string file("logger-rot.log");
+  {
+    SingletonHandler<Logger, std::string> shl(file);
+    Logger::setLevel(100);
+    Logger::setRotation(1024, 2);
+    for(int i = 0; i < 3; ++i) {
+      for(int j = 0; j < 20; ++j)
+        LOG(100, "i=%d j=%d some more padding\n", i, j);
+      Logger::flush();
+    }
+    LOG(100, "last one\n");
+    Logger::flush();
+  }
+  REQUIRE(isFile(file));
+  REQUIRE(isFile(file + ".1"));
+  REQUIRE(isFile(file + ".2"));
+  REQUIRE_FALSE(isFile(file + ".3"));
+  // rotated right after the record crossing the limit, whenever it's drained
+  for(const auto& f : {file + ".1", file + ".2"}) {
+    auto str = slurp(f);
+    auto lastLen = str.size() - str.rfind('\n', str.size() - 2) - 1;
+    REQUIRE(1024U <= str.size());
+    REQUIRE(1024U > str.size() - lastLen);
+  }
+  auto last = slurp(file);
+  REQUIRE(last.size() < 1024U);
+  REQUIRE(last.find("last one\n") == last.size() - 9);
+  for(const auto& f : {file, file + ".1", file + ".2"}) unlink(f.c_str());
+}
+
+// Not run by default. Use: teditor-tests "[bench]"
+TEST_CASE("Logger::Bench", "[.][bench]") {
+  std::string file("logger-bench.log");
+  const int N = 1000000;
+  {
+    SingletonHandler<Logger, std::string> shl(file);
+    Logger::setLevel(100000);
+    tic("log");
+    for(int i = 0; i < N; ++i) {
+      LOG(100, "render: y,x=%d,%d back=%u front=%u\n", i, i, 1u, 2u);
+      // be nice to the ring, else records get dropped
+      if(i % 1000 == 0) Logger::flush();
+    }
+    toc("log");
+    tic("disabled");
+    Logger::setLevel(-1);
+    for(int i = 0; i < N; ++i) LOG(100, "render: y,x=%d,%d\n", i, i);
+    toc("disabled");
+  }
+  printf("logger: %d records in %lf s, disabled: %lf s\n", N,
+         getTimer("log").elapsed(), getTimer("disabled").elapsed());
+  unlink(file.c_str());
+}
+
+} // end namespace teditor
@@ -1,5 +1,6 @@
 #include "core/mode.h"
 #include "catch.hpp"
+#include <vector>
 
 namespace teditor {
 
@@ -14,4 +15,23 @@ TEST_CASE("Mode::inferMode") {
   REQUIRE("text" == Mode::inferMode("file.txt", false));
 }
 
+TEST_CASE("Mode::SharedTables") {
+  auto text = Mode::createMode("text");
+  auto ro = Mode::createMode("ro");
+  int built = Mode::numTablesBuilt(), created = Mode::numCreated();
+  std::vector<ModePtr> modes;
+  for(int i = 0; i < 200; ++i) modes.push_back(Mode::createMode("text"));
+  REQUIRE(built == Mode::numTablesBuilt());
+  REQUIRE(created + 200 == Mode::numCreated());
+  for(auto& m : modes) {
+    REQUIRE(&text->getKeyCmdMap() == &m->getKeyCmdMap());
+    REQUIRE(&text->getColorMap() == &m->getColorMap());
+  }
+  // every mode has its own tables, even when they share the class hierarchy
+  REQUIRE(&text->getKeyCmdMap() != &ro->getKeyCmdMap());
+  REQUIRE(text->getKeyCmdMap().hasCmd(".insert-char"));
+  REQUIRE_FALSE(ro->getKeyCmdMap().hasCmd(".insert-char"));
+  REQUIRE(ro->getKeyCmdMap().hasCmd("kill-this-buffer"));
+}
+
 } // end namespace teditor
@@ -22,6 +22,17 @@ TEST_CASE("Option::ExpandOptions") {
           Option::get("orgNotesDir").getStr());
 }
 
+TEST_CASE("Option::ProfileStartup") {
+  std::vector<FileInfo> files;
+  parseArgs(0, nullptr, files);
+  REQUIRE_FALSE(Option::get("profileStartup").getBool());
+  const char* argv[] = {"teditor", "--profile-startup", "file.txt"};
+  REQUIRE(parseArgs(3, const_cast<char**>(argv), files));
+  REQUIRE(Option::get("profileStartup").getBool());
+  REQUIRE(1U == files.size());
+  Option::set("profileStartup", "NO");
+}
+
 TEST_CASE("Option::parseRcFile") {
   parseRcFile("samples/default.rcfile");
   REQUIRE(expandEnvVars("$HOME/.teditor/org") ==
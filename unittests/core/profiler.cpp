@@ -0,0 +1,87 @@
+#include "testutils.h"
+#include "core/profiler.h"
+#include "core/parser/nfa.h"
+#include "core/timer.h"
+#include "catch.hpp"
+#include <thread>
+
+
+namespace teditor {
+
+TEST_CASE("Profiler::Buckets") {
+  REQUIRE(0 == Profiler::bucketOf(0));
+  REQUIRE(3 == Profiler::bucketOf(3));
+  REQUIRE(4 == Profiler::bucketOf(4));
+  REQUIRE(7 == Profiler::bucketOf(7));
+  REQUIRE(8 == Profiler::bucketOf(8));
+  REQUIRE(8 == Profiler::bucketOf(9));
+  REQUIRE(9 == Profiler::bucketOf(10));
+  REQUIRE(Profiler::NumBuckets - 1 == Profiler::bucketOf(UINT64_MAX));
+  for(int b = 0; b < Profiler::NumBuckets; ++b) {
+    auto start = Profiler::bucketStart(b);
+    REQUIRE(b == Profiler::bucketOf(start));
+    if(b > 0) REQUIRE(b - 1 == Profiler::bucketOf(start - 1));
+  }
+}
+
+TEST_CASE("Profiler::Summary") {
+  Profiler::reset();
+  // 90 fast ones of 1us and 10 slow ones of 1ms
+  for(int i = 0; i < 90; ++i) Profiler::record(Probe_BufferSave, 1000);
+  std::thread t([]() {
+      for(int i = 0; i < 10; ++i) Profiler::record(Probe_BufferSave, 1000000);
+    });
+  t.join();
+  auto sum = Profiler::summary();
+  REQUIRE(size_t(Probe_Count) == sum.size());
+  const auto& ps = sum[Probe_BufferSave];
+  REQUIRE("Buffer::save" == ps.name);
+  REQUIRE(100 == ps.count);
+  REQUIRE(ps.totalMs == Approx(10.09));
+  REQUIRE(ps.meanUs == Approx(100.9));
+  REQUIRE(ps.maxUs == Approx(1000.0));
+  // percentiles are accurate to within the bucket width (25%)
+  REQUIRE(ps.p50Us == Approx(1.0).epsilon(0.25));
+  REQUIRE(ps.p90Us == Approx(1.0).epsilon(0.25));
+  REQUIRE(ps.p99Us == Approx(1000.0).epsilon(0.25));
+  Profiler::reset();
+  REQUIRE(0 == Profiler::summary()[Probe_BufferSave].count);
+}
+
+TEST_CASE("Profiler::ScopedProbe") {
+  Profiler::reset();
+  {
+    PROBE(BufferLoad);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  Profiler::setEnabled(false);
+  {
+    PROBE(BufferLoad);
+  }
+  Profiler::setEnabled(true);
+  auto ps = Profiler::summary()[Probe_BufferLoad];
+  REQUIRE(1 == ps.count);
+  REQUIRE(ps.maxUs >= 2000.0);
+  Profiler::reset();
+}
+
+// Not run by default. Use: teditor-tests "[bench]"
+TEST_CASE("Profiler::NfaOverhead", "[.][bench]") {
+  parser::NFA nfa("[a-z]+@[a-z]+[.]com");
+  std::string str(std::string(1000, ' ') + "user@example.com");
+  const int N = 2000;
+  size_t pos = 0;
+  Profiler::setEnabled(false);
+  tic("disabled");
+  for(int i = 0; i < N; ++i) nfa.findAny(str, pos);
+  toc("disabled");
+  Profiler::setEnabled(true);
+  tic("enabled");
+  for(int i = 0; i < N; ++i) nfa.findAny(str, pos);
+  toc("enabled");
+  printf("NFA::findAny: probes disabled: %lf s, enabled: %lf s\n",
+         getTimer("disabled").elapsed(), getTimer("enabled").elapsed());
+  Profiler::reset();
+}
+
+} // end namespace teditor
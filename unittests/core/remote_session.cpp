@@ -0,0 +1,142 @@
+#include "core/remote_session.h"
+#include "core/file_utils.h"
+#include "core/option.h"
+#include "core/timer.h"
+#include "catch.hpp"
+#include <signal.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace teditor {
+
+TEST_CASE("RemoteSession") {
+  auto root = tempFileName();
+  makeDir(root);
+  // the helper runs locally as a stand-in for the remote host
+  RemoteSession rs({"sh", "-c", RemoteSession::HelperScript});
+  REQUIRE_FALSE(rs.alive());
+  std::string data("line1\n\0binary\nno newline at end", 31);
+  auto replies = rs.request({
+    {"mkdir", root + "/sub/dir", ""},
+    {"save", root + "/a.txt", data},
+    {"stat", root + "/sub", ""},
+    {"stat", root + "/a.txt", ""},
+    {"stat", root + "/missing", ""},
+    {"load", root + "/a.txt", ""},
+    {"load", root + "/missing", ""},
+    {"list", root, ""},
+    {"run", root + "/sub", "pwd; exit 3"},
+    {"bogus", root, ""},
+  });
+  REQUIRE(rs.alive());
+  REQUIRE(10U == replies.size());
+  REQUIRE(0 == replies[0].status);
+  REQUIRE(isDir(root + "/sub/dir"));
+  REQUIRE(0 == replies[1].status);
+  REQUIRE("d\n" == replies[2].data);
+  REQUIRE("f\n" == replies[3].data);
+  REQUIRE("-\n" == replies[4].data);
+  REQUIRE(0 == replies[5].status);
+  REQUIRE(data == replies[5].data);
+  REQUIRE(0 != replies[6].status);
+  REQUIRE(Strings({".", "..", "a.txt", "sub"}) ==
+          DirCache::names(replies[7].data));
+  REQUIRE(3 == replies[8].status);
+  REQUIRE(root + "/sub\n" == replies[8].data);
+  REQUIRE(127 == replies[9].status);
+  // large payloads are read in blocks, and exactly upto their size
+  std::string big(4 * 1024 * 1024 + 7, 'x');
+  for(size_t i = 0; i < big.size(); i += 4099) big[i] = char('a' + i % 26);
+  tic("RemoteSessionBig");
+  replies = rs.request({
+    {"save", root + "/big", big},
+    {"run", root, "echo hi > \"with space\"; ln -s a.txt link"},
+    {"load", root + "/big", ""},
+    {"list", root, ""},
+  });
+  toc("RemoteSessionBig");
+  REQUIRE(getTimer("RemoteSessionBig").elapsed() < 5.0);
+  REQUIRE(4U == replies.size());
+  REQUIRE(0 == replies[1].status);
+  REQUIRE(big == replies[2].data);
+  REQUIRE(Strings({".", "..", "a.txt", "big", "link", "sub", "with space"}) ==
+          DirCache::names(replies[3].data));
+  REQUIRE(replies[3].data.find("  -rw") != std::string::npos);
+  REQUIRE(replies[3].data.find("  lrwx") != std::string::npos);
+  REQUIRE(replies[3].data.find(format("  %8d  big\n", (int)big.size())) !=
+          std::string::npos);
+  REQUIRE(0 != rs.request({"list", root + "/missing", ""}).status);
+  // a dead connection gets re-established
+  auto pid = rs.helperPid();
+  kill(pid, SIGKILL);
+  auto reply = rs.request({"stat", root, ""});
+  REQUIRE("d\n" == reply.data);
+  REQUIRE(pid != rs.helperPid());
+  RemoteSession bad({root + "/no-such-helper"});
+  REQUIRE_THROWS(bad.request({"stat", root, ""}));
+  REQUIRE_FALSE(bad.alive());
+  // a helper which dies after receiving a request, without replying to it
+  auto log = root + "/ops.log";
+  auto dying = "read -r op n p; echo $op >> " + log;
+  RemoteSession once({"sh", "-c", dying});
+  REQUIRE_THROWS(once.request({"run", root, "touch " + root + "/ran"}));
+  // non-idempotent ones are never sent again
+  REQUIRE("run\n" == slurp(log));
+  REQUIRE_THROWS(once.request({"stat", root, ""}));
+  // whereas the read-only ones are retried
+  REQUIRE("run\nstat\nstat\n" == slurp(log));
+  // a helper which stops responding is deemed dead
+  RemoteSession hung({"sh", "-c", "sleep 5"}, 200);
+  tic("RemoteSessionTimeout");
+  REQUIRE_THROWS(hung.request({"stat", root, ""}));
+  toc("RemoteSessionTimeout");
+  REQUIRE(getTimer("RemoteSessionTimeout").elapsed() < 3.0);
+  REQUIRE_FALSE(hung.alive());
+  check_output("rm -rf " + root);
+}
+
+TEST_CASE("RemoteSession::FileUtils") {
+  std::vector<FileInfo> files;
+  parseArgs(0, nullptr, files);
+  auto root = tempFileName();
+  makeDir(root);
+  // pretends to be ssh, by running the command locally
+  auto fakeSsh = root + "/fake-ssh";
+  FILE* fp = fopen(fakeSsh.c_str(), "w");
+  REQUIRE(fp != nullptr);
+  fprintf(fp, "#!/bin/sh\nshift\nexec sh -c \"$1\"\n");
+  fclose(fp);
+  REQUIRE(0 == chmod(fakeSsh.c_str(), 0755));
+  auto oldCmd = Option::get("ssh:cmd").getStr();
+  Option::set("ssh:cmd", fakeSsh);
+  RemoteSession::closeAll();
+  auto remote = "/ssh:fakehost:" + root;
+  makeDir(remote + "/d");
+  auto pid = RemoteSession::get("fakehost").helperPid();
+  REQUIRE(isDir(remote + "/d"));
+  REQUIRE_FALSE(isFile(remote + "/d"));
+  REQUIRE_FALSE(isFile(remote + "/missing"));
+  auto local = tempFileName();
+  fp = fopen(local.c_str(), "w");
+  fprintf(fp, "hello\nworld\n");
+  fclose(fp);
+  copyToRemote(remote + "/f.txt", local);
+  REQUIRE(isFile(remote + "/f.txt"));
+  auto copy = copyFromRemote(remote + "/f.txt");
+  REQUIRE("hello\nworld\n" == slurp(copy));
+  REQUIRE(Strings({".", "..", "d", "f.txt", "fake-ssh"}) == listDirRel(remote));
+  REQUIRE(listDir2str(remote).find("  f.txt\n") != std::string::npos);
+  REQUIRE(remote + "/f.txt" == findFirstUpwards(remote + "/d", "f.txt"));
+  REQUIRE("" == findFirstUpwards(remote + "/d", "no-such-file"));
+  REQUIRE("hi\n" == check_output("echo hi", "fakehost").output);
+  // all of the above went over the same connection
+  REQUIRE(pid == RemoteSession::get("fakehost").helperPid());
+  RemoteSession::closeAll();
+  Option::set("ssh:cmd", oldCmd);
+  unlink(local.c_str());
+  unlink(copy.c_str());
+  check_output("rm -rf " + root);
+}
+
+} // end namespace teditor
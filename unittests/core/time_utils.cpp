@@ -266,6 +266,38 @@ TEST_CASE("weekFor") {
   weekFor(start, end, timeFromStr("2020-10-07"));
   REQUIRE("2020-10-04" == timeToDateStr(start));
   REQUIRE("2020-10-10" == timeToDateStr(end));
+  TimePoint start1, end1;
+  weekFor(start1, end1, timeFromStr("2020-10-08 13:14:15"));
+  REQUIRE(start == start1);
+  REQUIRE(end == end1);
+  REQUIRE("2020-10-04 00:00:00" == timeToStr(start1));
+}
+
+TEST_CASE("monthFor") {
+  TimePoint start, end;
+  monthFor(start, end, timeFromStr("2020-02-07 10:11:12"));
+  REQUIRE("2020-02-01 00:00:00" == timeToStr(start));
+  REQUIRE("2020-02-29 23:59:59" == timeToStr(end));
+  monthFor(start, end, timeFromStr("2020-12-31"));
+  REQUIRE("2020-12-01 00:00:00" == timeToStr(start));
+  REQUIRE("2020-12-31 23:59:59" == timeToStr(end));
+}
+
+TEST_CASE("quarterFor") {
+  TimePoint start, end;
+  quarterFor(start, end, timeFromStr("2020-08-07"));
+  REQUIRE("2020-07-01 00:00:00" == timeToStr(start));
+  REQUIRE("2020-09-30 23:59:59" == timeToStr(end));
+  quarterFor(start, end, timeFromStr("2020-10-01"));
+  REQUIRE("2020-10-01 00:00:00" == timeToStr(start));
+  REQUIRE("2020-12-31 23:59:59" == timeToStr(end));
+}
+
+TEST_CASE("yearFor") {
+  TimePoint start, end;
+  yearFor(start, end, timeFromStr("2020-08-07"));
+  REQUIRE("2020-01-01 00:00:00" == timeToStr(start));
+  REQUIRE("2020-12-31 23:59:59" == timeToStr(end));
 }
 
 } // end namespace teditor
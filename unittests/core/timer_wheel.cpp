@@ -0,0 +1,77 @@
+#include "testutils.h"
+#include "core/timer_wheel.hpp"
+#include "catch.hpp"
+#include <algorithm>
+#include <map>
+#include <random>
+
+
+namespace teditor {
+
+TEST_CASE("TimerWheel::Basic") {
+  TimerWheel<int> tw;
+  std::vector<int> exp;
+  REQUIRE(tw.empty());
+  tw.add(5, 1);
+  tw.add(3, 2);
+  tw.add(0, 3);  // in the past, fires at the next tick
+  REQUIRE(3 == tw.size());
+  tw.advance(1, exp);
+  REQUIRE(exp == std::vector<int>{3});
+  exp.clear();
+  tw.advance(4, exp);
+  REQUIRE(exp == std::vector<int>{2});
+  exp.clear();
+  tw.advance(100, exp);
+  REQUIRE(exp == std::vector<int>{1});
+  REQUIRE(tw.empty());
+  REQUIRE(100 == tw.now());
+  // advancing an empty wheel is O(1)
+  tw.advance(1000000000ULL, exp);
+  REQUIRE(1000000000ULL == tw.now());
+}
+
+TEST_CASE("TimerWheel::TicksToNext") {
+  TimerWheel<int> tw;
+  REQUIRE(size_t(TimerWheel<int>::Slots) == tw.ticksToNext());
+  tw.add(10, 1);
+  REQUIRE(10 == tw.ticksToNext());
+  tw.add(1000, 2);
+  REQUIRE(10 == tw.ticksToNext());
+  std::vector<int> exp;
+  tw.advance(10, exp);
+  // next one is on a higher level, so wait only until the next cascade
+  REQUIRE(54 == tw.ticksToNext());
+}
+
+TEST_CASE("TimerWheel::Random") {
+  std::mt19937 rng(42);
+  // cover every level as well as the overflow list
+  const uint64_t spans[] = {50, 3000, 200000, 20000000, 40000000000ULL};
+  TimerWheel<int> tw(12345);
+  std::multimap<uint64_t, int> ref;
+  int id = 0;
+  for (int iter = 0; iter < 2000; ++iter) {
+    auto span = spans[rng() % 5];
+    auto expiry = tw.now() + 1 + rng() % span;
+    tw.add(expiry, id);
+    ref.insert({expiry, id});
+    ++id;
+    if (rng() % 4 != 0) continue;
+    // advance just enough to make the next few timers expire
+    auto now = std::next(ref.begin(), std::min<size_t>(ref.size() - 1,
+                                                       rng() % 3))->first;
+    std::vector<int> exp, expected;
+    tw.advance(now, exp);
+    while (!ref.empty() && ref.begin()->first <= now) {
+      expected.push_back(ref.begin()->second);
+      ref.erase(ref.begin());
+    }
+    std::sort(exp.begin(), exp.end());
+    std::sort(expected.begin(), expected.end());
+    REQUIRE(expected == exp);
+    REQUIRE(ref.size() == tw.size());
+  }
+}
+
+} // end namespace teditor
@@ -0,0 +1,89 @@
+#include "core/utils.h"
+#include "core/vt_screen.h"
+#include "catch.hpp"
+
+namespace teditor {
+
+TEST_CASE("VtScreen::Basic") {
+  VtScreen vt(10, 4);
+  REQUIRE(10U == vt.cells().w());
+  REQUIRE(4U == vt.cells().h());
+  REQUIRE(vt.row(0).empty());
+  vt.feed("hello");
+  REQUIRE("hello" == vt.row(0));
+  REQUIRE(Pos2di(5, 0) == vt.cursor());
+  vt.feed("\033[2;3Hab");
+  REQUIRE("  ab" == vt.row(1));
+  REQUIRE(Pos2di(4, 1) == vt.cursor());
+  // cursor is clamped to the screen
+  vt.feed("\033[100;100H");
+  REQUIRE(Pos2di(9, 3) == vt.cursor());
+  vt.feed("\033[H\033[2J");
+  for(int y = 0; y < 4; ++y) REQUIRE(vt.row(y).empty());
+  REQUIRE(Pos2di(0, 0) == vt.cursor());
+}
+
+TEST_CASE("VtScreen::Colors") {
+  VtScreen vt(10, 4);
+  vt.feed("\033[38;5;3;48;5;4mX\033(B\033[m\033[1mY");
+  REQUIRE('X' == vt.at(0, 0).ch);
+  REQUIRE(3 == vt.at(0, 0).fg.color());
+  REQUIRE(4 == vt.at(0, 0).bg.color());
+  REQUIRE_FALSE(vt.at(0, 0).fg.isBold());
+  REQUIRE('Y' == vt.at(1, 0).ch);
+  REQUIRE(0 == vt.at(1, 0).fg.color());
+  REQUIRE(vt.at(1, 0).fg.isBold());
+}
+
+TEST_CASE("VtScreen::SplitStream") {
+  VtScreen vt(10, 4);
+  // escape sequences and UTF-8 chars split across writes
+  vt.feed("\033[");
+  vt.feed("3;2");
+  vt.feed("Hz\xc3");
+  vt.feed("\xa9");
+  REQUIRE(" z\xc3\xa9" == vt.row(2));
+  REQUIRE(0xe9U == vt.at(2, 2).ch);
+}
+
+TEST_CASE("VtScreen::Misc") {
+  VtScreen vt(10, 4);
+  REQUIRE(vt.cursorVisible());
+  vt.feed("\033[?25l");
+  REQUIRE_FALSE(vt.cursorVisible());
+  vt.feed("\033[?12l\033[?25h");
+  REQUIRE(vt.cursorVisible());
+  vt.feed("\033]0;my title\007");
+  REQUIRE("my title" == vt.title());
+  vt.feed("abcdef\033[1;3H\033[K");
+  REQUIRE("ab" == vt.row(0));
+  vt.resize(5, 2);
+  REQUIRE(5U == vt.cells().w());
+  REQUIRE(vt.row(0).empty());
+  REQUIRE(Pos2di(2, 0) == vt.cursor());
+}
+
+TEST_CASE("VtScreen::Scroll") {
+  VtScreen vt(10, 5);
+  for(int y = 0; y < 5; ++y) vt.feed(format("\033[%d;1Hrow%d", y + 1, y));
+  // scroll region is the middle 3 rows
+  vt.feed("\033[2;4r\033[1S");
+  REQUIRE(Pos2di(0, 0) == vt.cursor());
+  REQUIRE("row0" == vt.row(0));
+  REQUIRE("row2" == vt.row(1));
+  REQUIRE("row3" == vt.row(2));
+  REQUIRE(vt.row(3).empty());
+  REQUIRE("row4" == vt.row(4));
+  vt.feed("\033[2T");
+  REQUIRE(vt.row(1).empty());
+  REQUIRE(vt.row(2).empty());
+  REQUIRE("row2" == vt.row(3));
+  // back to the whole screen
+  vt.feed("\033[r\033[S");
+  REQUIRE(vt.row(0).empty());
+  REQUIRE("row2" == vt.row(2));
+  REQUIRE("row4" == vt.row(3));
+  REQUIRE(vt.row(4).empty());
+}
+
+} // end namespace teditor
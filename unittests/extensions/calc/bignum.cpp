@@ -0,0 +1,230 @@
+#include "extensions/calc/bignum.h"
+#include "extensions/calc/parser.h"
+#include "core/timer.h"
+#include "catch.hpp"
+#include "testutils.h"
+#include <random>
+
+namespace teditor {
+namespace calc {
+
+BigInt randomBigInt(std::mt19937& rng, int numDigits) {
+  std::string str(rng() % 2 ? "-" : "");
+  str += char('1' + rng() % 9);
+  for (int i = 1; i < numDigits; ++i) str += char('0' + rng() % 10);
+  return BigInt(str);
+}
+
+TEST_CASE("BigInt") {
+  SECTION("ctor") {
+    REQUIRE(BigInt().isZero());
+    REQUIRE(BigInt(int64_t(0)).isZero());
+    REQUIRE(BigInt(int64_t(-42)).toString() == "-42");
+    REQUIRE(BigInt(INT64_MIN).toString() == "-9223372036854775808");
+    REQUIRE(BigInt("-0").toString() == "0");
+    REQUIRE(BigInt("+000123").toString() == "123");
+    REQUIRE(BigInt("123456789012345678901234567890").toString() ==
+            "123456789012345678901234567890");
+    REQUIRE_THROWS_AS(BigInt("12a"), std::runtime_error);
+    REQUIRE_THROWS_AS(BigInt("-"), std::runtime_error);
+  }
+  SECTION("int64") {
+    REQUIRE(BigInt(INT64_MAX).fitsInt64());
+    REQUIRE(BigInt(INT64_MIN).fitsInt64());
+    REQUIRE(BigInt(INT64_MIN).toInt64() == INT64_MIN);
+    REQUIRE_FALSE(BigInt("9223372036854775808").fitsInt64());
+    REQUIRE(BigInt("-9223372036854775808").fitsInt64());
+    REQUIRE_FALSE(BigInt("-9223372036854775809").fitsInt64());
+    REQUIRE(BigInt(int64_t(-12345)).toDouble() == -12345.0);
+  }
+  SECTION("add/sub") {
+    BigInt a("18446744073709551615"), one(int64_t(1));
+    REQUIRE((a + one).toString() == "18446744073709551616");
+    REQUIRE((one - a).toString() == "-18446744073709551614");
+    REQUIRE((a - a).isZero());
+    REQUIRE((a + -a).isZero());
+    REQUIRE((-a - one).toString() == "-18446744073709551616");
+  }
+  SECTION("mul") {
+    BigInt a("123456789012345678901234567890");
+    REQUIRE((a * a).toString() ==
+            "15241578753238836750495351562536198787501905199875019052100");
+    REQUIRE((a * -a).isNeg());
+    REQUIRE((a * BigInt()).isZero());
+  }
+  SECTION("karatsuba") {
+    std::mt19937 rng(42);
+    for (int digits : {400, 1000, 3000}) {
+      auto a = randomBigInt(rng, digits), b = randomBigInt(rng, digits / 3);
+      REQUIRE(a.size() >= BigInt::KaratsubaThreshold);
+      REQUIRE(a * a == BigInt::mulSchoolbook(a, a));
+      REQUIRE(a * b == BigInt::mulSchoolbook(a, b));
+    }
+  }
+  SECTION("divmod") {
+    std::mt19937 rng(7);
+    for (int i = 0; i < 50; ++i) {
+      auto a = randomBigInt(rng, 1 + rng() % 80);
+      auto b = randomBigInt(rng, 1 + rng() % 40);
+      BigInt q, r;
+      BigInt::divmod(a, b, q, r);
+      REQUIRE(q * b + r == a);
+      REQUIRE((r.isZero() || r.isNeg() == a.isNeg()));
+      REQUIRE((r.isNeg() ? -r : r) < (b.isNeg() ? -b : b));
+    }
+    REQUIRE((BigInt(int64_t(-7)) / BigInt(int64_t(2))).toInt64() == -3);
+    REQUIRE((BigInt(int64_t(-7)) % BigInt(int64_t(2))).toInt64() == -1);
+    REQUIRE_THROWS_AS(BigInt(int64_t(1)) / BigInt(), std::runtime_error);
+  }
+  SECTION("pow") {
+    REQUIRE(BigInt(int64_t(2)).pow(100).toString() ==
+            "1267650600228229401496703205376");
+    REQUIRE(BigInt(int64_t(-3)).pow(3).toInt64() == -27);
+    REQUIRE(BigInt(int64_t(5)).pow(0).toInt64() == 1);
+    REQUIRE(BigInt::pow10(20).toString() == "100000000000000000000");
+    REQUIRE_THROWS_AS(BigInt(int64_t(2)).pow(1ULL << 40), std::runtime_error);
+  }
+}
+
+TEST_CASE("BigNum") {
+  SECTION("parse") {
+    REQUIRE(BigNum("12").isInt());
+    REQUIRE(BigNum("1.5").type == BigNum::Float);
+    REQUIRE(BigNum("1.5", true).type == BigNum::Decimal);
+    REQUIRE(BigNum("1.5", true).toString() == "1.5");
+    REQUIRE(BigNum("-.25", true).toString() == "-0.25");
+    REQUIRE(BigNum("1.5e3", true).toString() == "1500");
+    REQUIRE(BigNum("15e-3", true).toString() == "0.015");
+    REQUIRE(BigNum("1e-30", true).toString() == "0");
+    REQUIRE_THROWS_AS(BigNum("1.5x", true), std::runtime_error);
+  }
+  SECTION("decimal sums") {
+    BigNum sum(BigNum("0", true)), cent("0.01", true);
+    double fsum = 0.0;
+    for (int i = 0; i < 1000; ++i) {
+      sum += cent;
+      fsum += 0.01;
+    }
+    REQUIRE(sum.toString() == "10");
+    REQUIRE(sum == BigNum(int64_t(10)));
+    REQUIRE(fsum != 10.0);
+  }
+  SECTION("mixed types") {
+    BigNum i(int64_t(3)), d("0.5", true), f(0.5);
+    REQUIRE((i + d).type == BigNum::Decimal);
+    REQUIRE((i + d).toString() == "3.5");
+    REQUIRE((d + f).type == BigNum::Float);
+    REQUIRE((i * f).type == BigNum::Float);
+    REQUIRE((i / BigNum(int64_t(2))).toString() == "1");
+    REQUIRE((BigNum("1", true).toDecimal() / i).toString() ==
+            "0.33333333333333333333");
+    REQUIRE((BigNum("2", true).toDecimal() / i).toString() ==
+            "0.66666666666666666667");
+    REQUIRE(d * d == BigNum("0.25", true));
+    REQUIRE(i > d);
+    REQUIRE(d < i);
+  }
+  SECTION("funcs") {
+    BigNum d("-2.5", true);
+    REQUIRE(floor(d).toString() == "-3");
+    REQUIRE(ceil(d).toString() == "-2");
+    REQUIRE(round(d).toString() == "-3");
+    REQUIRE(abs(d).toString() == "2.5");
+    REQUIRE(toInt(d).toString() == "-2");
+    REQUIRE(toInt(d).isInt());
+    REQUIRE(sq(d).toString() == "6.25");
+    REQUIRE(pow(d, BigNum(int64_t(2))).toString() == "6.25");
+    REQUIRE(pow(BigNum(int64_t(2)), BigNum(int64_t(-2))).toString() == "0.25");
+    REQUIRE(pow(BigNum(int64_t(10)), BigNum(int64_t(30))).toString() ==
+            "1000000000000000000000000000000");
+  }
+  SECTION("num64") {
+    REQUIRE(BigNum(Num64(int64_t(5))).isSmall());
+    REQUIRE(BigNum(Num64(2.5)).isSmall());
+    REQUIRE_FALSE(BigNum("0.5", true).isSmall());
+    REQUIRE_FALSE(BigNum("99999999999999999999").isSmall());
+    REQUIRE(BigNum("99999999999999999999").toNum64().f == Approx(1e20));
+  }
+}
+
+TEST_CASE("Parser::overflow") {
+  VarMap vars;
+  Parser p;
+  SECTION("auto switch") {
+    REQUIRE(p.evaluate("9223372036854775807 + 1", vars).toString() ==
+            "9223372036854775808");
+    REQUIRE(p.evaluate("2 ^ 64", vars).toString() == "18446744073709551616");
+    REQUIRE(p.evaluate("2 ^ 62", vars).toNum64().i == (int64_t(1) << 62));
+    REQUIRE(p.evaluate("2 ^ 0.5", vars).type == BigNum::Float);
+    REQUIRE(p.evaluate("sq(4294967296)", vars).toString() ==
+            "18446744073709551616");
+  }
+  SECTION("factorial") {
+    REQUIRE(p.evaluate("f = 1; i = 1", vars) == Num64(int64_t(1)));
+    for (int k = 0; k < 29; ++k) p.evaluate("i = i + 1; f = f * i", vars);
+    REQUIRE(vars["f"].toString() == "265252859812191058636308480000000");
+    REQUIRE_FALSE(vars["f"].isSmall());
+    // big variables make the subsequent evaluations happen on BigNum too
+    REQUIRE(p.evaluate("f / 30 / 29", vars).toString() ==
+            "304888344611713860501504000000");
+  }
+  SECTION("sequence") {
+    auto res = p.evaluateSequence("x ^ 4", "x", Num64(int64_t(1)),
+                                  Num64(int64_t(1000000)), Num64(int64_t(1)),
+                                  vars);
+    REQUIRE(res.count == 1000000);
+    // n(n+1)(2n+1)(3n^2+3n-1)/30
+    REQUIRE(res.sum.toString() == "200000500000333333333333300000");
+    REQUIRE(res.max.toString() == "1000000000000000000000000");
+  }
+  SECTION("decimal mode") {
+    Parser d(true);
+    REQUIRE(d.evaluate("0.1 + 0.2", vars).toString() == "0.3");
+    REQUIRE(d.evaluate("0.1 + 0.2", vars) == BigNum("0.3", true));
+    REQUIRE_FALSE(p.evaluate("0.1 + 0.2", vars) == Num64(0.3));
+    auto res = d.evaluateSequence("x * 0.01", "x", Num64(int64_t(1)),
+                                  Num64(int64_t(1000)), Num64(int64_t(1)),
+                                  vars);
+    REQUIRE(res.sum.toString() == "5005");
+  }
+}
+
+// Not run by default. Use: teditor-tests "[bench]"
+TEST_CASE("BigNum::SmallBench", "[.][bench]") {
+  const int N = 1000000;
+  Parser p;
+  VarMap vars;
+  vars["a"] = BigNum(int64_t(3));
+  tic("num64");
+  for (int i = 0; i < N; ++i) p.evaluate("a * 2 + 1", vars);
+  toc("num64");
+  tic("bignum");
+  Parser d(true);
+  for (int i = 0; i < N; ++i) d.evaluate("a * 2 + 1.5", vars);
+  toc("bignum");
+  tic("seq");
+  auto res = p.evaluateSequence("sq(x) + 2 * x + 1", "x", Num64(int64_t(0)),
+                                Num64(int64_t(N)), Num64(int64_t(1)), vars);
+  toc("seq");
+  REQUIRE(res.count == N + 1);
+  printf("evaluate: Num64 path: %lf s, BigNum path: %lf s, sequence: %lf s\n",
+         getTimer("num64").elapsed(), getTimer("bignum").elapsed(),
+         getTimer("seq").elapsed());
+}
+
+TEST_CASE("BigInt::MulBench", "[.][bench]") {
+  std::mt19937 rng(42);
+  auto a = randomBigInt(rng, 20000), b = randomBigInt(rng, 20000);
+  tic("karatsuba");
+  auto k = a * b;
+  toc("karatsuba");
+  tic("schoolbook");
+  auto s = BigInt::mulSchoolbook(a, b);
+  toc("schoolbook");
+  REQUIRE(k == s);
+  printf("20000 digits mul: karatsuba: %lf s, schoolbook: %lf s\n",
+         getTimer("karatsuba").elapsed(), getTimer("schoolbook").elapsed());
+}
+
+}  // namespace calc
+}  // namespace teditor
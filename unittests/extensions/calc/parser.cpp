@@ -1,12 +1,186 @@
 #include "extensions/calc/parser.h"
 #include "catch.hpp"
 #include "testutils.h"
+#include <cmath>
 
 namespace teditor {
 namespace calc {
 
-TEST_CASE("Parser") {
-  ///@todo: complete this test once the parser is ready
+BigNum eval(const std::string& expr) {
+  VarMap vars;
+  Parser p;
+  return p.evaluate(expr, vars);
+}
+
+TEST_CASE("Parser::evaluate") {
+  SECTION("numbers") {
+    REQUIRE(eval("42") == Num64(int64_t(42)));
+    REQUIRE(eval("42").isInt());
+    REQUIRE(eval("2.5") == Num64(2.5));
+    REQUIRE_FALSE(eval("2.5").isInt());
+    REQUIRE(eval("-3") == Num64(int64_t(-3)));
+  }
+  SECTION("precedence") {
+    REQUIRE(eval("1 + 2 * 3") == Num64(int64_t(7)));
+    REQUIRE(eval("(1 + 2) * 3") == Num64(int64_t(9)));
+    REQUIRE(eval("10 - 4 - 3") == Num64(int64_t(3)));
+    REQUIRE(eval("3-2") == Num64(int64_t(1)));
+    REQUIRE(eval("8 / 2 / 2") == Num64(int64_t(2)));
+    REQUIRE(eval("2 ^ 3 ^ 2") == Num64(512.0));
+    REQUIRE(eval("-2 ^ 2") == Num64(-4.0));
+    REQUIRE(eval("2 * -3") == Num64(int64_t(-6)));
+    REQUIRE(eval("1 + 0.5") == Num64(1.5));
+  }
+  SECTION("functions") {
+    REQUIRE(eval("sq(3)") == Num64(int64_t(9)));
+    REQUIRE(eval("cube(1 + 1)") == Num64(int64_t(8)));
+    REQUIRE(eval("sqrt(16) + 1") == Num64(5.0));
+    REQUIRE(eval("int(2.7)") == Num64(int64_t(2)));
+    REQUIRE_THROWS_AS(eval("foo(2)"), std::runtime_error);
+  }
+  SECTION("variables") {
+    VarMap vars;
+    Parser p;
+    REQUIRE(p.evaluate("a = 3; b = a * 2; a + b", vars) ==
+            Num64(int64_t(9)));
+    REQUIRE(vars["a"] == Num64(int64_t(3)));
+    REQUIRE(vars["b"] == Num64(int64_t(6)));
+    REQUIRE(p.evaluate("a = a + 1", vars) == Num64(int64_t(4)));
+    REQUIRE(vars["a"] == Num64(int64_t(4)));
+    REQUIRE_THROWS_AS(p.evaluate("c + 1", vars), std::runtime_error);
+  }
+  SECTION("errors") {
+    REQUIRE_THROWS_AS(eval("1 +"), std::runtime_error);
+    REQUIRE_THROWS_AS(eval("(1 + 2"), std::runtime_error);
+    REQUIRE_THROWS_AS(eval("1 2"), std::runtime_error);
+    REQUIRE_THROWS_AS(eval("1 / 0"), std::runtime_error);
+  }
+}
+
+TEST_CASE("Parser::compile") {
+  auto p1 = Parser::compile("x * 2 + 1");
+  auto p2 = Parser::compile("x * 2 + 1");
+  REQUIRE(p1.get() == p2.get());
+  REQUIRE(p1->vars.size() == 1);
+  REQUIRE(p1->vars[0] == "x");
+  REQUIRE(p1->code.size() == 5);
+  REQUIRE(p1->maxDepth == 2);
+  auto p3 = Parser::compile("x * 2 + 2");
+  REQUIRE(p1.get() != p3.get());
+}
+
+TEST_CASE("Parser::evaluateSequence") {
+  Parser p;
+  VarMap vars;
+  SECTION("sum") {
+    auto res = p.evaluateSequence("x", "x", Num64(int64_t(0)), Num64(1e6),
+                                  Num64(int64_t(1)), vars);
+    REQUIRE(res.count == 1000001);
+    REQUIRE(res.sum == Num64(int64_t(500000500000)));
+    REQUIRE(res.min == Num64(int64_t(0)));
+    REQUIRE(res.max == Num64(int64_t(1000000)));
+  }
+  SECTION("too long") {
+    REQUIRE_THROWS(p.evaluateSequence("x", "x", Num64(int64_t(0)), Num64(1e7),
+                                      Num64(int64_t(1)), vars));
+    // overflows into BigNum, which has a lower limit
+    REQUIRE_THROWS(p.evaluateSequence("x * x * x * x", "x", Num64(int64_t(0)),
+                                      Num64(2e6), Num64(int64_t(1)), vars));
+    auto res = p.evaluateSequence("x * x * x * x", "x", Num64(int64_t(0)),
+                                  Num64(1e5), Num64(int64_t(1)), vars);
+    REQUIRE(res.count == 100001);
+  }
+  SECTION("min/max") {
+    vars["c"] = Num64(int64_t(3));
+    auto res = p.evaluateSequence("sq(x - c)", "x", Num64(int64_t(-5)),
+                                  Num64(int64_t(5)), Num64(int64_t(1)), vars);
+    REQUIRE(res.count == 11);
+    REQUIRE(res.min == Num64(int64_t(0)));
+    REQUIRE(res.argMin == Num64(int64_t(3)));
+    REQUIRE(res.max == Num64(int64_t(64)));
+    REQUIRE(res.argMax == Num64(int64_t(-5)));
+    // sequence variable does not leak into the vars
+    REQUIRE(vars.find("x") == vars.end());
+  }
+  SECTION("float step") {
+    auto res = p.evaluateSequence("x * 2", "x", Num64(int64_t(0)),
+                                  Num64(int64_t(1)), Num64(0.25), vars);
+    REQUIRE(res.count == 5);
+    REQUIRE(res.sum == Num64(5.0));
+    REQUIRE(res.argMax == Num64(1.0));
+  }
+  SECTION("inexact float step") {
+    // 0.3 / 0.1 is just short of 3 in doubles
+    auto res = p.evaluateSequence("x", "x", Num64(int64_t(0)), Num64(0.3),
+                                  Num64(0.1), vars);
+    REQUIRE(res.count == 4);
+    REQUIRE(std::abs(res.max.toDouble() - 0.3) < 1e-12);
+    res = p.evaluateSequence("x", "x", Num64(int64_t(0)), Num64(0.7),
+                             Num64(0.1), vars);
+    REQUIRE(res.count == 8);
+    REQUIRE(std::abs(res.max.toDouble() - 0.7) < 1e-12);
+    res = p.evaluateSequence("x", "x", Num64(int64_t(0)), Num64(0.75),
+                             Num64(0.1), vars);
+    REQUIRE(res.count == 8);
+  }
+  SECTION("decimal step") {
+    Parser d(true);
+    auto res = d.evaluateSequence("x", "x", BigNum(int64_t(0)),
+                                  BigNum("0.3", true), BigNum("0.1", true),
+                                  vars);
+    REQUIRE(res.count == 4);
+    REQUIRE(res.max == BigNum("0.3", true));
+    res = d.evaluateSequence("x", "x", BigNum(int64_t(0)), BigNum("0.7", true),
+                             BigNum("0.1", true), vars);
+    REQUIRE(res.count == 8);
+    REQUIRE(res.max == BigNum("0.7", true));
+    REQUIRE_THROWS_AS(d.evaluateSequence("x", "x", BigNum(int64_t(1)),
+                                         BigNum("0.5", true),
+                                         BigNum(int64_t(1)), vars),
+                      std::runtime_error);
+  }
+  SECTION("errors") {
+    REQUIRE_THROWS_AS(p.evaluateSequence("x = 1", "x", Num64(int64_t(0)),
+                                         Num64(int64_t(1)), Num64(int64_t(1)),
+                                         vars), std::runtime_error);
+    REQUIRE_THROWS_AS(p.evaluateSequence("x + y", "x", Num64(int64_t(0)),
+                                         Num64(int64_t(1)), Num64(int64_t(1)),
+                                         vars), std::runtime_error);
+    REQUIRE_THROWS_AS(p.evaluateSequence("x", "x", Num64(int64_t(0)),
+                                         Num64(int64_t(1)), Num64(int64_t(0)),
+                                         vars), std::runtime_error);
+    REQUIRE_THROWS_AS(p.evaluateSequence("x", "x", Num64(int64_t(1)),
+                                         Num64(int64_t(0)), Num64(int64_t(1)),
+                                         vars), std::runtime_error);
+  }
+}
+
+TEST_CASE("Parser::isSequence") {
+  std::string expr, var;
+  BigNum start, end, step;
+  REQUIRE(Parser::isSequence("sq(x) for x in 0..1e6", expr, var, start, end,
+                             step));
+  REQUIRE(expr == "sq(x)");
+  REQUIRE(var == "x");
+  REQUIRE(start == Num64(int64_t(0)));
+  REQUIRE(end == Num64(1e6));
+  REQUIRE(step == Num64(int64_t(1)));
+  REQUIRE(Parser::isSequence("y * 2 for y in -1 .. 1 by 0.5", expr, var,
+                             start, end, step));
+  REQUIRE(expr == "y * 2");
+  REQUIRE(var == "y");
+  REQUIRE(start == Num64(int64_t(-1)));
+  REQUIRE(end == Num64(int64_t(1)));
+  REQUIRE(step == Num64(0.5));
+  REQUIRE_FALSE(Parser::isSequence("1 + 2", expr, var, start, end, step));
+}
+
+TEST_CASE("Parser::evaluateSequence benchmark", "[.][bench]") {
+  Parser p;
+  VarMap vars;
+  auto res = p.evaluateSequence("sq(x) + 2 * x + 1", "x", Num64(int64_t(0)),
+                                Num64(1e7 - 1), Num64(int64_t(1)), vars);
+  REQUIRE(res.count == 10000000);
 }
 
 }  // namespace calc
@@ -73,6 +73,57 @@ TEST_CASE("Accounts") {
   REQUIRE(0.0 == b.balance());
 }
 
+TEST_CASE("Accounts::interned") {
+  Accounts acc;
+  acc.push_back(Account("Assets:Cash", "", {"Cash"}));
+  acc.push_back(Account("Assets:Bank", "", {"Bank", "DefaultBank"}));
+  REQUIRE(0 == acc.lookup("Assets:Cash"));
+  REQUIRE(0 == acc.lookup("Cash"));
+  REQUIRE(1 == acc.lookup("DefaultBank"));
+  REQUIRE(-1 == acc.lookup("Expenses"));
+  REQUIRE(2 == acc.size());
+  acc.find("Bank") += 2.0;
+  REQUIRE(200 == acc[1].rawBalance());
+  REQUIRE(2 == acc.id("Expenses"));
+  REQUIRE(3 == acc.size());
+  REQUIRE(2 == acc.lookup("Expenses"));
+  // older accounts win for duplicate names
+  acc.push_back(Account("Cash"));
+  REQUIRE(0 == acc.lookup("Cash"));
+  // ids get re-assigned after sorting
+  acc.sort([](const Account& a, const Account& b) {
+      return a.name() < b.name();
+    });
+  REQUIRE("Assets:Bank" == acc[0].name());
+  REQUIRE(0 == acc.lookup("DefaultBank"));
+  REQUIRE(1 == acc.lookup("Cash"));
+  acc.clear();
+  REQUIRE(acc.empty());
+  REQUIRE(-1 == acc.lookup("Cash"));
+}
+
+TEST_CASE("AccountTree") {
+  Accounts acc;
+  acc.push_back(Account("a:b"));
+  acc.push_back(Account("d"));
+  acc.push_back(Account("a:c:e"));
+  acc.push_back(Account("a:c"));
+  AccountTree tree(acc, {100, 200, 300, 400});
+  REQUIRE(5 == tree.size());
+  REQUIRE(2 == tree.tops().size());
+  const auto& a = tree.node(tree.tops()[0]);
+  REQUIRE("a" == a.path);
+  REQUIRE(-1 == a.account);
+  REQUIRE(800 == a.bal);
+  REQUIRE(2 == a.children.size());
+  REQUIRE(200 == tree.node(tree.tops()[1]).bal);
+  const auto& c = tree.node(tree.lookup("a:c"));
+  REQUIRE(3 == c.account);
+  REQUIRE(700 == c.bal);
+  REQUIRE(300 == tree.node(tree.lookup("a:c:e")).bal);
+  REQUIRE(-1 == tree.lookup("a:x"));
+}
+
 TEST_CASE("Transaction") {
   Accounts acc;
   REQUIRE(0 == acc.size());
@@ -1,5 +1,6 @@
 #include "extensions/ledger/parser.h"
 #include "core/utils.h"
+#include "core/buffer.h"
 #include "catch.hpp"
 
 
@@ -13,6 +14,10 @@ TEST_CASE("Parser::sample") {
   const auto& accts = p.accounts();
   REQUIRE(12 == accts.size());
   for(const auto& t : trans) REQUIRE(0 == t.rawBalance());
+  const auto& bals = p.balances();
+  REQUIRE(12 == bals.size());
+  REQUIRE(103000 - 70000 == bals[accts.lookup("Cash")]);
+  REQUIRE(bals[0] == accts[0].rawBalance());
 }
 
 TEST_CASE("Parser::reload") {
@@ -41,6 +46,9 @@ TEST_CASE("Parser::topAccounts") {
   int64_t bal = 0;
   for(const auto& a : top) bal += a.rawBalance();
   REQUIRE(0 == bal);
+  REQUIRE("Assets" == top[0].name());
+  REQUIRE("Expenses" == top[2].name());
+  REQUIRE(2329809 == top[2].rawBalance());
 }
 
 TEST_CASE("Parser::allAccounts") {
@@ -50,6 +58,9 @@ TEST_CASE("Parser::allAccounts") {
   int64_t bal = 0;
   for(const auto& a : all) bal += a.rawBalance();
   REQUIRE(0 == bal);
+  REQUIRE("Assets" == all[0].name());
+  REQUIRE("  Bank1:JointSB" == all[1].name());
+  REQUIRE(-2100746 == all[1].rawBalance());
 }
 
 TEST_CASE("Parser::minMaxDates") {
@@ -67,6 +78,109 @@ TEST_CASE("Parser::customFile") {
   }
 }
 
+/** compares an incrementally updated ledger with a freshly parsed one */
+void checkSameAsFresh(const Parser& p, const Buffer& buf) {
+  Parser fresh;
+  fresh.update(buf);
+  REQUIRE(fresh.fingerprint() == p.fingerprint());
+  REQUIRE(fresh.transactions().size() == p.transactions().size());
+  for(size_t i = 0; i < p.transactions().size(); ++i) {
+    REQUIRE(fresh.transactions()[i].name() == p.transactions()[i].name());
+  }
+  auto all = p.allAccounts(), freshAll = fresh.allAccounts();
+  REQUIRE(freshAll.size() == all.size());
+  for(int i = 0; i < all.size(); ++i) {
+    REQUIRE(freshAll[i].name() == all[i].name());
+    REQUIRE(freshAll[i].rawBalance() == all[i].rawBalance());
+  }
+}
+
+/** line in the buffer containing the given string */
+int lineWith(const Buffer& buf, const std::string& str) {
+  for(int i = 0; i < buf.length(); ++i)
+    if(buf.at(i).get().find(str) != std::string::npos) return i;
+  return -1;
+}
+
+TEST_CASE("Parser::update") {
+  Buffer buf;
+  buf.load(rel2abs(getpwd(), "samples/ledger/sample.lg"), 0);
+  Parser p;
+  REQUIRE(p.update(buf));
+  REQUIRE(0 < p.lastParsed());
+  REQUIRE(7 == p.transactions().size());
+  REQUIRE(12 == p.accounts().size());
+  checkSameAsFresh(p, buf);
+  // nothing changed
+  auto fp = p.fingerprint();
+  REQUIRE_FALSE(p.update(buf));
+  REQUIRE(0 == p.lastParsed());
+  REQUIRE(fp == p.fingerprint());
+
+  SECTION("append") {
+    buf.end();
+    buf.insert("\n2018-09-11 Dinner\n  Expenses:Food:Restaurant  500\n  Cash\n");
+    REQUIRE(p.update(buf));
+    REQUIRE(2 >= p.lastParsed());
+    REQUIRE(fp != p.fingerprint());
+    REQUIRE(8 == p.transactions().size());
+    REQUIRE(13 == p.accounts().size());
+    const auto& accts = p.accounts();
+    REQUIRE(33000 - 50000 == p.balances()[accts.lookup("Cash")]);
+    REQUIRE(50000 == p.balances()[accts.lookup("Expenses:Food:Restaurant")]);
+    REQUIRE(accts[0].rawBalance() == p.balances()[0]);
+    checkSameAsFresh(p, buf);
+  }
+
+  SECTION("edit in the middle") {
+    int line = lineWith(buf, "Expenses:Auto:TireRepair");
+    REQUIRE(0 <= line);
+    buf.setPoint({buf.lengthOf(line), line});
+    buf.insert("0");
+    REQUIRE(p.update(buf));
+    REQUIRE(1 == p.lastParsed());
+    REQUIRE(7 == p.transactions().size());
+    const auto& accts = p.accounts();
+    REQUIRE(33000 - 630000 == p.balances()[accts.lookup("Cash")]);
+    REQUIRE(700000 == p.balances()[accts.lookup("Expenses:Auto:TireRepair")]);
+    checkSameAsFresh(p, buf);
+  }
+
+  SECTION("new transaction in the middle") {
+    int line = lineWith(buf, "2018-08-06 Hospital");
+    buf.setPoint({0, line});
+    buf.insert("2018-08-05 Bakery\n  Expenses:Food:Groceries  10\n  Cash\n");
+    REQUIRE(p.update(buf));
+    REQUIRE(1 == p.lastParsed());
+    REQUIRE(8 == p.transactions().size());
+    REQUIRE(" Bakery" == p.transactions()[2].name());
+    checkSameAsFresh(p, buf);
+  }
+
+  SECTION("account no longer referred") {
+    int line = lineWith(buf, "Expenses:Auto:TireRepair");
+    buf.setPoint({(int)std::string("  Expenses:Auto:Tire").size(), line});
+    buf.insert("s");
+    REQUIRE(p.update(buf));
+    REQUIRE(7 == p.transactions().size());
+    REQUIRE(-1 == p.accounts().lookup("Expenses:Auto:TireRepair"));
+    REQUIRE(0 <= p.accounts().lookup("Expenses:Auto:TiresRepair"));
+    checkSameAsFresh(p, buf);
+  }
+
+  SECTION("account definition edited") {
+    int line = lineWith(buf, "alias       Cash");
+    buf.setPoint({buf.lengthOf(line), line});
+    buf.insert("\n  alias       Wallet");
+    buf.end();
+    buf.insert("\n2018-09-11 Dinner\n  Expenses:Food:Restaurant  500\n  Wallet\n");
+    REQUIRE(p.update(buf));
+    REQUIRE(8 == p.transactions().size());
+    REQUIRE(12 == p.accounts().lookup("Expenses:Food:Restaurant"));
+    checkSameAsFresh(p, buf);
+  }
+}
+
 void parse(const std::string& file) {
   Parser p(file);
 }
@@ -0,0 +1,85 @@
+#include "extensions/ledger/store.h"
+#include "extensions/ledger/parser.h"
+#include "catch.hpp"
+
+
+namespace teditor {
+namespace ledger {
+
+TEST_CASE("TransactionStore::sample") {
+  Parser p("samples/ledger/sample.lg");
+  const auto& st = p.store();
+  REQUIRE(7 == st.size());
+  REQUIRE_FALSE(st.empty());
+  for(int i = 1; i < st.size(); ++i) REQUIRE_FALSE(st.date(i) < st.date(i - 1));
+  REQUIRE(" Opening" == st.payeeName(st.payee(0)));
+  REQUIRE(7 == st.numPayees());
+  REQUIRE(6 == st.postingEnd(0) - st.postingStart(0));
+  REQUIRE(p.accounts().lookup("Cash") == st.postingAccount(0));
+  REQUIRE(103000 == st.postingAmount(0));
+  // sum over all the rows must match the ledger balances
+  std::vector<int64_t> bals;
+  st.sum(0, st.size(), bals);
+  REQUIRE(p.balances() == bals);
+  TimePoint min, max;
+  st.minmaxDates(min, max);
+  REQUIRE("2018-08-04" == timeToDateStr(min));
+  REQUIRE("2018-09-10" == timeToDateStr(max));
+}
+
+TEST_CASE("TransactionStore::range") {
+  Parser p("samples/ledger/sample.lg");
+  const auto& st = p.store();
+  auto aug = st.range(timeFromStr("2018-08-01"), timeFromStr("2018-09-01"));
+  REQUIRE(0 == aug.first);
+  REQUIRE(3 == aug.second);
+  auto sep = st.range(timeFromStr("2018-09-01"), timeFromStr("2018-10-01"));
+  REQUIRE(3 == sep.first);
+  REQUIRE(7 == sep.second);
+  auto none = st.range(timeFromStr("2019-01-01"), timeFromStr("2019-02-01"));
+  REQUIRE(none.first == none.second);
+  // per-period sums add up to the total
+  std::vector<int64_t> bals;
+  st.sum(aug.first, aug.second, bals);
+  st.sum(sep.first, sep.second, bals);
+  bals.resize(p.balances().size(), 0);
+  REQUIRE(p.balances() == bals);
+  auto acct = p.accounts().lookup("Expenses:Auto:TireRepair");
+  std::vector<int64_t> sepBals;
+  st.sum(sep.first, sep.second, sepBals);
+  REQUIRE((acct >= (int)sepBals.size() || 0 == sepBals[acct]));
+}
+
+TEST_CASE("TransactionStore::unsorted") {
+  Accounts accts;
+  accts.id("A");
+  accts.id("B");
+  Transactions trans;
+  trans.push_back(Transaction("2020-03-01", "later"));
+  trans.back().add("A", 10.0);
+  trans.back().add("B");
+  trans.push_back(Transaction("2020-01-01", "earlier"));
+  trans.back().add("B", 5.0);
+  trans.back().add("A");
+  trans.push_back(Transaction("2020-03-01", "later"));
+  trans.back().add("A", 1.0);
+  trans.back().add("B");
+  TransactionStore st(trans, accts);
+  REQUIRE(3 == st.size());
+  REQUIRE(2 == st.numPayees());
+  REQUIRE("earlier" == st.payeeName(st.payee(0)));
+  REQUIRE(st.payee(1) == st.payee(2));
+  // same day transactions retain their order
+  REQUIRE(1000 == st.postingAmount(st.postingStart(1)));
+  REQUIRE(100 == st.postingAmount(st.postingStart(2)));
+  auto r = st.range(timeFromStr("2020-02-01"), timeFromStr("2020-04-01"));
+  REQUIRE(1 == r.first);
+  REQUIRE(3 == r.second);
+  std::vector<int64_t> bals;
+  st.sum(r.first, r.second, bals);
+  REQUIRE(1100 == bals[0]);
+  REQUIRE(-1100 == bals[1]);
+}
+
+} // end namespace ledger
+} // end namespace teditor
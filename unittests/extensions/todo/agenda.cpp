@@ -0,0 +1,74 @@
+#include <catch.hpp>
+#include "extensions/todo/agenda.h"
+#include "core/file_utils.h"
+#include <fstream>
+#include <unistd.h>
+#include <utime.h>
+
+namespace teditor {
+namespace todo {
+
+void writeTodo(const std::string& file, const std::string& contents) {
+  std::ofstream fp(file);
+  fp << contents;
+}
+
+TEST_CASE("Agenda") {
+  auto file = tempFileName();
+  writeTodo(file, "on 2020-01-01 for \"Task1\" repeat weekly\n");
+  Agenda agenda(file);
+  REQUIRE_FALSE(agenda.refresh());
+  REQUIRE(1U == agenda.parser().items().size());
+  auto start = timeFromStr("2020-01-01"), end = timeFromStr("2020-01-15");
+  auto text = agenda.range(start, end);
+  REQUIRE(std::string::npos != text.find("2020-01-08 ---> \"Task1\""));
+  REQUIRE(1 == agenda.numCached());
+  // served from the cache
+  REQUIRE(&agenda.range(start, end) == &agenda.range(start, end));
+  REQUIRE(1 == agenda.numCached());
+  auto next = agenda.next(start, 2);
+  REQUIRE(std::string::npos != next.find("Next 2 TODO's"));
+  REQUIRE(2 == agenda.numCached());
+
+  SECTION("touch") {
+    struct utimbuf tb{1000, 1000};
+    REQUIRE(0 == utime(file.c_str(), &tb));
+    REQUIRE_FALSE(agenda.refresh());
+    REQUIRE(2 == agenda.numCached());
+  }
+
+  SECTION("modified") {
+    writeTodo(file, "on 2020-01-01 for \"Task1\" repeat weekly\n"
+              "on 2020-01-02 for \"Task2\"\n");
+    REQUIRE(agenda.refresh());
+    REQUIRE(0 == agenda.numCached());
+    REQUIRE(2U == agenda.parser().items().size());
+    text = agenda.range(start, end);
+    REQUIRE(std::string::npos != text.find("2020-01-02 ---> \"Task2\""));
+  }
+  unlink(file.c_str());
+}
+
+TEST_CASE("Agenda::ThisWeek") {
+  auto file = tempFileName();
+  writeTodo(file, "on 2020-01-01 for \"Task1\" repeat weekly\n");
+  Agenda agenda(file);
+  TimePoint start, end;
+  weekFor(start, end, std::chrono::system_clock::now());
+  const auto& text = agenda.range(start, end);
+  REQUIRE(1 == agenda.numCached());
+  // a little later, still in the same week
+  weekFor(start, end, std::chrono::system_clock::now());
+  REQUIRE(&text == &agenda.range(start, end));
+  REQUIRE(1 == agenda.numCached());
+  // the cache doesn't grow without bounds
+  for (int i = 0; i < 2 * Agenda::MaxViews; ++i) {
+    weekFor(start, end, addWeek(std::chrono::system_clock::now(), i));
+    agenda.range(start, end);
+    REQUIRE(agenda.numCached() <= Agenda::MaxViews);
+  }
+  unlink(file.c_str());
+}
+
+}  // namespace todo
+}  // namespace teditor
@@ -1,6 +1,7 @@
 #include <catch.hpp>
 #include "extensions/todo/objects.h"
 #include <stdexcept>
+#include <string>
 
 namespace teditor {
 namespace todo {
@@ -101,6 +102,90 @@ TEST_CASE("CalendarItem::getNextOccurence") {
   }
 }
 
+/** reference: steps through every occurrence from the start of the item */
+TimePoint naiveFirstOccurence(const CalendarItem& item, const TimePoint& pt) {
+  auto ret = item.start;
+  while (ret < pt && item.repeat != Repeat_None)
+    ret = item.getNextOccurence(ret);
+  return ret;
+}
+
+TEST_CASE("CalendarItem::getFirstOccurenceFrom") {
+  CalendarItem item;
+  item.clear();
+  item.description = "some task";
+  item.hasStart = true;
+  item.start = timeFromStr("2015-01-31");
+  auto pt = timeFromStr("2020-10-06");
+  SECTION("Repeat_None") {
+    item.repeat = Repeat_None;
+    REQUIRE("2015-01-31" == timeToDateStr(item.getFirstOccurenceFrom(pt)));
+  }
+  SECTION("Repeat_Daily") {
+    item.repeat = Repeat_Daily;
+    REQUIRE("2020-10-06" == timeToDateStr(item.getFirstOccurenceFrom(pt)));
+    REQUIRE("2015-01-31" ==
+            timeToDateStr(item.getFirstOccurenceFrom(timeFromStr("2014-01-01"))));
+  }
+  SECTION("Repeat_Weekly") {
+    // 2015-01-31 was a Saturday
+    item.repeat = Repeat_Weekly;
+    REQUIRE("2020-10-10" == timeToDateStr(item.getFirstOccurenceFrom(pt)));
+  }
+  SECTION("Repeat_Monthly") {
+    item.repeat = Repeat_Monthly;
+    item.start = timeFromStr("2015-01-15");
+    REQUIRE("2020-10-15" == timeToDateStr(item.getFirstOccurenceFrom(pt)));
+    REQUIRE("2020-11-15" ==
+            timeToDateStr(item.getFirstOccurenceFrom(timeFromStr("2020-10-16"))));
+  }
+  SECTION("Repeat_Yearly") {
+    item.repeat = Repeat_Yearly;
+    REQUIRE("2021-01-31" == timeToDateStr(item.getFirstOccurenceFrom(pt)));
+  }
+  SECTION("same as stepping") {
+    std::vector<std::string> starts{"2015-01-31", "2016-02-29", "2015-03-15",
+                                    "2015-06-28", "2015-08-30"};
+    std::vector<std::string> pts{"2015-01-01", "2015-01-31", "2016-03-01",
+                                 "2020-10-06", "2021-02-28", "2024-02-29"};
+    for (auto r : {Repeat_Yearly, Repeat_Monthly, Repeat_Weekly, Repeat_Daily}) {
+      item.repeat = r;
+      for (const auto& s : starts) {
+        item.start = timeFromStr(s);
+        for (const auto& p : pts) {
+          auto q = timeFromStr(p);
+          REQUIRE(timeToDateStr(naiveFirstOccurence(item, q)) ==
+                  timeToDateStr(item.getFirstOccurenceFrom(q)));
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("CalendarIndex::overlaps") {
+  CalendarItems items{
+    CalendarItem{timeFromStr("2020-10-06"), Repeat_None, "task0"},
+    CalendarItem{timeFromStr("2020-01-01"), timeFromStr("2020-02-01"),
+      Repeat_Daily, "task1"},
+    CalendarItem{timeFromStr("2019-01-01"), Repeat_Weekly, "task2"},
+    CalendarItem{timeFromStr("2021-01-01"), Repeat_Monthly, "task3"},
+  };
+  items.push_back(CalendarItem());
+  CalendarIndex index(items);
+  auto ids = index.overlaps(timeFromStr("2020-01-15"),
+                            timeFromStr("2020-01-20"));
+  REQUIRE(std::vector<int>{2, 1} == ids);
+  ids = index.overlaps(timeFromStr("2020-10-01"), timeFromStr("2020-10-10"));
+  REQUIRE(std::vector<int>{2, 0} == ids);
+  ids = index.overlaps(timeFromStr("2018-10-01"), timeFromStr("2018-10-10"));
+  REQUIRE(ids.empty());
+  ids = index.overlaps(timeFromStr("2021-10-01"), timeFromStr("2021-10-10"));
+  REQUIRE(std::vector<int>{2, 3} == ids);
+  CalendarIndex empty;
+  REQUIRE(empty.findMatchesIn(timeFromStr("2021-10-01"),
+                              timeFromStr("2021-10-10")).empty());
+}
+
 TEST_CASE("findMatchesIn") {
   CalendarItems items{
     CalendarItem{timeFromStr("2020-10-06"), Repeat_None, "task1"},
@@ -163,6 +248,99 @@ TEST_CASE("findMatchesIn") {
     auto matches = findMatchesIn(items, start, end);
     REQUIRE(0U == matches.size());
   }
+  SECTION("index") {
+    CalendarIndex index(items);
+    std::vector<std::pair<std::string, std::string>> ranges{
+      {"2020-10-04", "2020-10-08"}, {"2021-10-06", "2021-10-06"},
+      {"2021-10-04", "2021-10-04"}, {"2019-10-04", "2019-10-08"},
+      {"2020-10-01", "2020-12-31"}, {"2019-01-01", "2025-01-01"}};
+    for (const auto& r : ranges) {
+      auto start = timeFromStr(r.first), end = timeFromStr(r.second);
+      auto expected = findMatchesIn(items, start, end);
+      auto matches = index.findMatchesIn(start, end);
+      REQUIRE(expected.size() == matches.size());
+      for (size_t i = 0; i < matches.size(); ++i) {
+        REQUIRE(expected[i].idx == matches[i].idx);
+        REQUIRE(expected[i].pt == matches[i].pt);
+      }
+    }
+  }
+}
+
+TEST_CASE("mergeMatches") {
+  auto t0 = timeFromStr("2020-01-01"), t1 = timeFromStr("2020-01-02");
+  std::vector<CalendarMatches> lists{
+    {{1, t0}, {3, t1}},
+    {},
+    {{0, t0}, {2, t0}, {0, t1}},
+  };
+  auto merged = mergeMatches(lists);
+  REQUIRE(5U == merged.size());
+  std::vector<int> idxs;
+  for (const auto& m : merged) idxs.push_back(m.idx);
+  REQUIRE(std::vector<int>{0, 1, 2, 0, 3} == idxs);
+  REQUIRE(t1 == merged[3].pt);
+  REQUIRE(mergeMatches(std::vector<CalendarMatches>()).empty());
+}
+
+TEST_CASE("CalendarIndex::parallel") {
+  CalendarItems items;
+  RepeatType types[] = {Repeat_None, Repeat_Yearly, Repeat_Monthly,
+                        Repeat_Weekly, Repeat_Daily};
+  const auto start = timeFromStr("2015-01-01");
+  for (int i = 0; i < 2000; ++i) {
+    const auto s = addDay(start, i % 700);
+    auto name = "task" + std::to_string(i);
+    if (i % 3 == 0) {
+      items.push_back(CalendarItem{s, addDay(s, 400), types[i % 5], name});
+    } else {
+      items.push_back(CalendarItem{s, types[i % 5], name});
+    }
+  }
+  CalendarIndex index(items);
+  auto from = timeFromStr("2016-06-01"), to = timeFromStr("2016-09-30");
+  auto expected = findMatchesIn(items, from, to);
+  REQUIRE(0U < expected.size());
+  for (unsigned nThreads : {1U, 3U, 8U}) {
+    auto matches = index.findMatchesIn(from, to, nThreads);
+    REQUIRE(expected.size() == matches.size());
+    for (size_t i = 0; i < matches.size(); ++i) {
+      REQUIRE(expected[i].idx == matches[i].idx);
+      REQUIRE(expected[i].pt == matches[i].pt);
+    }
+  }
+}
+
+TEST_CASE("CalendarIndex::nextOccurences") {
+  CalendarItems items{
+    CalendarItem{timeFromStr("2020-10-06"), Repeat_None, "task0"},
+    CalendarItem{timeFromStr("2020-10-01"), timeFromStr("2020-10-08"),
+      Repeat_Daily, "task1"},
+    CalendarItem{timeFromStr("2020-09-01"), Repeat_Monthly, "task2"},
+    CalendarItem{timeFromStr("2020-01-01"), Repeat_None, "task3"},
+  };
+  CalendarIndex index(items);
+  auto matches = index.nextOccurences(timeFromStr("2020-10-05"), 6);
+  REQUIRE(6U == matches.size());
+  std::vector<int> idxs;
+  std::vector<std::string> dates;
+  for (const auto& m : matches) {
+    idxs.push_back(m.idx);
+    dates.push_back(timeToDateStr(m.pt));
+  }
+  REQUIRE(std::vector<int>{1, 0, 1, 1, 1, 2} == idxs);
+  REQUIRE(std::vector<std::string>{"2020-10-05", "2020-10-06", "2020-10-06",
+        "2020-10-07", "2020-10-08", "2020-11-01"} == dates);
+  // must be the same as the first few matches in a range
+  auto all = index.findMatchesIn(timeFromStr("2020-10-05"),
+                                 timeFromStr("2020-11-01"));
+  REQUIRE(6U == all.size());
+  for (size_t i = 0; i < all.size(); ++i) REQUIRE(all[i].idx == idxs[i]);
+  REQUIRE(index.nextOccurences(timeFromStr("2020-10-05"), 0).empty());
+  matches = index.nextOccurences(timeFromStr("2021-10-05"), 2);
+  REQUIRE(2U == matches.size());
+  REQUIRE("2021-11-01" == timeToDateStr(matches[0].pt));
+  REQUIRE("2021-12-01" == timeToDateStr(matches[1].pt));
 }
 
 }  // namespace todo
@@ -0,0 +1,32 @@
+#include "extensions/watch/mode.h"
+#include "core/option.h"
+#include "catch.hpp"
+#include "testutils.h"
+#include <chrono>
+#include <thread>
+
+namespace teditor {
+namespace watch {
+
+TEST_CASE("WatchMode::MainThreadUpdates") {
+  std::vector<FileInfo> files;
+  parseArgs(0, nullptr, files);
+  Buffer buf("*watch");
+  buf.setMode(Mode::createMode("watch"));
+  auto* mode = buf.getMode<WatchMode>("watch");
+  mode->start(&buf, "echo hello", 10);
+  // the job only runs the command, the buffer is untouched till it is drawn
+  for (int i = 0; i < 2000 && !mode->hasUpdate(); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  REQUIRE(mode->hasUpdate());
+  REQUIRE(1 == buf.length());
+  mode->beforeDraw(buf);
+  REQUIRE_FALSE(mode->hasUpdate());
+  mode->stop();
+  REQUIRE(buf.length() > 5);
+  REQUIRE("Cmd     : echo hello" == buf.at(0).get());
+  REQUIRE("hello" == buf.at(5).get());
+}
+
+}  // namespace watch
+}  // namespace teditor
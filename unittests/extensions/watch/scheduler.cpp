@@ -0,0 +1,86 @@
+#include "extensions/watch/scheduler.h"
+#include "catch.hpp"
+#include "testutils.h"
+#include <atomic>
+
+namespace teditor {
+namespace watch {
+
+void sleepMs(int ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+TEST_CASE("Scheduler::Periodic") {
+  Scheduler s(2);
+  std::atomic<int> a(0), b(0);
+  int ida = s.add("a", "cmd-a", 10, [&]() { ++a; return true; });
+  int idb = s.add("b", "cmd-b", 1000, [&]() { ++b; return false; });
+  REQUIRE(ida != idb);
+  sleepMs(300);
+  REQUIRE(s.remove(ida));
+  REQUIRE_FALSE(s.remove(ida));
+  int runs = a;
+  // 10ms period + tick granularity, but be lenient on loaded machines
+  REQUIRE(runs >= 5);
+  REQUIRE(runs <= 31);
+  sleepMs(50);
+  REQUIRE(runs == a);
+  REQUIRE(1 == b);
+  JobStats st;
+  REQUIRE(s.stats(idb, st));
+  REQUIRE(1 == st.runs);
+  REQUIRE(1 == st.failures);
+  REQUIRE_FALSE(s.stats(ida, st));
+  auto jobs = s.jobs();
+  REQUIRE(1 == jobs.size());
+  REQUIRE("b" == jobs[0].name);
+  REQUIRE("cmd-b" == jobs[0].cmd);
+  REQUIRE(1000 == jobs[0].periodMs);
+}
+
+TEST_CASE("Scheduler::Concurrency") {
+  Scheduler s(2);
+  std::atomic<int> curr(0), maxCurr(0), overlaps(0);
+  const int N = 5;
+  std::atomic<int> perJob[N];
+  for (int i = 0; i < N; ++i) perJob[i] = 0;
+  std::vector<int> ids;
+  for (int i = 0; i < N; ++i) {
+    ids.push_back(s.add("j", "", 1, [&, i]() {
+          if (++perJob[i] > 1) ++overlaps;
+          int c = ++curr;
+          int m = maxCurr;
+          while (c > m && !maxCurr.compare_exchange_weak(m, c)) {}
+          sleepMs(20);
+          --curr;
+          --perJob[i];
+          return true;
+        }));
+  }
+  sleepMs(200);
+  for (auto id : ids) REQUIRE(s.remove(id));
+  REQUIRE(0 == curr);
+  REQUIRE(2 == maxCurr);
+  REQUIRE(0 == overlaps);
+  REQUIRE(0 == s.numJobs());
+}
+
+TEST_CASE("Scheduler::RemoveWaits") {
+  Scheduler s(1);
+  std::atomic<bool> inside(false), done(false);
+  int id = s.add("slow", "", 10, [&]() {
+      inside = true;
+      sleepMs(100);
+      done = true;
+      return true;
+    });
+  while (!inside) sleepMs(1);
+  REQUIRE(s.remove(id));
+  // the callback must have completed by the time 'remove' returns
+  REQUIRE(done);
+  JobStats st;
+  REQUIRE_FALSE(s.stats(id, st));
+}
+
+}  // namespace watch
+}  // namespace teditor